@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jni.h"
+
+#include "art_method-inl.h"
+#include "base/enums.h"
+#include "hidden_api.h"
+#include "mirror/class-inl.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+namespace {
+
+// Checks access to all declared methods of `target` from `caller`, without any side effects.
+// Returns the number of denied methods of the last repetition.
+extern "C" JNIEXPORT jint JNICALL Java_HiddenApiChecksBenchmark_timeShouldDenyAccess(
+    JNIEnv* env, jclass, jclass caller, jclass target, jint reps) {
+  ScopedObjectAccess soa(env);
+  ObjPtr<mirror::Class> caller_class = soa.Decode<mirror::Class>(caller);
+  ObjPtr<mirror::Class> target_class = soa.Decode<mirror::Class>(target);
+  const hiddenapi::AccessContext caller_context(caller_class);
+  jint denied = 0;
+  for (jint i = 0; i < reps; ++i) {
+    denied = 0;
+    for (ArtMethod& method : target_class->GetDeclaredMethods(kRuntimePointerSize)) {
+      if (hiddenapi::ShouldDenyAccessToMember(&method,
+                                              [&]() { return caller_context; },
+                                              hiddenapi::AccessMethod::kNone)) {
+        ++denied;
+      }
+    }
+  }
+  return denied;
+}
+
+}  // namespace
+}  // namespace art
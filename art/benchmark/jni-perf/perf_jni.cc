@@ -16,6 +16,9 @@
 
 #include <assert.h>
 
+#include <thread>
+#include <vector>
+
 #include "jni.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread.h"
@@ -34,6 +37,36 @@ extern "C" JNIEXPORT void JNICALL Java_JniPerfBenchmark_perfSOAUncheckedCall(JNI
   ScopedObjectAccessUnchecked soa(Thread::Current());
 }
 
+// Each thread attaches to the VM and repeatedly creates and deletes a batch of global
+// references, as native callbacks of networking and media libraries do.
+extern "C" JNIEXPORT void JNICALL Java_JniPerfBenchmark_perfGlobalRefChurn(
+    JNIEnv* env, jobject obj, jint num_threads, jint reps, jint batch_size) {
+  JavaVM* vm = nullptr;
+  CHECK_EQ(env->GetJavaVM(&vm), JNI_OK);
+  jobject shared_obj = env->NewGlobalRef(obj);
+  std::vector<std::thread> threads;
+  for (jint t = 0; t < num_threads; ++t) {
+    threads.emplace_back([vm, shared_obj, reps, batch_size]() {
+      JNIEnv* thread_env = nullptr;
+      CHECK_EQ(vm->AttachCurrentThread(&thread_env, nullptr), JNI_OK);
+      std::vector<jobject> refs(batch_size);
+      for (jint i = 0; i < reps; ++i) {
+        for (jint j = 0; j < batch_size; ++j) {
+          refs[j] = thread_env->NewGlobalRef(shared_obj);
+        }
+        for (jint j = 0; j < batch_size; ++j) {
+          thread_env->DeleteGlobalRef(refs[j]);
+        }
+      }
+      CHECK_EQ(vm->DetachCurrentThread(), JNI_OK);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  env->DeleteGlobalRef(shared_obj);
+}
+
 }  // namespace
 
 }  // namespace art
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jni.h"
+
+#include "art_method-inl.h"
+#include "jni/jni_internal.h"
+#include "mirror/class-alloc-inl.h"
+#include "mirror/class-inl.h"
+#include "reflection.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+namespace {
+
+// Calls `method` (a java.lang.reflect.Method) on `receiver` with `args` like Method.invoke.
+extern "C" JNIEXPORT void JNICALL Java_ReflectionInvokeBenchmark_timeInvokeMethod(
+    JNIEnv* env, jclass, jobject method, jobject receiver, jobjectArray args, jint reps) {
+  ScopedObjectAccess soa(env);
+  for (jint i = 0; i < reps; ++i) {
+    jobject result = InvokeMethod(soa, method, receiver, args);
+    CHECK(!soa.Self()->IsExceptionPending());
+    if (result != nullptr) {
+      soa.Env()->DeleteLocalRef(result);
+    }
+  }
+}
+
+// Allocates an instance of `klass` and runs `constructor` (a java.lang.reflect.Constructor of
+// `klass`) with `args` like Constructor.newInstance. `klass` must be initialized.
+extern "C" JNIEXPORT void JNICALL Java_ReflectionInvokeBenchmark_timeNewInstance(
+    JNIEnv* env, jclass, jclass klass, jobject constructor, jobjectArray args, jint reps) {
+  ArtMethod* constructor_method = jni::DecodeArtMethod(env->FromReflectedMethod(constructor));
+  ScopedObjectAccess soa(env);
+  ObjPtr<mirror::Class> c = soa.Decode<mirror::Class>(klass);
+  CHECK(c->IsInitialized());
+  for (jint i = 0; i < reps; ++i) {
+    ObjPtr<mirror::Object> receiver = c->AllocObject(soa.Self());
+    CHECK(receiver != nullptr);
+    InvokeConstructor(soa, constructor_method, receiver, args);
+    CHECK(!soa.Self()->IsExceptionPending());
+  }
+}
+
+}  // namespace
+}  // namespace art
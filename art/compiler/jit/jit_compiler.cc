@@ -191,11 +191,12 @@ bool JitCompiler::CompileMethod(
               << PrettyDuration(duration_ns);
   }
 
-  // Trim maps to reduce memory usage.
-  // TODO: move this to an idle phase.
-  {
-    TimingLogger::ScopedTiming t2("TrimMaps", &logger);
-    runtime->GetJitArenaPool()->TrimMaps();
+  // Trim the arena pool to reduce memory usage once there is nothing left to compile. Between
+  // back-to-back compilations, the free arenas are kept to avoid faulting their pages in again.
+  ThreadPool* thread_pool = runtime->GetJit()->GetThreadPool();
+  if (thread_pool == nullptr || thread_pool->GetTaskCount(self) == 0u) {
+    TimingLogger::ScopedTiming t2("TrimIdle", &logger);
+    runtime->GetJitArenaPool()->TrimIdle();
   }
 
   runtime->GetJit()->AddTimingLogger(logger);
@@ -23,6 +23,7 @@
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
 #include "oat_file-inl.h"
+#include "thread-current-inl.h"
 
 namespace art {
 namespace jit {
@@ -33,6 +34,24 @@ static const char* kLogPrefix = "/data/misc/trace";
 static const char* kLogPrefix = "/tmp";
 #endif
 
+void JitLogger::OpenLog() {
+  MutexLock mu(Thread::Current(), lock_);
+  OpenPerfMapLog();
+  OpenJitDumpLog();
+}
+
+void JitLogger::WriteLog(const void* ptr, size_t code_size, ArtMethod* method) {
+  MutexLock mu(Thread::Current(), lock_);
+  WritePerfMapLog(ptr, code_size, method);
+  WriteJitDumpLog(ptr, code_size, method);
+}
+
+void JitLogger::CloseLog() {
+  MutexLock mu(Thread::Current(), lock_);
+  ClosePerfMapLog();
+  CloseJitDumpLog();
+}
+
 // File format of perf-PID.map:
 // +---------------------+
 // |ADDR SIZE symbolname1|
@@ -88,46 +88,42 @@ namespace jit {
 //
 class JitLogger {
  public:
-    JitLogger() : code_index_(0), marker_address_(nullptr) {}
+    JitLogger() : lock_("JIT logger lock", kGenericBottomLock),
+                  code_index_(0),
+                  marker_address_(nullptr) {}
 
-    void OpenLog() {
-      OpenPerfMapLog();
-      OpenJitDumpLog();
-    }
+    void OpenLog() REQUIRES(!lock_);
 
+    // Called by every JIT worker thread once its method is committed.
     void WriteLog(const void* ptr, size_t code_size, ArtMethod* method)
-        REQUIRES_SHARED(Locks::mutator_lock_) {
-      WritePerfMapLog(ptr, code_size, method);
-      WriteJitDumpLog(ptr, code_size, method);
-    }
+        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!lock_);
 
-    void CloseLog() {
-      ClosePerfMapLog();
-      CloseJitDumpLog();
-    }
+    void CloseLog() REQUIRES(!lock_);
 
  private:
     // For perf-map profiling
-    void OpenPerfMapLog();
+    void OpenPerfMapLog() REQUIRES(lock_);
     void WritePerfMapLog(const void* ptr, size_t code_size, ArtMethod* method)
-        REQUIRES_SHARED(Locks::mutator_lock_);
-    void ClosePerfMapLog();
+        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(lock_);
+    void ClosePerfMapLog() REQUIRES(lock_);
 
     // For perf-inject profiling
-    void OpenJitDumpLog();
+    void OpenJitDumpLog() REQUIRES(lock_);
     void WriteJitDumpLog(const void* ptr, size_t code_size, ArtMethod* method)
-        REQUIRES_SHARED(Locks::mutator_lock_);
-    void CloseJitDumpLog();
-
-    void OpenMarkerFile();
-    void CloseMarkerFile();
-    void WriteJitDumpHeader();
-    void WriteJitDumpDebugInfo();
-
-    std::unique_ptr<File> perf_file_;
-    std::unique_ptr<File> jit_dump_file_;
-    uint64_t code_index_;
-    void* marker_address_;
+        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(lock_);
+    void CloseJitDumpLog() REQUIRES(lock_);
+
+    void OpenMarkerFile() REQUIRES(lock_);
+    void CloseMarkerFile() REQUIRES(lock_);
+    void WriteJitDumpHeader() REQUIRES(lock_);
+    void WriteJitDumpDebugInfo() REQUIRES(lock_);
+
+    // Serializes the records of concurrent compilations, which share the files and code index.
+    Mutex lock_;
+    std::unique_ptr<File> perf_file_ GUARDED_BY(lock_);
+    std::unique_ptr<File> jit_dump_file_ GUARDED_BY(lock_);
+    uint64_t code_index_ GUARDED_BY(lock_);
+    void* marker_address_ GUARDED_BY(lock_);
 
     DISALLOW_COPY_AND_ASSIGN(JitLogger);
 };
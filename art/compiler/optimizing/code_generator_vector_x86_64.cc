@@ -209,10 +209,25 @@ void InstructionCodeGeneratorX86_64::VisitVecReduce(HVecReduce* instruction) {
           __ phaddd(dst, dst);
           break;
         case HVecReduce::kMin:
-        case HVecReduce::kMax:
-          // Historical note: We've had a broken implementation here. b/117863065
-          // Do not draw on the old code if we ever want to bring MIN/MAX reduction back.
-          LOG(FATAL) << "Unsupported reduction type.";
+        case HVecReduce::kMax: {
+          // Fold the upper half onto the lower half, then lane 1 onto lane 0.
+          XmmRegister tmp = locations->GetTemp(0).AsFpuRegister<XmmRegister>();
+          bool is_min = instruction->GetReductionKind() == HVecReduce::kMin;
+          __ movaps(dst, src);
+          __ pshufd(tmp, dst, Immediate(0x0e));  // [x2, x3, x0, x0]
+          if (is_min) {
+            __ pminsd(dst, tmp);
+          } else {
+            __ pmaxsd(dst, tmp);
+          }
+          __ pshufd(tmp, dst, Immediate(0x01));  // [x1, x0, x0, x0]
+          if (is_min) {
+            __ pminsd(dst, tmp);
+          } else {
+            __ pmaxsd(dst, tmp);
+          }
+          break;
+        }
       }
       break;
     case DataType::Type::kInt64: {
@@ -83,6 +83,7 @@ class HLoopOptimization : public HOptimization {
     kNoSAD           = 1 << 10,  // no sum of absolute differences (SAD)
     kNoWideSAD       = 1 << 11,  // no sum of absolute differences (SAD) with operand widening
     kNoDotProd       = 1 << 12,  // no dot product
+    kNoMinMax        = 1 << 13,  // no min/max
   };
 
   /*
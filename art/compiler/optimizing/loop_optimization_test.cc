@@ -21,7 +21,7 @@ namespace art {
 
 /**
  * Fixture class for the loop optimization tests. These unit tests focus
- * constructing the loop hierarchy. Actual optimizations are tested
+ * constructing the loop hierarchy. Actual optimizations are mostly tested
  * through the checker tests.
  */
 class LoopOptimizationTest : public OptimizingUnitTest {
@@ -89,6 +89,95 @@ class LoopOptimizationTest : public OptimizingUnitTest {
     return LoopStructureRecurse(loop_opt_->top_loop_);
   }
 
+  /**
+   * Constructs the loop
+   *   for (int i = 0; i < 128; i++) {
+   *     a[i] = min(a[i], b[i]);
+   *     x = max(x, b[i]);  // if with_reduction
+   *   }
+   *   return x;
+   * without bounds or null checks, so that nothing but the operations themselves
+   * decides whether it is vectorized.
+   */
+  void BuildMinMaxLoop(bool with_reduction) {
+    HInstruction* a = new (GetAllocator()) HParameterValue(
+        graph_->GetDexFile(), dex::TypeIndex(1), 1, DataType::Type::kReference);
+    HInstruction* b = new (GetAllocator()) HParameterValue(
+        graph_->GetDexFile(), dex::TypeIndex(1), 2, DataType::Type::kReference);
+    entry_block_->AddInstruction(a);
+    entry_block_->AddInstruction(b);
+
+    HBasicBlock* header = new (GetAllocator()) HBasicBlock(graph_);
+    HBasicBlock* body = new (GetAllocator()) HBasicBlock(graph_);
+    graph_->AddBlock(header);
+    graph_->AddBlock(body);
+    entry_block_->ReplaceSuccessor(return_block_, header);
+    header->AddSuccessor(return_block_);  // exit when the condition holds
+    header->AddSuccessor(body);
+    body->AddSuccessor(header);
+
+    HPhi* phi_i = new (GetAllocator()) HPhi(GetAllocator(), 0, 0, DataType::Type::kInt32);
+    header->AddPhi(phi_i);
+    HSuspendCheck* suspend_check = new (GetAllocator()) HSuspendCheck();
+    header->AddInstruction(suspend_check);
+    suspend_check->SetRawEnvironment(new (GetAllocator()) HEnvironment(
+        GetAllocator(), /* number_of_vregs= */ 0, graph_->GetArtMethod(), 0, suspend_check));
+    HInstruction* cmp =
+        new (GetAllocator()) HGreaterThanOrEqual(phi_i, graph_->GetIntConstant(128));
+    header->AddInstruction(cmp);
+    header->AddInstruction(new (GetAllocator()) HIf(cmp));
+
+    HInstruction* get_a = new (GetAllocator()) HArrayGet(a, phi_i, DataType::Type::kInt32, 0);
+    HInstruction* get_b = new (GetAllocator()) HArrayGet(b, phi_i, DataType::Type::kInt32, 0);
+    HInstruction* min = new (GetAllocator()) HMin(DataType::Type::kInt32, get_a, get_b, 0);
+    HInstruction* set_a = new (GetAllocator()) HArraySet(a, phi_i, min, DataType::Type::kInt32, 0);
+    HInstruction* add = new (GetAllocator()) HAdd(
+        DataType::Type::kInt32, phi_i, graph_->GetIntConstant(1));
+    body->AddInstruction(get_a);
+    body->AddInstruction(get_b);
+    body->AddInstruction(min);
+    body->AddInstruction(set_a);
+    body->AddInstruction(add);
+    phi_i->AddInput(graph_->GetIntConstant(0));
+    phi_i->AddInput(add);
+
+    if (with_reduction) {
+      HPhi* phi_x = new (GetAllocator()) HPhi(GetAllocator(), 0, 0, DataType::Type::kInt32);
+      header->AddPhi(phi_x);
+      HInstruction* max = new (GetAllocator()) HMax(DataType::Type::kInt32, phi_x, get_b, 0);
+      body->InsertInstructionBefore(max, add);
+      phi_x->AddInput(parameter_);
+      phi_x->AddInput(max);
+      return_block_->ReplaceAndRemoveInstructionWith(return_block_->GetLastInstruction(),
+                                                     new (GetAllocator()) HReturn(phi_x));
+    }
+    body->AddInstruction(new (GetAllocator()) HGoto());
+  }
+
+  /** Runs the loop optimizations, with vectorization, for the given target. */
+  void PerformVectorization(InstructionSet isa, const std::string& variant) {
+    OverrideInstructionSetFeatures(isa, variant);
+    graph_->BuildDominatorTree();
+    iva_->Run();
+    HLoopOptimization* loop_opt = new (GetAllocator()) HLoopOptimization(
+        graph_, compiler_options_.get(), iva_, /* stats= */ nullptr);
+    loop_opt->Run();
+  }
+
+  /** Returns the instructions of the graph that satisfy the given predicate. */
+  template <typename Predicate>
+  std::vector<HInstruction*> FindInstructions(Predicate predicate) {
+    std::vector<HInstruction*> found;
+    for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+      for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+        if (predicate(it.Current())) {
+          found.push_back(it.Current());
+        }
+      }
+    }
+    return found;
+  }
+
   // Helper method
   std::string LoopStructureRecurse(HLoopOptimization::LoopNode* node) {
     std::string s;
@@ -317,4 +406,63 @@ TEST_F(LoopOptimizationTest, SimplifyLoopSinglePreheader) {
   EXPECT_EQ(header_phi->InputAt(1), body_add);
 }
 
+TEST_F(LoopOptimizationTest, VectorizeMinMaxReduction) {
+  BuildMinMaxLoop(/* with_reduction= */ true);
+  PerformVectorization(InstructionSet::kArm64, "default");
+
+  // The element-wise min and the max reduction are both vectorized.
+  EXPECT_FALSE(FindInstructions([](HInstruction* i) { return i->IsVecMin(); }).empty());
+  EXPECT_FALSE(FindInstructions([](HInstruction* i) { return i->IsVecMax(); }).empty());
+
+  // The max reduction starts from the initial value in every lane, rather than
+  // from the initial value in one lane and zeros, as a sum would.
+  HInstruction* parameter = parameter_;
+  std::vector<HInstruction*> inits = FindInstructions([=](HInstruction* i) {
+    return i->IsVecReplicateScalar() && i->InputAt(0) == parameter;
+  });
+  EXPECT_EQ(1u, inits.size());
+  EXPECT_TRUE(FindInstructions([](HInstruction* i) { return i->IsVecSetScalars(); }).empty());
+
+  // It is folded with a max across the lanes after the loop, whose result is returned.
+  std::vector<HInstruction*> reduces =
+      FindInstructions([](HInstruction* i) { return i->IsVecReduce(); });
+  ASSERT_EQ(1u, reduces.size());
+  EXPECT_EQ(HVecReduce::kMax, reduces[0]->AsVecReduce()->GetReductionKind());
+  HInstruction* result = return_block_->GetLastInstruction()->InputAt(0);
+  ASSERT_TRUE(result->IsVecExtractScalar());
+  EXPECT_EQ(reduces[0], result->InputAt(0));
+}
+
+TEST_F(LoopOptimizationTest, VectorizeMinMaxX86) {
+  BuildMinMaxLoop(/* with_reduction= */ false);
+  PerformVectorization(InstructionSet::kX86_64, "silvermont");
+
+  // pminsd does the element-wise min.
+  EXPECT_FALSE(FindInstructions([](HInstruction* i) { return i->IsVecMin(); }).empty());
+}
+
+TEST_F(LoopOptimizationTest, VectorizeMinMaxReductionX86) {
+  BuildMinMaxLoop(/* with_reduction= */ true);
+  PerformVectorization(InstructionSet::kX86_64, "silvermont");
+
+  // pminsd and pmaxsd do the element-wise min and the max reduction, which pmaxsd then
+  // folds across the lanes after the loop.
+  EXPECT_FALSE(FindInstructions([](HInstruction* i) { return i->IsVecMin(); }).empty());
+  EXPECT_FALSE(FindInstructions([](HInstruction* i) { return i->IsVecMax(); }).empty());
+  std::vector<HInstruction*> reduces =
+      FindInstructions([](HInstruction* i) { return i->IsVecReduce(); });
+  ASSERT_EQ(1u, reduces.size());
+  EXPECT_EQ(HVecReduce::kMax, reduces[0]->AsVecReduce()->GetReductionKind());
+  EXPECT_EQ(DataType::Type::kInt32, reduces[0]->AsVecReduce()->GetPackedType());
+}
+
+TEST_F(LoopOptimizationTest, NoMinMaxWithoutSSE4_1) {
+  BuildMinMaxLoop(/* with_reduction= */ true);
+  PerformVectorization(InstructionSet::kX86_64, "atom");
+
+  // pminsd and pmaxsd are SSE4.1 instructions, so the loop stays scalar without them.
+  EXPECT_TRUE(FindInstructions([](HInstruction* i) { return i->IsVecOperation(); }).empty());
+  EXPECT_FALSE(FindInstructions([](HInstruction* i) { return i->IsMax(); }).empty());
+}
+
 }  // namespace art
@@ -766,6 +766,19 @@ TEST(StackMapTest, TestDedupeBitTables) {
   }
 
   ASSERT_GT(memory.size() * 2, out.size());
+
+  // The statistics recorded while deduplicating match the ones read back from the output.
+  const CodeInfo::DedupeStats& stats = deduper.GetStats();
+  ASSERT_EQ(2u, stats.num_code_infos);
+  ASSERT_NE(0u, stats.num_deduped_bit_tables);
+  ASSERT_NE(0u, stats.deduped_bits);
+  CodeInfo::DedupeStats collected;
+  CodeInfo::CollectDedupeStats(out.data() + deduped1, &collected);
+  CodeInfo::CollectDedupeStats(out.data() + deduped2, &collected);
+  ASSERT_EQ(stats.num_code_infos, collected.num_code_infos);
+  ASSERT_EQ(stats.num_bit_tables, collected.num_bit_tables);
+  ASSERT_EQ(stats.num_deduped_bit_tables, collected.num_deduped_bit_tables);
+  ASSERT_EQ(stats.deduped_bits, collected.deduped_bits);
 }
 
 }  // namespace art
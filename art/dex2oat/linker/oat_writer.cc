@@ -17,6 +17,7 @@
 #include "oat_writer.h"
 
 #include <algorithm>
+#include <sstream>
 #include <unistd.h>
 #include <zlib.h>
 
@@ -1482,10 +1483,15 @@ class OatWriter::InitMapMethodVisitor : public OatDexMethodVisitor {
 
       ArrayRef<const uint8_t> map = compiled_method->GetVmapTable();
       if (map.size() != 0u) {
-        size_t offset = dedupe_code_info_.GetOrCreate(map.data(), [=]() {
+        bool is_new_code_info = false;
+        size_t offset = dedupe_code_info_.GetOrCreate(map.data(), [&]() {
           // Deduplicate the inner BitTable<>s within the CodeInfo.
+          is_new_code_info = true;
           return offset_ + dedupe_bit_table_.Dedupe(map.data());
         });
+        if (!is_new_code_info) {
+          ++num_shared_code_infos_;
+        }
         // Code offset is not initialized yet, so set the map offset to 0u-offset.
         DCHECK_EQ(oat_class->method_offsets_[method_offsets_index_].code_offset_, 0u);
         oat_class->method_headers_[method_offsets_index_].SetVmapTableOffset(0u - offset);
@@ -1496,7 +1502,17 @@ class OatWriter::InitMapMethodVisitor : public OatDexMethodVisitor {
     return true;
   }
 
+  // Report how much the deduplication saved.
+  void DumpDedupeStats(std::ostream& os) const {
+    os << "CodeInfo deduplication: " << num_shared_code_infos_
+       << " methods share a previously written CodeInfo; ";
+    dedupe_bit_table_.GetStats().Dump(os);
+  }
+
  private:
+  // Number of methods whose CodeInfo was already written for another method.
+  size_t num_shared_code_infos_ = 0;
+
   // Deduplicate at CodeInfo level. The value is byte offset within code_info_data_.
   // This deduplicates the whole CodeInfo object without going into the inner tables.
   // The compiler already deduplicated the pointers but it did not dedupe the tables.
@@ -2077,6 +2093,11 @@ size_t OatWriter::InitOatMaps(size_t offset) {
     DCHECK(success);
     code_info_data_.shrink_to_fit();
     offset += code_info_data_.size();
+    if (compiler_options_.GetDumpStats() || VLOG_IS_ON(compiler)) {
+      std::ostringstream oss;
+      visitor.DumpDedupeStats(oss);
+      LOG(INFO) << oss.str();
+    }
   }
   return offset;
 }
@@ -581,16 +581,17 @@ class Header : public Item {
 
 class StringData : public Item {
  public:
-  explicit StringData(const char* data) : data_(strdup(data)) {
+  // The data is not copied, it must outlive this item (see DexIrBuilder).
+  explicit StringData(const char* data) : data_(data) {
     size_ = UnsignedLeb128Size(CountModifiedUtf8Chars(data)) + strlen(data);
   }
 
-  const char* Data() const { return data_.get(); }
+  const char* Data() const { return data_; }
 
   void Accept(AbstractDispatcher* dispatch) const { dispatch->Dispatch(this); }
 
  private:
-  UniqueCPtr<const char> data_;
+  const char* const data_;
 
   DISALLOW_COPY_AND_ASSIGN(StringData);
 };
@@ -1040,7 +1041,7 @@ class CodeItem : public Item {
            uint16_t outs_size,
            DebugInfoItem* debug_info,
            uint32_t insns_size,
-           uint16_t* insns,
+           const uint16_t* insns,
            TryItemVector* tries,
            CatchHandlerVector* handlers)
       : registers_size_(registers_size),
@@ -1060,7 +1061,7 @@ class CodeItem : public Item {
   uint16_t TriesSize() const { return tries_ == nullptr ? 0 : tries_->size(); }
   DebugInfoItem* DebugInfo() const { return debug_info_; }
   uint32_t InsnsSize() const { return insns_size_; }
-  uint16_t* Insns() const { return insns_.get(); }
+  const uint16_t* Insns() const { return insns_; }
   TryItemVector* Tries() const { return tries_.get(); }
   CatchHandlerVector* Handlers() const { return handlers_.get(); }
 
@@ -1080,7 +1081,7 @@ class CodeItem : public Item {
   uint16_t outs_size_;
   DebugInfoItem* debug_info_;  // This can be nullptr.
   uint32_t insns_size_;
-  std::unique_ptr<uint16_t[]> insns_;
+  const uint16_t* const insns_;  // Points into the input dex file.
   std::unique_ptr<TryItemVector> tries_;  // This can be nullptr.
   std::unique_ptr<CatchHandlerVector> handlers_;  // This can be nullptr.
   std::unique_ptr<CodeFixups> fixups_;  // This can be nullptr.
@@ -1090,15 +1091,15 @@ class CodeItem : public Item {
 
 class DebugInfoItem : public Item {
  public:
-  DebugInfoItem(uint32_t debug_info_size, uint8_t* debug_info)
+  DebugInfoItem(uint32_t debug_info_size, const uint8_t* debug_info)
      : debug_info_size_(debug_info_size), debug_info_(debug_info) { }
 
   uint32_t GetDebugInfoSize() const { return debug_info_size_; }
-  uint8_t* GetDebugInfo() const { return debug_info_.get(); }
+  const uint8_t* GetDebugInfo() const { return debug_info_; }
 
  private:
   uint32_t debug_info_size_;
-  std::unique_ptr<uint8_t[]> debug_info_;
+  const uint8_t* const debug_info_;  // Points into the input dex file.
 
   DISALLOW_COPY_AND_ASSIGN(DebugInfoItem);
 };
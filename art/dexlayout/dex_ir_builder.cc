@@ -809,19 +809,16 @@ CodeItem* BuilderMaps::DedupeOrCreateCodeItem(const DexFile& dex_file,
     debug_info = debug_info_items_map_.GetExistingObject(debug_info_offset);
     if (debug_info == nullptr) {
       uint32_t debug_info_size = GetDebugInfoStreamSize(debug_info_stream);
-      uint8_t* debug_info_buffer = new uint8_t[debug_info_size];
-      memcpy(debug_info_buffer, debug_info_stream, debug_info_size);
       debug_info = debug_info_items_map_.CreateAndAddItem(header_->DebugInfoItems(),
                                                           eagerly_assign_offsets_,
                                                           debug_info_offset,
                                                           debug_info_size,
-                                                          debug_info_buffer);
+                                                          debug_info_stream);
     }
   }
 
   uint32_t insns_size = accessor.InsnsSizeInCodeUnits();
-  uint16_t* insns = new uint16_t[insns_size];
-  memcpy(insns, accessor.Insns(), insns_size * sizeof(uint16_t));
+  const uint16_t* insns = accessor.Insns();
 
   TryItemVector* tries = nullptr;
   CatchHandlerVector* handler_list = nullptr;
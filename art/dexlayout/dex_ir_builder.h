@@ -29,6 +29,9 @@ namespace dex_ir {
 
 // Eagerly assign offsets based on the original offsets in the input dex file. If this is not done,
 // dex_ir::Item::GetOffset will abort when reading uninitialized offsets.
+//
+// String data, code item instructions and debug info streams are not copied into the IR, the
+// items point into the input dex file instead. The dex file must outlive the returned header.
 dex_ir::Header* DexIrBuilder(const DexFile& dex_file,
                              bool eagerly_assign_offsets,
                              const Options& options);
@@ -913,8 +913,8 @@ bool VerifyDebugInfo(dex_ir::DebugInfoItem* orig,
     *error_msg = "DebugInfoSize disagreed.";
     return false;
   }
-  uint8_t* orig_data = orig->GetDebugInfo();
-  uint8_t* output_data = output->GetDebugInfo();
+  const uint8_t* orig_data = orig->GetDebugInfo();
+  const uint8_t* output_data = output->GetDebugInfo();
   if ((orig_data == nullptr && output_data != nullptr) ||
       (orig_data != nullptr && output_data == nullptr)) {
     *error_msg = "DebugInfo null/non-null mismatch.";
@@ -52,6 +52,7 @@
 #include "dex_visualize.h"
 #include "dex_writer.h"
 #include "profile/profile_compilation_info.h"
+#include "streaming_dex_writer.h"
 
 namespace art {
 
@@ -1821,54 +1822,95 @@ bool DexLayout::OutputDexFile(const DexFile* input_dex_file,
                               bool compute_offsets,
                               std::unique_ptr<DexContainer>* dex_container,
                               std::string* error_msg) {
-  const std::string& dex_file_location = input_dex_file->GetLocation();
-  std::unique_ptr<File> new_file;
+  if (!DexWriter::Output(this, dex_container, compute_offsets, error_msg)) {
+    return false;
+  }
+  return WriteOutputFile(input_dex_file, dex_container->get());
+}
+
+bool DexLayout::WriteOutputFile(const DexFile* input_dex_file, DexContainer* dex_container) {
   // If options_.output_dex_directory_ is non null, we are outputting to a file.
-  if (options_.output_dex_directory_ != nullptr) {
-    std::string output_location(options_.output_dex_directory_);
-    const size_t last_slash = dex_file_location.rfind('/');
-    std::string dex_file_directory = dex_file_location.substr(0, last_slash + 1);
-    if (output_location == dex_file_directory) {
-      output_location = dex_file_location + ".new";
-    } else {
-      if (!output_location.empty() && output_location.back() != '/') {
-        output_location += "/";
-      }
-      const size_t separator = dex_file_location.rfind('!');
-      if (separator != std::string::npos) {
-        output_location += dex_file_location.substr(separator + 1);
-      } else {
-        output_location += "classes.dex";
-      }
+  if (options_.output_dex_directory_ == nullptr) {
+    return true;
+  }
+  const std::string& dex_file_location = input_dex_file->GetLocation();
+  std::string output_location(options_.output_dex_directory_);
+  const size_t last_slash = dex_file_location.rfind('/');
+  std::string dex_file_directory = dex_file_location.substr(0, last_slash + 1);
+  if (output_location == dex_file_directory) {
+    output_location = dex_file_location + ".new";
+  } else {
+    if (!output_location.empty() && output_location.back() != '/') {
+      output_location += "/";
     }
-    new_file.reset(OS::CreateEmptyFile(output_location.c_str()));
-    if (new_file == nullptr) {
-      LOG(ERROR) << "Could not create dex writer output file: " << output_location;
-      return false;
+    const size_t separator = dex_file_location.rfind('!');
+    if (separator != std::string::npos) {
+      output_location += dex_file_location.substr(separator + 1);
+    } else {
+      output_location += "classes.dex";
     }
   }
-  if (!DexWriter::Output(this, dex_container, compute_offsets, error_msg)) {
+  std::unique_ptr<File> new_file(OS::CreateEmptyFile(output_location.c_str()));
+  if (new_file == nullptr) {
+    LOG(ERROR) << "Could not create dex writer output file: " << output_location;
     return false;
   }
-  if (new_file != nullptr) {
-    DexContainer* const container = dex_container->get();
-    DexContainer::Section* const main_section = container->GetMainSection();
-    if (!new_file->WriteFully(main_section->Begin(), main_section->Size())) {
-      LOG(ERROR) << "Failed to write main section for dex file " << dex_file_location;
-      new_file->Erase();
-      return false;
-    }
-    DexContainer::Section* const data_section = container->GetDataSection();
-    if (!new_file->WriteFully(data_section->Begin(), data_section->Size())) {
-      LOG(ERROR) << "Failed to write data section for dex file " << dex_file_location;
-      new_file->Erase();
-      return false;
-    }
-    UNUSED(new_file->FlushCloseOrErase());
+  DexContainer::Section* const main_section = dex_container->GetMainSection();
+  if (!new_file->WriteFully(main_section->Begin(), main_section->Size())) {
+    LOG(ERROR) << "Failed to write main section for dex file " << dex_file_location;
+    new_file->Erase();
+    return false;
   }
+  DexContainer::Section* const data_section = dex_container->GetDataSection();
+  if (!new_file->WriteFully(data_section->Begin(), data_section->Size())) {
+    LOG(ERROR) << "Failed to write data section for dex file " << dex_file_location;
+    new_file->Erase();
+    return false;
+  }
+  UNUSED(new_file->FlushCloseOrErase());
   return true;
 }
 
+void DexLayout::VerifyOutput(const char* file_name,
+                             const DexFile* dex_file,
+                             DexContainer* dex_container,
+                             std::string* error_msg) {
+  std::string location = "memory mapped file for " + std::string(file_name);
+  // Dex file verifier cannot handle compact dex.
+  bool verify = options_.compact_dex_level_ == CompactDexLevel::kCompactDexLevelNone;
+  const ArtDexFileLoader dex_file_loader;
+  DexContainer::Section* const main_section = dex_container->GetMainSection();
+  DexContainer::Section* const data_section = dex_container->GetDataSection();
+  std::unique_ptr<const DexFile> output_dex_file(
+      dex_file_loader.OpenWithDataSection(
+          main_section->Begin(),
+          main_section->Size(),
+          data_section->Begin(),
+          data_section->Size(),
+          location,
+          /* location_checksum= */ 0,
+          /*oat_dex_file=*/ nullptr,
+          verify,
+          /*verify_checksum=*/ false,
+          error_msg));
+  CHECK(output_dex_file != nullptr) << "Failed to re-open output file:" << *error_msg;
+
+  // Do IR-level comparison between input and output. This check ignores potential differences
+  // due to layout, so offsets are not checked. Instead, it checks the data contents of each
+  // item.
+  //
+  // Regenerate output IR to catch any bugs that might happen during writing.
+  std::unique_ptr<dex_ir::Header> output_header(
+      dex_ir::DexIrBuilder(*output_dex_file,
+                           /*eagerly_assign_offsets=*/ true,
+                           GetOptions()));
+  std::unique_ptr<dex_ir::Header> orig_header(
+      dex_ir::DexIrBuilder(*dex_file,
+                           /*eagerly_assign_offsets=*/ true,
+                           GetOptions()));
+  CHECK(VerifyOutputDexFile(output_header.get(), orig_header.get(), error_msg)) << *error_msg;
+}
+
 /*
  * Dumps the requested sections of the file.
  */
@@ -1880,6 +1922,29 @@ bool DexLayout::ProcessDexFile(const char* file_name,
   const bool has_output_container = dex_container != nullptr;
   const bool output = options_.output_dex_directory_ != nullptr || has_output_container;
 
+  // Standard dex files can be laid out without building the IR, which is only needed here if the
+  // input is not supported by the streaming writer.
+  if (output && options_.stream_layout_ && info_ != nullptr && !options_.visualize_pattern_ &&
+      !options_.show_section_statistics_ && !options_.dump_ && options_.class_filter_.empty()) {
+    std::unique_ptr<DexContainer> temp_container;
+    std::unique_ptr<DexContainer>* container =
+        has_output_container ? dex_container : &temp_container;
+    if (StreamingDexWriter::Output(this, *dex_file, container, error_msg)) {
+      if (!WriteOutputFile(dex_file, container->get())) {
+        return false;
+      }
+      // Verify the output dex file's structure, only enabled by default for debug builds.
+      if (options_.verify_output_ && has_output_container) {
+        VerifyOutput(file_name, dex_file, container->get(), error_msg);
+      }
+      return true;
+    }
+    VLOG(dex) << "Laying out " << file_name << " with the dex IR: " << *error_msg;
+    // Drop the partial output.
+    container->reset();
+    error_msg->clear();
+  }
+
   // Try to avoid eagerly assigning offsets to find bugs since Offset will abort if the offset
   // is unassigned.
   bool eagerly_assign_offsets = false;
@@ -1936,42 +2001,10 @@ bool DexLayout::ProcessDexFile(const char* file_name,
 
     // Verify the output dex file's structure, only enabled by default for debug builds.
     if (options_.verify_output_ && has_output_container) {
-      std::string location = "memory mapped file for " + std::string(file_name);
-      // Dex file verifier cannot handle compact dex.
-      bool verify = options_.compact_dex_level_ == CompactDexLevel::kCompactDexLevelNone;
-      const ArtDexFileLoader dex_file_loader;
-      DexContainer::Section* const main_section = (*dex_container)->GetMainSection();
-      DexContainer::Section* const data_section = (*dex_container)->GetDataSection();
-      DCHECK_EQ(file_size, main_section->Size())
-          << main_section->Size() << " " << data_section->Size();
-      std::unique_ptr<const DexFile> output_dex_file(
-          dex_file_loader.OpenWithDataSection(
-              main_section->Begin(),
-              main_section->Size(),
-              data_section->Begin(),
-              data_section->Size(),
-              location,
-              /* location_checksum= */ 0,
-              /*oat_dex_file=*/ nullptr,
-              verify,
-              /*verify_checksum=*/ false,
-              error_msg));
-      CHECK(output_dex_file != nullptr) << "Failed to re-open output file:" << *error_msg;
-
-      // Do IR-level comparison between input and output. This check ignores potential differences
-      // due to layout, so offsets are not checked. Instead, it checks the data contents of each
-      // item.
-      //
-      // Regenerate output IR to catch any bugs that might happen during writing.
-      std::unique_ptr<dex_ir::Header> output_header(
-          dex_ir::DexIrBuilder(*output_dex_file,
-                               /*eagerly_assign_offsets=*/ true,
-                               GetOptions()));
-      std::unique_ptr<dex_ir::Header> orig_header(
-          dex_ir::DexIrBuilder(*dex_file,
-                               /*eagerly_assign_offsets=*/ true,
-                               GetOptions()));
-      CHECK(VerifyOutputDexFile(output_header.get(), orig_header.get(), error_msg)) << *error_msg;
+      DCHECK_EQ(file_size, (*dex_container)->GetMainSection()->Size())
+          << (*dex_container)->GetMainSection()->Size() << " "
+          << (*dex_container)->GetDataSection()->Size();
+      VerifyOutput(file_name, dex_file, dex_container->get(), error_msg);
     }
   }
   return true;
@@ -68,6 +68,8 @@ class Options {
   bool update_checksum_ = false;
   CompactDexLevel compact_dex_level_ = CompactDexLevel::kCompactDexLevelNone;
   bool dedupe_code_items_ = true;
+  // Lay out standard dex files with a profile straight from the input, without the dex IR.
+  bool stream_layout_ = false;
   OutputFormat output_format_ = kOutputPlain;
   const char* output_dex_directory_ = nullptr;
   const char* output_file_name_ = nullptr;
@@ -133,6 +135,10 @@ class DexLayout {
     return options_;
   }
 
+  ProfileCompilationInfo* GetProfileInfo() const {
+    return info_;
+  }
+
  private:
   void DumpAnnotationSetItem(dex_ir::AnnotationSetItem* set_item);
   void DumpBytecodes(uint32_t idx, const dex_ir::CodeItem* code, uint32_t code_offset);
@@ -182,6 +188,12 @@ class DexLayout {
                      bool compute_offsets,
                      std::unique_ptr<DexContainer>* dex_container,
                      std::string* error_msg);
+  bool WriteOutputFile(const DexFile* input_dex_file, DexContainer* dex_container);
+  // Checks that the output is a valid dex file with the same contents as the input.
+  void VerifyOutput(const char* file_name,
+                    const DexFile* dex_file,
+                    DexContainer* dex_container,
+                    std::string* error_msg);
 
   void DumpCFG(const DexFile* dex_file, int idx);
   void DumpCFG(const DexFile* dex_file, uint32_t dex_method_idx, const dex::CodeItem* code);
@@ -46,7 +46,7 @@ static void Usage() {
   LOG(ERROR) << "Copyright (C) 2016 The Android Open Source Project\n";
   LOG(ERROR) << kProgramName
              << ": [-a] [-c] [-d] [-e] [-f] [-h] [-i] [-l layout] [-o outfile] [-p profile]"
-                " [-s] [-t] [-u] [-v] [-w directory] dexfile...\n";
+                " [-s] [-S] [-t] [-u] [-v] [-w directory] dexfile...\n";
   LOG(ERROR) << " -a : display annotations";
   LOG(ERROR) << " -b : build dex_ir";
   LOG(ERROR) << " -c : verify checksum and exit";
@@ -59,6 +59,7 @@ static void Usage() {
   LOG(ERROR) << " -o : output file name (defaults to stdout)";
   LOG(ERROR) << " -p : profile file name (defaults to no profile)";
   LOG(ERROR) << " -s : visualize reference pattern";
+  LOG(ERROR) << " -S : lay out standard dex without building the dex IR, does not dump";
   LOG(ERROR) << " -t : display file section sizes";
   LOG(ERROR) << " -u : update dex checksums";
   LOG(ERROR) << " -v : verify output file is canonical to input (IR level comparison)";
@@ -86,7 +87,7 @@ int DexlayoutDriver(int argc, char** argv) {
 
   // Parse all arguments.
   while (true) {
-    const int ic = getopt(argc, argv, "abcdefghil:o:p:stuvw:x:");
+    const int ic = getopt(argc, argv, "abcdefghil:o:p:sStuvw:x:");
     if (ic < 0) {
       break;  // done
     }
@@ -135,6 +136,10 @@ int DexlayoutDriver(int argc, char** argv) {
         options.visualize_pattern_ = true;
         options.verbose_ = false;
         break;
+      case 'S':  // stream the layout
+        options.stream_layout_ = true;
+        options.dump_ = false;
+        break;
       case 't':  // display section statistics
         options.show_section_statistics_ = true;
         options.verbose_ = false;
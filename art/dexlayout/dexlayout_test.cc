@@ -30,9 +30,12 @@
 #include "dex/code_item_accessors-inl.h"
 #include "dex/dex_file-inl.h"
 #include "dex/dex_file_loader.h"
+#include "dex_ir_builder.h"
+#include "dex_verify.h"
 #include "dexlayout.h"
 #include "exec_utils.h"
 #include "profile/profile_compilation_info.h"
+#include "streaming_dex_writer.h"
 
 namespace art {
 
@@ -832,4 +835,110 @@ TEST_F(DexLayoutTest, ClassFilter) {
   }
 }
 
+TEST_F(DexLayoutTest, IrReferencesInputData) {
+  std::vector<std::unique_ptr<const DexFile>> dex_files;
+  std::string error_msg;
+  const ArtDexFileLoader dex_file_loader;
+  const std::string input_jar = GetTestDexFileName("ManyMethods");
+  CHECK(dex_file_loader.Open(input_jar.c_str(),
+                             input_jar.c_str(),
+                             /*verify=*/ true,
+                             /*verify_checksum=*/ true,
+                             &error_msg,
+                             &dex_files)) << error_msg;
+  ASSERT_EQ(dex_files.size(), 1u);
+  const DexFile& dex_file = *dex_files[0];
+  auto in_input = [&](const void* ptr) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(ptr);
+    return p >= dex_file.DataBegin() && p < dex_file.DataBegin() + dex_file.DataSize();
+  };
+  Options options;
+  std::unique_ptr<dex_ir::Header> header(dex_ir::DexIrBuilder(dex_file,
+                                                               /*eagerly_assign_offsets=*/ true,
+                                                               options));
+  // The bulk data of the IR is not copied, it is read in place from the input dex file.
+  ASSERT_GT(header->StringDatas().Size(), 0u);
+  for (const std::unique_ptr<dex_ir::StringData>& string_data : header->StringDatas()) {
+    EXPECT_TRUE(in_input(string_data->Data()));
+  }
+  ASSERT_GT(header->CodeItems().Size(), 0u);
+  for (const std::unique_ptr<dex_ir::CodeItem>& code_item : header->CodeItems()) {
+    if (code_item->InsnsSize() != 0u) {
+      EXPECT_TRUE(in_input(code_item->Insns()));
+    }
+  }
+  for (const std::unique_ptr<dex_ir::DebugInfoItem>& debug_info : header->DebugInfoItems()) {
+    EXPECT_TRUE(in_input(debug_info->GetDebugInfo()));
+  }
+}
+
+TEST_F(DexLayoutTest, StreamingLayout) {
+  std::vector<std::unique_ptr<const DexFile>> dex_files;
+  std::string error_msg;
+  const ArtDexFileLoader dex_file_loader;
+  const std::string input_jar = GetTestDexFileName("ManyMethods");
+  CHECK(dex_file_loader.Open(input_jar.c_str(),
+                             input_jar.c_str(),
+                             /*verify=*/ true,
+                             /*verify_checksum=*/ true,
+                             &error_msg,
+                             &dex_files)) << error_msg;
+  ASSERT_EQ(dex_files.size(), 1u);
+  const DexFile& dex_file = *dex_files[0];
+  // Every even method is hot, every even class is in the profile.
+  ProfileCompilationInfo pfi;
+  for (uint32_t i = 0; i < dex_file.NumMethodIds(); i += 2) {
+    pfi.AddMethod(ProfileMethodInfo(MethodReference(&dex_file, /*index=*/ i)),
+                  ProfileCompilationInfo::MethodHotness::kFlagHot);
+  }
+  std::set<dex::TypeIndex> classes;
+  for (uint32_t i = 0; i < dex_file.NumClassDefs(); i += 2) {
+    classes.insert(dex_file.GetClassDef(i).class_idx_);
+  }
+  pfi.AddClassesForDex(&dex_file, classes.begin(), classes.end());
+
+  Options options;
+  options.update_checksum_ = true;
+  DexLayout dexlayout(options, &pfi, /*out_file=*/ nullptr, /*header=*/ nullptr);
+  std::unique_ptr<DexContainer> out;
+  ASSERT_TRUE(StreamingDexWriter::Output(&dexlayout, dex_file, &out, &error_msg)) << error_msg;
+  std::unique_ptr<const DexFile> output_dex_file(
+      dex_file_loader.Open(out->GetMainSection()->Begin(),
+                           out->GetMainSection()->Size(),
+                           dex_file.GetLocation(),
+                           /*location_checksum=*/ 0,
+                           /*oat_dex_file=*/ nullptr,
+                           /*verify=*/ true,
+                           /*verify_checksum=*/ true,
+                           &error_msg));
+  ASSERT_TRUE(output_dex_file != nullptr) << error_msg;
+
+  // The output holds the same items as the input.
+  std::unique_ptr<dex_ir::Header> orig_header(dex_ir::DexIrBuilder(dex_file,
+                                                                    /*eagerly_assign_offsets=*/ true,
+                                                                    options));
+  std::unique_ptr<dex_ir::Header> output_header(
+      dex_ir::DexIrBuilder(*output_dex_file, /*eagerly_assign_offsets=*/ true, options));
+  ASSERT_TRUE(VerifyOutputDexFile(output_header.get(), orig_header.get(), &error_msg))
+      << error_msg;
+
+  // The code of the hot methods is laid out together.
+  const DexLayoutSection::Subsection& hot_code =
+      dexlayout.GetSections().sections_[static_cast<size_t>(
+          DexLayoutSections::SectionType::kSectionTypeCode)].parts_[static_cast<size_t>(
+              LayoutType::kLayoutTypeHot)];
+  ASSERT_LT(hot_code.start_offset_, hot_code.end_offset_);
+  size_t hot_methods = 0;
+  for (ClassAccessor accessor : output_dex_file->GetClasses()) {
+    for (const ClassAccessor::Method& method : accessor.GetMethods()) {
+      if (method.GetCodeItemOffset() != 0u) {
+        const bool hot = (method.GetIndex() & 1u) == 0u;
+        EXPECT_EQ(hot, hot_code.Contains(method.GetCodeItemOffset())) << method.GetIndex();
+        hot_methods += hot ? 1u : 0u;
+      }
+    }
+  }
+  EXPECT_GT(hot_methods, 0u);
+}
+
 }  // namespace art
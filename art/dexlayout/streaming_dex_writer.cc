@@ -0,0 +1,615 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "streaming_dex_writer.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "android-base/stringprintf.h"
+#include "base/leb128.h"
+#include "base/logging.h"  // For VLOG_IS_ON.
+#include "dex/class_accessor-inl.h"
+#include "dex/code_item_accessors-inl.h"
+#include "dex/dex_file-inl.h"
+#include "dex/dex_instruction-inl.h"
+#include "dex/dex_instruction_iterator.h"
+#include "dex_writer.h"
+#include "dexlayout.h"
+#include "profile/profile_compilation_info.h"
+
+namespace art {
+
+using android::base::StringPrintf;
+
+// Returns the index of the item at `offset`, or `offsets.size()` if no item starts there.
+static size_t FindItem(const std::vector<uint32_t>& offsets, uint32_t offset) {
+  auto it = std::lower_bound(offsets.begin(), offsets.end(), offset);
+  return (it != offsets.end() && *it == offset) ? static_cast<size_t>(it - offsets.begin())
+                                                : offsets.size();
+}
+
+static uint32_t StringDataSize(const uint8_t* data) {
+  const uint8_t* ptr = data;
+  DecodeUnsignedLeb128(&ptr);
+  return (ptr - data) + strlen(reinterpret_cast<const char*>(ptr)) + 1u;
+}
+
+// Calls `visitor(value, is_code_item_offset)` for every value of the class data item at `data`
+// and returns the end of the item.
+template <typename Visitor>
+static const uint8_t* VisitClassData(const uint8_t* data, const Visitor& visitor) {
+  uint32_t sizes[4];
+  for (uint32_t& size : sizes) {
+    size = DecodeUnsignedLeb128(&data);
+    visitor(size, /*is_code_item_offset=*/ false);
+  }
+  // Fields are an index delta and access flags.
+  for (uint32_t i = 0, e = (sizes[0] + sizes[1]) * 2u; i != e; ++i) {
+    visitor(DecodeUnsignedLeb128(&data), /*is_code_item_offset=*/ false);
+  }
+  // Methods are an index delta, access flags and the code item offset.
+  for (uint32_t i = 0, e = sizes[2] + sizes[3]; i != e; ++i) {
+    visitor(DecodeUnsignedLeb128(&data), /*is_code_item_offset=*/ false);
+    visitor(DecodeUnsignedLeb128(&data), /*is_code_item_offset=*/ false);
+    visitor(DecodeUnsignedLeb128(&data), /*is_code_item_offset=*/ true);
+  }
+  return data;
+}
+
+// Returns the index an instruction refers to, read the same way as the IR builder reads it.
+static uint32_t GetIndexFromInstruction(const Instruction& inst) {
+  switch (Instruction::FormatOf(inst.Opcode())) {
+    case Instruction::k21c:
+    case Instruction::k31c:
+    case Instruction::k35c:
+    case Instruction::k3rc:
+    case Instruction::k45cc:
+    case Instruction::k4rcc:
+      return inst.VRegB();
+    case Instruction::k22c:
+      return inst.VRegC();
+    default:
+      return dex::kDexNoIndex;
+  }
+}
+
+StreamingDexWriter::StreamingDexWriter(DexLayout* dex_layout, const DexFile& dex_file)
+    : dex_layout_(dex_layout), dex_file_(dex_file) {}
+
+bool StreamingDexWriter::FindSectionItems(DexFile::MapItemType type,
+                                          SectionItems* items,
+                                          std::string* error_msg) const {
+  const dex::MapList* map = dex_file_.GetMapList();
+  const dex::MapItem* item = nullptr;
+  for (uint32_t i = 0; i < map->size_; ++i) {
+    if (map->list_[i].type_ == type) {
+      item = &map->list_[i];
+      break;
+    }
+  }
+  if (item == nullptr) {
+    // The section is empty.
+    return true;
+  }
+  const uint32_t file_size = dex_file_.GetHeader().file_size_;
+  const uint32_t alignment = DexWriter::SectionAlignment(type);
+  items->begin = item->offset_;
+  items->limit = file_size;
+  for (uint32_t i = 0; i < map->size_; ++i) {
+    if (map->list_[i].offset_ > item->offset_) {
+      items->limit = std::min(items->limit, map->list_[i].offset_);
+    }
+  }
+  items->offsets.reserve(item->size_);
+  items->sizes.reserve(item->size_);
+  uint32_t offset = item->offset_;
+  for (uint32_t i = 0; i < item->size_; ++i) {
+    offset = RoundUp(offset, alignment);
+    if (offset >= items->limit) {
+      *error_msg = StringPrintf("Section %x overruns at item %u", type, i);
+      return false;
+    }
+    const uint8_t* data = dex_file_.Begin() + offset;
+    uint32_t size = 0u;
+    switch (type) {
+      case DexFile::kDexTypeStringDataItem:
+        size = StringDataSize(data);
+        break;
+      case DexFile::kDexTypeCodeItem: {
+        const dex::CodeItem* code_item = reinterpret_cast<const dex::CodeItem*>(data);
+        // The copy only keeps debug info intact where it does not move. Debug info that overlaps
+        // the header would change with the checksum.
+        // The method index only matters for compact dex.
+        const uint32_t debug_info_off =
+            CodeItemDebugInfoAccessor(dex_file_, code_item, dex::kDexNoIndex).DebugInfoOffset();
+        if (debug_info_off != 0u && debug_info_off < dex_file_.GetHeader().data_off_) {
+          *error_msg = StringPrintf("Debug info at %x is outside the data section",
+                                    debug_info_off);
+          return false;
+        }
+        size = dex_file_.GetCodeItemSize(*code_item);
+        break;
+      }
+      case DexFile::kDexTypeClassDataItem:
+        size = VisitClassData(data, [](uint32_t, bool) {}) - data;
+        break;
+      default:
+        LOG(FATAL) << "Unsupported section " << type;
+        UNREACHABLE();
+    }
+    items->offsets.push_back(offset);
+    items->sizes.push_back(size);
+    offset += size;
+  }
+  if (offset > items->limit) {
+    *error_msg = StringPrintf("Section %x overlaps the next section", type);
+    return false;
+  }
+  items->end = offset;
+  return true;
+}
+
+std::vector<uint32_t> StreamingDexWriter::GetStringIdOrder() const {
+  ProfileCompilationInfo* info = dex_layout_->GetProfileInfo();
+  const size_t num_strings = dex_file_.NumStringIds();
+  std::vector<bool> is_shorty(num_strings, false);
+  std::vector<bool> from_hot_method(num_strings, false);
+  auto mark_type = [&](dex::TypeIndex type_idx) {
+    from_hot_method[dex_file_.GetTypeId(type_idx).descriptor_idx_.index_] = true;
+  };
+  for (ClassAccessor accessor : dex_file_.GetClasses()) {
+    // A name of a profile class is probably going to get looked up by ClassTable::Lookup, mark it
+    // as hot. Add its super class and interfaces as well, which can be used during initialization.
+    const dex::ClassDef& class_def = accessor.GetClassDef();
+    const bool is_profile_class = info->ContainsClass(dex_file_, class_def.class_idx_);
+    if (is_profile_class) {
+      mark_type(class_def.class_idx_);
+      if (class_def.superclass_idx_.IsValid()) {
+        mark_type(class_def.superclass_idx_);
+      }
+      const dex::TypeList* interfaces = dex_file_.GetInterfacesList(class_def);
+      if (interfaces != nullptr) {
+        for (uint32_t i = 0; i < interfaces->Size(); ++i) {
+          mark_type(interfaces->GetTypeItem(i).type_idx_);
+        }
+      }
+    }
+    for (const ClassAccessor::Method& method : accessor.GetMethods()) {
+      if (method.GetCodeItemOffset() == 0u) {
+        continue;
+      }
+      const bool is_clinit = is_profile_class &&
+          (method.GetAccessFlags() & kAccConstructor) != 0 &&
+          (method.GetAccessFlags() & kAccStatic) != 0;
+      const bool method_executed = is_clinit ||
+          info->GetMethodHotness(MethodReference(&dex_file_, method.GetIndex())).IsInProfile();
+      if (!method_executed) {
+        continue;
+      }
+      const dex::MethodId& method_id = dex_file_.GetMethodId(method.GetIndex());
+      is_shorty[dex_file_.GetProtoId(method_id.proto_idx_).shorty_idx_.index_] = true;
+      // Add const-strings, field classes, names, and types, and for clinits the referenced method
+      // classes, names, and protos.
+      CodeItemInstructionAccessor instructions = method.GetInstructions();
+      SafeDexInstructionIterator it(instructions.begin(), instructions.end());
+      for (; !it.IsErrorState() && it < instructions.end(); ++it) {
+        // In case the instruction goes past the end of the code item, make sure to not process it.
+        SafeDexInstructionIterator next = it;
+        ++next;
+        if (next.IsErrorState()) {
+          break;
+        }
+        const uint32_t index = GetIndexFromInstruction(it.Inst());
+        switch (Instruction::IndexTypeOf(it.Inst().Opcode())) {
+          case Instruction::kIndexStringRef:
+            if (index < num_strings) {
+              from_hot_method[index] = true;
+            }
+            break;
+          case Instruction::kIndexFieldRef:
+            if (index < dex_file_.NumFieldIds()) {
+              // TODO: Only visit field ids from static getters and setters.
+              const dex::FieldId& field_id = dex_file_.GetFieldId(index);
+              mark_type(field_id.class_idx_);
+              from_hot_method[field_id.name_idx_.index_] = true;
+              mark_type(field_id.type_idx_);
+            }
+            break;
+          case Instruction::kIndexMethodRef:
+          case Instruction::kIndexMethodAndProtoRef:
+            if (is_clinit && index < dex_file_.NumMethodIds()) {
+              const dex::MethodId& id = dex_file_.GetMethodId(index);
+              mark_type(id.class_idx_);
+              from_hot_method[id.name_idx_.index_] = true;
+              is_shorty[dex_file_.GetProtoId(id.proto_idx_).shorty_idx_.index_] = true;
+            }
+            break;
+          default:
+            break;
+        }
+      }
+    }
+  }
+  std::vector<uint32_t> string_ids(num_strings);
+  for (uint32_t i = 0; i < num_strings; ++i) {
+    string_ids[i] = i;
+  }
+  std::sort(string_ids.begin(),
+            string_ids.end(),
+            [&is_shorty, &from_hot_method](uint32_t a, uint32_t b) {
+    const bool a_is_hot = from_hot_method[a];
+    const bool b_is_hot = from_hot_method[b];
+    if (a_is_hot != b_is_hot) {
+      return a_is_hot < b_is_hot;
+    }
+    // After hot methods are partitioned, subpartition shorties.
+    const bool a_is_shorty = is_shorty[a];
+    const bool b_is_shorty = is_shorty[b];
+    if (a_is_shorty != b_is_shorty) {
+      return a_is_shorty < b_is_shorty;
+    }
+    // Order by index by default.
+    return a < b;
+  });
+  return string_ids;
+}
+
+bool StreamingDexWriter::GetCodeItemLayout(const SectionItems& code_items,
+                                           std::vector<LayoutType>* layout,
+                                           std::string* error_msg) const {
+  ProfileCompilationInfo* info = dex_layout_->GetProfileInfo();
+  // Items that no method refers to are unused, kLayoutTypeCount merges with any other type.
+  layout->assign(code_items.offsets.size(), LayoutType::kLayoutTypeCount);
+  for (ClassAccessor accessor : dex_file_.GetClasses()) {
+    const bool is_profile_class = info->ContainsClass(dex_file_, accessor.GetClassIdx());
+    for (const ClassAccessor::Method& method : accessor.GetMethods()) {
+      if (method.GetCodeItemOffset() == 0u) {
+        continue;
+      }
+      const size_t item = FindItem(code_items.offsets, method.GetCodeItemOffset());
+      if (item == code_items.offsets.size()) {
+        *error_msg = StringPrintf("Method %u has code item at %x outside the code item section",
+                                  method.GetIndex(),
+                                  method.GetCodeItemOffset());
+        return false;
+      }
+      // Separate executed methods (clinits and profiled methods) from unexecuted methods.
+      const bool is_clinit = (method.GetAccessFlags() & kAccConstructor) != 0 &&
+          (method.GetAccessFlags() & kAccStatic) != 0;
+      const bool is_startup_clinit = is_profile_class && is_clinit;
+      using Hotness = ProfileCompilationInfo::MethodHotness;
+      Hotness hotness = info->GetMethodHotness(MethodReference(&dex_file_, method.GetIndex()));
+      LayoutType state = LayoutType::kLayoutTypeUnused;
+      if (hotness.IsHot()) {
+        // Hot code is compiled, maybe one day it won't be accessed. So lay it out together for
+        // now.
+        state = LayoutType::kLayoutTypeHot;
+      } else if (is_startup_clinit || hotness.GetFlags() == Hotness::kFlagStartup) {
+        // Startup clinit or a method that only has the startup flag.
+        state = LayoutType::kLayoutTypeStartupOnly;
+      } else if (is_clinit) {
+        state = LayoutType::kLayoutTypeUsedOnce;
+      } else if (hotness.IsInProfile()) {
+        state = LayoutType::kLayoutTypeSometimesUsed;
+      }
+      (*layout)[item] = MergeLayoutType((*layout)[item], state);
+    }
+  }
+  for (LayoutType& layout_type : *layout) {
+    layout_type = MergeLayoutType(layout_type, LayoutType::kLayoutTypeUnused);
+  }
+  if (VLOG_IS_ON(dex)) {
+    size_t layout_count[static_cast<size_t>(LayoutType::kLayoutTypeCount)] = {};
+    for (LayoutType layout_type : *layout) {
+      ++layout_count[static_cast<size_t>(layout_type)];
+    }
+    for (size_t i = 0; i < static_cast<size_t>(LayoutType::kLayoutTypeCount); ++i) {
+      LOG(INFO) << "Code items in category " << i << " count=" << layout_count[i];
+    }
+  }
+  return true;
+}
+
+std::vector<uint32_t> StreamingDexWriter::GetClassDefOrder() const {
+  ProfileCompilationInfo* info = dex_layout_->GetProfileInfo();
+  std::vector<uint32_t> class_defs;
+  class_defs.reserve(dex_file_.NumClassDefs());
+  for (uint32_t i = 0; i < dex_file_.NumClassDefs(); ++i) {
+    if (info->ContainsClass(dex_file_, dex_file_.GetClassDef(i).class_idx_)) {
+      class_defs.push_back(i);
+    }
+  }
+  for (uint32_t i = 0; i < dex_file_.NumClassDefs(); ++i) {
+    if (!info->ContainsClass(dex_file_, dex_file_.GetClassDef(i).class_idx_)) {
+      class_defs.push_back(i);
+    }
+  }
+  return class_defs;
+}
+
+bool StreamingDexWriter::WriteStringDatas(const SectionItems& string_datas,
+                                          uint8_t* out,
+                                          std::string* error_msg) const {
+  const std::vector<uint32_t>& offsets = string_datas.offsets;
+  // String data is byte aligned, so the section keeps its size in any order. Zero means that the
+  // item is not placed yet, the header is always at offset zero.
+  std::vector<uint32_t> new_offsets(offsets.size(), 0u);
+  uint32_t offset = string_datas.begin;
+  auto place = [&](size_t item) {
+    memcpy(out + offset, dex_file_.Begin() + offsets[item], string_datas.sizes[item]);
+    new_offsets[item] = offset;
+    offset += string_datas.sizes[item];
+  };
+  std::vector<size_t> string_id_items(dex_file_.NumStringIds());
+  for (uint32_t string_idx : GetStringIdOrder()) {
+    const dex::StringId& string_id = dex_file_.GetStringId(dex::StringIndex(string_idx));
+    const size_t item = FindItem(offsets, string_id.string_data_off_);
+    if (item == offsets.size()) {
+      *error_msg = StringPrintf("String %u has data at %x outside the string data section",
+                                string_idx,
+                                string_id.string_data_off_);
+      return false;
+    }
+    string_id_items[string_idx] = item;
+    if (new_offsets[item] == 0u) {
+      place(item);
+    }
+  }
+  // Keep the string data that no string id refers to.
+  for (size_t item = 0; item < offsets.size(); ++item) {
+    if (new_offsets[item] == 0u) {
+      place(item);
+    }
+  }
+  CHECK_EQ(offset, string_datas.end);
+  dex::StringId* string_ids =
+      reinterpret_cast<dex::StringId*>(out + dex_file_.GetHeader().string_ids_off_);
+  for (size_t i = 0; i < string_id_items.size(); ++i) {
+    string_ids[i].string_data_off_ = new_offsets[string_id_items[i]];
+  }
+  return true;
+}
+
+bool StreamingDexWriter::WriteCodeItems(const SectionItems& code_items,
+                                        uint8_t* out,
+                                        std::vector<uint32_t>* new_offsets,
+                                        DexLayoutSection* code_section,
+                                        std::string* error_msg) const {
+  std::vector<LayoutType> layout;
+  if (!GetCodeItemLayout(code_items, &layout, error_msg)) {
+    return false;
+  }
+  // Stable sort to preserve any existing locality that might be there.
+  std::vector<size_t> order(code_items.offsets.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&layout](size_t a, size_t b) {
+    return layout[a] < layout[b];
+  });
+  // Code items are word aligned, so the section grows if the new last item is padded less than
+  // the old one, and the next section may start right after it.
+  auto section_end = [&]() {
+    uint32_t end = code_items.begin;
+    for (size_t item : order) {
+      end = RoundUp(end, DexWriter::kDexSectionWordAlignment) + code_items.sizes[item];
+    }
+    return end;
+  };
+  uint32_t end = section_end();
+  if (end > code_items.limit) {
+    // End with the item of the last layout type that needs the most padding.
+    auto padding = [&](size_t item) {
+      return RoundUp(code_items.sizes[item], DexWriter::kDexSectionWordAlignment) -
+          code_items.sizes[item];
+    };
+    auto last_type = std::find_if(order.begin(), order.end(), [&](size_t item) {
+      return layout[item] == layout[order.back()];
+    });
+    auto most_padded = std::max_element(last_type, order.end(), [&](size_t a, size_t b) {
+      return padding(a) < padding(b);
+    });
+    std::rotate(most_padded, most_padded + 1, order.end());
+    end = section_end();
+  }
+  if (end > code_items.limit) {
+    *error_msg = StringPrintf("Reordered code items end at %x, past the next section at %x",
+                              end,
+                              code_items.limit);
+    return false;
+  }
+  // Clear the old padding between the items.
+  std::fill(out + code_items.begin, out + code_items.end, 0u);
+  new_offsets->resize(order.size());
+  uint32_t offset = code_items.begin;
+  for (size_t item : order) {
+    offset = RoundUp(offset, DexWriter::kDexSectionWordAlignment);
+    memcpy(out + offset, dex_file_.Begin() + code_items.offsets[item], code_items.sizes[item]);
+    (*new_offsets)[item] = offset;
+    code_section->parts_[static_cast<size_t>(layout[item])].CombineSection(
+        offset,
+        offset + code_items.sizes[item]);
+    offset += code_items.sizes[item];
+  }
+  return true;
+}
+
+bool StreamingDexWriter::WriteClassDatas(const SectionItems& class_datas,
+                                         const SectionItems& code_items,
+                                         const std::vector<uint32_t>& new_code_item_offsets,
+                                         DexContainer::Section* output,
+                                         std::string* error_msg) const {
+  // The code item offsets are ULEB128 encoded, so the class data changes size with them and is
+  // encoded into a separate buffer first.
+  std::vector<uint8_t> data;
+  data.reserve(class_datas.end - class_datas.begin);
+  bool offsets_valid = true;
+  auto encode = [&](uint32_t value, bool is_code_item_offset) {
+    if (is_code_item_offset && value != 0u) {
+      const size_t item = FindItem(code_items.offsets, value);
+      if (item == code_items.offsets.size()) {
+        offsets_valid = false;
+      } else {
+        value = new_code_item_offsets[item];
+      }
+    }
+    EncodeUnsignedLeb128(&data, value);
+  };
+  const std::vector<uint32_t>& offsets = class_datas.offsets;
+  // Offsets into `data` plus one, zero means that the item is not placed yet.
+  std::vector<uint32_t> new_offsets(offsets.size(), 0u);
+  auto place = [&](size_t item) {
+    new_offsets[item] = data.size() + 1u;
+    VisitClassData(dex_file_.Begin() + offsets[item], encode);
+  };
+  std::vector<size_t> class_def_items(dex_file_.NumClassDefs(), offsets.size());
+  for (uint32_t class_def_idx : GetClassDefOrder()) {
+    const uint32_t class_data_off = dex_file_.GetClassDef(class_def_idx).class_data_off_;
+    if (class_data_off == 0u) {
+      continue;
+    }
+    const size_t item = FindItem(offsets, class_data_off);
+    if (item == offsets.size()) {
+      *error_msg = StringPrintf("Class def %u has class data at %x outside the class data section",
+                                class_def_idx,
+                                class_data_off);
+      return false;
+    }
+    class_def_items[class_def_idx] = item;
+    if (new_offsets[item] == 0u) {
+      place(item);
+    }
+  }
+  // Keep the class data that no class def refers to.
+  for (size_t item = 0; item < offsets.size(); ++item) {
+    if (new_offsets[item] == 0u) {
+      place(item);
+    }
+  }
+  if (!offsets_valid) {
+    *error_msg = "Class data refers to a code item outside the code item section";
+    return false;
+  }
+
+  uint32_t begin = class_datas.begin;
+  if (data.size() > class_datas.limit - class_datas.begin) {
+    // The class data grew past the next section, move it to the end of the data section. The
+    // section it leaves behind becomes padding.
+    const DexFile::Header& header = dex_file_.GetHeader();
+    if (header.data_off_ + header.data_size_ != header.file_size_) {
+      *error_msg = "Class data does not fit its section, and the data section is not at the end";
+      return false;
+    }
+    begin = header.file_size_;
+    const uint32_t file_size = RoundUp(begin + data.size(), DexWriter::kDataSectionAlignment);
+    output->Resize(file_size);
+    uint8_t* out = output->Begin();
+    DexFile::Header* out_header = reinterpret_cast<DexFile::Header*>(out);
+    out_header->file_size_ = file_size;
+    out_header->data_size_ = file_size - header.data_off_;
+    // Keep the map sorted by offset.
+    dex::MapList* map = reinterpret_cast<dex::MapList*>(out + header.map_off_);
+    for (uint32_t i = 0; i < map->size_; ++i) {
+      if (map->list_[i].type_ == DexFile::kDexTypeClassDataItem) {
+        map->list_[i].offset_ = begin;
+      }
+    }
+    std::sort(map->list_,
+              map->list_ + map->size_,
+              [](const dex::MapItem& a, const dex::MapItem& b) {
+      return a.offset_ < b.offset_;
+    });
+  }
+  uint8_t* out = output->Begin();
+  std::fill(out + class_datas.begin, out + class_datas.end, 0u);
+  std::copy(data.begin(), data.end(), out + begin);
+  dex::ClassDef* class_defs =
+      reinterpret_cast<dex::ClassDef*>(out + dex_file_.GetHeader().class_defs_off_);
+  for (size_t i = 0; i < class_def_items.size(); ++i) {
+    if (class_def_items[i] != offsets.size()) {
+      class_defs[i].class_data_off_ = begin + new_offsets[class_def_items[i]] - 1u;
+    }
+  }
+  return true;
+}
+
+bool StreamingDexWriter::Write(DexContainer* output, std::string* error_msg) {
+  const DexFile::Header& header = dex_file_.GetHeader();
+  if (header.link_size_ != 0u) {
+    *error_msg = "Link data is not supported";
+    return false;
+  }
+  SectionItems string_datas;
+  SectionItems code_items;
+  SectionItems class_datas;
+  if (!FindSectionItems(DexFile::kDexTypeStringDataItem, &string_datas, error_msg) ||
+      !FindSectionItems(DexFile::kDexTypeCodeItem, &code_items, error_msg) ||
+      !FindSectionItems(DexFile::kDexTypeClassDataItem, &class_datas, error_msg)) {
+    return false;
+  }
+
+  // Start from a copy of the input, everything else stays where it is.
+  DexContainer::Section* const main_section = output->GetMainSection();
+  main_section->Clear();
+  main_section->Resize(header.file_size_);
+  std::copy_n(dex_file_.Begin(), header.file_size_, main_section->Begin());
+
+  std::vector<uint32_t> new_code_item_offsets;
+  DexLayoutSection code_section;
+  if (!WriteStringDatas(string_datas, main_section->Begin(), error_msg) ||
+      !WriteCodeItems(code_items,
+                      main_section->Begin(),
+                      &new_code_item_offsets,
+                      &code_section,
+                      error_msg) ||
+      !WriteClassDatas(class_datas, code_items, new_code_item_offsets, main_section, error_msg)) {
+    return false;
+  }
+  dex_layout_->GetSections().sections_[static_cast<size_t>(
+      DexLayoutSections::SectionType::kSectionTypeCode)] = code_section;
+
+  if (dex_layout_->GetOptions().update_checksum_) {
+    DexFile::Header* out_header = reinterpret_cast<DexFile::Header*>(main_section->Begin());
+    out_header->checksum_ = DexFile::CalculateChecksum(main_section->Begin(),
+                                                       out_header->file_size_);
+  }
+  return true;
+}
+
+bool StreamingDexWriter::Output(DexLayout* dex_layout,
+                                const DexFile& dex_file,
+                                std::unique_ptr<DexContainer>* container,
+                                std::string* error_msg) {
+  CHECK(dex_layout != nullptr);
+  CHECK(dex_layout->GetProfileInfo() != nullptr);
+  if (!dex_file.IsStandardDexFile() ||
+      dex_layout->GetOptions().compact_dex_level_ != CompactDexLevel::kCompactDexLevelNone) {
+    *error_msg = "Only standard dex is supported";
+    return false;
+  }
+  DCHECK(container != nullptr);
+  if (*container == nullptr) {
+    container->reset(new DexWriter::Container());
+  }
+  StreamingDexWriter writer(dex_layout, dex_file);
+  return writer.Write(container->get(), error_msg);
+}
+
+}  // namespace art
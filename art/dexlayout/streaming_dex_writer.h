@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Header file of a dex writer that lays out standard dex files without the dex IR.
+ */
+
+#ifndef ART_DEXLAYOUT_STREAMING_DEX_WRITER_H_
+#define ART_DEXLAYOUT_STREAMING_DEX_WRITER_H_
+
+#include <memory>  // For unique_ptr
+#include <string>
+#include <vector>
+
+#include "dex/dex_file.h"
+#include "dex/dex_file_layout.h"
+#include "dex_container.h"
+
+namespace art {
+
+class DexLayout;
+
+// Writes the profile guided layout of a standard dex file straight from the input, without
+// building the dex IR. The output is a copy of the input where the string data, code items and
+// class data are reordered within their sections and the offsets to them are updated. Besides the
+// output, this only needs a few words per item, and it reads the input in a fixed number of
+// passes.
+class StreamingDexWriter {
+ public:
+  // Returns false if the input has a layout that this writer does not handle, for instance link
+  // data or code items that do not fit their section once reordered. The caller is expected to
+  // fall back to DexWriter then, after dropping the partially written container.
+  static bool Output(DexLayout* dex_layout,
+                     const DexFile& dex_file,
+                     std::unique_ptr<DexContainer>* container,
+                     std::string* error_msg) WARN_UNUSED;
+
+ private:
+  // The items of a data section, in file order.
+  struct SectionItems {
+    uint32_t begin = 0u;
+    // End of the last item.
+    uint32_t end = 0u;
+    // Start of the next section, the items may grow up to here.
+    uint32_t limit = 0u;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> sizes;
+  };
+
+  StreamingDexWriter(DexLayout* dex_layout, const DexFile& dex_file);
+
+  bool Write(DexContainer* output, std::string* error_msg);
+
+  bool FindSectionItems(DexFile::MapItemType type,
+                        SectionItems* items,
+                        std::string* error_msg) const;
+
+  // Returns the string ids in the order their string data is laid out, like
+  // DexLayout::LayoutStringData.
+  std::vector<uint32_t> GetStringIdOrder() const;
+  // Returns the layout type of each code item, like DexLayout::LayoutCodeItems.
+  bool GetCodeItemLayout(const SectionItems& code_items,
+                         std::vector<LayoutType>* layout,
+                         std::string* error_msg) const;
+  // Returns the class defs in the order their class data is laid out, like
+  // DexLayout::LayoutClassDefsAndClassData.
+  std::vector<uint32_t> GetClassDefOrder() const;
+
+  bool WriteStringDatas(const SectionItems& string_datas,
+                        uint8_t* out,
+                        std::string* error_msg) const;
+  bool WriteCodeItems(const SectionItems& code_items,
+                      uint8_t* out,
+                      std::vector<uint32_t>* new_offsets,
+                      DexLayoutSection* code_section,
+                      std::string* error_msg) const;
+  bool WriteClassDatas(const SectionItems& class_datas,
+                       const SectionItems& code_items,
+                       const std::vector<uint32_t>& new_code_item_offsets,
+                       DexContainer::Section* output,
+                       std::string* error_msg) const;
+
+  DexLayout* const dex_layout_;
+  const DexFile& dex_file_;
+
+  DISALLOW_COPY_AND_ASSIGN(StreamingDexWriter);
+};
+
+}  // namespace art
+
+#endif  // ART_DEXLAYOUT_STREAMING_DEX_WRITER_H_
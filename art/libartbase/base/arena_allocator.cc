@@ -25,6 +25,7 @@
 #include <android-base/logging.h>
 
 #include "mman.h"
+#include "utils.h"
 
 namespace art {
 
@@ -322,6 +323,124 @@ bool ArenaAllocator::Contains(const void* ptr) const {
   return false;
 }
 
+void ArenaPoolStats::Dump(std::ostream& os) const {
+  os << "arenas allocated: " << num_allocations
+     << ", reused: " << num_reused;
+  if (num_allocations != 0u) {
+    os << " (" << std::fixed << std::setprecision(1)
+       << 100.0 * num_reused / num_allocations << "%)";
+  }
+  os << ", total: " << PrettySize(bytes_total)
+     << ", peak: " << PrettySize(peak_bytes_total)
+     << ", free: " << PrettySize(bytes_free)
+     << ", returned: " << PrettySize(bytes_returned) << "\n";
+}
+
+ArenaFreeLists::ArenaFreeLists() : recent_peak_bytes_in_use_(0u), high_water_mark_(0u) {
+  free_arenas_.fill(nullptr);
+}
+
+size_t ArenaFreeLists::SizeClassOf(size_t size) {
+  static_assert(IsPowerOfTwo(arena_allocator::kArenaDefaultSize), "Expected power of two");
+  if (size <= arena_allocator::kArenaDefaultSize) {
+    return 0u;
+  }
+  size_t size_class =
+      MinimumBitsToStore(size - 1u) -
+      static_cast<size_t>(WhichPowerOf2(arena_allocator::kArenaDefaultSize));
+  return std::min(size_class, kNumSizeClasses - 1u);
+}
+
+void ArenaFreeLists::RecordBytesInUse() {
+  stats_.peak_bytes_total = std::max(stats_.peak_bytes_total, stats_.bytes_total);
+  recent_peak_bytes_in_use_ = std::max(recent_peak_bytes_in_use_, BytesInUse());
+}
+
+Arena* ArenaFreeLists::Take(size_t size) {
+  ++stats_.num_allocations;
+  // Arenas of the size classes above the one of `size` are all large enough, but the arenas of
+  // its own size class and of the last size class may be too small.
+  for (size_t size_class = SizeClassOf(size); size_class != kNumSizeClasses; ++size_class) {
+    Arena* arena = free_arenas_[size_class];
+    if (arena != nullptr && LIKELY(arena->Size() >= size)) {
+      free_arenas_[size_class] = arena->next_;
+      arena->next_ = nullptr;
+      ++stats_.num_reused;
+      stats_.bytes_free -= arena->Size();
+      RecordBytesInUse();
+      return arena;
+    }
+  }
+  return nullptr;
+}
+
+void ArenaFreeLists::AddNewArena(const Arena* arena) {
+  stats_.bytes_total += arena->Size();
+  RecordBytesInUse();
+}
+
+void ArenaFreeLists::Put(Arena* first) {
+  while (first != nullptr) {
+    Arena* arena = first;
+    first = first->next_;
+    size_t size_class = SizeClassOf(arena->Size());
+    arena->next_ = free_arenas_[size_class];
+    free_arenas_[size_class] = arena;
+    stats_.bytes_free += arena->Size();
+  }
+}
+
+void ArenaFreeLists::RecordDeleted(size_t bytes) {
+  stats_.bytes_total -= bytes;
+  stats_.bytes_returned += bytes;
+}
+
+Arena* ArenaFreeLists::TakeAll() {
+  Arena* all = nullptr;
+  for (Arena*& first : free_arenas_) {
+    while (first != nullptr) {
+      Arena* arena = first;
+      first = first->next_;
+      arena->next_ = all;
+      all = arena;
+    }
+  }
+  RecordDeleted(stats_.bytes_free);
+  stats_.bytes_free = 0u;
+  return all;
+}
+
+Arena* ArenaFreeLists::TakeExcess() {
+  // Remember the peaks of the bytes in use over the last few calls, so that we keep enough free
+  // arenas for the compilations we are likely to see again but let a one-off large compilation
+  // fade out.
+  high_water_mark_ = std::max(recent_peak_bytes_in_use_, high_water_mark_ / 4u * 3u);
+  recent_peak_bytes_in_use_ = BytesInUse();
+  size_t bytes_to_keep = (high_water_mark_ > BytesInUse()) ? high_water_mark_ - BytesInUse() : 0u;
+  Arena* excess = nullptr;
+  for (size_t size_class = kNumSizeClasses; size_class != 0u; ) {
+    --size_class;
+    Arena*& first = free_arenas_[size_class];
+    while (first != nullptr && stats_.bytes_free > bytes_to_keep) {
+      Arena* arena = first;
+      first = first->next_;
+      arena->next_ = excess;
+      excess = arena;
+      stats_.bytes_free -= arena->Size();
+      RecordDeleted(arena->Size());
+    }
+  }
+  return excess;
+}
+
+void ArenaFreeLists::DeleteArenaChain(Arena* first) {
+  while (first != nullptr) {
+    Arena* next = first->next_;
+    delete first;
+    first = next;
+  }
+}
+
 MemStats::MemStats(const char* name,
                    const ArenaAllocatorStats* stats,
                    const Arena* first_arena,
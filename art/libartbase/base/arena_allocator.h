@@ -20,6 +20,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <array>
+#include <iosfwd>
+
 #include "bit_utils.h"
 #include "debug_stack.h"
 #include "dchecked_vector.h"
@@ -214,6 +217,7 @@ class Arena {
   Arena* next_;
   friend class MallocArenaPool;
   friend class MemMapArenaPool;
+  friend class ArenaFreeLists;
   friend class ArenaAllocator;
   friend class ArenaStack;
   friend class ScopedArenaAllocator;
@@ -225,6 +229,90 @@ class Arena {
   DISALLOW_COPY_AND_ASSIGN(Arena);
 };
 
+// Statistics of the arenas of an ArenaPool.
+struct ArenaPoolStats {
+  // Number of arenas handed out, and how many of them were reused free arenas.
+  size_t num_allocations = 0u;
+  size_t num_reused = 0u;
+  // Bytes of all arenas of the pool, free or in use, now and at the peak.
+  size_t bytes_total = 0u;
+  size_t peak_bytes_total = 0u;
+  // Bytes of the free arenas.
+  size_t bytes_free = 0u;
+  // Bytes of the arenas deleted to return their memory to the system.
+  size_t bytes_returned = 0u;
+
+  void Dump(std::ostream& os) const;
+};
+
+// The free arenas of an ArenaPool, segregated by size so that a request takes the smallest free
+// arena that fits rather than whatever was freed last. This keeps the large arenas left behind
+// by big compilations for the requests that need them.
+//
+// The free lists also keep a high-water mark of the bytes in use, decayed by each TakeExcess(),
+// to decide how many free arenas are worth keeping around.
+//
+// Not thread safe, the pool must hold its lock.
+class ArenaFreeLists {
+ public:
+  // Size class 0 holds the arenas of up to the default arena size, size class i > 0 the arenas
+  // of up to (default size << i) bytes and the last size class all larger arenas.
+  static constexpr size_t kNumSizeClasses = 8;
+
+  ArenaFreeLists();
+
+  // Removes and returns a free arena of at least `size` bytes, or null if there is none.
+  Arena* Take(size_t size);
+  // Records an arena created by the pool because Take() returned null.
+  void AddNewArena(const Arena* arena);
+  // Adds a chain of arenas to the free lists.
+  void Put(Arena* first);
+  // Records that the pool deleted arenas of `bytes` bytes instead of putting them back.
+  void RecordDeleted(size_t bytes);
+  // Removes and returns all free arenas, as a chain.
+  Arena* TakeAll();
+  // Decays the high-water mark of the bytes in use and removes and returns, as a chain, the free
+  // arenas we no longer expect to need, largest first.
+  Arena* TakeExcess();
+
+  template <typename Visitor>
+  void VisitFreeArenas(const Visitor& visitor) const;
+
+  const ArenaPoolStats& GetStats() const {
+    return stats_;
+  }
+
+  // Deletes a chain of arenas, to be called without holding the pool lock where possible.
+  static void DeleteArenaChain(Arena* first);
+
+ private:
+  static size_t SizeClassOf(size_t size);
+
+  size_t BytesInUse() const {
+    return stats_.bytes_total - stats_.bytes_free;
+  }
+
+  void RecordBytesInUse();
+
+  std::array<Arena*, kNumSizeClasses> free_arenas_;
+  // Peak of the bytes in use since the last TakeExcess().
+  size_t recent_peak_bytes_in_use_;
+  // The recent peaks of the bytes in use, decayed by each TakeExcess().
+  size_t high_water_mark_;
+  ArenaPoolStats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(ArenaFreeLists);
+};
+
+template <typename Visitor>
+void ArenaFreeLists::VisitFreeArenas(const Visitor& visitor) const {
+  for (Arena* first : free_arenas_) {
+    for (Arena* arena = first; arena != nullptr; arena = arena->next_) {
+      visitor(arena);
+    }
+  }
+}
+
 class ArenaPool {
  public:
   virtual ~ArenaPool() = default;
@@ -236,6 +324,11 @@ class ArenaPool {
   virtual void LockReclaimMemory() = 0;
   // Trim the maps in arenas by madvising, used by JIT to reduce memory usage.
   virtual void TrimMaps() = 0;
+  // Delete the free arenas that recent use suggests will not be needed again and trim the others
+  // where possible. Meant to be called when the user of the pool becomes idle, e.g. the JIT once
+  // it has no pending compilations.
+  virtual void TrimIdle() = 0;
+  virtual ArenaPoolStats GetStats() const = 0;
 
  protected:
   ArenaPool() = default;
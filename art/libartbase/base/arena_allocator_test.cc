@@ -349,5 +349,58 @@ TEST_F(ArenaAllocatorTest, ReallocAlignment) {
   }
 }
 
+TEST_F(ArenaAllocatorTest, PoolSizeClasses) {
+  if (arena_allocator::kArenaAllocatorPreciseTracking) {
+    return;  // Arenas are not reused when tracking.
+  }
+  MallocArenaPool pool;
+  const size_t small_size = arena_allocator::kArenaDefaultSize;
+  const size_t large_size = 8 * arena_allocator::kArenaDefaultSize;
+  Arena* small_arena = pool.AllocArena(small_size);
+  Arena* large_arena = pool.AllocArena(large_size);
+  pool.FreeArenaChain(small_arena);
+  pool.FreeArenaChain(large_arena);
+
+  // A small request should not take the large arena even though it was freed last.
+  EXPECT_EQ(small_arena, pool.AllocArena(small_size));
+  EXPECT_EQ(large_arena, pool.AllocArena(2 * small_size));
+  ArenaPoolStats stats = pool.GetStats();
+  EXPECT_EQ(4u, stats.num_allocations);
+  EXPECT_EQ(2u, stats.num_reused);
+  EXPECT_EQ(small_size + large_size, stats.bytes_total);
+  EXPECT_EQ(0u, stats.bytes_free);
+  pool.FreeArenaChain(small_arena);
+  pool.FreeArenaChain(large_arena);
+}
+
+TEST_F(ArenaAllocatorTest, PoolTrimIdle) {
+  if (arena_allocator::kArenaAllocatorPreciseTracking) {
+    return;  // Arenas are not reused when tracking.
+  }
+  MallocArenaPool pool;
+  static constexpr size_t kNumArenas = 4u;
+  const size_t total_size = kNumArenas * arena_allocator::kArenaDefaultSize;
+  Arena* arenas[kNumArenas];
+  for (Arena*& arena : arenas) {
+    arena = pool.AllocArena(arena_allocator::kArenaDefaultSize);
+  }
+  for (Arena* arena : arenas) {
+    pool.FreeArenaChain(arena);
+  }
+
+  // The arenas were all in use recently, they should be kept.
+  pool.TrimIdle();
+  EXPECT_EQ(total_size, pool.GetStats().bytes_free);
+
+  // Without further use, the high-water mark decays and the arenas get deleted.
+  for (size_t i = 0; i != 100u; ++i) {
+    pool.TrimIdle();
+  }
+  ArenaPoolStats stats = pool.GetStats();
+  EXPECT_EQ(0u, stats.bytes_free);
+  EXPECT_EQ(0u, stats.bytes_total);
+  EXPECT_EQ(total_size, stats.peak_bytes_total);
+  EXPECT_EQ(total_size, stats.bytes_returned);
+}
 
 }  // namespace art
@@ -82,7 +82,7 @@ void Arena::Reset() {
   }
 }
 
-MallocArenaPool::MallocArenaPool() : free_arenas_(nullptr) {
+MallocArenaPool::MallocArenaPool() {
 }
 
 MallocArenaPool::~MallocArenaPool() {
@@ -90,11 +90,7 @@ MallocArenaPool::~MallocArenaPool() {
 }
 
 void MallocArenaPool::ReclaimMemory() {
-  while (free_arenas_ != nullptr) {
-    Arena* arena = free_arenas_;
-    free_arenas_ = free_arenas_->next_;
-    delete arena;
-  }
+  ArenaFreeLists::DeleteArenaChain(free_arenas_.TakeAll());
 }
 
 void MallocArenaPool::LockReclaimMemory() {
@@ -106,13 +102,12 @@ Arena* MallocArenaPool::AllocArena(size_t size) {
   Arena* ret = nullptr;
   {
     std::lock_guard<std::mutex> lock(lock_);
-    if (free_arenas_ != nullptr && LIKELY(free_arenas_->Size() >= size)) {
-      ret = free_arenas_;
-      free_arenas_ = free_arenas_->next_;
-    }
+    ret = free_arenas_.Take(size);
   }
   if (ret == nullptr) {
     ret = new MallocArena(size);
+    std::lock_guard<std::mutex> lock(lock_);
+    free_arenas_.AddNewArena(ret);
   }
   ret->Reset();
   return ret;
@@ -122,15 +117,29 @@ void MallocArenaPool::TrimMaps() {
   // Nop, because there is no way to do madvise here.
 }
 
+void MallocArenaPool::TrimIdle() {
+  Arena* excess;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    excess = free_arenas_.TakeExcess();
+  }
+  ArenaFreeLists::DeleteArenaChain(excess);
+}
+
 size_t MallocArenaPool::GetBytesAllocated() const {
   size_t total = 0;
   std::lock_guard<std::mutex> lock(lock_);
-  for (Arena* arena = free_arenas_; arena != nullptr; arena = arena->next_) {
+  free_arenas_.VisitFreeArenas([&](const Arena* arena) {
     total += arena->GetBytesAllocated();
-  }
+  });
   return total;
 }
 
+ArenaPoolStats MallocArenaPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return free_arenas_.GetStats();
+}
+
 void MallocArenaPool::FreeArenaChain(Arena* first) {
   if (kRunningOnMemoryTool) {
     for (Arena* arena = first; arena != nullptr; arena = arena->next_) {
@@ -140,22 +149,19 @@ void MallocArenaPool::FreeArenaChain(Arena* first) {
 
   if (arena_allocator::kArenaAllocatorPreciseTracking) {
     // Do not reuse arenas when tracking.
-    while (first != nullptr) {
-      Arena* next = first->next_;
-      delete first;
-      first = next;
+    size_t bytes = 0u;
+    for (Arena* arena = first; arena != nullptr; arena = arena->next_) {
+      bytes += arena->Size();
     }
+    ArenaFreeLists::DeleteArenaChain(first);
+    std::lock_guard<std::mutex> lock(lock_);
+    free_arenas_.RecordDeleted(bytes);
     return;
   }
 
   if (first != nullptr) {
-    Arena* last = first;
-    while (last->next_ != nullptr) {
-      last = last->next_;
-    }
     std::lock_guard<std::mutex> lock(lock_);
-    last->next_ = free_arenas_;
-    free_arenas_ = first;
+    free_arenas_.Put(first);
   }
 }
 
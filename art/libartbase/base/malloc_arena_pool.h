@@ -34,9 +34,11 @@ class MallocArenaPool final : public ArenaPool {
   void LockReclaimMemory() override;
   // Is a nop for malloc pools.
   void TrimMaps() override;
+  void TrimIdle() override;
+  ArenaPoolStats GetStats() const override;
 
  private:
-  Arena* free_arenas_;
+  ArenaFreeLists free_arenas_;
   // Use a std::mutex here as Arenas are at the bottom of the lock hierarchy when malloc is used.
   mutable std::mutex lock_;
 
@@ -505,6 +505,12 @@ class OatDumper {
       os << oat_file_.GetBssGcRoots().size() << " GC roots.\n\n";
     }
 
+    // Summarize how much CodeInfo sharing saves. This walks every compiled method, so it is
+    // left out of the header-only dump.
+    if (!options_.dump_header_only_) {
+      DumpCodeInfoDedupeStats(os);
+    }
+
     // Dumping the dex file overview is compact enough to do even if header only.
     for (size_t i = 0; i < oat_dex_files_.size(); i++) {
       const OatDexFile* oat_dex_file = oat_dex_files_[i];
@@ -830,6 +836,38 @@ class OatDumper {
   }
 
  private:
+  void DumpCodeInfoDedupeStats(std::ostream& os) {
+    std::set<const uint8_t*> code_infos;
+    size_t num_methods = 0;
+    CodeInfo::DedupeStats stats;
+    for (const OatDexFile* oat_dex_file : oat_dex_files_) {
+      CHECK(oat_dex_file != nullptr);
+      std::string error_msg;
+      const DexFile* const dex_file = OpenDexFile(oat_dex_file, &error_msg);
+      if (dex_file == nullptr) {
+        continue;  // The error is reported when dumping the dex file overview.
+      }
+      for (ClassAccessor accessor : dex_file->GetClasses()) {
+        const OatFile::OatClass oat_class = oat_dex_file->GetOatClass(accessor.GetClassDefIndex());
+        uint32_t class_method_index = 0;
+        for (const ClassAccessor::Method& method : accessor.GetMethods()) {
+          const OatFile::OatMethod oat_method = oat_class.GetOatMethod(class_method_index++);
+          CodeItemDataAccessor code_item_accessor(*dex_file, method.GetCodeItem());
+          if (IsMethodGeneratedByOptimizingCompiler(oat_method, code_item_accessor)) {
+            ++num_methods;
+            if (code_infos.insert(oat_method.GetVmapTable()).second) {
+              CodeInfo::CollectDedupeStats(oat_method.GetVmapTable(), &stats);
+            }
+          }
+        }
+      }
+    }
+    os << "CODE INFO:\n";
+    os << num_methods << " compiled methods, ";
+    stats.Dump(os);
+    os << "\n\n";
+  }
+
   void AddAllOffsets() {
     // We don't know the length of the code for each method, but we need to know where to stop
     // when disassembling. What we do know is that a region of code will be followed by some other
@@ -34,12 +34,17 @@
 
 #include "jvmti_weak_table.h"
 
+#include <algorithm>
 #include <limits>
+#include <utility>
+#include <vector>
 
 #include <android-base/logging.h>
 
 #include "art_jvmti.h"
+#include "barrier.h"
 #include "gc/allocation_listener.h"
+#include "gc/heap.h"
 #include "instrumentation.h"
 #include "jni/jni_env_ext-inl.h"
 #include "jvmti_allocator.h"
@@ -47,6 +52,7 @@
 #include "mirror/object.h"
 #include "nativehelper/scoped_local_ref.h"
 #include "runtime.h"
+#include "thread_pool.h"
 
 namespace openjdkjvmti {
 
@@ -76,6 +82,83 @@ void JvmtiWeakTable<T>::UpdateTableWithReadBarrier() {
   UpdateTableWith<decltype(WithReadBarrierUpdater), kIgnoreNull>(WithReadBarrierUpdater);
 }
 
+template <typename T>
+void JvmtiWeakTable<T>::EnableTagIndex() {
+  if constexpr (kSupportsTagIndex) {
+    if (!tag_index_enabled_) {
+      for (TagMapEntry& entry : tagged_objects_) {
+        AddToTagIndex(&entry);
+      }
+      tag_index_enabled_ = true;
+    }
+    tag_index_used_since_sweep_ = true;
+  }
+}
+
+template <typename T>
+void JvmtiWeakTable<T>::SweepTagIndex() {
+  if constexpr (kSupportsTagIndex) {
+    if (!tag_index_enabled_) {
+      return;
+    }
+    if (!tag_index_used_since_sweep_) {
+      // Nobody looked up tags for a whole GC cycle, drop the index until the next lookup.
+      TagIndex().swap(tag_index_);
+      tag_index_enabled_ = false;
+    }
+    tag_index_used_since_sweep_ = false;
+  }
+}
+
+template <typename T>
+bool JvmtiWeakTable<T>::CheckTagIndex() {
+  art::Thread* self = art::Thread::Current();
+  art::MutexLock mu(self, allow_disallow_lock_);
+  if constexpr (kSupportsTagIndex) {
+    if (!tag_index_enabled_) {
+      return true;
+    }
+    size_t indexed = 0;
+    for (const auto& index_entry : tag_index_) {
+      for (TagMapEntry* entry : index_entry.second) {
+        if (index_entry.first != entry->second) {
+          return false;
+        }
+      }
+      indexed += index_entry.second.size();
+    }
+    if (indexed != tagged_objects_.size()) {
+      return false;
+    }
+    for (TagMapEntry& entry : tagged_objects_) {
+      auto index_it = tag_index_.find(entry.second);
+      if (index_it == tag_index_.end() || index_it->second.count(&entry) != 1u) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <typename T>
+void JvmtiWeakTable<T>::AddToTagIndex(TagMapEntry* entry) {
+  if constexpr (kSupportsTagIndex) {
+    tag_index_[entry->second].insert(entry);
+  }
+}
+
+template <typename T>
+void JvmtiWeakTable<T>::RemoveFromTagIndex(TagMapEntry* entry) {
+  if constexpr (kSupportsTagIndex) {
+    auto it = tag_index_.find(entry->second);
+    DCHECK(it != tag_index_.end());
+    it->second.erase(entry);
+    if (it->second.empty()) {
+      tag_index_.erase(it);
+    }
+  }
+}
+
 template <typename T>
 bool JvmtiWeakTable<T>::GetTagSlowPath(art::Thread* self, art::ObjPtr<art::mirror::Object> obj, T* result) {
   // Under concurrent GC, there is a window between moving objects and sweeping of system
@@ -110,6 +193,10 @@ bool JvmtiWeakTable<T>::RemoveLocked(art::Thread* self, art::ObjPtr<art::mirror:
     if (tag != nullptr) {
       *tag = it->second;
     }
+    if (tag_index_enabled_) {
+      RemoveFromTagIndex(&*it);
+    }
+    art::WriterMutexLock mu(self, table_lock_);
     tagged_objects_.erase(it);
     return true;
   }
@@ -152,7 +239,16 @@ template <typename T>
 bool JvmtiWeakTable<T>::SetLocked(art::Thread* self, art::ObjPtr<art::mirror::Object> obj, T new_tag) {
   auto it = tagged_objects_.find(art::GcRoot<art::mirror::Object>(obj));
   if (it != tagged_objects_.end()) {
-    it->second = new_tag;
+    if (tag_index_enabled_) {
+      RemoveFromTagIndex(&*it);
+    }
+    {
+      art::WriterMutexLock mu(self, table_lock_);
+      it->second = new_tag;
+    }
+    if (tag_index_enabled_) {
+      AddToTagIndex(&*it);
+    }
     return true;
   }
 
@@ -170,8 +266,15 @@ bool JvmtiWeakTable<T>::SetLocked(art::Thread* self, art::ObjPtr<art::mirror::Ob
   }
 
   // New element.
-  auto insert_it = tagged_objects_.emplace(art::GcRoot<art::mirror::Object>(obj), new_tag);
+  std::pair<typename TagMap::iterator, bool> insert_it;
+  {
+    art::WriterMutexLock mu(self, table_lock_);
+    insert_it = tagged_objects_.emplace(art::GcRoot<art::mirror::Object>(obj), new_tag);
+  }
   DCHECK(insert_it.second);
+  if (tag_index_enabled_) {
+    AddToTagIndex(&*insert_it.first);
+  }
   return false;
 }
 
@@ -196,15 +299,108 @@ template <typename T>
 template <bool kHandleNull>
 void JvmtiWeakTable<T>::SweepImpl(art::IsMarkedVisitor* visitor) {
   art::Thread* self = art::Thread::Current();
-  art::MutexLock mu(self, allow_disallow_lock_);
 
   auto IsMarkedUpdater = [&](const art::GcRoot<art::mirror::Object>& original_root ATTRIBUTE_UNUSED,
                              art::mirror::Object* original_obj) {
     return visitor->IsMarked(original_obj);
   };
 
+  size_t num_threads = GetSweepThreadCount(self);
+  if (num_threads > 1) {
+    ParallelSweepImpl<kHandleNull>(IsMarkedUpdater, num_threads);
+    return;
+  }
+
+  art::MutexLock mu(self, allow_disallow_lock_);
   UpdateTableWith<decltype(IsMarkedUpdater),
                   kHandleNull ? kCallHandleNull : kRemoveNull>(IsMarkedUpdater);
+  SweepTagIndex();
+}
+
+template <typename T>
+size_t JvmtiWeakTable<T>::GetSweepThreadCount(art::Thread* self) {
+  {
+    art::MutexLock mu(self, allow_disallow_lock_);
+    if (tagged_objects_.size() < kMinParallelSweepSize) {
+      return 1;
+    }
+  }
+  // Like the collectors, only use the other threads when in the foreground.
+  art::Runtime* runtime = art::Runtime::Current();
+  art::gc::Heap* heap = runtime->GetHeap();
+  if (heap->GetThreadPool() == nullptr || !runtime->InJankPerceptibleProcessState()) {
+    return 1;
+  }
+  return std::min(heap->GetParallelGCThreadCount(), heap->GetThreadPool()->GetThreadCount()) + 1;
+}
+
+template <typename T>
+template <bool kHandleNull, typename Updater>
+void JvmtiWeakTable<T>::ParallelSweepImpl(Updater& updater, size_t num_threads) {
+  art::Thread* self = art::Thread::Current();
+
+  // Each task runs the updater on a range of buckets, and collects the entries to change. The
+  // table itself is not changed until all of them are done.
+  using Update = std::pair<typename TagMap::iterator, art::mirror::Object*>;
+  std::vector<std::vector<Update>> updates(num_threads);
+  size_t bucket_count = 0u;
+  size_t buckets_per_task = 0u;
+  auto update_buckets = [&](size_t task) NO_THREAD_SAFETY_ANALYSIS {
+    size_t begin = std::min(task * buckets_per_task, bucket_count);
+    size_t end = std::min(begin + buckets_per_task, bucket_count);
+    for (size_t bucket = begin; bucket != end; ++bucket) {
+      for (auto local_it = tagged_objects_.begin(bucket);
+           local_it != tagged_objects_.end(bucket);
+           ++local_it) {
+        DCHECK(!local_it->first.IsNull());
+        art::mirror::Object* original_obj =
+            local_it->first.template Read<art::kWithoutReadBarrier>();
+        art::mirror::Object* target_obj = updater(local_it->first, original_obj);
+        if (original_obj != target_obj) {
+          updates[task].emplace_back(tagged_objects_.find(local_it->first), target_obj);
+        }
+      }
+    }
+  };
+
+  // The locks of the thread pool rank above the ones of the table, so the tasks are queued, and
+  // later waited for, without holding them. They wait for the calling thread to lock the table.
+  art::Barrier table_locked(1);
+  art::Barrier tasks_done(0);
+  art::ThreadPool* thread_pool = art::Runtime::Current()->GetHeap()->GetThreadPool();
+  for (size_t task = 1; task != num_threads; ++task) {
+    thread_pool->AddTask(self, new art::FunctionTask([&, task](art::Thread* worker) {
+      table_locked.Increment(worker, 0);
+      update_buckets(task);
+      tasks_done.Pass(worker);
+    }));
+  }
+  thread_pool->SetMaxActiveWorkers(num_threads - 1);
+  thread_pool->StartWorkers(self);
+  {
+    art::MutexLock mu(self, allow_disallow_lock_);
+    {
+      // See UpdateTableWith for the load factor.
+      art::WriterMutexLock mu2(self, table_lock_);
+      float original_max_load_factor = tagged_objects_.max_load_factor();
+      tagged_objects_.max_load_factor(std::numeric_limits<float>::max());
+      bucket_count = tagged_objects_.bucket_count();
+      buckets_per_task = (bucket_count + num_threads - 1) / num_threads;
+      table_locked.Pass(self);
+      update_buckets(0);
+      tasks_done.Increment<art::Barrier::kAllowHoldingLocks>(self, num_threads - 1);
+
+      for (const std::vector<Update>& task_updates : updates) {
+        for (const Update& update : task_updates) {
+          UpdateEntry<kHandleNull ? kCallHandleNull : kRemoveNull>(update.first, update.second);
+        }
+      }
+      tagged_objects_.max_load_factor(original_max_load_factor);
+    }
+    SweepTagIndex();
+  }
+  thread_pool->Wait(self, /* do_work= */ true, /* may_hold_locks= */ true);
+  thread_pool->StopWorkers(self);
 }
 
 template <typename T>
@@ -212,11 +408,11 @@ template <typename Updater, typename JvmtiWeakTable<T>::TableUpdateNullTarget kT
 ALWAYS_INLINE inline void JvmtiWeakTable<T>::UpdateTableWith(Updater& updater) {
   // We optimistically hope that elements will still be well-distributed when re-inserting them.
   // So play with the map mechanics, and postpone rehashing. This avoids the need of a side
-  // vector and two passes.
+  // vector and two passes. Moved objects are re-keyed by extracting and re-inserting their
+  // node, which neither allocates nor invalidates pointers to the entry held by the tag index.
+  art::WriterMutexLock mu(art::Thread::Current(), table_lock_);
   float original_max_load_factor = tagged_objects_.max_load_factor();
   tagged_objects_.max_load_factor(std::numeric_limits<float>::max());
-  // For checking that a max load-factor actually does what we expect.
-  size_t original_bucket_count = tagged_objects_.bucket_count();
 
   for (auto it = tagged_objects_.begin(); it != tagged_objects_.end();) {
     DCHECK(!it->first.IsNull());
@@ -226,15 +422,10 @@ ALWAYS_INLINE inline void JvmtiWeakTable<T>::UpdateTableWith(Updater& updater) {
       if (kTargetNull == kIgnoreNull && target_obj == nullptr) {
         // Ignore null target, don't do anything.
       } else {
-        T tag = it->second;
-        it = tagged_objects_.erase(it);
-        if (target_obj != nullptr) {
-          tagged_objects_.emplace(art::GcRoot<art::mirror::Object>(target_obj), tag);
-          DCHECK_EQ(original_bucket_count, tagged_objects_.bucket_count());
-        } else if (kTargetNull == kCallHandleNull) {
-          HandleNullSweep(tag);
-        }
-        continue;  // Iterator was implicitly updated by erase.
+        auto next = std::next(it);
+        UpdateEntry<kTargetNull>(it, target_obj);
+        it = next;
+        continue;  // Iterator was updated before the entry was moved.
       }
     }
     it++;
@@ -244,6 +435,28 @@ ALWAYS_INLINE inline void JvmtiWeakTable<T>::UpdateTableWith(Updater& updater) {
   // TODO: consider rehash here.
 }
 
+template <typename T>
+template <typename JvmtiWeakTable<T>::TableUpdateNullTarget kTargetNull>
+void JvmtiWeakTable<T>::UpdateEntry(typename TagMap::iterator it,
+                                    art::mirror::Object* target_obj) {
+  // Moved objects are re-keyed by extracting and re-inserting their node, which neither
+  // allocates nor invalidates pointers to the entry held by the tag index. The table's maximum
+  // load factor is raised while doing this, so re-inserting does not rehash either.
+  size_t original_bucket_count = tagged_objects_.bucket_count();
+  T tag = it->second;
+  if (target_obj == nullptr && tag_index_enabled_) {
+    RemoveFromTagIndex(&*it);
+  }
+  auto node = tagged_objects_.extract(it);
+  if (target_obj != nullptr) {
+    node.key() = art::GcRoot<art::mirror::Object>(target_obj);
+    tagged_objects_.insert(std::move(node));
+    DCHECK_EQ(original_bucket_count, tagged_objects_.bucket_count());
+  } else if (kTargetNull == kCallHandleNull) {
+    HandleNullSweep(tag);
+  }
+}
+
 template <typename T>
 template <typename Storage, class Allocator>
 struct JvmtiWeakTable<T>::ReleasableContainer {
@@ -347,30 +560,52 @@ jvmtiError JvmtiWeakTable<T>::GetTaggedObjects(jvmtiEnv* jvmti_env,
   ReleasableContainer<T, JvmtiAllocator<T>> selected_tags(allocator, initial_tag_size);
 
   size_t count = 0;
-  for (auto& pair : tagged_objects_) {
-    bool select;
-    if (tag_count > 0) {
-      select = false;
-      for (size_t i = 0; i != static_cast<size_t>(tag_count); ++i) {
-        if (tags[i] == pair.second) {
-          select = true;
-          break;
-        }
+  auto select_entry = [&](const TagMapEntry& pair) REQUIRES_SHARED(art::Locks::mutator_lock_) {
+    art::ObjPtr<art::mirror::Object> obj = pair.first.template Read<art::kWithReadBarrier>();
+    if (obj != nullptr) {
+      count++;
+      if (object_result_ptr != nullptr) {
+        selected_objects.Pushback(jni_env->AddLocalReference<jobject>(obj));
+      }
+      if (tag_result_ptr != nullptr) {
+        selected_tags.Pushback(pair.second);
       }
-    } else {
-      select = true;
     }
+  };
 
-    if (select) {
-      art::ObjPtr<art::mirror::Object> obj = pair.first.template Read<art::kWithReadBarrier>();
-      if (obj != nullptr) {
-        count++;
-        if (object_result_ptr != nullptr) {
-          selected_objects.Pushback(jni_env->AddLocalReference<jobject>(obj));
+  if (kSupportsTagIndex &&
+      tag_count > 0 &&
+      static_cast<size_t>(tag_count) <= kMaxTagIndexQuerySize) {
+    // Small tag sets are answered from the tag index instead of scanning the whole table.
+    EnableTagIndex();
+    for (size_t i = 0; i != static_cast<size_t>(tag_count); ++i) {
+      if (std::find(tags, tags + i, tags[i]) != tags + i) {
+        continue;  // Duplicate tag, already reported.
+      }
+      auto index_it = tag_index_.find(tags[i]);
+      if (index_it != tag_index_.end()) {
+        for (TagMapEntry* entry : index_it->second) {
+          select_entry(*entry);
         }
-        if (tag_result_ptr != nullptr) {
-          selected_tags.Pushback(pair.second);
+      }
+    }
+  } else {
+    for (auto& pair : tagged_objects_) {
+      bool select;
+      if (tag_count > 0) {
+        select = false;
+        for (size_t i = 0; i != static_cast<size_t>(tag_count); ++i) {
+          if (tags[i] == pair.second) {
+            select = true;
+            break;
+          }
         }
+      } else {
+        select = true;
+      }
+
+      if (select) {
+        select_entry(pair);
       }
     }
   }
@@ -391,11 +626,25 @@ art::ObjPtr<art::mirror::Object> JvmtiWeakTable<T>::Find(T tag) {
   art::MutexLock mu(self, allow_disallow_lock_);
   Wait(self);
 
-  for (auto& pair : tagged_objects_) {
-    if (tag == pair.second) {
-      art::ObjPtr<art::mirror::Object> obj = pair.first.template Read<art::kWithReadBarrier>();
-      if (obj != nullptr) {
-        return obj;
+  if constexpr (kSupportsTagIndex) {
+    EnableTagIndex();
+    auto index_it = tag_index_.find(tag);
+    if (index_it != tag_index_.end()) {
+      for (TagMapEntry* entry : index_it->second) {
+        art::ObjPtr<art::mirror::Object> obj =
+            entry->first.template Read<art::kWithReadBarrier>();
+        if (obj != nullptr) {
+          return obj;
+        }
+      }
+    }
+  } else {
+    for (auto& pair : tagged_objects_) {
+      if (tag == pair.second) {
+        art::ObjPtr<art::mirror::Object> obj = pair.first.template Read<art::kWithReadBarrier>();
+        if (obj != nullptr) {
+          return obj;
+        }
       }
     }
   }
@@ -32,11 +32,13 @@
 #ifndef ART_OPENJDKJVMTI_JVMTI_WEAK_TABLE_H_
 #define ART_OPENJDKJVMTI_JVMTI_WEAK_TABLE_H_
 
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "base/globals.h"
 #include "base/macros.h"
-#include "base/mutex.h"
+#include "base/mutex-inl.h"
 #include "gc/system_weak.h"
 #include "gc_root-inl.h"
 #include "jvmti.h"
@@ -55,6 +57,9 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
  public:
   JvmtiWeakTable()
       : art::gc::SystemWeakHolder(art::kTaggingLockLevel),
+        table_lock_("JVMTI weak table lock", art::kTaggingTableLockLevel),
+        tag_index_enabled_(false),
+        tag_index_used_since_sweep_(false),
         update_since_last_sweep_(false) {
   }
 
@@ -62,26 +67,40 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   // value).
   ALWAYS_INLINE bool Remove(art::ObjPtr<art::mirror::Object> obj, /* out */ T* tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_);
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
   ALWAYS_INLINE bool RemoveLocked(art::ObjPtr<art::mirror::Object> obj, /* out */ T* tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, !table_lock_);
 
   // Set the mapping for the given object. Returns true if this overwrites an already existing
   // mapping.
   ALWAYS_INLINE virtual bool Set(art::ObjPtr<art::mirror::Object> obj, T tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_);
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
   ALWAYS_INLINE virtual bool SetLocked(art::ObjPtr<art::mirror::Object> obj, T tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, !table_lock_);
 
   // Return the value associated with the given object. Returns true if the mapping exists, false
   // otherwise.
   bool GetTag(art::ObjPtr<art::mirror::Object> obj, /* out */ T* result)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_) {
+      REQUIRES(!allow_disallow_lock_, !table_lock_) {
     art::Thread* self = art::Thread::Current();
+    // With read barriers, a thread that may access weaks keeps doing so until its next suspend
+    // point, so it has nothing to wait for. Such lookups only keep the table from changing, and
+    // do not block each other.
+    if (art::kUseReadBarrier && self->GetWeakRefAccessEnabled()) {
+      art::ReaderMutexLock mu(self, table_lock_);
+      if (GetTagShared(obj, result)) {
+        return true;
+      }
+      // Outside of marking, the table holds no from-space pointers to retry with.
+      if (!self->GetIsGcMarking()) {
+        return false;
+      }
+    }
+
     art::MutexLock mu(self, allow_disallow_lock_);
     Wait(self);
 
@@ -89,7 +108,7 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   }
   bool GetTagLocked(art::ObjPtr<art::mirror::Object> obj, /* out */ T* result)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_) {
+      REQUIRES(allow_disallow_lock_, !table_lock_) {
     art::Thread* self = art::Thread::Current();
     allow_disallow_lock_.AssertHeld(self);
     Wait(self);
@@ -100,7 +119,7 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   // Sweep the container. DO NOT CALL MANUALLY.
   ALWAYS_INLINE void Sweep(art::IsMarkedVisitor* visitor)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(!allow_disallow_lock_);
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
 
   // Return all objects that have a value mapping in tags.
   ALWAYS_INLINE
@@ -122,6 +141,12 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
       REQUIRES_SHARED(art::Locks::mutator_lock_)
       REQUIRES(!allow_disallow_lock_);
 
+  // For tests: returns whether every entry is indexed exactly once, under its current tag, if the
+  // tag index is enabled.
+  bool CheckTagIndex()
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(!allow_disallow_lock_);
+
  protected:
   // Should HandleNullSweep be called when Sweep detects the release of an object?
   virtual bool DoesHandleNullOnSweep() {
@@ -134,16 +159,29 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   ALWAYS_INLINE
   bool SetLocked(art::Thread* self, art::ObjPtr<art::mirror::Object> obj, T tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, !table_lock_);
 
   ALWAYS_INLINE
   bool RemoveLocked(art::Thread* self, art::ObjPtr<art::mirror::Object> obj, /* out */ T* tag)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, !table_lock_);
+
+  // Lookup for GetTag() holding only the table lock. The table is only changed with both locks
+  // held, which the analysis cannot express.
+  bool GetTagShared(art::ObjPtr<art::mirror::Object> obj, /* out */ T* result)
+      REQUIRES_SHARED(art::Locks::mutator_lock_, table_lock_)
+      NO_THREAD_SAFETY_ANALYSIS {
+    auto it = tagged_objects_.find(art::GcRoot<art::mirror::Object>(obj));
+    if (it != tagged_objects_.end()) {
+      *result = it->second;
+      return true;
+    }
+    return false;
+  }
 
   bool GetTagLocked(art::Thread* self, art::ObjPtr<art::mirror::Object> obj, /* out */ T* result)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_) {
+      REQUIRES(allow_disallow_lock_, !table_lock_) {
     auto it = tagged_objects_.find(art::GcRoot<art::mirror::Object>(obj));
     if (it != tagged_objects_.end()) {
       *result = it->second;
@@ -167,20 +205,35 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   ALWAYS_INLINE
   bool GetTagSlowPath(art::Thread* self, art::ObjPtr<art::mirror::Object> obj, /* out */ T* result)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, !table_lock_);
 
   // Update the table by doing read barriers on each element, ensuring that to-space pointers
   // are stored.
   ALWAYS_INLINE
   void UpdateTableWithReadBarrier()
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, !table_lock_);
 
   template <bool kHandleNull>
   void SweepImpl(art::IsMarkedVisitor* visitor)
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
+
+  // Tables at least this large are swept on the heap thread pool, if there is one.
+  static constexpr size_t kMinParallelSweepSize = 16 * 1024;
+  // Returns how many threads should sweep the table, including the calling one.
+  size_t GetSweepThreadCount(art::Thread* self)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
       REQUIRES(!allow_disallow_lock_);
 
+  // Sweeps with the updater running for parts of the table on `num_threads` threads of the heap
+  // thread pool, including the calling one. Moved and cleared entries are then updated on the
+  // calling thread.
+  template <bool kHandleNull, typename Updater>
+  void ParallelSweepImpl(Updater& updater, size_t num_threads)
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(!allow_disallow_lock_, !table_lock_);
+
   enum TableUpdateNullTarget {
     kIgnoreNull,
     kRemoveNull,
@@ -190,7 +243,7 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   template <typename Updater, TableUpdateNullTarget kTargetNull>
   void UpdateTableWith(Updater& updater)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
-      REQUIRES(allow_disallow_lock_);
+      REQUIRES(allow_disallow_lock_, !table_lock_);
 
   template <typename Storage, class Allocator = JvmtiAllocator<T>>
   struct ReleasableContainer;
@@ -211,13 +264,63 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   };
 
   using TagAllocator = JvmtiAllocator<std::pair<const art::GcRoot<art::mirror::Object>, T>>;
-  std::unordered_map<art::GcRoot<art::mirror::Object>,
-                     T,
-                     HashGcRoot,
-                     EqGcRoot,
-                     TagAllocator> tagged_objects_
+  using TagMap = std::unordered_map<art::GcRoot<art::mirror::Object>,
+                                    T,
+                                    HashGcRoot,
+                                    EqGcRoot,
+                                    TagAllocator>;
+  using TagMapEntry = typename TagMap::value_type;
+
+  // Re-keys the entry to `target_obj`, or removes it if that is null. Does not invalidate
+  // iterators to other entries.
+  template <TableUpdateNullTarget kTargetNull>
+  void UpdateEntry(typename TagMap::iterator it, art::mirror::Object* target_obj)
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(allow_disallow_lock_, table_lock_);
+
+  // Lookups by tag (GetTaggedObjects for a few tags, Find) use a reverse index from tags to
+  // table entries. The index is only supported for integral tags. It is built on the first such
+  // lookup, and dropped again by a sweep if no lookup used it since the previous sweep, so that
+  // agents which do not query by tag, or stopped doing so, do not pay for it. Entries are
+  // referenced by address, which stays stable as the table re-keys moved objects in place.
+  static constexpr bool kSupportsTagIndex = std::is_integral<T>::value;
+  // Largest number of tags for which GetTaggedObjects uses the index instead of a table scan.
+  static constexpr size_t kMaxTagIndexQuerySize = 16;
+  using TagIndexKey = typename std::conditional<kSupportsTagIndex, T, uintptr_t>::type;
+  using TagIndexEntries = std::unordered_set<TagMapEntry*,
+                                             std::hash<TagMapEntry*>,
+                                             std::equal_to<TagMapEntry*>,
+                                             JvmtiAllocator<TagMapEntry*>>;
+  using TagIndex = std::unordered_map<TagIndexKey,
+                                      TagIndexEntries,
+                                      std::hash<TagIndexKey>,
+                                      std::equal_to<TagIndexKey>,
+                                      JvmtiAllocator<std::pair<const TagIndexKey,
+                                                               TagIndexEntries>>>;
+
+  ALWAYS_INLINE void EnableTagIndex()
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(allow_disallow_lock_);
+  ALWAYS_INLINE void AddToTagIndex(TagMapEntry* entry)
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(allow_disallow_lock_);
+  ALWAYS_INLINE void RemoveFromTagIndex(TagMapEntry* entry)
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(allow_disallow_lock_);
+  // Called by sweeps, once the table is up to date.
+  void SweepTagIndex()
+      REQUIRES_SHARED(art::Locks::mutator_lock_)
+      REQUIRES(allow_disallow_lock_);
+
+  // Taken, after allow_disallow_lock_, to change tagged_objects_, and on its own by GetTag()
+  // lookups that do not need to wait for weak access.
+  art::ReaderWriterMutex table_lock_ ACQUIRED_AFTER(allow_disallow_lock_);
+  TagMap tagged_objects_
       GUARDED_BY(allow_disallow_lock_)
       GUARDED_BY(art::Locks::mutator_lock_);
+  TagIndex tag_index_ GUARDED_BY(allow_disallow_lock_);
+  bool tag_index_enabled_ GUARDED_BY(allow_disallow_lock_);
+  bool tag_index_used_since_sweep_ GUARDED_BY(allow_disallow_lock_);
   // To avoid repeatedly scanning the whole table, remember if we did that since the last sweep.
   bool update_since_last_sweep_;
 };
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jvmti_weak_table-inl.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "class_root.h"
+#include "common_runtime_test.h"
+#include "handle_scope-inl.h"
+#include "mirror/object-inl.h"
+#include "mirror/object_array-alloc-inl.h"
+#include "mirror/object_array-inl.h"
+#include "mirror/string-alloc-inl.h"
+#include "object_callbacks.h"
+#include "scoped_thread_state_change-inl.h"
+#include "ti_allocator.h"
+
+namespace openjdkjvmti {
+
+// Records the tags of the objects that sweeps clear.
+class TestTable : public JvmtiWeakTable<jlong> {
+ public:
+  std::vector<jlong> swept_tags_;
+
+ protected:
+  bool DoesHandleNullOnSweep() override {
+    return true;
+  }
+  void HandleNullSweep(jlong tag) override {
+    swept_tags_.push_back(tag);
+  }
+};
+
+// Keeps objects alive unless told otherwise, and may report them moved to other objects.
+class TestIsMarkedVisitor : public art::IsMarkedVisitor {
+ public:
+  art::mirror::Object* IsMarked(art::mirror::Object* obj) override {
+    auto it = forwarding_.find(obj);
+    return it != forwarding_.end() ? it->second : obj;
+  }
+
+  std::unordered_map<art::mirror::Object*, art::mirror::Object*> forwarding_;
+};
+
+class JvmtiWeakTableTest : public art::CommonRuntimeTest {
+ protected:
+  static art::ObjPtr<art::mirror::Object> NewObject(art::Thread* self)
+      REQUIRES_SHARED(art::Locks::mutator_lock_) {
+    return art::mirror::String::AllocFromModifiedUtf8(self, "tagged");
+  }
+
+  // Returns the objects tagged with `tag`, and checks that they are reported with it.
+  static std::vector<art::ObjPtr<art::mirror::Object>> GetTaggedObjects(
+      const art::ScopedObjectAccess& soa, TestTable* table, jlong tag)
+      REQUIRES_SHARED(art::Locks::mutator_lock_) {
+    jint count = 0;
+    jobject* objects = nullptr;
+    jlong* tags = nullptr;
+    EXPECT_EQ(JVMTI_ERROR_NONE,
+              table->GetTaggedObjects(/* jvmti_env= */ nullptr, 1, &tag, &count, &objects, &tags));
+    std::vector<art::ObjPtr<art::mirror::Object>> result;
+    for (jint i = 0; i != count; ++i) {
+      EXPECT_EQ(tag, tags[i]);
+      result.push_back(soa.Decode<art::mirror::Object>(objects[i]));
+    }
+    AllocUtil::Deallocate(/* env= */ nullptr, reinterpret_cast<unsigned char*>(objects));
+    AllocUtil::Deallocate(/* env= */ nullptr, reinterpret_cast<unsigned char*>(tags));
+    return result;
+  }
+};
+
+TEST_F(JvmtiWeakTableTest, TagRetagAndLookUp) {
+  art::Thread* self = art::Thread::Current();
+  art::ScopedObjectAccess soa(self);
+  art::StackHandleScope<3> hs(self);
+  art::Handle<art::mirror::Object> a = hs.NewHandle(NewObject(self));
+  art::Handle<art::mirror::Object> b = hs.NewHandle(NewObject(self));
+  art::Handle<art::mirror::Object> c = hs.NewHandle(NewObject(self));
+  TestTable table;
+
+  // Set() returns whether the object was tagged before.
+  EXPECT_FALSE(table.Set(a.Get(), 1));
+  EXPECT_TRUE(table.Set(a.Get(), 2));
+  EXPECT_FALSE(table.Set(b.Get(), 2));
+  EXPECT_FALSE(table.Set(c.Get(), 3));
+  jlong tag = 0;
+  EXPECT_TRUE(table.GetTag(a.Get(), &tag));
+  EXPECT_EQ(2, tag);
+  EXPECT_TRUE(table.GetTag(c.Get(), &tag));
+  EXPECT_EQ(3, tag);
+
+  // The first lookup by tag builds the index, and the tags changed later are kept in it.
+  EXPECT_EQ(c.Get(), table.Find(3));
+  EXPECT_TRUE(table.Find(1) == nullptr);
+  std::vector<art::ObjPtr<art::mirror::Object>> tagged = GetTaggedObjects(soa, &table, 2);
+  EXPECT_EQ(2u, tagged.size());
+  EXPECT_TRUE(std::find(tagged.begin(), tagged.end(), a.Get()) != tagged.end());
+  EXPECT_TRUE(std::find(tagged.begin(), tagged.end(), b.Get()) != tagged.end());
+  EXPECT_TRUE(table.CheckTagIndex());
+
+  EXPECT_TRUE(table.Set(a.Get(), 4));
+  EXPECT_EQ(a.Get(), table.Find(4));
+  EXPECT_EQ(b.Get(), table.Find(2));
+  EXPECT_EQ(1u, GetTaggedObjects(soa, &table, 2).size());
+  EXPECT_TRUE(table.CheckTagIndex());
+
+  EXPECT_TRUE(table.Remove(c.Get(), &tag));
+  EXPECT_EQ(3, tag);
+  EXPECT_FALSE(table.GetTag(c.Get(), &tag));
+  EXPECT_TRUE(table.Find(3) == nullptr);
+  EXPECT_TRUE(table.CheckTagIndex());
+}
+
+TEST_F(JvmtiWeakTableTest, Sweep) {
+  art::Thread* self = art::Thread::Current();
+  art::ScopedObjectAccess soa(self);
+  art::StackHandleScope<4> hs(self);
+  art::Handle<art::mirror::Object> kept = hs.NewHandle(NewObject(self));
+  art::Handle<art::mirror::Object> moved = hs.NewHandle(NewObject(self));
+  art::Handle<art::mirror::Object> moved_to = hs.NewHandle(NewObject(self));
+  art::Handle<art::mirror::Object> cleared = hs.NewHandle(NewObject(self));
+  TestTable table;
+  table.Set(kept.Get(), 1);
+  table.Set(moved.Get(), 2);
+  table.Set(cleared.Get(), 3);
+  ASSERT_EQ(kept.Get(), table.Find(1));
+
+  TestIsMarkedVisitor visitor;
+  visitor.forwarding_.emplace(moved.Get(), moved_to.Get());
+  visitor.forwarding_.emplace(cleared.Get(), nullptr);
+  table.Sweep(&visitor);
+
+  jlong tag = 0;
+  EXPECT_TRUE(table.GetTag(kept.Get(), &tag));
+  EXPECT_EQ(1, tag);
+  EXPECT_TRUE(table.GetTag(moved_to.Get(), &tag));
+  EXPECT_EQ(2, tag);
+  EXPECT_FALSE(table.GetTag(moved.Get(), &tag));
+  EXPECT_FALSE(table.GetTag(cleared.Get(), &tag));
+  EXPECT_EQ(std::vector<jlong>({3}), table.swept_tags_);
+
+  // The index follows the moved object, and forgets the cleared one.
+  EXPECT_EQ(moved_to.Get(), table.Find(2));
+  EXPECT_TRUE(table.Find(3) == nullptr);
+  EXPECT_TRUE(table.CheckTagIndex());
+
+  // Retagging the moved object updates its entry.
+  EXPECT_TRUE(table.Set(moved_to.Get(), 5));
+  EXPECT_EQ(moved_to.Get(), table.Find(5));
+  EXPECT_TRUE(table.Find(2) == nullptr);
+  EXPECT_TRUE(table.CheckTagIndex());
+}
+
+TEST_F(JvmtiWeakTableTest, ParallelSweep) {
+  // Enough objects for sweeps to split the table between the heap's threads.
+  static constexpr size_t kNumTagged = 32 * 1024;
+  // Every fourth tagged object is moved to one of the objects after them, which are not tagged.
+  static constexpr size_t kNumObjects = kNumTagged + kNumTagged / 4;
+  art::Thread* self = art::Thread::Current();
+  art::ScopedObjectAccess soa(self);
+  art::StackHandleScope<1> hs(self);
+  art::Handle<art::mirror::ObjectArray<art::mirror::Object>> objects = hs.NewHandle(
+      art::mirror::ObjectArray<art::mirror::Object>::Alloc(
+          self,
+          art::GetClassRoot<art::mirror::ObjectArray<art::mirror::Object>>(),
+          kNumObjects));
+  ASSERT_TRUE(objects != nullptr);
+  for (size_t i = 0; i != kNumObjects; ++i) {
+    art::ObjPtr<art::mirror::Object> obj = NewObject(self);
+    ASSERT_TRUE(obj != nullptr);
+    objects->Set(i, obj);
+  }
+  TestTable table;
+  for (size_t i = 0; i != kNumTagged; ++i) {
+    table.Set(objects->Get(i), static_cast<jlong>(i + 1));
+  }
+  ASSERT_EQ(objects->Get(0), table.Find(1));
+
+  // Clear every odd object, move every fourth one, and keep the others.
+  TestIsMarkedVisitor visitor;
+  for (size_t i = 0; i != kNumTagged; ++i) {
+    if (i % 2 == 1) {
+      visitor.forwarding_.emplace(objects->Get(i).Ptr(), nullptr);
+    } else if (i % 4 == 0) {
+      visitor.forwarding_.emplace(objects->Get(i).Ptr(),
+                                  objects->Get(kNumTagged + i / 4).Ptr());
+    }
+  }
+  table.Sweep(&visitor);
+
+  EXPECT_EQ(kNumTagged / 2, table.swept_tags_.size());
+  for (size_t i = 0; i != kNumTagged; ++i) {
+    jlong tag = 0;
+    if (i % 2 == 1) {
+      EXPECT_FALSE(table.GetTag(objects->Get(i), &tag)) << i;
+    } else if (i % 4 == 0) {
+      EXPECT_FALSE(table.GetTag(objects->Get(i), &tag)) << i;
+      ASSERT_TRUE(table.GetTag(objects->Get(kNumTagged + i / 4), &tag)) << i;
+      EXPECT_EQ(static_cast<jlong>(i + 1), tag);
+    } else {
+      ASSERT_TRUE(table.GetTag(objects->Get(i), &tag)) << i;
+      EXPECT_EQ(static_cast<jlong>(i + 1), tag);
+    }
+  }
+  EXPECT_EQ(objects->Get(kNumTagged), table.Find(1));
+  EXPECT_TRUE(table.Find(2) == nullptr);
+  EXPECT_TRUE(table.CheckTagIndex());
+}
+
+}  // namespace openjdkjvmti
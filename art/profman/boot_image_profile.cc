@@ -26,6 +26,7 @@
 #include "dex/dex_file-inl.h"
 #include "dex/method_reference.h"
 #include "dex/type_reference.h"
+#include "parallel_chunks.h"
 #include "profile/profile_compilation_info.h"
 
 namespace art {
@@ -208,52 +209,120 @@ bool GenerateBootImageProfile(
 
   bool generate_preloaded_classes = !preloaded_classes_out_path.empty();
 
+  // Load and flatten the profiles in contiguous chunks on separate threads, then merge the
+  // chunks in order so that the package use lists come out as with a sequential merge.
+  const size_t num_profile_chunks =
+      GetNumberOfChunks(options.number_of_threads, profile_files.size());
+  std::vector<std::unique_ptr<FlattenProfileData>> chunk_data(num_profile_chunks);
+  ForEachChunkInParallel(
+      options.number_of_threads,
+      profile_files.size(),
+      [&](size_t chunk, size_t begin, size_t end) {
+        chunk_data[chunk].reset(new FlattenProfileData());
+        for (size_t i = begin; i < end; ++i) {
+          ProfileCompilationInfo profile;
+          if (!profile.Load(profile_files[i], /*clear_if_invalid=*/ false)) {
+            LOG(ERROR) << "Profile is not a valid: " << profile_files[i];
+            chunk_data[chunk].reset();  // Marks the chunk as invalid.
+            return;
+          }
+          std::unique_ptr<FlattenProfileData> currentData = profile.ExtractProfileData(dex_files);
+          chunk_data[chunk]->MergeData(*currentData);
+        }
+      });
   std::unique_ptr<FlattenProfileData> flattend_data(new FlattenProfileData());
-  for (const std::string& profile_file : profile_files) {
-    ProfileCompilationInfo profile;
-    if (!profile.Load(profile_file, /*clear_if_invalid=*/ false)) {
-      LOG(ERROR) << "Profile is not a valid: " << profile_file;
+  for (size_t chunk = 0; chunk < num_profile_chunks; ++chunk) {
+    if (chunk_data[chunk] == nullptr) {
       return false;
     }
-    std::unique_ptr<FlattenProfileData> currentData = profile.ExtractProfileData(dex_files);
-    flattend_data->MergeData(*currentData);
+    flattend_data->MergeData(*chunk_data[chunk]);
+    chunk_data[chunk].reset();
   }
 
   // We want the output sorted by the method/class name.
   // So we use an intermediate map for that.
-  // There's no attempt to optimize this as it's not part of any critical path,
-  // and mostly executed on hosts.
   SafeMap<std::string, FlattenProfileData::ItemMetadata> profile_methods;
   SafeMap<std::string, FlattenProfileData::ItemMetadata> profile_classes;
   SafeMap<std::string, FlattenProfileData::ItemMetadata> preloaded_classes;
 
-  for (const auto& it : flattend_data->GetMethodData()) {
-    if (IncludeMethodInProfile(flattend_data->GetMaxAggregationForMethods(), it.second, options)) {
-      FlattenProfileData::ItemMetadata metadata(it.second);
-      if (options.upgrade_startup_to_hot
-          && ((metadata.GetFlags() & Hotness::Flag::kFlagStartup) != 0)) {
-        metadata.AddFlag(Hotness::Flag::kFlagHot);
-      }
-      profile_methods.Put(BootImageRepresentation(it.first), metadata);
+  // Classify the methods and classes in parallel. Each thread fills its own maps which are
+  // combined afterwards; the combined maps are sorted by name, so the output is deterministic.
+  using MethodEntry = std::pair<const MethodReference, FlattenProfileData::ItemMetadata>;
+  using ClassEntry = std::pair<const TypeReference, FlattenProfileData::ItemMetadata>;
+  std::vector<const MethodEntry*> method_entries;
+  method_entries.reserve(flattend_data->GetMethodData().size());
+  for (const MethodEntry& entry : flattend_data->GetMethodData()) {
+    method_entries.push_back(&entry);
+  }
+  std::vector<const ClassEntry*> class_entries;
+  class_entries.reserve(flattend_data->GetClassData().size());
+  for (const ClassEntry& entry : flattend_data->GetClassData()) {
+    class_entries.push_back(&entry);
+  }
+
+  const size_t num_method_chunks =
+      GetNumberOfChunks(options.number_of_threads, method_entries.size());
+  std::vector<SafeMap<std::string, FlattenProfileData::ItemMetadata>> chunk_methods(
+      num_method_chunks);
+  ForEachChunkInParallel(
+      options.number_of_threads,
+      method_entries.size(),
+      [&](size_t chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const MethodEntry& it = *method_entries[i];
+          if (IncludeMethodInProfile(
+                  flattend_data->GetMaxAggregationForMethods(), it.second, options)) {
+            FlattenProfileData::ItemMetadata metadata(it.second);
+            if (options.upgrade_startup_to_hot
+                && ((metadata.GetFlags() & Hotness::Flag::kFlagStartup) != 0)) {
+              metadata.AddFlag(Hotness::Flag::kFlagHot);
+            }
+            chunk_methods[chunk].Put(BootImageRepresentation(it.first), metadata);
+          }
+        }
+      });
+  for (const auto& methods : chunk_methods) {
+    for (const auto& it : methods) {
+      profile_methods.Put(it.first, it.second);
     }
   }
 
-  for (const auto& it : flattend_data->GetClassData()) {
-    const TypeReference& type_ref = it.first;
-    const FlattenProfileData::ItemMetadata& metadata = it.second;
-    if (IncludeClassInProfile(type_ref,
-            flattend_data->GetMaxAggregationForClasses(),
-            metadata,
-            options)) {
-      profile_classes.Put(BootImageRepresentation(it.first), it.second);
+  const size_t num_class_chunks =
+      GetNumberOfChunks(options.number_of_threads, class_entries.size());
+  std::vector<SafeMap<std::string, FlattenProfileData::ItemMetadata>> chunk_classes(
+      num_class_chunks);
+  std::vector<SafeMap<std::string, FlattenProfileData::ItemMetadata>> chunk_preloaded_classes(
+      num_class_chunks);
+  ForEachChunkInParallel(
+      options.number_of_threads,
+      class_entries.size(),
+      [&](size_t chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const ClassEntry& it = *class_entries[i];
+          const TypeReference& type_ref = it.first;
+          const FlattenProfileData::ItemMetadata& metadata = it.second;
+          if (IncludeClassInProfile(type_ref,
+                  flattend_data->GetMaxAggregationForClasses(),
+                  metadata,
+                  options)) {
+            chunk_classes[chunk].Put(BootImageRepresentation(it.first), it.second);
+          }
+          std::string preloaded_class_representation = PreloadedClassesRepresentation(it.first);
+          if (generate_preloaded_classes && IncludeInPreloadedClasses(
+                  preloaded_class_representation,
+                  flattend_data->GetMaxAggregationForClasses(),
+                  metadata,
+                  options)) {
+            chunk_preloaded_classes[chunk].Put(preloaded_class_representation, it.second);
+          }
+        }
+      });
+  for (size_t chunk = 0; chunk < num_class_chunks; ++chunk) {
+    for (const auto& it : chunk_classes[chunk]) {
+      profile_classes.Put(it.first, it.second);
     }
-    std::string preloaded_class_representation = PreloadedClassesRepresentation(it.first);
-    if (generate_preloaded_classes && IncludeInPreloadedClasses(
-            preloaded_class_representation,
-            flattend_data->GetMaxAggregationForClasses(),
-            metadata,
-            options)) {
-      preloaded_classes.Put(preloaded_class_representation, it.second);
+    for (const auto& it : chunk_preloaded_classes[chunk]) {
+      preloaded_classes.Put(it.first, it.second);
     }
   }
 
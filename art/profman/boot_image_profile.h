@@ -67,6 +67,10 @@ struct BootImageOptions {
 
   // The set of classes that should not be preloaded in Zygote
   std::set<std::string> preloaded_classes_blacklist;
+
+  // The number of threads used to load the profiles and to classify their content.
+  // The output does not depend on it.
+  size_t number_of_threads = 1;
 };
 
 // Generate a boot image profile according to the specified options.
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_PROFMAN_PARALLEL_CHUNKS_H_
+#define ART_PROFMAN_PARALLEL_CHUNKS_H_
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace art {
+
+// Returns the number of chunks ForEachChunkInParallel splits `num_items` into.
+inline size_t GetNumberOfChunks(size_t num_threads, size_t num_items) {
+  return std::min(std::max<size_t>(num_threads, 1u), num_items);
+}
+
+// Splits [0, num_items) into GetNumberOfChunks() contiguous chunks and calls
+// `fn(chunk_index, begin, end)` for each of them, each chunk on its own thread.
+// Chunk i only covers items that come before the items of chunk i + 1, so combining
+// the per-chunk results in chunk order gives the same result as a sequential pass
+// regardless of the number of threads.
+template <typename Fn>
+void ForEachChunkInParallel(size_t num_threads, size_t num_items, const Fn& fn) {
+  const size_t num_chunks = GetNumberOfChunks(num_threads, num_items);
+  auto chunk_begin = [=](size_t chunk) { return chunk * num_items / num_chunks; };
+  std::vector<std::thread> threads;
+  threads.reserve(num_chunks);
+  for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+    threads.emplace_back(std::cref(fn), chunk, chunk_begin(chunk), chunk_begin(chunk + 1));
+  }
+  if (num_chunks != 0u) {
+    // Process the first chunk on the calling thread.
+    fn(0u, chunk_begin(0u), chunk_begin(1u));
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace art
+
+#endif  // ART_PROFMAN_PARALLEL_CHUNKS_H_
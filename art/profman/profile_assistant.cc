@@ -16,8 +16,11 @@
 
 #include "profile_assistant.h"
 
+#include <memory>
+
 #include "base/os.h"
 #include "base/unix_file/fd_file.h"
+#include "parallel_chunks.h"
 
 namespace art {
 
@@ -29,32 +32,15 @@ static constexpr const uint32_t kMinNewClassesForCompilation = 50;
 static constexpr const uint32_t kMinNewClassesPercentChangeForCompilation = 2;
 
 
-ProfileAssistant::ProcessingResult ProfileAssistant::ProcessProfilesInternal(
+ProfileAssistant::ProcessingResult ProfileAssistant::MergeProfiles(
         const std::vector<ScopedFlock>& profile_files,
-        const ScopedFlock& reference_profile_file,
+        size_t begin,
+        size_t end,
+        const ProfileCompilationInfo& reference_info,
         const ProfileCompilationInfo::ProfileLoadFilterFn& filter_fn,
-        const Options& options) {
-  DCHECK(!profile_files.empty());
-
-  ProfileCompilationInfo info(options.IsBootImageMerge());
-
-  // Load the reference profile.
-  if (!info.Load(reference_profile_file->Fd(), /*merge_classes=*/ true, filter_fn)) {
-    LOG(WARNING) << "Could not load reference profile file";
-    return kErrorBadProfiles;
-  }
-
-  if (options.IsBootImageMerge() && !info.IsForBootImage()) {
-    LOG(WARNING) << "Requested merge for boot image profile but the reference profile is regular.";
-    return kErrorBadProfiles;
-  }
-
-  // Store the current state of the reference profile before merging with the current profiles.
-  uint32_t number_of_methods = info.GetNumberOfMethods();
-  uint32_t number_of_classes = info.GetNumberOfResolvedClasses();
-
-  // Merge all current profiles.
-  for (size_t i = 0; i < profile_files.size(); i++) {
+        const Options& options,
+        /*out*/ ProfileCompilationInfo* info) {
+  for (size_t i = begin; i < end; i++) {
     ProfileCompilationInfo cur_info;
     if (!cur_info.Load(profile_files[i]->Fd(), /*merge_classes=*/ true, filter_fn)) {
       LOG(WARNING) << "Could not load profile file at index " << i;
@@ -71,7 +57,7 @@ ProfileAssistant::ProcessingResult ProfileAssistant::ProcessProfilesInternal(
     // This may happen during profile analysis if one profile is regular and
     // the other one is for the boot image. For example when switching on-off
     // the boot image profiles.
-    if (!info.SameVersion(cur_info)) {
+    if (!reference_info.SameVersion(cur_info)) {
       if (options.IsForceMerge()) {
         // If we have to merge forcefully, ignore the current profile and
         // continue to the next one.
@@ -82,11 +68,60 @@ ProfileAssistant::ProcessingResult ProfileAssistant::ProcessProfilesInternal(
       }
     }
 
-    if (!info.MergeWith(cur_info)) {
+    if (!info->MergeWith(cur_info)) {
       LOG(WARNING) << "Could not merge profile file at index " << i;
       return kErrorBadProfiles;
     }
   }
+  return kSuccess;
+}
+
+ProfileAssistant::ProcessingResult ProfileAssistant::ProcessProfilesInternal(
+        const std::vector<ScopedFlock>& profile_files,
+        const ScopedFlock& reference_profile_file,
+        const ProfileCompilationInfo::ProfileLoadFilterFn& filter_fn,
+        const Options& options) {
+  DCHECK(!profile_files.empty());
+
+  ProfileCompilationInfo info(options.IsBootImageMerge());
+
+  // Load the reference profile.
+  if (!info.Load(reference_profile_file->Fd(), /*merge_classes=*/ true, filter_fn)) {
+    LOG(WARNING) << "Could not load reference profile file";
+    return kErrorBadProfiles;
+  }
+
+  if (options.IsBootImageMerge() && !info.IsForBootImage()) {
+    LOG(WARNING) << "Requested merge for boot image profile but the reference profile is regular.";
+    return kErrorBadProfiles;
+  }
+
+  // Store the current state of the reference profile before merging with the current profiles.
+  uint32_t number_of_methods = info.GetNumberOfMethods();
+  uint32_t number_of_classes = info.GetNumberOfResolvedClasses();
+
+  // Merge all current profiles. The profiles are split into contiguous chunks that are loaded
+  // and merged on separate threads. The chunk results are then merged in order, which keeps the
+  // output identical to a sequential merge.
+  const size_t num_chunks = GetNumberOfChunks(options.GetNumberOfThreads(), profile_files.size());
+  std::vector<std::unique_ptr<ProfileCompilationInfo>> chunk_infos(num_chunks);
+  std::vector<ProcessingResult> chunk_results(num_chunks, kSuccess);
+  auto merge_chunk = [&](size_t chunk, size_t begin, size_t end) {
+    chunk_infos[chunk].reset(new ProfileCompilationInfo(info.IsForBootImage()));
+    chunk_results[chunk] = MergeProfiles(
+        profile_files, begin, end, info, filter_fn, options, chunk_infos[chunk].get());
+  };
+  ForEachChunkInParallel(options.GetNumberOfThreads(), profile_files.size(), merge_chunk);
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    if (chunk_results[chunk] != kSuccess) {
+      return chunk_results[chunk];
+    }
+    if (!info.MergeWith(*chunk_infos[chunk])) {
+      LOG(WARNING) << "Could not merge profile files in chunk " << chunk;
+      return kErrorBadProfiles;
+    }
+    chunk_infos[chunk].reset();
+  }
 
   // If we perform a forced merge do not analyze the difference between profiles.
   if (!options.IsForceMerge()) {
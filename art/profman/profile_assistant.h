@@ -43,17 +43,21 @@ class ProfileAssistant {
    public:
     static constexpr bool kForceMergeDefault = false;
     static constexpr bool kBootImageMergeDefault = false;
+    static constexpr size_t kNumberOfThreadsDefault = 1u;
 
     Options()
         : force_merge_(kForceMergeDefault),
-          boot_image_merge_(kBootImageMergeDefault) {
+          boot_image_merge_(kBootImageMergeDefault),
+          number_of_threads_(kNumberOfThreadsDefault) {
     }
 
     bool IsForceMerge() const { return force_merge_; }
     bool IsBootImageMerge() const { return boot_image_merge_; }
+    size_t GetNumberOfThreads() const { return number_of_threads_; }
 
     void SetForceMerge(bool value) { force_merge_ = value; }
     void SetBootImageMerge(bool value) { boot_image_merge_ = value; }
+    void SetNumberOfThreads(size_t value) { number_of_threads_ = value; }
 
    private:
     // If true, performs a forced merge, without analyzing if there is a
@@ -63,6 +67,9 @@ class ProfileAssistant {
     // Signals that the merge is for boot image profiles. It will ignore differences
     // in profile versions (instead of aborting).
     bool boot_image_merge_;
+    // The number of threads used to load and merge the current profiles.
+    // The result does not depend on it.
+    size_t number_of_threads_;
   };
 
   // Process the profile information present in the given files. Returns one of
@@ -79,6 +86,9 @@ class ProfileAssistant {
   // merge of the current profiles and the reference one is insignificant. In
   // this case no file will be updated.
   //
+  // When more than one thread is requested the filter_fn may be called
+  // concurrently from several threads.
+  //
   static ProcessingResult ProcessProfiles(
       const std::vector<std::string>& profile_files,
       const std::string& reference_profile_file,
@@ -94,6 +104,17 @@ class ProfileAssistant {
       const Options& options = Options());
 
  private:
+  // Loads profile_files[begin, end) and merges them into `info`. The profiles are
+  // checked against the version of `reference_info`.
+  static ProcessingResult MergeProfiles(
+      const std::vector<ScopedFlock>& profile_files,
+      size_t begin,
+      size_t end,
+      const ProfileCompilationInfo& reference_info,
+      const ProfileCompilationInfo::ProfileLoadFilterFn& filter_fn,
+      const Options& options,
+      /*out*/ ProfileCompilationInfo* info);
+
   static ProcessingResult ProcessProfilesInternal(
       const std::vector<ScopedFlock>& profile_files,
       const ScopedFlock& reference_profile_file,
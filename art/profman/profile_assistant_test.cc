@@ -1145,6 +1145,55 @@ TEST_F(ProfileAssistantTest, MergeProfilesWithDifferentDexOrder) {
   CheckProfileInfo(profile1, info1);
 }
 
+TEST_F(ProfileAssistantTest, MergeProfilesWithMultipleThreads) {
+  ScratchFile profile1;
+  ScratchFile profile2;
+  ScratchFile profile3;
+  ScratchFile profile4;
+  ScratchFile reference_profile_single_thread;
+  ScratchFile reference_profile_multiple_threads;
+
+  std::vector<int> profile_fds({
+      GetFd(profile1),
+      GetFd(profile2),
+      GetFd(profile3),
+      GetFd(profile4)});
+
+  const uint16_t kNumberOfMethodsToEnableCompilation = 100;
+  ProfileCompilationInfo info1;
+  SetupProfile(dex1, dex2, kNumberOfMethodsToEnableCompilation, 0, profile1, &info1);
+  ProfileCompilationInfo info2;
+  SetupProfile(dex3, dex4, kNumberOfMethodsToEnableCompilation, 0, profile2, &info2);
+  ProfileCompilationInfo info3;
+  SetupProfile(dex1, dex2, kNumberOfMethodsToEnableCompilation, 0, profile3, &info3,
+      kNumberOfMethodsToEnableCompilation, /*reverse_dex_write_order=*/ true);
+  ProfileCompilationInfo info4;
+  SetupProfile(dex4, dex1, kNumberOfMethodsToEnableCompilation, 0, profile4, &info4,
+      2 * kNumberOfMethodsToEnableCompilation);
+
+  ASSERT_EQ(ProfileAssistant::kCompile,
+            ProcessProfiles(profile_fds,
+                            GetFd(reference_profile_single_thread),
+                            std::vector<const std::string>({"-j1"})));
+  for (ScratchFile* profile : {&profile1, &profile2, &profile3, &profile4}) {
+    ASSERT_TRUE(profile->GetFile()->ResetOffset());
+  }
+  ASSERT_EQ(ProfileAssistant::kCompile,
+            ProcessProfiles(profile_fds,
+                            GetFd(reference_profile_multiple_threads),
+                            std::vector<const std::string>({"-j3"})));
+
+  // Both results must be equal to the sequential merge of the inputs, including the order
+  // of the dex files in the profile.
+  ProfileCompilationInfo expected;
+  ASSERT_TRUE(expected.MergeWith(info1));
+  ASSERT_TRUE(expected.MergeWith(info2));
+  ASSERT_TRUE(expected.MergeWith(info3));
+  ASSERT_TRUE(expected.MergeWith(info4));
+  CheckProfileInfo(reference_profile_single_thread, expected);
+  CheckProfileInfo(reference_profile_multiple_threads, expected);
+}
+
 TEST_F(ProfileAssistantTest, TestProfileCreateWithInvalidData) {
   // Create the profile content.
   std::vector<std::string> profile_methods = {
@@ -180,6 +180,11 @@ NO_RETURN static void Usage(const char *fmt, ...) {
   UsageError("  --force-merge: performs a forced merge, without analyzing if there is a");
   UsageError("      significant difference between the current profile and the reference profile.");
   UsageError("");
+  UsageError("  -j<number>: the number of threads used to load and merge profiles and to generate");
+  UsageError("      boot image profiles. The output does not depend on it.");
+  UsageError("      Example: -j12");
+  UsageError("      Default: number of CPU cores.");
+  UsageError("");
 
   exit(EXIT_FAILURE);
 }
@@ -281,7 +286,8 @@ class ProfMan final {
       test_profile_seed_(NanoTime()),
       start_ns_(NanoTime()),
       copy_and_update_profile_key_(false),
-      profile_assistant_options_(ProfileAssistant::Options()) {}
+      profile_assistant_options_(ProfileAssistant::Options()),
+      number_of_threads_(sysconf(_SC_NPROCESSORS_CONF)) {}
 
   ~ProfMan() {
     LogCompletionTime();
@@ -412,6 +418,8 @@ class ProfMan final {
         profile_assistant_options_.SetBootImageMerge(true);
       } else if (option == "--force-merge") {
         profile_assistant_options_.SetForceMerge(true);
+      } else if (StartsWith(option, "-j")) {
+        ParseUintValue("-j", std::string(option.substr(strlen("-j"))), &number_of_threads_, 1u);
       } else {
         Usage("Unknown argument '%s'", raw_option);
       }
@@ -428,6 +436,9 @@ class ProfMan final {
     if (!apk_files_.empty() && !apks_fd_.empty()) {
       Usage("APK files should not be specified with both --apk-fd and --apk");
     }
+
+    profile_assistant_options_.SetNumberOfThreads(number_of_threads_);
+    boot_image_options_.number_of_threads = number_of_threads_;
   }
 
   struct ProfileFilterKey {
@@ -1518,6 +1529,7 @@ class ProfMan final {
   uint64_t start_ns_;
   bool copy_and_update_profile_key_;
   ProfileAssistant::Options profile_assistant_options_;
+  uint32_t number_of_threads_;
   std::string boot_profile_out_path_;
   std::string preloaded_classes_out_path_;
 };
@@ -73,11 +73,15 @@ enum LockLevel : uint8_t {
   kRosAllocBracketLock,
   kRosAllocBulkFreeLock,
   kAllocSpaceLock,
+  // The tag table lock of JVMTI is held while objects are marked by read barriers, which may
+  // allocate, so it goes above the allocation locks.
+  kTaggingTableLockLevel,
   kTaggingLockLevel,
   kTransactionLogLock,
   kCustomTlsLock,
   kJniFunctionTableLock,
   kJniWeakGlobalsLock,
+  kJniGlobalsShardLock,
   kJniGlobalsLock,
   kReferenceQueueSoftReferencesLock,
   kReferenceQueuePhantomReferencesLock,
@@ -79,8 +79,7 @@ void MemMapArena::Release() {
 
 MemMapArenaPool::MemMapArenaPool(bool low_4gb, const char* name)
     : low_4gb_(low_4gb),
-      name_(name),
-      free_arenas_(nullptr) {
+      name_(name) {
   MemMap::Init();
 }
 
@@ -89,11 +88,7 @@ MemMapArenaPool::~MemMapArenaPool() {
 }
 
 void MemMapArenaPool::ReclaimMemory() {
-  while (free_arenas_ != nullptr) {
-    Arena* arena = free_arenas_;
-    free_arenas_ = free_arenas_->next_;
-    delete arena;
-  }
+  ArenaFreeLists::DeleteArenaChain(free_arenas_.TakeAll());
 }
 
 void MemMapArenaPool::LockReclaimMemory() {
@@ -105,13 +100,12 @@ Arena* MemMapArenaPool::AllocArena(size_t size) {
   Arena* ret = nullptr;
   {
     std::lock_guard<std::mutex> lock(lock_);
-    if (free_arenas_ != nullptr && LIKELY(free_arenas_->Size() >= size)) {
-      ret = free_arenas_;
-      free_arenas_ = free_arenas_->next_;
-    }
+    ret = free_arenas_.Take(size);
   }
   if (ret == nullptr) {
     ret = new MemMapArena(size, low_4gb_, name_);
+    std::lock_guard<std::mutex> lock(lock_);
+    free_arenas_.AddNewArena(ret);
   }
   ret->Reset();
   return ret;
@@ -120,20 +114,40 @@ Arena* MemMapArenaPool::AllocArena(size_t size) {
 void MemMapArenaPool::TrimMaps() {
   ScopedTrace trace(__PRETTY_FUNCTION__);
   std::lock_guard<std::mutex> lock(lock_);
-  for (Arena* arena = free_arenas_; arena != nullptr; arena = arena->next_) {
+  free_arenas_.VisitFreeArenas([](Arena* arena) {
     arena->Release();
+  });
+}
+
+void MemMapArenaPool::TrimIdle() {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  Arena* excess;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    excess = free_arenas_.TakeExcess();
+    // Keep the mappings of the remaining free arenas for the next compilations, but not their
+    // pages.
+    free_arenas_.VisitFreeArenas([](Arena* arena) {
+      arena->Release();
+    });
   }
+  ArenaFreeLists::DeleteArenaChain(excess);
 }
 
 size_t MemMapArenaPool::GetBytesAllocated() const {
   size_t total = 0;
   std::lock_guard<std::mutex> lock(lock_);
-  for (Arena* arena = free_arenas_; arena != nullptr; arena = arena->next_) {
+  free_arenas_.VisitFreeArenas([&](const Arena* arena) {
     total += arena->GetBytesAllocated();
-  }
+  });
   return total;
 }
 
+ArenaPoolStats MemMapArenaPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return free_arenas_.GetStats();
+}
+
 void MemMapArenaPool::FreeArenaChain(Arena* first) {
   if (kRunningOnMemoryTool) {
     for (Arena* arena = first; arena != nullptr; arena = arena->next_) {
@@ -143,22 +157,19 @@ void MemMapArenaPool::FreeArenaChain(Arena* first) {
 
   if (arena_allocator::kArenaAllocatorPreciseTracking) {
     // Do not reuse arenas when tracking.
-    while (first != nullptr) {
-      Arena* next = first->next_;
-      delete first;
-      first = next;
+    size_t bytes = 0u;
+    for (Arena* arena = first; arena != nullptr; arena = arena->next_) {
+      bytes += arena->Size();
     }
+    ArenaFreeLists::DeleteArenaChain(first);
+    std::lock_guard<std::mutex> lock(lock_);
+    free_arenas_.RecordDeleted(bytes);
     return;
   }
 
   if (first != nullptr) {
-    Arena* last = first;
-    while (last->next_ != nullptr) {
-      last = last->next_;
-    }
     std::lock_guard<std::mutex> lock(lock_);
-    last->next_ = free_arenas_;
-    free_arenas_ = first;
+    free_arenas_.Put(first);
   }
 }
 
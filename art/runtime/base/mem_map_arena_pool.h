@@ -32,11 +32,13 @@ class MemMapArenaPool final : public ArenaPool {
   void LockReclaimMemory() override;
   // Trim the maps in arenas by madvising, used by JIT to reduce memory usage.
   void TrimMaps() override;
+  void TrimIdle() override;
+  ArenaPoolStats GetStats() const override;
 
  private:
   const bool low_4gb_;
   const char* name_;
-  Arena* free_arenas_;
+  ArenaFreeLists free_arenas_;
   // Use a std::mutex here as Arenas are second-from-the-bottom when using MemMaps, and MemMap
   // itself uses std::mutex scoped to within an allocate/free only.
   mutable std::mutex lock_;
@@ -134,6 +134,7 @@
 #include "oat_file_manager.h"
 #include "object_lock.h"
 #include "profile/profile_compilation_info.h"
+#include "reflective_invoke_cache.h"
 #include "runtime.h"
 #include "runtime_callbacks.h"
 #include "scoped_thread_state_change-inl.h"
@@ -2115,34 +2116,30 @@ bool ClassLinker::AddImageSpace(
     }
   }
 
-  // Set entry point to interpreter if in InterpretOnly mode.
-  if (!runtime->IsAotCompiler() && runtime->GetInstrumentation()->InterpretOnly()) {
-    // Set image methods' entry point to interpreter.
+  // Fix up the image methods in a single pass, each method is likely to miss in the cache.
+  const bool interpret_only =
+      !runtime->IsAotCompiler() && runtime->GetInstrumentation()->InterpretOnly();
+  const bool use_nterp = interpreter::CanRuntimeUseNterp();
+  const bool verification_soft_fail = runtime->IsVerificationSoftFail();
+  if (interpret_only || use_nterp || verification_soft_fail) {
+    ScopedTrace trace("FixupImageMethods");
     header.VisitPackedArtMethods([&](ArtMethod& method) REQUIRES_SHARED(Locks::mutator_lock_) {
-      if (!method.IsRuntimeMethod()) {
+      // Set entry point to interpreter if in InterpretOnly mode.
+      if (interpret_only && !method.IsRuntimeMethod()) {
         DCHECK(method.GetDeclaringClass() != nullptr);
         if (!method.IsNative() && !method.IsResolutionMethod()) {
           method.SetEntryPointFromQuickCompiledCodePtrSize(GetQuickToInterpreterBridge(),
                                                             image_pointer_size_);
         }
       }
-    }, space->Begin(), image_pointer_size_);
-  }
-
-  if (interpreter::CanRuntimeUseNterp()) {
-    // Set image methods' entry point that point to the interpreter bridge to the nterp entry point.
-    header.VisitPackedArtMethods([&](ArtMethod& method) REQUIRES_SHARED(Locks::mutator_lock_) {
-      if (IsQuickToInterpreterBridge(method.GetEntryPointFromQuickCompiledCode()) &&
+      // Set entry points that point to the interpreter bridge to the nterp entry point.
+      if (use_nterp &&
+          IsQuickToInterpreterBridge(method.GetEntryPointFromQuickCompiledCode()) &&
           interpreter::CanMethodUseNterp(&method)) {
         method.SetEntryPointFromQuickCompiledCodePtrSize(interpreter::GetNterpEntryPoint(),
                                                          image_pointer_size_);
       }
-    }, space->Begin(), image_pointer_size_);
-  }
-
-  if (runtime->IsVerificationSoftFail()) {
-    header.VisitPackedArtMethods([&](ArtMethod& method) REQUIRES_SHARED(Locks::mutator_lock_) {
-      if (!method.IsNative() && method.IsInvokable()) {
+      if (verification_soft_fail && !method.IsNative() && method.IsInvokable()) {
         method.ClearSkipAccessChecks();
       }
     }, space->Begin(), image_pointer_size_);
@@ -2169,11 +2166,25 @@ bool ClassLinker::AddImageSpace(
   if (app_image) {
     AppImageLoadingHelper::Update(this, space, class_loader, dex_caches, &temp_set);
 
-    {
-      ScopedTrace trace("AppImage:UpdateClassLoaders");
-      // Update class loader and resolved strings. If added_class_table is false, the resolved
-      // strings were forwarded UpdateAppImageClassLoadersAndDexCaches.
-      ObjPtr<mirror::ClassLoader> loader(class_loader.Get());
+    // The class table of the image is used in place, the only per-class work left is to update
+    // the class loader of the classes and, if enabled, their SubtypeCheck bitstrings. Do both in
+    // a single pass over the classes, as each class is likely to miss in the cache.
+    //
+    // Every class in the app image has initially SubtypeCheckInfo in the Uninitialized state.
+    // The SubtypeCheck invariants imply that a SubtypeCheckInfo is at least Initialized after
+    // class initialization is complete. The app image ClassStatus as-is are almost all
+    // ClassStatus::Initialized, and being in the SubtypeCheckInfo::kUninitialized state is
+    // violating that invariant. Force every app image class's SubtypeCheck to be at least
+    // kInitialized. See also ImageWriter::FixupClass.
+    //
+    // The class loader cannot be updated lazily on lookup, app image classes are reachable
+    // through dex caches, super classes and objects before they are ever looked up.
+    ScopedTrace trace("AppImage:FixupClasses");
+    const uint64_t fixup_start_time = NanoTime();
+    ObjPtr<mirror::ClassLoader> loader(class_loader.Get());
+    size_t num_classes = 0u;
+    // The subtype check lock is held when needed, see below.
+    auto fixup_classes = [&]() NO_THREAD_SAFETY_ANALYSIS {
       for (const ClassTable::TableSlot& root : temp_set) {
         // Note: We probably don't need the read barrier unless we copy the app image objects into
         // the region space.
@@ -2184,27 +2195,20 @@ bool ClassLinker::AddImageSpace(
         if (klass->GetClassLoader<kDefaultVerifyFlags, kWithoutReadBarrier>() != nullptr) {
           klass->SetClassLoader(loader);
         }
+        if (kBitstringSubtypeCheckEnabled) {
+          SubtypeCheck<ObjPtr<mirror::Class>>::EnsureInitialized(klass);
+        }
+        ++num_classes;
       }
-    }
-
+    };
     if (kBitstringSubtypeCheckEnabled) {
-      // Every class in the app image has initially SubtypeCheckInfo in the
-      // Uninitialized state.
-      //
-      // The SubtypeCheck invariants imply that a SubtypeCheckInfo is at least Initialized
-      // after class initialization is complete. The app image ClassStatus as-is
-      // are almost all ClassStatus::Initialized, and being in the
-      // SubtypeCheckInfo::kUninitialized state is violating that invariant.
-      //
-      // Force every app image class's SubtypeCheck to be at least kIninitialized.
-      //
-      // See also ImageWriter::FixupClass.
-      ScopedTrace trace("AppImage:RecacluateSubtypeCheckBitstrings");
-      MutexLock subtype_check_lock(Thread::Current(), *Locks::subtype_check_lock_);
-      for (const ClassTable::TableSlot& root : temp_set) {
-        SubtypeCheck<ObjPtr<mirror::Class>>::EnsureInitialized(root.Read());
-      }
+      MutexLock subtype_check_lock(self, *Locks::subtype_check_lock_);
+      fixup_classes();
+    } else {
+      fixup_classes();
     }
+    VLOG(image) << "Fixing up " << num_classes << " app image classes took "
+                << PrettyDuration(NanoTime() - fixup_start_time);
   }
   if (!oat_file->GetBssGcRoots().empty()) {
     // Insert oat file to class table for visiting .bss GC roots.
@@ -2496,6 +2500,10 @@ void ClassLinker::DeleteClassLoader(Thread* self, const ClassLoaderData& data, b
     CHAOnDeleteUpdateClassVisitor visitor(data.allocator);
     data.class_table->Visit<CHAOnDeleteUpdateClassVisitor, kWithoutReadBarrier>(visitor);
   }
+  // The ArtMethods in the allocator may be recorded in the reflective invoke caches.
+  ReflectiveInvokeCache::InvalidateAll();
+  // Likewise for the ArtFields and ArtMethods in the hidden API access decision caches.
+  Runtime::Current()->InvalidateHiddenApiAccessDecisions();
 
   delete data.allocator;
   delete data.class_table;
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "code_info_cache.h"
+
+#include <ostream>
+
+#include "base/mutex.h"
+#include "oat_quick_method_header.h"
+#include "runtime.h"
+#include "thread-current-inl.h"
+#include "thread_list.h"
+
+namespace art {
+
+// Start at 1 so that default constructed entries never match.
+std::atomic<uint32_t> CodeInfoCache::global_epoch_(1u);
+CodeInfoCache::Stats CodeInfoCache::retired_stats_;
+
+CodeInfoCache::CodeInfoCache() {}
+
+CodeInfoCache::~CodeInfoCache() {
+  retired_stats_.code_info_hits += stats_.code_info_hits.load(std::memory_order_relaxed);
+  retired_stats_.code_info_misses += stats_.code_info_misses.load(std::memory_order_relaxed);
+  retired_stats_.stack_map_hits += stats_.stack_map_hits.load(std::memory_order_relaxed);
+  retired_stats_.stack_map_misses += stats_.stack_map_misses.load(std::memory_order_relaxed);
+}
+
+CodeInfo CodeInfoCache::GetCodeInfo(const OatQuickMethodHeader* header) {
+  DCHECK(header->IsOptimized());
+  uint32_t epoch = CurrentEpoch();
+  CodeInfoEntry& entry = code_infos_[CodeInfoIndexOf(header)];
+  if (LIKELY(entry.header == header && entry.epoch == epoch)) {
+    Increment(&stats_.code_info_hits);
+    return entry.code_info;
+  }
+  Increment(&stats_.code_info_misses);
+  entry.header = header;
+  entry.epoch = epoch;
+  entry.code_info = CodeInfo(header);
+  return entry.code_info;
+}
+
+StackMap CodeInfoCache::GetStackMapForNativePcOffset(const OatQuickMethodHeader* header,
+                                                     const CodeInfo& code_info,
+                                                     uint32_t native_pc_offset) {
+  uint32_t epoch = CurrentEpoch();
+  StackMapEntry& entry = stack_maps_[StackMapIndexOf(header, native_pc_offset)];
+  if (LIKELY(entry.header == header &&
+             entry.native_pc_offset == native_pc_offset &&
+             entry.epoch == epoch)) {
+    Increment(&stats_.stack_map_hits);
+    return (entry.row == StackMap::kNoValue)
+        ? code_info.GetStackMaps().GetInvalidRow()
+        : code_info.GetStackMapAt(entry.row);
+  }
+  Increment(&stats_.stack_map_misses);
+  StackMap stack_map = code_info.GetStackMapForNativePcOffset(native_pc_offset);
+  entry.header = header;
+  entry.native_pc_offset = native_pc_offset;
+  entry.epoch = epoch;
+  entry.row = stack_map.IsValid() ? stack_map.Row() : StackMap::kNoValue;
+  return stack_map;
+}
+
+static void DumpHitRate(std::ostream& os, const char* name, uint64_t hits, uint64_t misses) {
+  uint64_t total = hits + misses;
+  os << name << " cache: " << hits << " hits, " << misses << " misses";
+  if (total != 0u) {
+    os << " (" << (100u * hits / total) << "% hit rate)";
+  }
+  os << "\n";
+}
+
+void CodeInfoCache::DumpStats(std::ostream& os) {
+  uint64_t code_info_hits = retired_stats_.code_info_hits.load(std::memory_order_relaxed);
+  uint64_t code_info_misses = retired_stats_.code_info_misses.load(std::memory_order_relaxed);
+  uint64_t stack_map_hits = retired_stats_.stack_map_hits.load(std::memory_order_relaxed);
+  uint64_t stack_map_misses = retired_stats_.stack_map_misses.load(std::memory_order_relaxed);
+  {
+    MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+    Runtime::Current()->GetThreadList()->ForEach([&](Thread* thread) {
+      const CodeInfoCache* cache = thread->GetCodeInfoCacheIfExists();
+      if (cache != nullptr) {
+        code_info_hits += cache->stats_.code_info_hits.load(std::memory_order_relaxed);
+        code_info_misses += cache->stats_.code_info_misses.load(std::memory_order_relaxed);
+        stack_map_hits += cache->stats_.stack_map_hits.load(std::memory_order_relaxed);
+        stack_map_misses += cache->stats_.stack_map_misses.load(std::memory_order_relaxed);
+      }
+    });
+  }
+  DumpHitRate(os, "CodeInfo", code_info_hits, code_info_misses);
+  DumpHitRate(os, "Stack map", stack_map_hits, stack_map_misses);
+}
+
+}  // namespace art
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CODE_INFO_CACHE_H_
+#define ART_RUNTIME_CODE_INFO_CACHE_H_
+
+#include <array>
+#include <atomic>
+#include <iosfwd>
+
+#include "base/bit_utils.h"
+#include "base/macros.h"
+#include "stack_map.h"
+
+namespace art {
+
+class OatQuickMethodHeader;
+class Thread;
+
+// Small thread-local cache of decoded CodeInfo headers and stack map lookups.
+//
+// Stack walks (GC root visiting, exception delivery, stack traces for the sampling profiler)
+// decode the CodeInfo of every compiled frame and binary search its stack maps. The same hot
+// methods show up again and again, so we remember the decoded tables keyed by method header,
+// and the stack map index keyed by method header and native pc offset.
+//
+// All operations must be done from the owning thread.
+//
+// Method headers can be reused when JIT code is collected or an oat file is unloaded. Rather
+// than clearing the caches of all threads in a checkpoint, we bump a global epoch whenever that
+// happens, and entries recorded in an older epoch are treated as misses.
+class CodeInfoCache {
+ public:
+  // Number of decoded CodeInfo headers per thread. Each entry is a few hundred bytes.
+  static constexpr size_t kCodeInfoSize = 16;
+  // Number of stack map lookups per thread.
+  static constexpr size_t kStackMapSize = 64;
+
+  CodeInfoCache();
+  ~CodeInfoCache();
+
+  // Returns the fully decoded CodeInfo of the given optimized method header.
+  CodeInfo GetCodeInfo(const OatQuickMethodHeader* header);
+
+  // Returns the stack map of `code_info` (which must belong to `header`) for the given native pc
+  // offset, like CodeInfo::GetStackMapForNativePcOffset.
+  StackMap GetStackMapForNativePcOffset(const OatQuickMethodHeader* header,
+                                        const CodeInfo& code_info,
+                                        uint32_t native_pc_offset);
+
+  // Invalidate the caches of all threads. Must be called before the memory of any method header
+  // can be reused for different code.
+  static void InvalidateAll() {
+    global_epoch_.fetch_add(1u, std::memory_order_release);
+  }
+
+  // Print the hit rates of all caches, including the ones of threads that have exited.
+  static void DumpStats(std::ostream& os);
+
+ private:
+  struct CodeInfoEntry {
+    const OatQuickMethodHeader* header = nullptr;
+    uint32_t epoch = 0u;
+    CodeInfo code_info;
+  };
+
+  struct StackMapEntry {
+    const OatQuickMethodHeader* header = nullptr;
+    uint32_t native_pc_offset = 0u;
+    uint32_t epoch = 0u;
+    uint32_t row = StackMap::kNoValue;
+  };
+
+  struct Stats {
+    std::atomic<uint64_t> code_info_hits{0u};
+    std::atomic<uint64_t> code_info_misses{0u};
+    std::atomic<uint64_t> stack_map_hits{0u};
+    std::atomic<uint64_t> stack_map_misses{0u};
+  };
+
+  static ALWAYS_INLINE size_t CodeInfoIndexOf(const OatQuickMethodHeader* header) {
+    static_assert(IsPowerOfTwo(kCodeInfoSize), "Size must be power of two");
+    return (reinterpret_cast<uintptr_t>(header) >> 4) & (kCodeInfoSize - 1);
+  }
+
+  static ALWAYS_INLINE size_t StackMapIndexOf(const OatQuickMethodHeader* header,
+                                              uint32_t native_pc_offset) {
+    static_assert(IsPowerOfTwo(kStackMapSize), "Size must be power of two");
+    return ((reinterpret_cast<uintptr_t>(header) >> 4) ^ native_pc_offset) & (kStackMapSize - 1);
+  }
+
+  static ALWAYS_INLINE uint32_t CurrentEpoch() {
+    return global_epoch_.load(std::memory_order_acquire);
+  }
+
+  // The counters are only written by the owning thread, but may be read by the thread dumping
+  // the statistics, so they are relaxed atomics updated without read-modify-write operations.
+  static ALWAYS_INLINE void Increment(std::atomic<uint64_t>* counter) {
+    counter->store(counter->load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+  }
+
+  std::array<CodeInfoEntry, kCodeInfoSize> code_infos_;
+  std::array<StackMapEntry, kStackMapSize> stack_maps_;
+  Stats stats_;
+
+  static std::atomic<uint32_t> global_epoch_;
+  // Statistics of the caches of threads that have exited.
+  static Stats retired_stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(CodeInfoCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CODE_INFO_CACHE_H_
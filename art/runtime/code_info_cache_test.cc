@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "code_info_cache.h"
+
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "base/bit_utils.h"
+#include "base/casts.h"
+#include "base/malloc_arena_pool.h"
+#include "base/scoped_arena_allocator.h"
+#include "dex/dex_file_types.h"
+#include "dexopt_test.h"
+#include "oat_file.h"
+#include "oat_file_assistant.h"
+#include "oat_file_manager.h"
+#include "oat_quick_method_header.h"
+#include "optimizing/stack_map_stream.h"
+#include "runtime.h"
+
+namespace art {
+
+constexpr static uint32_t kPcAlign = GetInstructionSetInstructionAlignment(kRuntimeISA);
+
+// Headers this far apart use the same CodeInfo cache entry.
+constexpr static size_t kCodeInfoCollisionStride = CodeInfoCache::kCodeInfoSize << 4;
+
+// The tests build method headers by hand, in front of no code, and point them at one of two
+// encoded CodeInfos. Pointing a header at the other CodeInfo stands for its memory being reused
+// for different code, which the cache cannot notice by itself.
+class CodeInfoCacheTest : public DexoptTest {
+ protected:
+  static constexpr size_t kCodeInfoSpace = 1024;
+  static constexpr size_t kHeaderSpace = 4 * kCodeInfoCollisionStride;
+
+  void SetUp() override {
+    DexoptTest::SetUp();
+    // CodeInfo `a_` has stack maps at pcs 4 and 8, and `b_` at pcs 2, 4, 8 and 12, all in units
+    // of the instruction alignment. Each stack map's dex pc tells which CodeInfo and row it is.
+    memory_.resize(kCodeInfoSpace + kHeaderSpace + kCodeInfoCollisionStride);
+    a_ = Encode({{4u, 10u}, {8u, 20u}}, &memory_[0]);
+    b_ = Encode({{2u, 30u}, {4u, 40u}, {8u, 50u}, {12u, 60u}}, &memory_[kCodeInfoSpace / 2]);
+  }
+
+  // Encodes a CodeInfo with stack maps at the given (native pc, dex pc) pairs into `out`.
+  static const uint8_t* Encode(const std::vector<std::pair<uint32_t, uint32_t>>& stack_maps,
+                               uint8_t* out) {
+    MallocArenaPool pool;
+    ArenaStack arena_stack(&pool);
+    ScopedArenaAllocator allocator(&arena_stack);
+    StackMapStream stream(&allocator, kRuntimeISA);
+    stream.BeginMethod(/* frame_size_in_bytes= */ 32,
+                       /* core_spill_mask= */ 0,
+                       /* fp_spill_mask= */ 0,
+                       /* num_dex_registers= */ 0);
+    for (const auto& [native_pc, dex_pc] : stack_maps) {
+      stream.BeginStackMapEntry(dex_pc, native_pc * kPcAlign);
+      stream.EndStackMapEntry();
+    }
+    stream.EndMethod();
+    ScopedArenaVector<uint8_t> encoded = stream.Encode();
+    CHECK_LE(encoded.size(), kCodeInfoSpace / 2);
+    std::copy(encoded.begin(), encoded.end(), out);
+    return out;
+  }
+
+  // Returns a method header in the given slot. Slots are 16 bytes apart.
+  OatQuickMethodHeader* NewHeader(size_t slot, const uint8_t* code_info) {
+    uint8_t* base = AlignUp(&memory_[kCodeInfoSpace], kCodeInfoCollisionStride);
+    CHECK_LT(slot * 16u, kHeaderSpace);
+    OatQuickMethodHeader* header =
+        new (base + slot * 16u) OatQuickMethodHeader(/* vmap_table_offset= */ 0u,
+                                                     /* code_size= */ 64u);
+    PointAt(header, code_info);
+    return header;
+  }
+
+  static void PointAt(OatQuickMethodHeader* header, const uint8_t* code_info) {
+    header->SetVmapTableOffset(dchecked_integral_cast<uint32_t>(header->GetCode() - code_info));
+  }
+
+  static uint32_t DexPcAt(CodeInfoCache* cache,
+                          const OatQuickMethodHeader* header,
+                          const CodeInfo& code_info,
+                          uint32_t native_pc) {
+    StackMap stack_map =
+        cache->GetStackMapForNativePcOffset(header, code_info, native_pc * kPcAlign);
+    return stack_map.IsValid() ? stack_map.GetDexPc() : dex::kDexNoIndex;
+  }
+
+  std::vector<uint8_t> memory_;
+  const uint8_t* a_;
+  const uint8_t* b_;
+};
+
+TEST_F(CodeInfoCacheTest, CodeInfoHit) {
+  CodeInfoCache cache;
+  OatQuickMethodHeader* header = NewHeader(0u, a_);
+  EXPECT_EQ(2u, cache.GetCodeInfo(header).GetNumberOfStackMaps());
+
+  // A hit returns the CodeInfo decoded before, wherever the header points now.
+  PointAt(header, b_);
+  EXPECT_EQ(2u, cache.GetCodeInfo(header).GetNumberOfStackMaps());
+
+  CodeInfoCache::InvalidateAll();
+  EXPECT_EQ(4u, cache.GetCodeInfo(header).GetNumberOfStackMaps());
+  EXPECT_EQ(4u, cache.GetCodeInfo(header).GetNumberOfStackMaps());
+}
+
+TEST_F(CodeInfoCacheTest, CodeInfoEviction) {
+  CodeInfoCache cache;
+  OatQuickMethodHeader* header = NewHeader(0u, a_);
+  OatQuickMethodHeader* neighbor = NewHeader(1u, b_);
+  OatQuickMethodHeader* colliding = NewHeader(CodeInfoCache::kCodeInfoSize, b_);
+  EXPECT_EQ(2u, cache.GetCodeInfo(header).GetNumberOfStackMaps());
+
+  // A header in another entry does not evict it.
+  EXPECT_EQ(4u, cache.GetCodeInfo(neighbor).GetNumberOfStackMaps());
+  PointAt(header, b_);
+  EXPECT_EQ(2u, cache.GetCodeInfo(header).GetNumberOfStackMaps());
+
+  // A header in the same entry does.
+  EXPECT_EQ(4u, cache.GetCodeInfo(colliding).GetNumberOfStackMaps());
+  EXPECT_EQ(4u, cache.GetCodeInfo(header).GetNumberOfStackMaps());
+}
+
+TEST_F(CodeInfoCacheTest, StackMapHit) {
+  CodeInfoCache cache;
+  OatQuickMethodHeader* header = NewHeader(0u, a_);
+  CodeInfo a(a_);
+  CodeInfo b(b_);
+  EXPECT_EQ(20u, DexPcAt(&cache, header, a, 8u));
+  EXPECT_EQ(dex::kDexNoIndex, DexPcAt(&cache, header, a, 12u));
+
+  // A hit returns the row found before, even the lack of one, in the CodeInfo it is given.
+  EXPECT_EQ(40u, DexPcAt(&cache, header, b, 8u));
+  EXPECT_EQ(dex::kDexNoIndex, DexPcAt(&cache, header, b, 12u));
+
+  CodeInfoCache::InvalidateAll();
+  EXPECT_EQ(50u, DexPcAt(&cache, header, b, 8u));
+  EXPECT_EQ(60u, DexPcAt(&cache, header, b, 12u));
+}
+
+TEST_F(CodeInfoCacheTest, StackMapEviction) {
+  CodeInfoCache cache;
+  OatQuickMethodHeader* header = NewHeader(0u, a_);
+  CodeInfo a(a_);
+  CodeInfo b(b_);
+  EXPECT_EQ(20u, DexPcAt(&cache, header, a, 8u));
+
+  // Another pc of the same method in another entry does not evict it.
+  EXPECT_EQ(10u, DexPcAt(&cache, header, a, 4u));
+  EXPECT_EQ(40u, DexPcAt(&cache, header, b, 8u));
+
+  // A pc in the same entry does.
+  uint32_t colliding_pc = 8u + CodeInfoCache::kStackMapSize / kPcAlign;
+  EXPECT_EQ(dex::kDexNoIndex, DexPcAt(&cache, header, a, colliding_pc));
+  EXPECT_EQ(50u, DexPcAt(&cache, header, b, 8u));
+}
+
+TEST_F(CodeInfoCacheTest, InvalidatedByOatUnload) {
+  std::string dex_location = GetScratchDir() + "/CodeInfoCache.jar";
+  Copy(GetDexSrc1(), dex_location);
+  GenerateOatForTest(dex_location.c_str(), CompilerFilter::kSpeed);
+  std::string oat_location;
+  std::string error_msg;
+  ASSERT_TRUE(OatFileAssistant::DexLocationToOatFilename(
+        dex_location, kRuntimeISA, &oat_location, &error_msg)) << error_msg;
+  std::unique_ptr<OatFile> oat_file(OatFile::Open(/*zip_fd=*/ -1,
+                                                  oat_location,
+                                                  oat_location,
+                                                  /*executable=*/ false,
+                                                  /*low_4gb=*/ false,
+                                                  dex_location,
+                                                  &error_msg));
+  ASSERT_TRUE(oat_file != nullptr) << error_msg;
+  OatFileManager& oat_file_manager = Runtime::Current()->GetOatFileManager();
+  const OatFile* registered = oat_file_manager.RegisterOatFile(std::move(oat_file));
+
+  CodeInfoCache cache;
+  OatQuickMethodHeader* header = NewHeader(0u, a_);
+  CodeInfo a(a_);
+  CodeInfo b(b_);
+  EXPECT_EQ(2u, cache.GetCodeInfo(header).GetNumberOfStackMaps());
+  EXPECT_EQ(20u, DexPcAt(&cache, header, a, 8u));
+  PointAt(header, b_);
+  EXPECT_EQ(2u, cache.GetCodeInfo(header).GetNumberOfStackMaps());
+  EXPECT_EQ(40u, DexPcAt(&cache, header, b, 8u));
+
+  // The headers of the unloaded file may be reused, so nothing cached before stays valid.
+  oat_file_manager.UnRegisterAndDeleteOatFile(registered);
+  EXPECT_EQ(4u, cache.GetCodeInfo(header).GetNumberOfStackMaps());
+  EXPECT_EQ(50u, DexPcAt(&cache, header, b, 8u));
+}
+
+}  // namespace art
@@ -16,6 +16,8 @@
 
 #include "allocation_record.h"
 
+#include <cmath>
+
 #include "art_method-inl.h"
 #include "base/enums.h"
 #include "base/logging.h"  // For VLOG
@@ -23,6 +25,7 @@
 #include "obj_ptr-inl.h"
 #include "object_callbacks.h"
 #include "stack.h"
+#include "thread-current-inl.h"
 
 #include <android-base/properties.h>
 
@@ -50,6 +53,50 @@ AllocRecordObjectMap::~AllocRecordObjectMap() {
   Clear();
 }
 
+const AllocRecordStackTrace* AllocRecordObjectMap::InternStackTrace(
+    AllocRecordStackTrace&& trace) {
+  auto it = traces_.emplace(std::move(trace), 0u).first;
+  ++it->second;
+  return &it->first;
+}
+
+void AllocRecordObjectMap::ReleaseStackTrace(const AllocRecordStackTrace* trace) {
+  auto it = traces_.find(*trace);
+  DCHECK(it != traces_.end());
+  DCHECK_EQ(&it->first, trace);
+  DCHECK_NE(it->second, 0u);
+  if (--it->second == 0u) {
+    traces_.erase(it);
+  }
+}
+
+bool AllocRecordObjectMap::ShouldSampleAllocation(Thread* self, size_t byte_count) {
+  size_t sample_interval = GetSampleInterval();
+  if (sample_interval == 0u) {
+    return true;
+  }
+  size_t bytes_until_sample = self->GetAllocTrackerBytesUntilSample();
+  if (byte_count < bytes_until_sample) {
+    self->SetAllocTrackerBytesUntilSample(bytes_until_sample - byte_count);
+    return false;
+  }
+  // Draw the distance to the next sample from an exponential distribution with the requested
+  // mean, using a per-thread xorshift generator.
+  uint64_t* seed = self->GetAllocTrackerSampleSeed();
+  if (*seed == 0u) {
+    *seed = (static_cast<uint64_t>(self->GetTid()) << 32) ^ reinterpret_cast<uintptr_t>(self) ^ 1u;
+  }
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 7;
+  *seed ^= *seed << 17;
+  // Uniform in (0, 1].
+  double uniform = (static_cast<double>(*seed >> 11) + 1.0) / static_cast<double>(1ull << 53);
+  double distance = -std::log(uniform) * static_cast<double>(sample_interval);
+  self->SetAllocTrackerBytesUntilSample(
+      static_cast<size_t>(std::min(distance, static_cast<double>(sample_interval) * 64.0)) + 1u);
+  return true;
+}
+
 void AllocRecordObjectMap::VisitRoots(RootVisitor* visitor) {
   CHECK_LE(recent_record_max_, alloc_record_max_);
   BufferedRootVisitor<kDefaultBufferedRootCount> buffered_visitor(visitor, RootInfo(kRootDebugger));
@@ -106,6 +153,7 @@ void AllocRecordObjectMap::SweepAllocationRecords(IsMarkedVisitor* visitor) {
         SweepClassObject(&record, visitor);
         ++it;
       } else {
+        ReleaseStackTrace(record.GetStackTrace());
         it = entries_.erase(it);
         ++count_deleted;
       }
@@ -153,11 +201,20 @@ void AllocRecordObjectMap::SetAllocTrackingEnabled(bool enable) {
       }
       CHECK(records != nullptr);
       records->SetMaxStackDepth(heap->GetAllocTrackerStackDepth());
+#ifdef ART_TARGET_ANDROID
+      // Sampling keeps the overhead low enough to leave tracking on in production.
+      records->SetSampleInterval(android::base::GetUintProperty<size_t>(
+          "dalvik.vm.allocTrackerSampleInterval", kDefaultSampleInterval));
+#endif
       size_t sz = sizeof(AllocRecordStackTraceElement) * records->max_stack_depth_ +
                   sizeof(AllocRecord) + sizeof(AllocRecordStackTrace);
       LOG(INFO) << "Enabling alloc tracker (" << records->alloc_record_max_ << " entries of "
                 << records->max_stack_depth_ << " frames, taking up to "
                 << PrettySize(sz * records->alloc_record_max_) << ")";
+      if (records->GetSampleInterval() != 0u) {
+        LOG(INFO) << "Sampling one allocation every "
+                  << PrettySize(records->GetSampleInterval()) << " on average";
+      }
     }
     Runtime::Current()->GetInstrumentation()->InstrumentQuickAllocEntryPoints();
     {
@@ -185,6 +242,9 @@ void AllocRecordObjectMap::SetAllocTrackingEnabled(bool enable) {
 void AllocRecordObjectMap::RecordAllocation(Thread* self,
                                             ObjPtr<mirror::Object>* obj,
                                             size_t byte_count) {
+  if (!ShouldSampleAllocation(self, byte_count)) {
+    return;
+  }
   // Get stack trace outside of lock in case there are allocations during the stack walk.
   // b/27858645.
   AllocRecordStackTrace trace;
@@ -242,12 +302,13 @@ void AllocRecordObjectMap::RecordAllocation(Thread* self,
   trace.SetTid(self->GetTid());
 
   // Add the record.
-  Put(obj->Ptr(), AllocRecord(byte_count, (*obj)->GetClass(), std::move(trace)));
+  Put(obj->Ptr(), byte_count, (*obj)->GetClass(), std::move(trace));
   DCHECK_LE(Size(), alloc_record_max_);
 }
 
 void AllocRecordObjectMap::Clear() {
   entries_.clear();
+  traces_.clear();
 }
 
 AllocRecordObjectMap::AllocRecordObjectMap()
@@ -17,8 +17,10 @@
 #ifndef ART_RUNTIME_GC_ALLOCATION_RECORD_H_
 #define ART_RUNTIME_GC_ALLOCATION_RECORD_H_
 
+#include <atomic>
 #include <list>
 #include <memory>
+#include <unordered_map>
 
 #include "base/mutex.h"
 #include "gc_root.h"
@@ -155,16 +157,17 @@ template <typename T> struct EqAllocRecordTypesPtr {
 
 class AllocRecord {
  public:
-  // All instances of AllocRecord should be managed by an instance of AllocRecordObjectMap.
-  AllocRecord(size_t count, mirror::Class* klass, AllocRecordStackTrace&& trace)
-      : byte_count_(count), klass_(klass), trace_(std::move(trace)) {}
+  // All instances of AllocRecord should be managed by an instance of AllocRecordObjectMap,
+  // which also owns the (shared) stack trace.
+  AllocRecord(size_t count, mirror::Class* klass, const AllocRecordStackTrace* trace)
+      : byte_count_(count), klass_(klass), trace_(trace) {}
 
   size_t GetDepth() const {
-    return trace_.GetDepth();
+    return trace_->GetDepth();
   }
 
   const AllocRecordStackTrace* GetStackTrace() const {
-    return &trace_;
+    return trace_;
   }
 
   size_t ByteCount() const {
@@ -172,7 +175,7 @@ class AllocRecord {
   }
 
   pid_t GetTid() const {
-    return trace_.GetTid();
+    return trace_->GetTid();
   }
 
   mirror::Class* GetClass() const REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -187,15 +190,15 @@ class AllocRecord {
   }
 
   const AllocRecordStackTraceElement& StackElement(size_t index) const {
-    return trace_.GetStackElement(index);
+    return trace_->GetStackElement(index);
   }
 
  private:
   const size_t byte_count_;
   // The klass_ could be a strong or weak root for GC
   GcRoot<mirror::Class> klass_;
-  // TODO: Share between alloc records with identical stack traces.
-  AllocRecordStackTrace trace_;
+  // Shared between alloc records with identical stack traces, see AllocRecordObjectMap::traces_.
+  const AllocRecordStackTrace* trace_;
 };
 
 class AllocRecordObjectMap {
@@ -204,6 +207,8 @@ class AllocRecordObjectMap {
   static constexpr size_t kDefaultNumRecentRecords = 64 * 1024 - 1;
   static constexpr size_t kDefaultAllocStackDepth = 16;
   static constexpr size_t kMaxSupportedStackDepth = 128;
+  // By default every allocation is recorded.
+  static constexpr size_t kDefaultSampleInterval = 0;
 
   // GcRoot<mirror::Object> pointers in the list are weak roots, and the last recent_record_max_
   // number of AllocRecord::klass_ pointers are strong roots (and the rest of klass_ pointers are
@@ -226,13 +231,33 @@ class AllocRecordObjectMap {
   AllocRecordObjectMap() REQUIRES(Locks::alloc_tracker_lock_);
   ~AllocRecordObjectMap();
 
-  void Put(mirror::Object* obj, AllocRecord&& record)
+  void Put(mirror::Object* obj, size_t byte_count, mirror::Class* klass,
+           AllocRecordStackTrace&& trace)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(Locks::alloc_tracker_lock_) {
     if (entries_.size() == alloc_record_max_) {
+      ReleaseStackTrace(entries_.front().second.GetStackTrace());
       entries_.pop_front();
     }
-    entries_.push_back(EntryPair(GcRoot<mirror::Object>(obj), std::move(record)));
+    const AllocRecordStackTrace* shared_trace = InternStackTrace(std::move(trace));
+    entries_.push_back(
+        EntryPair(GcRoot<mirror::Object>(obj), AllocRecord(byte_count, klass, shared_trace)));
+  }
+
+  // Number of distinct stack traces referenced by the records.
+  size_t NumStackTraces() const REQUIRES_SHARED(Locks::alloc_tracker_lock_) {
+    return traces_.size();
+  }
+
+  // Record only a sample of the allocations: on average one every `sample_interval` bytes,
+  // with the distance between samples drawn from an exponential distribution so that every
+  // allocated byte has the same chance of being sampled. Zero records every allocation.
+  void SetSampleInterval(size_t sample_interval) {
+    sample_interval_.store(sample_interval, std::memory_order_relaxed);
+  }
+
+  size_t GetSampleInterval() const {
+    return sample_interval_.load(std::memory_order_relaxed);
   }
 
   size_t Size() const REQUIRES_SHARED(Locks::alloc_tracker_lock_) {
@@ -296,6 +321,14 @@ class AllocRecordObjectMap {
   void Clear() REQUIRES(Locks::alloc_tracker_lock_);
 
  private:
+  // Returns whether the allocation should be recorded, and updates the sampling state of `self`.
+  bool ShouldSampleAllocation(Thread* self, size_t byte_count);
+
+  const AllocRecordStackTrace* InternStackTrace(AllocRecordStackTrace&& trace)
+      REQUIRES(Locks::alloc_tracker_lock_);
+  void ReleaseStackTrace(const AllocRecordStackTrace* trace)
+      REQUIRES(Locks::alloc_tracker_lock_);
+
   size_t alloc_record_max_ GUARDED_BY(Locks::alloc_tracker_lock_) = kDefaultNumAllocRecords;
   size_t recent_record_max_ GUARDED_BY(Locks::alloc_tracker_lock_) = kDefaultNumRecentRecords;
   size_t max_stack_depth_ = kDefaultAllocStackDepth;
@@ -303,6 +336,11 @@ class AllocRecordObjectMap {
   ConditionVariable new_record_condition_ GUARDED_BY(Locks::alloc_tracker_lock_);
   // see the comment in typedef of EntryList
   EntryList entries_ GUARDED_BY(Locks::alloc_tracker_lock_);
+  // Stack traces referenced by the records in entries_, with their number of references.
+  // Records allocated from the same call site in a loop all share a single trace.
+  std::unordered_map<AllocRecordStackTrace, size_t, HashAllocRecordTypes> traces_
+      GUARDED_BY(Locks::alloc_tracker_lock_);
+  std::atomic<size_t> sample_interval_{kDefaultSampleInterval};
 
   void SetMaxStackDepth(size_t max_stack_depth) REQUIRES(Locks::alloc_tracker_lock_);
 };
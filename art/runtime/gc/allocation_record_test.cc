@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_record.h"
+
+#include <thread>
+#include <vector>
+
+#include "common_runtime_test.h"
+#include "gc/heap.h"
+#include "handle_scope-inl.h"
+#include "mirror/object-inl.h"
+#include "mirror/string-alloc-inl.h"
+#include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
+#include "thread-current-inl.h"
+
+namespace art {
+namespace gc {
+
+class AllocationRecordTest : public CommonRuntimeTest {
+ protected:
+  void TearDown() override {
+    AllocRecordObjectMap::SetAllocTrackingEnabled(false);
+    CommonRuntimeTest::TearDown();
+  }
+
+  // Turns on tracking and returns the records. The runtime records the objects it allocates
+  // while tracking is on, so the tests allocate their objects first and record them by hand.
+  static AllocRecordObjectMap* EnableTracking(Thread* self) REQUIRES_SHARED(Locks::mutator_lock_) {
+    {
+      ScopedThreadSuspension sts(self, ThreadState::kSuspended);
+      AllocRecordObjectMap::SetAllocTrackingEnabled(true);
+    }
+    MutexLock mu(self, *Locks::alloc_tracker_lock_);
+    return Runtime::Current()->GetHeap()->GetAllocationRecords();
+  }
+
+  static size_t NumRecords(Thread* self, AllocRecordObjectMap* records) {
+    MutexLock mu(self, *Locks::alloc_tracker_lock_);
+    return records->Size();
+  }
+
+  // Returns whether the allocation was recorded.
+  static bool Record(Thread* self,
+                     AllocRecordObjectMap* records,
+                     Handle<mirror::Object> object,
+                     size_t byte_count) REQUIRES_SHARED(Locks::mutator_lock_) {
+    size_t num_records = NumRecords(self, records);
+    ObjPtr<mirror::Object> obj = object.Get();
+    records->RecordAllocation(self, &obj, byte_count);
+    return NumRecords(self, records) != num_records;
+  }
+};
+
+TEST_F(AllocationRecordTest, RecordsInOrder) {
+  static constexpr size_t kNumObjects = 5;
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  StackHandleScope<kNumObjects> hs(self);
+  std::vector<Handle<mirror::Object>> objects;
+  for (size_t i = 0; i != kNumObjects; ++i) {
+    objects.push_back(hs.NewHandle<mirror::Object>(
+        mirror::String::AllocFromModifiedUtf8(self, "record")));
+    ASSERT_TRUE(objects.back() != nullptr);
+  }
+
+  AllocRecordObjectMap* records = EnableTracking(self);
+  ASSERT_EQ(0u, records->GetSampleInterval());
+  for (size_t i = 0; i != kNumObjects; ++i) {
+    EXPECT_TRUE(Record(self, records, objects[i], (i + 1u) * 8u));
+  }
+  // Without sampling, the sampling state of the thread is left alone.
+  EXPECT_EQ(0u, self->GetAllocTrackerBytesUntilSample());
+
+  // Oldest first, and the most recent allocation last.
+  MutexLock mu(self, *Locks::alloc_tracker_lock_);
+  ASSERT_EQ(kNumObjects, records->Size());
+  size_t i = 0;
+  for (auto it = records->Begin(); it != records->End(); ++it, ++i) {
+    EXPECT_EQ(objects[i].Get(), it->first.Read());
+    EXPECT_EQ((i + 1u) * 8u, it->second.ByteCount());
+    EXPECT_EQ(self->GetTid(), it->second.GetTid());
+    // The allocations come from the same place, so they all share one stack trace.
+    EXPECT_EQ(records->Begin()->second.GetStackTrace(), it->second.GetStackTrace());
+  }
+  EXPECT_EQ(objects.back().Get(), records->RBegin()->first.Read());
+  EXPECT_EQ(1u, records->NumStackTraces());
+}
+
+TEST_F(AllocationRecordTest, SampleInterval) {
+  static constexpr size_t kSampleInterval = 1000;
+  static constexpr size_t kNumSamples = 10000;
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  StackHandleScope<1> hs(self);
+  Handle<mirror::Object> object =
+      hs.NewHandle<mirror::Object>(mirror::String::AllocFromModifiedUtf8(self, "sampled"));
+  ASSERT_TRUE(object != nullptr);
+
+  AllocRecordObjectMap* records = EnableTracking(self);
+  records->SetSampleInterval(kSampleInterval);
+
+  // The first allocation of a thread is always sampled.
+  ASSERT_TRUE(Record(self, records, object, 8u));
+
+  // Allocating exactly the bytes left until the next sample takes it, which reads back the
+  // distances between samples one by one.
+  uint64_t total_distance = 0u;
+  for (size_t i = 0; i != kNumSamples; ++i) {
+    size_t distance = self->GetAllocTrackerBytesUntilSample();
+    ASSERT_GE(distance, 1u);
+    ASSERT_LE(distance, 64u * kSampleInterval + 1u);
+    total_distance += distance;
+    if (distance > 1u) {
+      ASSERT_FALSE(Record(self, records, object, distance - 1u));
+      ASSERT_EQ(1u, self->GetAllocTrackerBytesUntilSample());
+    }
+    ASSERT_TRUE(Record(self, records, object, 1u));
+  }
+  EXPECT_EQ(kNumSamples + 1u, NumRecords(self, records));
+
+  // The distances are exponentially distributed with the interval as their mean, so the
+  // average of this many is well within 10% of it.
+  double mean = static_cast<double>(total_distance) / kNumSamples;
+  EXPECT_GT(mean, 0.9 * kSampleInterval);
+  EXPECT_LT(mean, 1.1 * kSampleInterval);
+}
+
+TEST_F(AllocationRecordTest, SamplingIsPerThread) {
+  static constexpr size_t kSampleInterval = 4096;
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  StackHandleScope<1> hs(self);
+  Handle<mirror::Object> object =
+      hs.NewHandle<mirror::Object>(mirror::String::AllocFromModifiedUtf8(self, "sampled"));
+  ASSERT_TRUE(object != nullptr);
+
+  AllocRecordObjectMap* records = EnableTracking(self);
+  records->SetSampleInterval(kSampleInterval);
+  ASSERT_TRUE(Record(self, records, object, 8u));
+  size_t distance = self->GetAllocTrackerBytesUntilSample();
+  if (distance > 1u) {
+    ASSERT_FALSE(Record(self, records, object, distance - 1u));
+  }
+  ASSERT_EQ(1u, self->GetAllocTrackerBytesUntilSample());
+
+  // Another thread counts down from its own first allocation, and leaves this one's count alone.
+  pid_t other_tid = 0;
+  std::thread other([&]() {
+    Runtime* runtime = Runtime::Current();
+    CHECK(runtime->AttachCurrentThread("AllocationRecordTest", false, nullptr, false));
+    {
+      Thread* other_self = Thread::Current();
+      ScopedObjectAccess other_soa(other_self);
+      other_tid = other_self->GetTid();
+      EXPECT_EQ(0u, other_self->GetAllocTrackerBytesUntilSample());
+      EXPECT_TRUE(Record(other_self, records, object, 8u));
+      EXPECT_NE(0u, other_self->GetAllocTrackerBytesUntilSample());
+    }
+    runtime->DetachCurrentThread();
+  });
+  {
+    ScopedThreadSuspension sts(self, ThreadState::kSuspended);
+    other.join();
+  }
+  EXPECT_EQ(1u, self->GetAllocTrackerBytesUntilSample());
+  EXPECT_TRUE(Record(self, records, object, 1u));
+
+  // The records of both threads are in the order they were taken, each with its own trace.
+  MutexLock mu(self, *Locks::alloc_tracker_lock_);
+  std::vector<pid_t> tids;
+  for (auto it = records->Begin(); it != records->End(); ++it) {
+    tids.push_back(it->second.GetTid());
+  }
+  EXPECT_EQ(std::vector<pid_t>({self->GetTid(), other_tid, self->GetTid()}), tids);
+  EXPECT_EQ(2u, records->NumStackTraces());
+}
+
+}  // namespace gc
+}  // namespace art
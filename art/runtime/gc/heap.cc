@@ -1192,6 +1192,8 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
     }
   }
 
+  reference_processor_->DumpStats(os);
+
   if (kDumpRosAllocStatsOnSigQuit && rosalloc_space_ != nullptr) {
     rosalloc_space_->DumpStats(os);
   }
@@ -1209,6 +1211,7 @@ void Heap::ResetGcPerformanceInfo() {
   for (auto* collector : garbage_collectors_) {
     collector->ResetMeasurements();
   }
+  reference_processor_->ResetStats();
 
   process_cpu_start_time_ns_ = ProcessCpuNanoTime();
 
@@ -17,6 +17,7 @@
 #include "reference_processor.h"
 
 #include "art_field-inl.h"
+#include "base/histogram-inl.h"
 #include "base/mutex.h"
 #include "base/time_utils.h"
 #include "base/utils.h"
@@ -39,6 +40,10 @@ namespace gc {
 
 static constexpr bool kAsyncReferenceQueueAdd = false;
 
+// Bucket width (in microseconds) and count of the reference handoff latency histogram.
+static constexpr uint64_t kHandoffLatencyBucketSize = 100;
+static constexpr size_t kHandoffLatencyBucketCount = 100;
+
 ReferenceProcessor::ReferenceProcessor()
     : collector_(nullptr),
       preserving_references_(false),
@@ -47,7 +52,18 @@ ReferenceProcessor::ReferenceProcessor()
       weak_reference_queue_(Locks::reference_queue_weak_references_lock_),
       finalizer_reference_queue_(Locks::reference_queue_finalizer_references_lock_),
       phantom_reference_queue_(Locks::reference_queue_phantom_references_lock_),
-      cleared_references_(Locks::reference_queue_cleared_references_lock_) {
+      cleared_references_(Locks::reference_queue_cleared_references_lock_),
+      num_cleared_references_(0u),
+      num_cleared_finalizers_(0u),
+      cleared_references_start_ns_(0u),
+      stats_lock_("reference processor stats lock", kDefaultMutexLevel),
+      num_handoffs_(0u),
+      num_references_handed_off_(0u),
+      num_finalizers_handed_off_(0u),
+      max_handoff_size_(0u),
+      handoff_latency_histogram_("Reference queue handoff latency",
+                                 kHandoffLatencyBucketSize,
+                                 kHandoffLatencyBucketCount) {
 }
 
 static inline MemberOffset GetSlowPathFlagOffset(ObjPtr<mirror::Class> reference_class)
@@ -190,8 +206,10 @@ void ReferenceProcessor::ProcessReferences(bool concurrent,
     }
   }
   // Clear all remaining soft and weak references with white referents.
-  soft_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
-  weak_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  size_t num_cleared = 0u;
+  num_cleared += soft_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  num_cleared += weak_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  size_t num_finalizers = 0u;
   {
     TimingLogger::ScopedTiming t2(concurrent ? "EnqueueFinalizerReferences" :
         "(Paused)EnqueueFinalizerReferences", timings);
@@ -199,17 +217,18 @@ void ReferenceProcessor::ProcessReferences(bool concurrent,
       StartPreservingReferences(self);
     }
     // Preserve all white objects with finalize methods and schedule them for finalization.
-    finalizer_reference_queue_.EnqueueFinalizerReferences(&cleared_references_, collector);
+    num_finalizers =
+        finalizer_reference_queue_.EnqueueFinalizerReferences(&cleared_references_, collector);
     collector->ProcessMarkStack();
     if (concurrent) {
       StopPreservingReferences(self);
     }
   }
   // Clear all finalizer referent reachable soft and weak references with white referents.
-  soft_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
-  weak_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  num_cleared += soft_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  num_cleared += weak_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
   // Clear all phantom references with white referents.
-  phantom_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  num_cleared += phantom_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
   // At this point all reference queues other than the cleared references should be empty.
   DCHECK(soft_reference_queue_.IsEmpty());
   DCHECK(weak_reference_queue_.IsEmpty());
@@ -222,6 +241,13 @@ void ReferenceProcessor::ProcessReferences(bool concurrent,
     // starts since there is a small window of time where slow_path_enabled_ is enabled but the
     // callback isn't yet set.
     collector_ = nullptr;
+    if (num_cleared + num_finalizers != 0u) {
+      if (num_cleared_references_ == 0u) {
+        cleared_references_start_ns_ = NanoTime();
+      }
+      num_cleared_references_ += num_cleared + num_finalizers;
+      num_cleared_finalizers_ += num_finalizers;
+    }
     if (!kUseReadBarrier && concurrent) {
       // Done processing, disable the slow path and broadcast to the waiters.
       DisableSlowPath(self);
@@ -275,19 +301,33 @@ void ReferenceProcessor::UpdateRoots(IsMarkedVisitor* visitor) {
 
 class ClearedReferenceTask : public HeapTask {
  public:
-  explicit ClearedReferenceTask(jobject cleared_references)
-      : HeapTask(NanoTime()), cleared_references_(cleared_references) {
+  ClearedReferenceTask(jobject cleared_references,
+                       size_t num_references,
+                       size_t num_finalizers,
+                       uint64_t cleared_start_ns)
+      : HeapTask(NanoTime()),
+        cleared_references_(cleared_references),
+        num_references_(num_references),
+        num_finalizers_(num_finalizers),
+        cleared_start_ns_(cleared_start_ns) {
   }
   void Run(Thread* thread) override {
-    ScopedObjectAccess soa(thread);
-    jvalue args[1];
-    args[0].l = cleared_references_;
-    InvokeWithJValues(soa, nullptr, WellKnownClasses::java_lang_ref_ReferenceQueue_add, args);
-    soa.Env()->DeleteGlobalRef(cleared_references_);
+    {
+      ScopedObjectAccess soa(thread);
+      jvalue args[1];
+      args[0].l = cleared_references_;
+      InvokeWithJValues(soa, nullptr, WellKnownClasses::java_lang_ref_ReferenceQueue_add, args);
+      soa.Env()->DeleteGlobalRef(cleared_references_);
+    }
+    Runtime::Current()->GetHeap()->GetReferenceProcessor()->RecordHandoff(
+        thread, num_references_, num_finalizers_, NanoTime() - cleared_start_ns_);
   }
 
  private:
   const jobject cleared_references_;
+  const size_t num_references_;
+  const size_t num_finalizers_;
+  const uint64_t cleared_start_ns_;
 };
 
 SelfDeletingTask* ReferenceProcessor::CollectClearedReferences(Thread* self) {
@@ -295,6 +335,17 @@ SelfDeletingTask* ReferenceProcessor::CollectClearedReferences(Thread* self) {
   // By default we don't actually need to do anything. Just return this no-op task to avoid having
   // to put in ifs.
   std::unique_ptr<SelfDeletingTask> result(new FunctionTask([](Thread*) {}));
+  size_t num_references;
+  size_t num_finalizers;
+  uint64_t cleared_start_ns;
+  {
+    MutexLock mu(self, *Locks::reference_processor_lock_);
+    num_references = num_cleared_references_;
+    num_finalizers = num_cleared_finalizers_;
+    cleared_start_ns = cleared_references_start_ns_;
+    num_cleared_references_ = 0u;
+    num_cleared_finalizers_ = 0u;
+  }
   // When a runtime isn't started there are no reference queues to care about so ignore.
   if (!cleared_references_.IsEmpty()) {
     if (LIKELY(Runtime::Current()->IsStarted())) {
@@ -304,13 +355,17 @@ SelfDeletingTask* ReferenceProcessor::CollectClearedReferences(Thread* self) {
         cleared_references = self->GetJniEnv()->GetVm()->AddGlobalRef(
             self, cleared_references_.GetList());
       }
+      // The whole list is handed to the Java side at once. ReferenceQueue.add() links it to the
+      // pending list and wakes up the ReferenceQueueDaemon, which then enqueues the references
+      // (including the finalizer references) on their queues in one go.
+      ClearedReferenceTask* task = new ClearedReferenceTask(
+          cleared_references, num_references, num_finalizers, cleared_start_ns);
       if (kAsyncReferenceQueueAdd) {
         // TODO: This can cause RunFinalization to terminate before newly freed objects are
         // finalized since they may not be enqueued by the time RunFinalization starts.
-        Runtime::Current()->GetHeap()->GetTaskProcessor()->AddTask(
-            self, new ClearedReferenceTask(cleared_references));
+        Runtime::Current()->GetHeap()->GetTaskProcessor()->AddTask(self, task);
       } else {
-        result.reset(new ClearedReferenceTask(cleared_references));
+        result.reset(task);
       }
     }
     cleared_references_.Clear();
@@ -318,6 +373,51 @@ SelfDeletingTask* ReferenceProcessor::CollectClearedReferences(Thread* self) {
   return result.release();
 }
 
+void ReferenceProcessor::RecordHandoff(Thread* self,
+                                       size_t num_references,
+                                       size_t num_finalizers,
+                                       uint64_t latency_ns) {
+  MutexLock mu(self, stats_lock_);
+  ++num_handoffs_;
+  num_references_handed_off_ += num_references;
+  num_finalizers_handed_off_ += num_finalizers;
+  max_handoff_size_ = std::max(max_handoff_size_, num_references);
+  handoff_latency_histogram_.AdjustAndAddValue(latency_ns);
+}
+
+void ReferenceProcessor::DumpStats(std::ostream& os) {
+  Thread* self = Thread::Current();
+  // References the GC cleared that are not on the Java side yet; this is not the length of the
+  // Java reference queues.
+  size_t num_not_handed_off;
+  {
+    MutexLock mu(self, *Locks::reference_processor_lock_);
+    num_not_handed_off = num_cleared_references_;
+  }
+  MutexLock mu(self, stats_lock_);
+  if (num_handoffs_ == 0u && num_not_handed_off == 0u) {
+    return;
+  }
+  os << "Cleared references handed to the reference queue: " << num_references_handed_off_
+     << " (finalizer references: " << num_finalizers_handed_off_ << ")"
+     << " in " << num_handoffs_ << " handoffs, largest handoff: " << max_handoff_size_
+     << ", cleared but not handed off yet: " << num_not_handed_off << "\n";
+  if (handoff_latency_histogram_.SampleSize() > 0u) {
+    Histogram<uint64_t>::CumulativeData cumulative_data;
+    handoff_latency_histogram_.CreateHistogram(&cumulative_data);
+    handoff_latency_histogram_.PrintConfidenceIntervals(os, 0.99, cumulative_data);
+  }
+}
+
+void ReferenceProcessor::ResetStats() {
+  MutexLock mu(Thread::Current(), stats_lock_);
+  num_handoffs_ = 0u;
+  num_references_handed_off_ = 0u;
+  num_finalizers_handed_off_ = 0u;
+  max_handoff_size_ = 0u;
+  handoff_latency_histogram_.Reset();
+}
+
 void ReferenceProcessor::ClearReferent(ObjPtr<mirror::Reference> ref) {
   Thread* self = Thread::Current();
   MutexLock mu(self, *Locks::reference_processor_lock_);
@@ -17,7 +17,11 @@
 #ifndef ART_RUNTIME_GC_REFERENCE_PROCESSOR_H_
 #define ART_RUNTIME_GC_REFERENCE_PROCESSOR_H_
 
+#include <iosfwd>
+
+#include "base/histogram.h"
 #include "base/locks.h"
+#include "base/mutex.h"
 #include "jni.h"
 #include "reference_queue.h"
 #include "runtime_globals.h"
@@ -78,6 +82,16 @@ class ReferenceProcessor {
   void ClearReferent(ObjPtr<mirror::Reference> ref)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::reference_processor_lock_);
+  // Records that `num_references` cleared references, `num_finalizers` of them finalizer
+  // references, were added to the Java reference queue `latency_ns` after the GC cleared them.
+  void RecordHandoff(Thread* self,
+                     size_t num_references,
+                     size_t num_finalizers,
+                     uint64_t latency_ns) REQUIRES(!stats_lock_);
+  // Dump the number of references handed to the Java reference queue and the handoff latency.
+  void DumpStats(std::ostream& os)
+      REQUIRES(!Locks::reference_processor_lock_, !stats_lock_);
+  void ResetStats() REQUIRES(!stats_lock_);
 
  private:
   bool SlowPathEnabled() REQUIRES_SHARED(Locks::mutator_lock_);
@@ -108,6 +122,19 @@ class ReferenceProcessor {
   ReferenceQueue finalizer_reference_queue_;
   ReferenceQueue phantom_reference_queue_;
   ReferenceQueue cleared_references_;
+  // Number of references in cleared_references_, and how many of them are finalizer references.
+  size_t num_cleared_references_ GUARDED_BY(Locks::reference_processor_lock_);
+  size_t num_cleared_finalizers_ GUARDED_BY(Locks::reference_processor_lock_);
+  // Time at which the oldest reference in cleared_references_ was cleared.
+  uint64_t cleared_references_start_ns_ GUARDED_BY(Locks::reference_processor_lock_);
+
+  // Statistics about the handoffs of cleared references to the Java reference queue.
+  Mutex stats_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  uint64_t num_handoffs_ GUARDED_BY(stats_lock_);
+  uint64_t num_references_handed_off_ GUARDED_BY(stats_lock_);
+  uint64_t num_finalizers_handed_off_ GUARDED_BY(stats_lock_);
+  size_t max_handoff_size_ GUARDED_BY(stats_lock_);
+  Histogram<uint64_t> handoff_latency_histogram_ GUARDED_BY(stats_lock_);
 
   DISALLOW_COPY_AND_ASSIGN(ReferenceProcessor);
 };
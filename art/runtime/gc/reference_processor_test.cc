@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "reference_processor.h"
+
+#include <stdio.h>
+
+#include <sstream>
+#include <string>
+
+#include "common_runtime_test.h"
+#include "gc/heap.h"
+#include "handle_scope-inl.h"
+#include "mirror/class-alloc-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/reference-inl.h"
+#include "mirror/string-alloc-inl.h"
+#include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+namespace gc {
+
+class ReferenceProcessorTest : public CommonRuntimeTest {
+ protected:
+  struct Stats {
+    size_t num_references = 0u;
+    size_t num_finalizers = 0u;
+    size_t num_handoffs = 0u;
+    size_t max_handoff_size = 0u;
+    size_t num_not_handed_off = 0u;
+    bool has_latency_histogram = false;
+  };
+
+  // Reads the statistics back from the dump, which is empty without any.
+  static bool GetStats(ReferenceProcessor* reference_processor, Stats* stats) {
+    std::ostringstream oss;
+    reference_processor->DumpStats(oss);
+    std::string dump = oss.str();
+    if (dump.empty()) {
+      return false;
+    }
+    int matched = sscanf(dump.c_str(),
+                         "Cleared references handed to the reference queue: %zu "
+                         "(finalizer references: %zu) in %zu handoffs, largest handoff: %zu, "
+                         "cleared but not handed off yet: %zu",
+                         &stats->num_references,
+                         &stats->num_finalizers,
+                         &stats->num_handoffs,
+                         &stats->max_handoff_size,
+                         &stats->num_not_handed_off);
+    EXPECT_EQ(5, matched) << dump;
+    stats->has_latency_histogram =
+        dump.find("\nReference queue handoff latency:") != std::string::npos;
+    return true;
+  }
+};
+
+TEST_F(ReferenceProcessorTest, HandoffStats) {
+  // The cleared references are only handed to the Java side once the runtime is started.
+  Thread* self = Thread::Current();
+  self->TransitionFromSuspendedToRunnable();
+  ASSERT_TRUE(runtime_->Start());
+  Heap* heap = runtime_->GetHeap();
+  ReferenceProcessor* reference_processor = heap->GetReferenceProcessor();
+
+  static constexpr size_t kNumReferences = 8;
+  ScopedObjectAccess soa(self);
+  StackHandleScope<kNumReferences + 1> hs(self);
+  Handle<mirror::Class> weak_ref_class = hs.NewHandle(
+      runtime_->GetClassLinker()->FindClass(self, "Ljava/lang/ref/WeakReference;",
+                                            ScopedNullHandle<mirror::ClassLoader>()));
+  ASSERT_TRUE(weak_ref_class != nullptr);
+  Handle<mirror::Reference> refs[kNumReferences];
+  for (size_t i = 0; i != kNumReferences; ++i) {
+    refs[i] = hs.NewHandle(weak_ref_class->AllocObject(self)->AsReference());
+    ASSERT_TRUE(refs[i] != nullptr);
+    ObjPtr<mirror::String> referent = mirror::String::AllocFromModifiedUtf8(self, "referent");
+    ASSERT_TRUE(referent != nullptr);
+    refs[i]->SetReferent<false>(referent);
+  }
+
+  // Only count the references cleared by the GC below.
+  reference_processor->ResetStats();
+  heap->CollectGarbage(/* clear_soft_references= */ false);
+  for (size_t i = 0; i != kNumReferences; ++i) {
+    EXPECT_TRUE(refs[i]->GetReferent() == nullptr);
+  }
+
+  // The GC hands off everything it cleared, at least the references above, in one go.
+  Stats stats;
+  ASSERT_TRUE(GetStats(reference_processor, &stats));
+  EXPECT_GE(stats.num_references, kNumReferences);
+  EXPECT_LE(stats.num_finalizers, stats.num_references);
+  EXPECT_GE(stats.num_handoffs, 1u);
+  EXPECT_GE(stats.max_handoff_size, kNumReferences);
+  EXPECT_EQ(0u, stats.num_not_handed_off);
+  EXPECT_TRUE(stats.has_latency_histogram);
+
+  reference_processor->ResetStats();
+  EXPECT_FALSE(GetStats(reference_processor, &stats));
+}
+
+}  // namespace gc
+}  // namespace art
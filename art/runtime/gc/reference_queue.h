@@ -78,9 +78,10 @@ class ReferenceQueue {
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Enqueues finalizer references with white referents.  White referents are blackened, moved to
-  // the zombie field, and the referent field is cleared.
-  void EnqueueFinalizerReferences(ReferenceQueue* cleared_references,
-                                  collector::GarbageCollector* collector)
+  // the zombie field, and the referent field is cleared. Returns the number of references added to
+  // `cleared_references`.
+  size_t EnqueueFinalizerReferences(ReferenceQueue* cleared_references,
+                                    collector::GarbageCollector* collector)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Walks the reference list marking any references subject to the reference clearing policy.
@@ -91,8 +92,9 @@ class ReferenceQueue {
 
   // Unlink the reference list clearing references objects with white referents. Cleared references
   // registered to a reference queue are scheduled for appending by the heap worker thread.
-  void ClearWhiteReferences(ReferenceQueue* cleared_references,
-                            collector::GarbageCollector* collector)
+  // Returns the number of references added to `cleared_references`.
+  size_t ClearWhiteReferences(ReferenceQueue* cleared_references,
+                              collector::GarbageCollector* collector)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   void Dump(std::ostream& os) const REQUIRES_SHARED(Locks::mutator_lock_);
@@ -348,13 +348,102 @@ const AllocationInfo* FreeListSpace::GetAllocationInfoForAddress(uintptr_t addre
   return &allocation_info_[GetSlotIndexForAddress(address)];
 }
 
-inline bool FreeListSpace::SortByPrevFree::operator()(const AllocationInfo* a,
-                                                      const AllocationInfo* b) const {
-  if (a->GetPrevFree() < b->GetPrevFree()) return true;
-  if (a->GetPrevFree() > b->GetPrevFree()) return false;
-  if (a->AlignSize() < b->AlignSize()) return true;
-  if (a->AlignSize() > b->AlignSize()) return false;
-  return reinterpret_cast<uintptr_t>(a) < reinterpret_cast<uintptr_t>(b);
+inline void FreeListSpace::GetFreeListIndices(size_t pages, size_t* fl, size_t* sl) {
+  DCHECK_NE(pages, 0u);
+  if (pages < kNumSecondLevelLists) {
+    *fl = 0u;
+    *sl = pages;
+  } else {
+    size_t msb = MostSignificantBit(pages);
+    *fl = msb - kSecondLevelBits + 1u;
+    *sl = (pages >> (msb - kSecondLevelBits)) - kNumSecondLevelLists;
+  }
+  DCHECK_LT(*fl, kNumFirstLevelLists);
+  DCHECK_LT(*sl, kNumSecondLevelLists);
+}
+
+void FreeListSpace::InsertFreeBlock(AllocationInfo* info) {
+  size_t fl;
+  size_t sl;
+  GetFreeListIndices(info->GetPrevFree(), &fl, &sl);
+  uint32_t slot = dchecked_integral_cast<uint32_t>(GetSlotIndexForAllocationInfo(info));
+  uint32_t& head = free_list_heads_[fl * kNumSecondLevelLists + sl];
+  free_list_links_[slot].prev = kNoFreeBlock;
+  free_list_links_[slot].next = head;
+  if (head != kNoFreeBlock) {
+    free_list_links_[head].prev = slot;
+  }
+  head = slot;
+  first_level_bitmap_ |= 1u << fl;
+  second_level_bitmaps_[fl] |= 1u << sl;
+}
+
+void FreeListSpace::RemoveFreeBlock(AllocationInfo* info) {
+  CHECK_GT(info->GetPrevFree(), 0U);
+  size_t fl;
+  size_t sl;
+  GetFreeListIndices(info->GetPrevFree(), &fl, &sl);
+  uint32_t slot = dchecked_integral_cast<uint32_t>(GetSlotIndexForAllocationInfo(info));
+  uint32_t& head = free_list_heads_[fl * kNumSecondLevelLists + sl];
+  const FreeListLinks links = free_list_links_[slot];
+  if (links.prev != kNoFreeBlock) {
+    free_list_links_[links.prev].next = links.next;
+  } else {
+    DCHECK_EQ(head, slot);
+    head = links.next;
+  }
+  if (links.next != kNoFreeBlock) {
+    free_list_links_[links.next].prev = links.prev;
+  }
+  if (head == kNoFreeBlock) {
+    second_level_bitmaps_[fl] &= ~(1u << sl);
+    if (second_level_bitmaps_[fl] == 0u) {
+      first_level_bitmap_ &= ~(1u << fl);
+    }
+  }
+}
+
+AllocationInfo* FreeListSpace::FindFreeBlock(size_t pages) {
+  if (UNLIKELY(pages >= (static_cast<size_t>(1u) << (kNumFirstLevelLists - 2u)))) {
+    // Larger than any block can be, see AllocationInfo::kFlagsMask.
+    return nullptr;
+  }
+  size_t fl;
+  size_t sl;
+  // Round the request up to the next list boundary so that any block of the list we find fits.
+  size_t rounded_pages = pages;
+  if (pages >= kNumSecondLevelLists) {
+    size_t list_width = static_cast<size_t>(1u) << (MostSignificantBit(pages) - kSecondLevelBits);
+    rounded_pages += list_width - 1u;
+  }
+  GetFreeListIndices(rounded_pages, &fl, &sl);
+  uint32_t sl_bitmap = second_level_bitmaps_[fl] & (~0u << sl);
+  if (sl_bitmap == 0u) {
+    uint32_t fl_bitmap = (fl + 1u < kNumFirstLevelLists) ? first_level_bitmap_ & (~0u << (fl + 1u))
+                                                          : 0u;
+    if (fl_bitmap != 0u) {
+      fl = CTZ(fl_bitmap);
+      sl_bitmap = second_level_bitmaps_[fl];
+      DCHECK_NE(sl_bitmap, 0u);
+    }
+  }
+  if (sl_bitmap != 0u) {
+    uint32_t slot = free_list_heads_[fl * kNumSecondLevelLists + CTZ(sl_bitmap)];
+    DCHECK_NE(slot, kNoFreeBlock);
+    DCHECK_GE(allocation_info_[slot].GetPrevFree(), pages);
+    return &allocation_info_[slot];
+  }
+  // No list is guaranteed to fit, but the list of the requested size may still hold a block that
+  // is large enough. Look for one before the caller resorts to the free space at the end.
+  GetFreeListIndices(pages, &fl, &sl);
+  for (uint32_t slot = free_list_heads_[fl * kNumSecondLevelLists + sl];
+       slot != kNoFreeBlock;
+       slot = free_list_links_[slot].next) {
+    if (allocation_info_[slot].GetPrevFree() >= pages) {
+      return &allocation_info_[slot];
+    }
+  }
+  return nullptr;
 }
 
 FreeListSpace* FreeListSpace::Create(const std::string& name, size_t size) {
@@ -388,6 +477,18 @@ FreeListSpace::FreeListSpace(const std::string& name,
                            &error_msg);
   CHECK(allocation_info_map_.IsValid()) << "Failed to allocate allocation info map" << error_msg;
   allocation_info_ = reinterpret_cast<AllocationInfo*>(allocation_info_map_.Begin());
+  const size_t free_list_links_size = sizeof(FreeListLinks) * (space_capacity / kAlignment);
+  free_list_links_map_ =
+      MemMap::MapAnonymous("large object free list space free list links map",
+                           free_list_links_size,
+                           PROT_READ | PROT_WRITE,
+                           /*low_4gb=*/ false,
+                           &error_msg);
+  CHECK(free_list_links_map_.IsValid()) << "Failed to allocate free list links map" << error_msg;
+  free_list_links_ = reinterpret_cast<FreeListLinks*>(free_list_links_map_.Begin());
+  first_level_bitmap_ = 0u;
+  second_level_bitmaps_.fill(0u);
+  free_list_heads_.fill(kNoFreeBlock);
 }
 
 FreeListSpace::~FreeListSpace() {}
@@ -413,17 +514,10 @@ void FreeListSpace::Walk(DlMallocSpace::WalkCallback callback, void* arg) {
 void FreeListSpace::ForEachMemMap(std::function<void(const MemMap&)> func) const {
   MutexLock mu(Thread::Current(), lock_);
   func(allocation_info_map_);
+  func(free_list_links_map_);
   func(mem_map_);
 }
 
-void FreeListSpace::RemoveFreePrev(AllocationInfo* info) {
-  CHECK_GT(info->GetPrevFree(), 0U);
-  auto it = free_blocks_.lower_bound(info);
-  CHECK(it != free_blocks_.end());
-  CHECK_EQ(*it, info);
-  free_blocks_.erase(it);
-}
-
 size_t FreeListSpace::Free(Thread* self, mirror::Object* obj) {
   DCHECK(Contains(obj)) << reinterpret_cast<void*>(Begin()) << " " << obj << " "
                         << reinterpret_cast<void*>(End());
@@ -452,7 +546,7 @@ size_t FreeListSpace::Free(Thread* self, mirror::Object* obj) {
   if (prev_free_bytes != 0) {
     // Coalesce with previous free chunk.
     new_free_size += prev_free_bytes;
-    RemoveFreePrev(info);
+    RemoveFreeBlock(info);
     info = info->GetPrevFreeInfo();
     // The previous allocation info must not be free since we are supposed to always coalesce.
     DCHECK_EQ(info->GetPrevFreeBytes(), 0U) << "Previous allocation was free";
@@ -471,12 +565,12 @@ size_t FreeListSpace::Free(Thread* self, mirror::Object* obj) {
       DCHECK_ALIGNED(next_next_info->ByteSize(), kAlignment);
       new_free_info = next_next_info;
       new_free_size += next_next_info->GetPrevFreeBytes();
-      RemoveFreePrev(next_next_info);
+      RemoveFreeBlock(next_next_info);
     } else {
       new_free_info = next_info;
     }
     new_free_info->SetPrevFreeBytes(new_free_size);
-    free_blocks_.insert(new_free_info);
+    InsertFreeBlock(new_free_info);
     info->SetByteSize(new_free_size, true);
     DCHECK_EQ(info->GetNextInfo(), new_free_info);
   }
@@ -501,15 +595,11 @@ mirror::Object* FreeListSpace::Alloc(Thread* self, size_t num_bytes, size_t* byt
                                      size_t* usable_size, size_t* bytes_tl_bulk_allocated) {
   MutexLock mu(self, lock_);
   const size_t allocation_size = RoundUp(num_bytes, kAlignment);
-  AllocationInfo temp_info;
-  temp_info.SetPrevFreeBytes(allocation_size);
-  temp_info.SetByteSize(0, false);
   AllocationInfo* new_info;
-  // Find the smallest chunk at least num_bytes in size.
-  auto it = free_blocks_.lower_bound(&temp_info);
-  if (it != free_blocks_.end()) {
-    AllocationInfo* info = *it;
-    free_blocks_.erase(it);
+  // Find a chunk at least num_bytes in size.
+  AllocationInfo* info = FindFreeBlock(allocation_size / kAlignment);
+  if (info != nullptr) {
+    RemoveFreeBlock(info);
     // Fit our object in the previous allocation info free space.
     new_info = info->GetPrevFreeInfo();
     // Remove the newly allocated block from the info and update the prev_free_.
@@ -518,8 +608,8 @@ mirror::Object* FreeListSpace::Alloc(Thread* self, size_t num_bytes, size_t* byt
       AllocationInfo* new_free = info - info->GetPrevFree();
       new_free->SetPrevFreeBytes(0);
       new_free->SetByteSize(info->GetPrevFreeBytes(), true);
-      // If there is remaining space, insert back into the free set.
-      free_blocks_.insert(info);
+      // If there is remaining space, insert back into the free lists.
+      InsertFreeBlock(info);
     }
   } else {
     // Try to steal some memory from the free space at the end of the space.
@@ -18,12 +18,15 @@
 #define ART_RUNTIME_GC_SPACE_LARGE_OBJECT_SPACE_H_
 
 #include "base/allocator.h"
+#include "base/bit_utils.h"
 #include "base/safe_map.h"
 #include "base/tracking_safe_map.h"
 #include "dlmalloc_space.h"
 #include "space.h"
 #include "thread-current-inl.h"
 
+#include <array>
+#include <limits>
 #include <set>
 #include <vector>
 
@@ -215,19 +218,39 @@ class FreeListSpace final : public LargeObjectSpace {
   uintptr_t GetAddressForAllocationInfo(const AllocationInfo* info) const {
     return GetAllocationAddressForSlot(GetSlotIndexForAllocationInfo(info));
   }
-  // Removes header from the free blocks set by finding the corresponding iterator and erasing it.
-  void RemoveFreePrev(AllocationInfo* info) REQUIRES(lock_);
   bool IsZygoteLargeObject(Thread* self, mirror::Object* obj) const override;
   void SetAllLargeObjectsAsZygoteObjects(Thread* self, bool set_mark_bit) override
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
-  class SortByPrevFree {
-   public:
-    bool operator()(const AllocationInfo* a, const AllocationInfo* b) const;
+  // Free blocks are identified by the allocation info that follows them, whose prev_free_ holds
+  // the size of the block. They are indexed in segregated free lists (TLSF-style): the first
+  // level splits block sizes by powers of two, the second level splits each power of two range
+  // into kNumSecondLevelLists linear classes. Blocks of less than kNumSecondLevelLists pages get
+  // one list per size. Bitmaps of the non-empty lists make insertion, removal and finding a
+  // block that fits O(1).
+  static constexpr size_t kSecondLevelBits = 4;
+  static constexpr size_t kNumSecondLevelLists = 1u << kSecondLevelBits;
+  static constexpr size_t kNumFirstLevelLists = BitSizeOf<uint32_t>();
+  static constexpr uint32_t kNoFreeBlock = std::numeric_limits<uint32_t>::max();
+
+  // Links of a free block in its free list, as slot indices of the allocation infos that follow
+  // the blocks. Stored in a side table parallel to allocation_info_ so that AllocationInfo keeps
+  // its layout.
+  struct FreeListLinks {
+    uint32_t prev;
+    uint32_t next;
   };
-  typedef std::set<AllocationInfo*, SortByPrevFree,
-                   TrackingAllocator<AllocationInfo*, kAllocatorTagLOSFreeList>> FreeBlocks;
+
+  // Returns the indices of the free list holding free blocks of `pages` pages.
+  static void GetFreeListIndices(size_t pages, /*out*/ size_t* fl, /*out*/ size_t* sl);
+  // Adds the free block preceding `info` to the free lists.
+  void InsertFreeBlock(AllocationInfo* info) REQUIRES(lock_);
+  // Removes the free block preceding `info` from the free lists. Must be called before the size
+  // of the block changes.
+  void RemoveFreeBlock(AllocationInfo* info) REQUIRES(lock_);
+  // Returns the allocation info following a free block of at least `pages` pages, or null.
+  AllocationInfo* FindFreeBlock(size_t pages) REQUIRES(lock_);
 
   // There is not footer for any allocations at the end of the space, so we keep track of how much
   // free space there is at the end manually.
@@ -235,10 +258,19 @@ class FreeListSpace final : public LargeObjectSpace {
   // Side table for allocation info, one per page.
   MemMap allocation_info_map_;
   AllocationInfo* allocation_info_;
+  // Side table for free list links, one per page.
+  MemMap free_list_links_map_;
+  FreeListLinks* free_list_links_;
 
   // Free bytes at the end of the space.
   size_t free_end_ GUARDED_BY(lock_);
-  FreeBlocks free_blocks_ GUARDED_BY(lock_);
+  // Bit fl is set if any second level list of first level fl is not empty.
+  uint32_t first_level_bitmap_ GUARDED_BY(lock_);
+  // Bit sl of entry fl is set if the list (fl, sl) is not empty.
+  std::array<uint32_t, kNumFirstLevelLists> second_level_bitmaps_ GUARDED_BY(lock_);
+  // Slot index of the first block of each list, or kNoFreeBlock.
+  std::array<uint32_t, kNumFirstLevelLists * kNumSecondLevelLists> free_list_heads_
+      GUARDED_BY(lock_);
 };
 
 }  // namespace space
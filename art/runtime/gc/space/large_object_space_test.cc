@@ -30,6 +30,9 @@ class LargeObjectSpaceTest : public SpaceTest<CommonRuntimeTest> {
   static constexpr size_t kNumThreads = 10;
   static constexpr size_t kNumIterations = 1000;
   void RaceTest();
+
+  // Allocates and frees many objects of varied sizes in a fragmented space.
+  void FragmentedChurnTest();
 };
 
 
@@ -174,6 +177,72 @@ void LargeObjectSpaceTest::RaceTest() {
   }
 }
 
+void LargeObjectSpaceTest::FragmentedChurnTest() {
+  static constexpr size_t kCapacity = 256 * MB;
+  static constexpr size_t kNumLiveObjects = 512;
+  static constexpr size_t kNumChurnIterations = 100000;
+  static constexpr size_t kMaxAllocationPages = 32;
+  Thread* const self = Thread::Current();
+  for (size_t los_type = 0; los_type < 2; ++los_type) {
+    LargeObjectSpace* los = nullptr;
+    if (los_type == 0) {
+      los = space::LargeObjectMapSpace::Create("large object space");
+    } else {
+      los = space::FreeListSpace::Create("large object space", kCapacity);
+    }
+    size_t rand_seed = 0;
+    auto alloc = [&]() {
+      size_t request_size = (1 + test_rand(&rand_seed) % kMaxAllocationPages) * kPageSize -
+          test_rand(&rand_seed) % kPageSize;
+      size_t allocation_size, bytes_tl_bulk_allocated;
+      mirror::Object* obj = los->Alloc(self, request_size, &allocation_size, nullptr,
+                                       &bytes_tl_bulk_allocated);
+      CHECK(obj != nullptr) << request_size;
+      CHECK_GE(allocation_size, request_size);
+      return obj;
+    };
+
+    // Fragment the space by freeing every other object.
+    std::vector<mirror::Object*> objects;
+    for (size_t i = 0; i < 2 * kNumLiveObjects; ++i) {
+      objects.push_back(alloc());
+    }
+    for (size_t i = 0; i < kNumLiveObjects; ++i) {
+      los->Free(self, objects[2 * i + 1]);
+      objects[i] = objects[2 * i];
+    }
+    objects.resize(kNumLiveObjects);
+
+    uint64_t start_ns = NanoTime();
+    for (size_t i = 0; i < kNumChurnIterations; ++i) {
+      size_t index = test_rand(&rand_seed) % objects.size();
+      los->Free(self, objects[index]);
+      objects[index] = alloc();
+    }
+    uint64_t duration_ns = NanoTime() - start_ns;
+    LOG(INFO) << (los_type == 0 ? "map" : "free list")
+              << ": " << kNumChurnIterations << " free/alloc pairs in "
+              << PrettyDuration(duration_ns) << ", "
+              << duration_ns / kNumChurnIterations << "ns per pair";
+
+    for (mirror::Object* obj : objects) {
+      los->Free(self, obj);
+    }
+    EXPECT_EQ(0U, los->GetBytesAllocated());
+    EXPECT_EQ(0U, los->GetObjectsAllocated());
+
+    // Everything should have been coalesced back into one free block.
+    size_t bytes_allocated, bytes_tl_bulk_allocated;
+    mirror::Object* obj = los->Alloc(self, kCapacity - kPageSize, &bytes_allocated, nullptr,
+                                     &bytes_tl_bulk_allocated);
+    EXPECT_TRUE(obj != nullptr);
+    if (obj != nullptr) {
+      los->Free(self, obj);
+    }
+    delete los;
+  }
+}
+
 TEST_F(LargeObjectSpaceTest, LargeObjectTest) {
   LargeObjectTest();
 }
@@ -182,6 +251,10 @@ TEST_F(LargeObjectSpaceTest, RaceTest) {
   RaceTest();
 }
 
+TEST_F(LargeObjectSpaceTest, FragmentedChurnTest) {
+  FragmentedChurnTest();
+}
+
 }  // namespace space
 }  // namespace gc
 }  // namespace art
@@ -466,24 +466,20 @@ bool HandleCorePlatformApiViolation(T* member,
   return policy == EnforcementPolicy::kEnabled;
 }
 
+// Decides whether to deny access to a hidden `member` from the application domain. Does not
+// have any side effects, the result can be cached until the hidden API settings change.
 template<typename T>
-bool ShouldDenyAccessToMemberImpl(T* member, ApiList api_list, AccessMethod access_method) {
-  DCHECK(member != nullptr);
-  Runtime* runtime = Runtime::Current();
-
+static AccessDecisionCache::Decision DecideAccess(Runtime* runtime,
+                                                  const MemberSignature& member_signature,
+                                                  ApiList api_list)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
   EnforcementPolicy hiddenApiPolicy = runtime->GetHiddenApiEnforcementPolicy();
   DCHECK(hiddenApiPolicy != EnforcementPolicy::kDisabled)
       << "Should never enter this function when access checks are completely disabled";
 
-  MemberSignature member_signature(member);
-
   // Check for an exemption first. Exempted APIs are treated as white list.
   if (member_signature.DoesPrefixMatchAny(runtime->GetHiddenApiExemptions())) {
-    // Avoid re-examining the exemption list next time.
-    // Note this results in no warning for the member, which seems like what one would expect.
-    // Exemptions effectively adds new members to the whitelist.
-    MaybeUpdateAccessFlags(runtime, member, kAccPublicApi);
-    return false;
+    return AccessDecisionCache::Decision::kExempt;
   }
 
   EnforcementPolicy testApiPolicy = runtime->GetTestApiEnforcementPolicy();
@@ -506,7 +502,29 @@ bool ShouldDenyAccessToMemberImpl(T* member, ApiList api_list, AccessMethod acce
       }
     }
   }
+  return deny_access ? AccessDecisionCache::Decision::kDeny
+                     : AccessDecisionCache::Decision::kAllow;
+}
 
+// Applies the side effects of an access to a hidden `member` from the application domain:
+// logging, notifying the listener and updating the access flags. Returns whether to deny access.
+template<typename T>
+static bool ReportAccess(Runtime* runtime,
+                         T* member,
+                         MemberSignature& member_signature,
+                         ApiList api_list,
+                         AccessMethod access_method,
+                         AccessDecisionCache::Decision decision)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  if (decision == AccessDecisionCache::Decision::kExempt) {
+    // Avoid re-examining the exemption list next time.
+    // Note this results in no warning for the member, which seems like what one would expect.
+    // Exemptions effectively adds new members to the whitelist.
+    MaybeUpdateAccessFlags(runtime, member, kAccPublicApi);
+    return false;
+  }
+
+  const bool deny_access = (decision == AccessDecisionCache::Decision::kDeny);
   if (access_method != AccessMethod::kNone) {
     // Warn if non-greylisted signature is being accessed or it is not exempted.
     if (deny_access || !member_signature.DoesPrefixMatchAny(kWarningExemptions)) {
@@ -543,6 +561,45 @@ bool ShouldDenyAccessToMemberImpl(T* member, ApiList api_list, AccessMethod acce
   return deny_access;
 }
 
+template<typename T>
+bool ShouldDenyAccessToMemberImpl(T* member, ApiList api_list, AccessMethod access_method) {
+  DCHECK(member != nullptr);
+  Runtime* runtime = Runtime::Current();
+  MemberSignature member_signature(member);
+  AccessDecisionCache::Decision decision = DecideAccess<T>(runtime, member_signature, api_list);
+  return ReportAccess(runtime, member, member_signature, api_list, access_method, decision);
+}
+
+template<typename T>
+bool ShouldDenyAccessToMemberCached(T* member, AccessMethod access_method) {
+  DCHECK(member != nullptr);
+  Runtime* runtime = Runtime::Current();
+  AccessDecisionCache* cache = Thread::Current()->GetHiddenApiAccessDecisionCache();
+  const uint32_t epoch = runtime->GetHiddenApiAccessDecisionsEpoch();
+  const AccessDecisionCache::Entry* entry = cache->Lookup(member, epoch);
+  if (entry != nullptr && access_method == AccessMethod::kNone) {
+    // Nothing to report, the decision is all we need.
+    return entry->decision == AccessDecisionCache::Decision::kDeny;
+  }
+
+  MemberSignature member_signature(member);
+  ApiList api_list;
+  AccessDecisionCache::Decision decision;
+  if (entry != nullptr) {
+    api_list = ApiList(entry->dex_flags);
+    decision = entry->decision;
+  } else {
+    // Decode hidden API access flags from the dex file.
+    // This is an O(N) operation scaling with the number of fields/methods
+    // in the class. Only do this on slow path and only do it once.
+    api_list = ApiList(GetDexFlags(member));
+    DCHECK(api_list.IsValid());
+    decision = DecideAccess<T>(runtime, member_signature, api_list);
+    cache->Insert(member, epoch, api_list.GetDexFlags(), decision);
+  }
+  return ReportAccess(runtime, member, member_signature, api_list, access_method, decision);
+}
+
 // Need to instantiate these.
 template uint32_t GetDexFlags<ArtField>(ArtField* member);
 template uint32_t GetDexFlags<ArtMethod>(ArtMethod* member);
@@ -560,6 +617,10 @@ template bool ShouldDenyAccessToMemberImpl<ArtField>(ArtField* member,
 template bool ShouldDenyAccessToMemberImpl<ArtMethod>(ArtMethod* member,
                                                       ApiList api_list,
                                                       AccessMethod access_method);
+template bool ShouldDenyAccessToMemberCached<ArtField>(ArtField* member,
+                                                       AccessMethod access_method);
+template bool ShouldDenyAccessToMemberCached<ArtMethod>(ArtMethod* member,
+                                                        AccessMethod access_method);
 }  // namespace detail
 
 }  // namespace hiddenapi
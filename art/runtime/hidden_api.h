@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_HIDDEN_API_H_
 #define ART_RUNTIME_HIDDEN_API_H_
 
+#include <array>
+
 #include "art_field.h"
 #include "art_method.h"
 #include "base/hiddenapi_domain.h"
@@ -227,6 +229,13 @@ template<typename T>
 bool ShouldDenyAccessToMemberImpl(T* member, ApiList api_list, AccessMethod access_method)
     REQUIRES_SHARED(Locks::mutator_lock_);
 
+// Same as ShouldDenyAccessToMemberImpl() but decodes the hiddenapi flags of `member` from the
+// dex file, and caches them together with the access decision in the thread's
+// AccessDecisionCache.
+template<typename T>
+bool ShouldDenyAccessToMemberCached(T* member, AccessMethod access_method)
+    REQUIRES_SHARED(Locks::mutator_lock_);
+
 inline ArtField* GetInterfaceMemberIfProxy(ArtField* field) { return field; }
 
 inline ArtMethod* GetInterfaceMemberIfProxy(ArtMethod* method)
@@ -380,6 +389,59 @@ ALWAYS_INLINE inline uint32_t GetRuntimeFlags(ArtMethod* method)
   }
 }
 
+// Small thread-local cache of the access decisions for hidden members accessed from the
+// application domain.
+//
+// Deciding requires decoding the hiddenapi flags of the member from the dex file, which scales
+// with the number of members of its class, and matching the member's signature against the
+// exemptions. Reflection on platform classes, e.g. Class.getDeclaredMethods(), checks the same
+// members over and over.
+//
+// Decisions only depend on the member and on the runtime's hidden API settings. The runtime
+// bumps an epoch when those change, see Runtime::InvalidateHiddenApiAccessDecisions().
+//
+// All operations must be done from the owning thread.
+class AccessDecisionCache {
+ public:
+  static constexpr size_t kSize = 64;
+
+  enum class Decision : uint8_t {
+    kAllow,
+    kDeny,
+    // The member matches an exemption and is treated as public API.
+    kExempt,
+  };
+
+  struct Entry {
+    const void* member = nullptr;
+    uint32_t epoch = 0u;
+    uint32_t dex_flags = 0u;
+    Decision decision = Decision::kAllow;
+  };
+
+  AccessDecisionCache() {}
+
+  // Returns the entry for `member`, or null if there is none for the current `epoch`.
+  const Entry* Lookup(const void* member, uint32_t epoch) const {
+    const Entry& entry = entries_[IndexOf(member)];
+    return (entry.member == member && entry.epoch == epoch) ? &entry : nullptr;
+  }
+
+  void Insert(const void* member, uint32_t epoch, uint32_t dex_flags, Decision decision) {
+    entries_[IndexOf(member)] = Entry{member, epoch, dex_flags, decision};
+  }
+
+ private:
+  static ALWAYS_INLINE size_t IndexOf(const void* member) {
+    static_assert(IsPowerOfTwo(kSize), "Size must be power of two");
+    return (reinterpret_cast<uintptr_t>(member) >> 3) & (kSize - 1);
+  }
+
+  std::array<Entry, kSize> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(AccessDecisionCache);
+};
+
 // Called by class linker when a new dex file has been registered. Assigns
 // the AccessContext domain to the newly-registered dex file based on its
 // location and class loader.
@@ -438,14 +500,8 @@ inline bool ShouldDenyAccessToMember(T* member,
       // If this is a proxy method, look at the interface method instead.
       member = detail::GetInterfaceMemberIfProxy(member);
 
-      // Decode hidden API access flags from the dex file.
-      // This is an O(N) operation scaling with the number of fields/methods
-      // in the class. Only do this on slow path and only do it once.
-      ApiList api_list(detail::GetDexFlags(member));
-      DCHECK(api_list.IsValid());
-
       // Member is hidden and caller is not exempted. Enter slow path.
-      return detail::ShouldDenyAccessToMemberImpl(member, api_list, access_method);
+      return detail::ShouldDenyAccessToMemberCached(member, access_method);
     }
 
     case Domain::kPlatform: {
@@ -223,6 +223,62 @@ TEST_F(HiddenApiTest, CheckTestApiEnforcement) {
       ShouldDenyAccess(hiddenapi::ApiList::TestApi() | hiddenapi::ApiList::Blacklist()), false);
 }
 
+TEST_F(HiddenApiTest, CheckAccessDecisionCache) {
+  ScopedObjectAccess soa(self_);
+
+  hiddenapi::AccessDecisionCache* cache = self_->GetHiddenApiAccessDecisionCache();
+  ASSERT_TRUE(cache != nullptr);
+  ASSERT_EQ(cache, self_->GetHiddenApiAccessDecisionCache());
+
+  uint32_t epoch = runtime_->GetHiddenApiAccessDecisionsEpoch();
+  ASSERT_TRUE(cache->Lookup(class1_field1_, epoch) == nullptr);
+
+  uint32_t blacklist_flags = hiddenapi::ApiList::Blacklist().GetDexFlags();
+  cache->Insert(
+      class1_field1_, epoch, blacklist_flags, hiddenapi::AccessDecisionCache::Decision::kDeny);
+  const hiddenapi::AccessDecisionCache::Entry* entry = cache->Lookup(class1_field1_, epoch);
+  ASSERT_TRUE(entry != nullptr);
+  ASSERT_EQ(entry->dex_flags, blacklist_flags);
+  ASSERT_EQ(entry->decision, hiddenapi::AccessDecisionCache::Decision::kDeny);
+  ASSERT_TRUE(cache->Lookup(class1_method1_, epoch) == nullptr);
+
+  // Any change of the hidden API settings invalidates the cached decisions.
+  runtime_->SetTargetSdkVersion(runtime_->GetTargetSdkVersion());
+  uint32_t new_epoch = runtime_->GetHiddenApiAccessDecisionsEpoch();
+  ASSERT_NE(epoch, new_epoch);
+  ASSERT_TRUE(cache->Lookup(class1_field1_, new_epoch) == nullptr);
+}
+
+TEST_F(HiddenApiTest, CheckCachedDecisionFollowsPolicy) {
+  ScopedObjectAccess soa(self_);
+
+  hiddenapi::ApiList api_list(hiddenapi::detail::GetDexFlags(class1_method1_));
+  auto cached = [&]() REQUIRES_SHARED(Locks::mutator_lock_) {
+    return hiddenapi::detail::ShouldDenyAccessToMemberCached(
+        class1_method1_, hiddenapi::AccessMethod::kNone);
+  };
+  auto uncached = [&]() REQUIRES_SHARED(Locks::mutator_lock_) {
+    return ShouldDenyAccessToMemberImpl(
+        class1_method1_, api_list, hiddenapi::AccessMethod::kNone);
+  };
+
+  runtime_->SetHiddenApiEnforcementPolicy(hiddenapi::EnforcementPolicy::kJustWarn);
+  ASSERT_EQ(cached(), uncached());
+  ASSERT_EQ(cached(), uncached());
+
+  runtime_->SetHiddenApiEnforcementPolicy(hiddenapi::EnforcementPolicy::kEnabled);
+  runtime_->SetTargetSdkVersion(
+      static_cast<uint32_t>(hiddenapi::ApiList::GreylistMaxO().GetMaxAllowedSdkVersion()));
+  ASSERT_EQ(cached(), uncached());
+
+  runtime_->SetTargetSdkVersion(
+      static_cast<uint32_t>(hiddenapi::ApiList::GreylistMaxQ().GetMaxAllowedSdkVersion()) + 1);
+  setChangeIdState(kHideMaxtargetsdkPHiddenApis, true);
+  setChangeIdState(kHideMaxtargetsdkQHiddenApis, true);
+  ASSERT_EQ(cached(), uncached());
+  ASSERT_EQ(cached(), uncached());
+}
+
 TEST_F(HiddenApiTest, CheckMembersRead) {
   ASSERT_NE(nullptr, class1_field1_);
   ASSERT_NE(nullptr, class1_field12_);
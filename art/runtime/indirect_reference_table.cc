@@ -67,13 +67,24 @@ IndirectReferenceTable::IndirectReferenceTable(size_t max_count,
                                                IndirectRefKind desired_kind,
                                                ResizableCapacity resizable,
                                                std::string* error_msg)
+    : IndirectReferenceTable(max_count, desired_kind, resizable, /*first_index=*/ 0u, error_msg) {
+}
+
+IndirectReferenceTable::IndirectReferenceTable(size_t max_count,
+                                               IndirectRefKind desired_kind,
+                                               ResizableCapacity resizable,
+                                               uint32_t first_index,
+                                               std::string* error_msg)
     : segment_state_(kIRTFirstSegment),
       kind_(desired_kind),
       max_entries_(max_count),
+      first_index_(first_index),
       current_num_holes_(0),
       resizable_(resizable) {
   CHECK(error_msg != nullptr);
   CHECK_NE(desired_kind, kHandleScopeOrInvalid);
+  // A table with an index offset cannot grow into the range of the next table.
+  CHECK(first_index == 0u || resizable == ResizableCapacity::kNo);
 
   // Overflow and maximum check.
   CHECK_LE(max_count, kMaxTableSizeInBytes / sizeof(IrtEntry));
@@ -235,6 +235,15 @@ class IndirectReferenceTable {
                          ResizableCapacity resizable,
                          std::string* error_msg);
 
+  // As above, but the table encodes its entries with indices starting at `first_index`. This
+  // allows several tables of the same kind to hand out distinct references, see
+  // GetEncodedIndex.
+  IndirectReferenceTable(size_t max_count,
+                         IndirectRefKind kind,
+                         ResizableCapacity resizable,
+                         uint32_t first_index,
+                         std::string* error_msg);
+
   ~IndirectReferenceTable();
 
   /*
@@ -331,6 +340,12 @@ class IndirectReferenceTable {
     return DecodeIndirectRefKind(reinterpret_cast<uintptr_t>(iref));
   }
 
+  // Return the index encoded in an indirect reference, including the `first_index` of the
+  // table that created it.
+  ALWAYS_INLINE static uint32_t GetEncodedIndex(IndirectRef iref) {
+    return DecodeIndex(reinterpret_cast<uintptr_t>(iref));
+  }
+
  private:
   static constexpr size_t kSerialBits = MinimumBitsToStore(kIRTPrevCount);
   static constexpr uint32_t kShiftedSerialMask = (1u << kSerialBits) - 1;
@@ -365,14 +380,17 @@ class IndirectReferenceTable {
 
   constexpr uintptr_t EncodeIndirectRef(uint32_t table_index, uint32_t serial) const {
     DCHECK_LT(table_index, max_entries_);
-    return EncodeIndex(table_index) | EncodeSerial(serial) | EncodeIndirectRefKind(kind_);
+    return EncodeIndex(first_index_ + table_index) |
+           EncodeSerial(serial) |
+           EncodeIndirectRefKind(kind_);
   }
 
   static void ConstexprChecks();
 
-  // Extract the table index from an indirect reference.
-  ALWAYS_INLINE static uint32_t ExtractIndex(IndirectRef iref) {
-    return DecodeIndex(reinterpret_cast<uintptr_t>(iref));
+  // Extract the table index from an indirect reference. References created by another table
+  // with a higher `first_index_` yield an out-of-range index.
+  ALWAYS_INLINE uint32_t ExtractIndex(IndirectRef iref) const {
+    return DecodeIndex(reinterpret_cast<uintptr_t>(iref)) - first_index_;
   }
 
   IndirectRef ToIndirectRef(uint32_t table_index) const {
@@ -407,6 +425,9 @@ class IndirectReferenceTable {
   // max #of entries allowed (modulo resizing).
   size_t max_entries_;
 
+  // Offset added to table indices when encoding references.
+  const uint32_t first_index_;
+
   // Some values to retain old behavior with holes. Description of the algorithm is in the .cc
   // file.
   // TODO: Consider other data structures for compact tables, e.g., free lists.
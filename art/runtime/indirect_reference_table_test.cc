@@ -514,4 +514,49 @@ TEST_F(IndirectReferenceTableTest, Resize) {
   EXPECT_EQ(irt.Capacity(), kTableMax + 1);
 }
 
+TEST_F(IndirectReferenceTableTest, FirstIndex) {
+  // This will lead to error messages in the log.
+  ScopedLogSeverity sls(LogSeverity::FATAL);
+
+  ScopedObjectAccess soa(Thread::Current());
+  static const size_t kTableMax = 20;
+
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::Class> c = hs.NewHandle(
+      class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;"));
+  ASSERT_TRUE(c != nullptr);
+  Handle<mirror::Object> obj0 = hs.NewHandle(c->AllocObject(soa.Self()));
+  ASSERT_TRUE(obj0 != nullptr);
+
+  std::string error_msg;
+  IndirectReferenceTable irt0(kTableMax,
+                              kGlobal,
+                              IndirectReferenceTable::ResizableCapacity::kNo,
+                              &error_msg);
+  ASSERT_TRUE(irt0.IsValid()) << error_msg;
+  IndirectReferenceTable irt1(kTableMax,
+                              kGlobal,
+                              IndirectReferenceTable::ResizableCapacity::kNo,
+                              kTableMax,
+                              &error_msg);
+  ASSERT_TRUE(irt1.IsValid()) << error_msg;
+
+  const IRTSegmentState cookie = kIRTFirstSegment;
+  IndirectRef iref0 = irt0.Add(cookie, obj0.Get(), &error_msg);
+  IndirectRef iref1 = irt1.Add(cookie, obj0.Get(), &error_msg);
+  ASSERT_TRUE(iref0 != nullptr);
+  ASSERT_TRUE(iref1 != nullptr);
+  EXPECT_NE(iref0, iref1);
+  EXPECT_EQ(kGlobal, IndirectReferenceTable::GetIndirectRefKind(iref1));
+  EXPECT_EQ(0u, IndirectReferenceTable::GetEncodedIndex(iref0));
+  EXPECT_EQ(kTableMax, IndirectReferenceTable::GetEncodedIndex(iref1));
+  EXPECT_OBJ_PTR_EQ(obj0.Get(), irt1.Get(iref1));
+
+  // A table does not accept references of another table.
+  EXPECT_FALSE(irt0.Remove(cookie, iref1));
+  EXPECT_FALSE(irt1.Remove(cookie, iref0));
+  EXPECT_TRUE(irt1.Remove(cookie, iref1));
+  EXPECT_TRUE(irt0.Remove(cookie, iref0));
+}
+
 }  // namespace art
@@ -19,6 +19,7 @@
 #include <dlfcn.h>
 
 #include "art_method-inl.h"
+#include "base/arena_allocator.h"
 #include "base/enums.h"
 #include "base/file_utils.h"
 #include "base/logging.h"  // For VLOG.
@@ -26,6 +27,7 @@
 #include "base/memory_tool.h"
 #include "base/runtime_debug.h"
 #include "base/scoped_flock.h"
+#include "base/time_utils.h"
 #include "base/utils.h"
 #include "class_root.h"
 #include "debugger.h"
@@ -37,6 +39,7 @@
 #include "interpreter/interpreter.h"
 #include "jit-inl.h"
 #include "jit_code_cache.h"
+#include "jit_compile_queue.h"
 #include "jni/java_vm_ext.h"
 #include "mirror/method_handle_impl.h"
 #include "mirror/var_handle.h"
@@ -102,6 +105,8 @@ JitOptions* JitOptions::CreateFromRuntimeArguments(const RuntimeArgumentMap& opt
       options.GetOrDefault(RuntimeArgumentMap::ProfileSaverOpts);
   jit_options->thread_pool_pthread_priority_ =
       options.GetOrDefault(RuntimeArgumentMap::JITPoolThreadPthreadPriority);
+  jit_options->thread_pool_thread_count_ =
+      std::max(1u, options.GetOrDefault(RuntimeArgumentMap::JITPoolThreadCount));
 
   // Set default compile threshold to aide with sanity checking defaults.
   jit_options->compile_threshold_ =
@@ -195,9 +200,101 @@ JitOptions* JitOptions::CreateFromRuntimeArguments(const RuntimeArgumentMap& opt
   return jit_options;
 }
 
+JitCompileTask::JitCompileTask(ArtMethod* method, TaskKind kind)
+    : method_(method), kind_(kind), klass_(nullptr), hotness_(0), enqueue_time_ns_(0) {
+  ScopedObjectAccess soa(Thread::Current());
+  hotness_ = method->GetCounter();
+  // For a non-bootclasspath class, add a global ref to the class to prevent class unloading
+  // until compilation is done.
+  // When we precompile, this is either with boot classpath methods, or main
+  // class loader methods, so we don't need to keep a global reference.
+  if (method->GetDeclaringClass()->GetClassLoader() != nullptr &&
+      kind_ != TaskKind::kPreCompile) {
+    klass_ = soa.Vm()->AddGlobalRef(soa.Self(), method_->GetDeclaringClass());
+    CHECK(klass_ != nullptr);
+  }
+}
+
+JitCompileTask::~JitCompileTask() {
+  if (klass_ != nullptr) {
+    ScopedObjectAccess soa(Thread::Current());
+    soa.Vm()->DeleteGlobalRef(soa.Self(), klass_);
+  }
+}
+
+void JitCompileTask::Run(Thread* self) {
+  {
+    ScopedObjectAccess soa(self);
+    switch (kind_) {
+      case TaskKind::kPreCompile:
+      case TaskKind::kCompile:
+      case TaskKind::kCompileBaseline:
+      case TaskKind::kCompileOsr: {
+        Runtime::Current()->GetJit()->CompileMethod(
+            method_,
+            self,
+            /* baseline= */ (kind_ == TaskKind::kCompileBaseline),
+            /* osr= */ (kind_ == TaskKind::kCompileOsr),
+            /* prejit= */ (kind_ == TaskKind::kPreCompile));
+        break;
+      }
+      case TaskKind::kAllocateProfile: {
+        if (ProfilingInfo::Create(self, method_, /* retry_allocation= */ true)) {
+          VLOG(jit) << "Start profiling " << ArtMethod::PrettyMethod(method_);
+        }
+        break;
+      }
+    }
+  }
+  ProfileSaver::NotifyJitActivity();
+}
+
+/**
+ * A thread pool task that runs the highest priority compilation of a `JitCompileQueue`. One
+ * such task is added to the thread pool for each compilation added to the queue.
+ */
+class JitCompileQueueTask final : public Task {
+ public:
+  explicit JitCompileQueueTask(JitCompileQueue* queue) : queue_(queue), did_run_(false) {}
+
+  void Run(Thread* self) override {
+    JitCompileTask* task = queue_->Take(self);
+    uint64_t start_ns = NanoTime();
+    task->Run(self);
+    queue_->AddCompileTime(self, NanoTime() - start_ns);
+    task->Finalize();
+    did_run_ = true;
+  }
+
+  void Finalize() override {
+    if (!did_run_) {
+      // The thread pool dropped us without running, drop one compilation to keep the number
+      // of queued compilations and queue tasks in sync.
+      queue_->Take(Thread::Current())->Finalize();
+    }
+    delete this;
+  }
+
+ private:
+  JitCompileQueue* const queue_;
+  bool did_run_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitCompileQueueTask);
+};
+
+void Jit::AddCompileTask(Thread* self, JitCompileTask* task) {
+  DCHECK(thread_pool_ != nullptr);
+  if (compile_queue_->Add(self, task)) {
+    thread_pool_->AddTask(self, new JitCompileQueueTask(compile_queue_.get()));
+  }
+}
+
 void Jit::DumpInfo(std::ostream& os) {
   code_cache_->Dump(os);
   cumulative_timings_.Dump(os);
+  compile_queue_->Dump(Thread::Current(), os);
+  os << "JIT arena pool ";
+  Runtime::Current()->GetJitArenaPool()->GetStats().Dump(os);
   MutexLock mu(Thread::Current(), lock_);
   memory_use_.PrintMemoryUse(os);
 }
@@ -214,6 +311,7 @@ void Jit::AddTimingLogger(const TimingLogger& logger) {
 Jit::Jit(JitCodeCache* code_cache, JitOptions* options)
     : code_cache_(code_cache),
       options_(options),
+      compile_queue_(new JitCompileQueue()),
       boot_completed_lock_("Jit::boot_completed_lock_"),
       cumulative_timings_("JIT timings"),
       memory_use_("Memory used for compilation", 16),
@@ -753,75 +851,6 @@ void Jit::NotifyZygoteCompilationDone() {
   child_mapping_methods.Reset();
 }
 
-class JitCompileTask final : public Task {
- public:
-  enum class TaskKind {
-    kAllocateProfile,
-    kCompile,
-    kCompileBaseline,
-    kCompileOsr,
-    kPreCompile,
-  };
-
-  JitCompileTask(ArtMethod* method, TaskKind kind) : method_(method), kind_(kind), klass_(nullptr) {
-    ScopedObjectAccess soa(Thread::Current());
-    // For a non-bootclasspath class, add a global ref to the class to prevent class unloading
-    // until compilation is done.
-    // When we precompile, this is either with boot classpath methods, or main
-    // class loader methods, so we don't need to keep a global reference.
-    if (method->GetDeclaringClass()->GetClassLoader() != nullptr &&
-        kind_ != TaskKind::kPreCompile) {
-      klass_ = soa.Vm()->AddGlobalRef(soa.Self(), method_->GetDeclaringClass());
-      CHECK(klass_ != nullptr);
-    }
-  }
-
-  ~JitCompileTask() {
-    if (klass_ != nullptr) {
-      ScopedObjectAccess soa(Thread::Current());
-      soa.Vm()->DeleteGlobalRef(soa.Self(), klass_);
-    }
-  }
-
-  void Run(Thread* self) override {
-    {
-      ScopedObjectAccess soa(self);
-      switch (kind_) {
-        case TaskKind::kPreCompile:
-        case TaskKind::kCompile:
-        case TaskKind::kCompileBaseline:
-        case TaskKind::kCompileOsr: {
-          Runtime::Current()->GetJit()->CompileMethod(
-              method_,
-              self,
-              /* baseline= */ (kind_ == TaskKind::kCompileBaseline),
-              /* osr= */ (kind_ == TaskKind::kCompileOsr),
-              /* prejit= */ (kind_ == TaskKind::kPreCompile));
-          break;
-        }
-        case TaskKind::kAllocateProfile: {
-          if (ProfilingInfo::Create(self, method_, /* retry_allocation= */ true)) {
-            VLOG(jit) << "Start profiling " << ArtMethod::PrettyMethod(method_);
-          }
-          break;
-        }
-      }
-    }
-    ProfileSaver::NotifyJitActivity();
-  }
-
-  void Finalize() override {
-    delete this;
-  }
-
- private:
-  ArtMethod* const method_;
-  const TaskKind kind_;
-  jobject klass_;
-
-  DISALLOW_IMPLICIT_CONSTRUCTORS(JitCompileTask);
-};
-
 static std::string GetProfileFile(const std::string& dex_location) {
   // Hardcoded assumption where the profile file is.
   // TODO(ngeoffray): this is brittle and we would need to change change if we
@@ -1199,7 +1228,12 @@ void Jit::CreateThreadPool() {
 
   // We need peers as we may report the JIT thread, e.g., in the debugger.
   constexpr bool kJitPoolNeedsPeers = true;
-  thread_pool_.reset(new ThreadPool("Jit thread pool", 1, kJitPoolNeedsPeers));
+  // The zygote relies on its profile compilation tasks running in order, see
+  // JitDoneCompilingProfileTask. Forked children get the requested count in
+  // PostForkChildAction.
+  size_t thread_count =
+      Runtime::Current()->IsZygote() ? 1u : options_->GetThreadPoolThreadCount();
+  thread_pool_.reset(new ThreadPool("Jit thread pool", thread_count, kJitPoolNeedsPeers));
 
   thread_pool_->SetPthreadPriority(options_->GetThreadPoolPthreadPriority());
   Start();
@@ -1561,7 +1595,7 @@ bool Jit::MaybeCompileMethod(Thread* self,
             (options_->UseTieredJitCompilation() || options_->UseBaselineCompiler())
                 ? JitCompileTask::TaskKind::kCompileBaseline
                 : JitCompileTask::TaskKind::kCompile;
-        thread_pool_->AddTask(self, new JitCompileTask(method, kind));
+        AddCompileTask(self, new JitCompileTask(method, kind));
       }
     }
     if (old_count < OSRMethodThreshold() && new_count >= OSRMethodThreshold()) {
@@ -1571,8 +1605,7 @@ bool Jit::MaybeCompileMethod(Thread* self,
       DCHECK(!method->IsNative());  // No back edges reported for native methods.
       if (!code_cache_->IsOsrCompiled(method)) {
         DCHECK(thread_pool_ != nullptr);
-        thread_pool_->AddTask(
-            self, new JitCompileTask(method, JitCompileTask::TaskKind::kCompileOsr));
+        AddCompileTask(self, new JitCompileTask(method, JitCompileTask::TaskKind::kCompileOsr));
       }
     }
   }
@@ -1587,8 +1620,7 @@ void Jit::EnqueueOptimizedCompilation(ArtMethod* method, Thread* self) {
   // hotness threshold. If tiered compilation is enabled, enqueue a compilation
   // task that will compile optimize the method.
   if (options_->UseTieredJitCompilation()) {
-    thread_pool_->AddTask(
-        self, new JitCompileTask(method, JitCompileTask::TaskKind::kCompile));
+    AddCompileTask(self, new JitCompileTask(method, JitCompileTask::TaskKind::kCompile));
   }
 }
 
@@ -1745,6 +1777,13 @@ void Jit::PostForkChildAction(bool is_system_server, bool is_zygote) {
     thread_pool_.reset(nullptr);
     return;
   }
+
+  // The zygote ran a single JIT worker, use the configured number of workers from now on.
+  // The threads themselves are created in PostZygoteFork, unless this child already
+  // recreated them (e.g. an unspecialized app process), in which case we keep a single worker.
+  if (thread_pool_ != nullptr && thread_pool_->GetThreadCount() == 0u) {
+    thread_pool_->SetThreadCount(options_->GetThreadPoolThreadCount());
+  }
   // At this point, the compiler options have been adjusted to the particular configuration
   // of the forked child. Parse them again.
   jit_compiler_->ParseCompilerOptions();
@@ -1847,17 +1886,14 @@ void Jit::EnqueueCompilationFromNterp(ArtMethod* method, Thread* self) {
   if (GetCodeCache()->ContainsPc(method->GetEntryPointFromQuickCompiledCode())) {
     // If we already have compiled code for it, nterp may be stuck in a loop.
     // Compile OSR.
-    thread_pool_->AddTask(
-        self, new JitCompileTask(method, JitCompileTask::TaskKind::kCompileOsr));
+    AddCompileTask(self, new JitCompileTask(method, JitCompileTask::TaskKind::kCompileOsr));
     return;
   }
   if (GetCodeCache()->CanAllocateProfilingInfo()) {
     ProfilingInfo::Create(self, method, /* retry_allocation= */ false);
-    thread_pool_->AddTask(
-        self, new JitCompileTask(method, JitCompileTask::TaskKind::kCompileBaseline));
+    AddCompileTask(self, new JitCompileTask(method, JitCompileTask::TaskKind::kCompileBaseline));
   } else {
-    thread_pool_->AddTask(
-        self, new JitCompileTask(method, JitCompileTask::TaskKind::kCompile));
+    AddCompileTask(self, new JitCompileTask(method, JitCompileTask::TaskKind::kCompile));
   }
 }
 
@@ -52,6 +52,8 @@ class String;
 namespace jit {
 
 class JitCodeCache;
+class JitCompileQueue;
+class JitCompileTask;
 class JitMemoryRegion;
 class JitOptions;
 
@@ -60,6 +62,8 @@ static constexpr int16_t kJitHotnessDisabled = -2;
 // At what priority to schedule jit threads. 9 is the lowest foreground priority on device.
 // See android/os/Process.java.
 static constexpr int kJitPoolThreadPthreadDefaultPriority = 9;
+// Number of JIT worker threads. Zygotes always use a single worker, see Jit::CreateThreadPool.
+static constexpr unsigned int kJitPoolThreadDefaultCount = 1;
 // We check whether to jit-compile the method every Nth invoke.
 // The tests often use threshold of 1000 (and thus 500 to start profiling).
 static constexpr uint32_t kJitSamplesBatchSize = 512;  // Must be power of 2.
@@ -112,6 +116,10 @@ class JitOptions {
     return thread_pool_pthread_priority_;
   }
 
+  size_t GetThreadPoolThreadCount() const {
+    return thread_pool_thread_count_;
+  }
+
   bool UseJitCompilation() const {
     return use_jit_compilation_;
   }
@@ -168,6 +176,7 @@ class JitOptions {
   uint16_t invoke_transition_weight_;
   bool dump_info_on_shutdown_;
   int thread_pool_pthread_priority_;
+  size_t thread_pool_thread_count_;
   ProfileSaverOptions profile_saver_options_;
 
   JitOptions()
@@ -182,7 +191,8 @@ class JitOptions {
         priority_thread_weight_(0),
         invoke_transition_weight_(0),
         dump_info_on_shutdown_(false),
-        thread_pool_pthread_priority_(kJitPoolThreadPthreadDefaultPriority) {}
+        thread_pool_pthread_priority_(kJitPoolThreadPthreadDefaultPriority),
+        thread_pool_thread_count_(kJitPoolThreadDefaultCount) {}
 
   DISALLOW_COPY_AND_ASSIGN(JitOptions);
 };
@@ -464,6 +474,11 @@ class Jit {
                           bool with_backedges)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Queue a hotness-triggered compilation. Compilations are not run in FIFO order: they
+  // go through `compile_queue_`, which favors cheap and hot compilations and drops
+  // requests already pending.
+  void AddCompileTask(Thread* self, JitCompileTask* task);
+
   static bool BindCompilerMethods(std::string* error_msg);
 
   // JIT compiler
@@ -476,6 +491,8 @@ class Jit {
   jit::JitCodeCache* const code_cache_;
   const JitOptions* const options_;
 
+  // Must outlive `thread_pool_`, whose pending tasks reference it.
+  std::unique_ptr<JitCompileQueue> compile_queue_;
   std::unique_ptr<ThreadPool> thread_pool_;
   std::vector<std::unique_ptr<OatDexFile>> type_lookup_tables_;
 
@@ -34,6 +34,7 @@
 #include "base/time_utils.h"
 #include "base/utils.h"
 #include "cha.h"
+#include "code_info_cache.h"
 #include "debugger_interface.h"
 #include "dex/dex_file_loader.h"
 #include "dex/method_reference.h"
@@ -474,6 +475,9 @@ void JitCodeCache::FreeCodeAndData(const void* code_ptr, bool free_debug_info) {
     private_region_.FreeData(GetRootTable(code_ptr));
   }  // else this is a JNI stub without any data.
 
+  // The method header may be reused for different code, drop it from stack walk caches.
+  CodeInfoCache::InvalidateAll();
+
   private_region_.FreeCode(reinterpret_cast<uint8_t*>(allocation));
 }
 
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_COMPILE_QUEUE_H_
+#define ART_RUNTIME_JIT_JIT_COMPILE_QUEUE_H_
+
+#include <queue>
+#include <set>
+#include <vector>
+
+#include <android-base/logging.h>
+
+#include "base/histogram-inl.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "base/time_utils.h"
+#include "jni.h"
+#include "thread_pool.h"
+
+namespace art {
+
+class ArtMethod;
+
+namespace jit {
+
+class JitCompileTask final : public Task {
+ public:
+  enum class TaskKind {
+    kAllocateProfile,
+    kCompile,
+    kCompileBaseline,
+    kCompileOsr,
+    kPreCompile,
+  };
+
+  JitCompileTask(ArtMethod* method, TaskKind kind);
+
+  ~JitCompileTask();
+
+  void Run(Thread* self) override;
+
+  void Finalize() override {
+    delete this;
+  }
+
+  ArtMethod* GetMethod() const {
+    return method_;
+  }
+
+  TaskKind GetKind() const {
+    return kind_;
+  }
+
+  // The hotness counter of the method when the task was created.
+  uint16_t GetHotness() const {
+    return hotness_;
+  }
+
+  uint64_t GetEnqueueTime() const {
+    return enqueue_time_ns_;
+  }
+
+  void SetEnqueueTime(uint64_t time_ns) {
+    enqueue_time_ns_ = time_ns;
+  }
+
+ private:
+  ArtMethod* const method_;
+  const TaskKind kind_;
+  jobject klass_;
+  uint16_t hotness_;
+  uint64_t enqueue_time_ns_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(JitCompileTask);
+};
+
+/**
+ * Pending compilations ordered by priority: baseline compilations first as they are cheap and
+ * get methods out of the interpreter quickly, then optimized compilations, then OSR
+ * compilations which tend to be large. Within a kind, hotter methods go first, and equally hot
+ * methods in FIFO order.
+ */
+class JitCompileQueue {
+ public:
+  JitCompileQueue()
+      : lock_("JIT compile queue lock"),
+        next_sequence_number_(0),
+        num_deduplicated_(0),
+        wait_times_("JIT compile queue wait time", 16),
+        compile_times_("JIT compile time", 16) {}
+
+  ~JitCompileQueue() {
+    DCHECK(queue_.empty());
+  }
+
+  // Add `task` to the queue. Returns false and deletes `task` if the same compilation of the
+  // same method is already pending.
+  bool Add(Thread* self, JitCompileTask* task) REQUIRES(!lock_) {
+    MutexLock mu(self, lock_);
+    if (!pending_.insert(std::make_pair(task->GetMethod(), task->GetKind())).second) {
+      ++num_deduplicated_;
+      task->Finalize();
+      return false;
+    }
+    task->SetEnqueueTime(NanoTime());
+    queue_.push(Entry{task, next_sequence_number_++});
+    return true;
+  }
+
+  // Remove and return the highest priority task.
+  JitCompileTask* Take(Thread* self) REQUIRES(!lock_) {
+    MutexLock mu(self, lock_);
+    DCHECK(!queue_.empty());
+    JitCompileTask* task = queue_.top().task;
+    queue_.pop();
+    pending_.erase(std::make_pair(task->GetMethod(), task->GetKind()));
+    wait_times_.AdjustAndAddValue(NanoTime() - task->GetEnqueueTime());
+    return task;
+  }
+
+  void AddCompileTime(Thread* self, uint64_t time_ns) REQUIRES(!lock_) {
+    MutexLock mu(self, lock_);
+    compile_times_.AdjustAndAddValue(time_ns);
+  }
+
+  void Dump(Thread* self, std::ostream& os) REQUIRES(!lock_) {
+    MutexLock mu(self, lock_);
+    os << "JIT compile queue size: " << queue_.size()
+       << ", deduplicated requests: " << num_deduplicated_ << "\n";
+    for (const Histogram<uint64_t>* histogram : { &wait_times_, &compile_times_ }) {
+      if (histogram->SampleSize() != 0u) {
+        Histogram<uint64_t>::CumulativeData data;
+        histogram->CreateHistogram(&data);
+        histogram->PrintConfidenceIntervals(os, 0.99, data);
+      }
+    }
+  }
+
+ private:
+  struct Entry {
+    JitCompileTask* task;
+    uint64_t sequence_number;
+  };
+
+  static uint32_t KindRank(JitCompileTask::TaskKind kind) {
+    switch (kind) {
+      case JitCompileTask::TaskKind::kCompileBaseline:
+        return 0u;
+      case JitCompileTask::TaskKind::kCompile:
+        return 1u;
+      case JitCompileTask::TaskKind::kCompileOsr:
+        return 2u;
+      case JitCompileTask::TaskKind::kAllocateProfile:
+      case JitCompileTask::TaskKind::kPreCompile:
+        break;
+    }
+    LOG(FATAL) << "Unexpected task kind in JIT compile queue";
+    UNREACHABLE();
+  }
+
+  // Returns whether `lhs` has lower priority than `rhs`.
+  struct LowerPriority {
+    bool operator()(const Entry& lhs, const Entry& rhs) const {
+      uint32_t lhs_rank = KindRank(lhs.task->GetKind());
+      uint32_t rhs_rank = KindRank(rhs.task->GetKind());
+      if (lhs_rank != rhs_rank) {
+        return lhs_rank > rhs_rank;
+      }
+      if (lhs.task->GetHotness() != rhs.task->GetHotness()) {
+        return lhs.task->GetHotness() < rhs.task->GetHotness();
+      }
+      return lhs.sequence_number > rhs.sequence_number;
+    }
+  };
+
+  Mutex lock_;
+  std::priority_queue<Entry, std::vector<Entry>, LowerPriority> queue_ GUARDED_BY(lock_);
+  std::set<std::pair<ArtMethod*, JitCompileTask::TaskKind>> pending_ GUARDED_BY(lock_);
+  uint64_t next_sequence_number_ GUARDED_BY(lock_);
+  size_t num_deduplicated_ GUARDED_BY(lock_);
+  Histogram<uint64_t> wait_times_ GUARDED_BY(lock_);
+  Histogram<uint64_t> compile_times_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(JitCompileQueue);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_COMPILE_QUEUE_H_
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit/jit_compile_queue.h"
+
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "art_method-inl.h"
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "mirror/class-inl.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+namespace jit {
+
+using TaskKind = JitCompileTask::TaskKind;
+
+class JitCompileQueueTest : public CommonRuntimeTest {
+ protected:
+  void SetUp() override {
+    CommonRuntimeTest::SetUp();
+    ScopedObjectAccess soa(Thread::Current());
+    ObjPtr<mirror::Class> object_class =
+        class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+    ASSERT_TRUE(object_class != nullptr);
+    static const std::pair<const char*, const char*> kMethods[] = {
+        {"hashCode", "()I"},
+        {"toString", "()Ljava/lang/String;"},
+        {"getClass", "()Ljava/lang/Class;"},
+    };
+    for (const auto& [name, signature] : kMethods) {
+      ArtMethod* method = object_class->FindClassMethod(name, signature, kRuntimePointerSize);
+      ASSERT_TRUE(method != nullptr) << name;
+      methods_.push_back(method);
+      saved_counters_.push_back(method->GetCounter());
+    }
+  }
+
+  void TearDown() override {
+    {
+      ScopedObjectAccess soa(Thread::Current());
+      for (size_t i = 0; i < methods_.size(); ++i) {
+        methods_[i]->SetCounter(saved_counters_[i]);
+      }
+    }
+    CommonRuntimeTest::TearDown();
+  }
+
+  // A task takes the hotness of its method when it is created.
+  JitCompileTask* NewTask(ArtMethod* method, TaskKind kind, uint16_t hotness)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    method->SetCounter(hotness);
+    return new JitCompileTask(method, kind);
+  }
+
+  // Takes `count` tasks, and returns their methods and kinds in the order taken.
+  std::vector<std::pair<ArtMethod*, TaskKind>> Drain(JitCompileQueue* queue, size_t count) {
+    std::vector<std::pair<ArtMethod*, TaskKind>> taken;
+    for (size_t i = 0; i < count; ++i) {
+      JitCompileTask* task = queue->Take(Thread::Current());
+      taken.emplace_back(task->GetMethod(), task->GetKind());
+      task->Finalize();
+    }
+    return taken;
+  }
+
+  std::vector<ArtMethod*> methods_;
+  std::vector<uint16_t> saved_counters_;
+};
+
+TEST_F(JitCompileQueueTest, Ordering) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  ArtMethod* a = methods_[0];
+  ArtMethod* b = methods_[1];
+  ArtMethod* c = methods_[2];
+
+  JitCompileQueue queue;
+  ASSERT_TRUE(queue.Add(self, NewTask(a, TaskKind::kCompileOsr, 100)));
+  ASSERT_TRUE(queue.Add(self, NewTask(b, TaskKind::kCompile, 10)));
+  ASSERT_TRUE(queue.Add(self, NewTask(c, TaskKind::kCompile, 10)));
+  ASSERT_TRUE(queue.Add(self, NewTask(a, TaskKind::kCompile, 50)));
+  ASSERT_TRUE(queue.Add(self, NewTask(c, TaskKind::kCompileBaseline, 1)));
+  ASSERT_TRUE(queue.Add(self, NewTask(b, TaskKind::kCompileOsr, 200)));
+
+  // Baseline before optimized before OSR whatever the hotness, hotter first within a kind,
+  // and equally hot methods in the order they were added.
+  std::vector<std::pair<ArtMethod*, TaskKind>> expected = {
+      {c, TaskKind::kCompileBaseline},
+      {a, TaskKind::kCompile},
+      {b, TaskKind::kCompile},
+      {c, TaskKind::kCompile},
+      {b, TaskKind::kCompileOsr},
+      {a, TaskKind::kCompileOsr},
+  };
+  EXPECT_EQ(expected, Drain(&queue, expected.size()));
+}
+
+TEST_F(JitCompileQueueTest, DropsPendingDuplicates) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  ArtMethod* a = methods_[0];
+  ArtMethod* b = methods_[1];
+
+  JitCompileQueue queue;
+  EXPECT_TRUE(queue.Add(self, NewTask(a, TaskKind::kCompileBaseline, 10)));
+  // The same compilation of the same method is dropped, even if the method got hotter.
+  EXPECT_FALSE(queue.Add(self, NewTask(a, TaskKind::kCompileBaseline, 20)));
+  // Other kinds for the same method, and the same kind for other methods, are not.
+  EXPECT_TRUE(queue.Add(self, NewTask(a, TaskKind::kCompile, 10)));
+  EXPECT_TRUE(queue.Add(self, NewTask(a, TaskKind::kCompileOsr, 10)));
+  EXPECT_TRUE(queue.Add(self, NewTask(b, TaskKind::kCompileBaseline, 10)));
+
+  // The pending request kept the hotness it was added with.
+  JitCompileTask* task = queue.Take(self);
+  EXPECT_EQ(a, task->GetMethod());
+  EXPECT_EQ(TaskKind::kCompileBaseline, task->GetKind());
+  EXPECT_EQ(10u, task->GetHotness());
+  task->Finalize();
+
+  // Once taken, the compilation can be requested again.
+  EXPECT_TRUE(queue.Add(self, NewTask(a, TaskKind::kCompileBaseline, 30)));
+  EXPECT_FALSE(queue.Add(self, NewTask(b, TaskKind::kCompileBaseline, 30)));
+
+  std::ostringstream oss;
+  queue.Dump(self, oss);
+  EXPECT_NE(std::string::npos, oss.str().find("deduplicated requests: 2")) << oss.str();
+
+  std::vector<std::pair<ArtMethod*, TaskKind>> expected = {
+      {a, TaskKind::kCompileBaseline},
+      {b, TaskKind::kCompileBaseline},
+      {a, TaskKind::kCompile},
+      {a, TaskKind::kCompileOsr},
+  };
+  EXPECT_EQ(expected, Drain(&queue, expected.size()));
+}
+
+}  // namespace jit
+}  // namespace art
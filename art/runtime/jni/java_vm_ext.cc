@@ -17,11 +17,13 @@
 #include "java_vm_ext.h"
 
 #include <dlfcn.h>
+#include <algorithm>
 #include <string_view>
 
 #include "android-base/stringprintf.h"
 
 #include "art_method-inl.h"
+#include "base/casts.h"
 #include "base/dumpable.h"
 #include "base/mutex-inl.h"
 #include "base/sdk_version.h"
@@ -60,6 +62,7 @@ using android::base::StringAppendF;
 using android::base::StringAppendV;
 
 static constexpr size_t kGlobalsMax = 51200;  // Arbitrary sanity check. (Must fit in 16 bits.)
+static constexpr size_t kGlobalsShardMax = kGlobalsMax / JavaVMExt::kGlobalsShards;
 
 static constexpr size_t kWeakGlobalsMax = 51200;  // Arbitrary sanity check. (Must fit in 16 bits.)
 
@@ -496,7 +499,6 @@ JavaVMExt::JavaVMExt(Runtime* runtime,
       tracing_enabled_(runtime_options.Exists(RuntimeArgumentMap::JniTrace)
                        || VLOG_IS_ON(third_party_jni)),
       trace_(runtime_options.GetOrDefault(RuntimeArgumentMap::JniTrace)),
-      globals_(kGlobalsMax, kGlobal, IndirectReferenceTable::ResizableCapacity::kNo, error_msg),
       libraries_(new Libraries),
       unchecked_functions_(&gJniInvokeInterface),
       weak_globals_(kWeakGlobalsMax,
@@ -512,10 +514,27 @@ JavaVMExt::JavaVMExt(Runtime* runtime,
           runtime_options.GetOrDefault(RuntimeArgumentMap::GlobalRefAllocStackTraceLimit)),
       allocation_tracking_enabled_(false),
       old_allocation_tracking_state_(false) {
+  for (size_t i = 0; i != kGlobalsShards; ++i) {
+    globals_[i].reset(new GlobalsShard(i, error_msg));
+  }
   functions = unchecked_functions_;
   SetCheckJniEnabled(runtime_options.Exists(RuntimeArgumentMap::CheckJni));
 }
 
+JavaVMExt::GlobalsShard::GlobalsShard(size_t shard_index, std::string* error_msg)
+    : lock("JNI global reference table shard lock", kJniGlobalsShardLock),
+      table(kGlobalsShardMax,
+            kGlobal,
+            IndirectReferenceTable::ResizableCapacity::kNo,
+            dchecked_integral_cast<uint32_t>(shard_index * kGlobalsShardMax),
+            error_msg) {}
+
+JavaVMExt::GlobalsShard* JavaVMExt::GetGlobalsShard(IndirectRef ref) const {
+  // Invalid references are mapped to the last shard, whose table rejects them.
+  size_t shard_index = IndirectReferenceTable::GetEncodedIndex(ref) / kGlobalsShardMax;
+  return globals_[std::min(shard_index, kGlobalsShards - 1)].get();
+}
+
 JavaVMExt::~JavaVMExt() {
   UnloadBootNativeLibraries();
 }
@@ -527,7 +546,13 @@ std::unique_ptr<JavaVMExt> JavaVMExt::Create(Runtime* runtime,
                                              const RuntimeArgumentMap& runtime_options,
                                              std::string* error_msg) NO_THREAD_SAFETY_ANALYSIS {
   std::unique_ptr<JavaVMExt> java_vm(new JavaVMExt(runtime, runtime_options, error_msg));
-  if (java_vm && java_vm->globals_.IsValid() && java_vm->weak_globals_.IsValid()) {
+  if (java_vm &&
+      std::all_of(std::begin(java_vm->globals_),
+                  std::end(java_vm->globals_),
+                  [](const std::unique_ptr<GlobalsShard>& shard) {
+                    return shard->table.IsValid();
+                  }) &&
+      java_vm->weak_globals_.IsValid()) {
     return java_vm;
   }
   return nullptr;
@@ -629,7 +654,10 @@ void JavaVMExt::CheckGlobalRefAllocationTracking() {
   if (LIKELY(enable_allocation_tracking_delta_ == 0)) {
     return;
   }
-  size_t simple_free_capacity = globals_.FreeCapacity();
+  size_t simple_free_capacity = 0u;
+  for (const std::unique_ptr<GlobalsShard>& shard : globals_) {
+    simple_free_capacity += shard->table.FreeCapacity();
+  }
   if (UNLIKELY(simple_free_capacity <= enable_allocation_tracking_delta_)) {
     if (!allocation_tracking_enabled_) {
       LOG(WARNING) << "Global reference storage appears close to exhaustion, program termination "
@@ -663,11 +691,25 @@ jobject JavaVMExt::AddGlobalRef(Thread* self, ObjPtr<mirror::Object> obj) {
   if (obj == nullptr) {
     return nullptr;
   }
-  IndirectRef ref;
+  IndirectRef ref = nullptr;
   std::string error_msg;
   {
-    WriterMutexLock mu(self, *Locks::jni_globals_lock_);
-    ref = globals_.Add(kIRTFirstSegment, obj, &error_msg);
+    ReaderMutexLock mu(self, *Locks::jni_globals_lock_);
+    // Start with the shard of this thread and only move on to other shards when it is full.
+    size_t first_shard = static_cast<size_t>(self->GetTid()) % kGlobalsShards;
+    for (size_t i = 0; i != kGlobalsShards && ref == nullptr; ++i) {
+      GlobalsShard* shard = globals_[(first_shard + i) % kGlobalsShards].get();
+      MutexLock shard_mu(self, shard->lock);
+      if (shard->table.FreeCapacity() != 0u) {
+        ref = shard->table.Add(kIRTFirstSegment, obj, &error_msg);
+      }
+    }
+    if (ref == nullptr && error_msg.empty()) {
+      // All shards are full, let the table of this thread report the overflow.
+      GlobalsShard* shard = globals_[first_shard].get();
+      MutexLock shard_mu(self, shard->lock);
+      ref = shard->table.Add(kIRTFirstSegment, obj, &error_msg);
+    }
   }
   if (UNLIKELY(ref == nullptr)) {
     LOG(FATAL) << error_msg;
@@ -705,8 +747,10 @@ void JavaVMExt::DeleteGlobalRef(Thread* self, jobject obj) {
     return;
   }
   {
-    WriterMutexLock mu(self, *Locks::jni_globals_lock_);
-    if (!globals_.Remove(kIRTFirstSegment, obj)) {
+    ReaderMutexLock mu(self, *Locks::jni_globals_lock_);
+    GlobalsShard* shard = GetGlobalsShard(obj);
+    MutexLock shard_mu(self, shard->lock);
+    if (!shard->table.Remove(kIRTFirstSegment, obj)) {
       LOG(WARNING) << "JNI WARNING: DeleteGlobalRef(" << obj << ") "
                    << "failed to find entry";
     }
@@ -746,8 +790,12 @@ void JavaVMExt::DumpForSigQuit(std::ostream& os) {
   }
   Thread* self = Thread::Current();
   {
-    ReaderMutexLock mu(self, *Locks::jni_globals_lock_);
-    os << "; globals=" << globals_.Capacity();
+    WriterMutexLock mu(self, *Locks::jni_globals_lock_);
+    size_t globals_capacity = 0u;
+    for (const std::unique_ptr<GlobalsShard>& shard : globals_) {
+      globals_capacity += shard->table.Capacity();
+    }
+    os << "; globals=" << globals_capacity;
   }
   {
     MutexLock mu(self, *Locks::jni_weak_globals_lock_);
@@ -789,12 +837,14 @@ void JavaVMExt::BroadcastForNewWeakGlobals() {
 }
 
 ObjPtr<mirror::Object> JavaVMExt::DecodeGlobal(IndirectRef ref) {
-  return globals_.SynchronizedGet(ref);
+  return GetGlobalsShard(ref)->table.SynchronizedGet(ref);
 }
 
 void JavaVMExt::UpdateGlobal(Thread* self, IndirectRef ref, ObjPtr<mirror::Object> result) {
-  WriterMutexLock mu(self, *Locks::jni_globals_lock_);
-  globals_.Update(ref, result);
+  ReaderMutexLock mu(self, *Locks::jni_globals_lock_);
+  GlobalsShard* shard = GetGlobalsShard(ref);
+  MutexLock shard_mu(self, shard->lock);
+  shard->table.Update(ref, result);
 }
 
 inline bool JavaVMExt::MayAccessWeakGlobals(Thread* self) const {
@@ -873,8 +923,10 @@ void JavaVMExt::UpdateWeakGlobal(Thread* self, IndirectRef ref, ObjPtr<mirror::O
 void JavaVMExt::DumpReferenceTables(std::ostream& os) {
   Thread* self = Thread::Current();
   {
-    ReaderMutexLock mu(self, *Locks::jni_globals_lock_);
-    globals_.Dump(os);
+    WriterMutexLock mu(self, *Locks::jni_globals_lock_);
+    for (const std::unique_ptr<GlobalsShard>& shard : globals_) {
+      shard->table.Dump(os);
+    }
   }
   {
     MutexLock mu(self, *Locks::jni_weak_globals_lock_);
@@ -1168,13 +1220,18 @@ void JavaVMExt::SweepJniWeakGlobals(IsMarkedVisitor* visitor) {
 
 void JavaVMExt::TrimGlobals() {
   WriterMutexLock mu(Thread::Current(), *Locks::jni_globals_lock_);
-  globals_.Trim();
+  for (const std::unique_ptr<GlobalsShard>& shard : globals_) {
+    shard->table.Trim();
+  }
 }
 
 void JavaVMExt::VisitRoots(RootVisitor* visitor) {
   Thread* self = Thread::Current();
-  ReaderMutexLock mu(self, *Locks::jni_globals_lock_);
-  globals_.VisitRoots(visitor, RootInfo(kRootJNIGlobal));
+  // Exclusive, as adding and removing global references only holds the lock shared.
+  WriterMutexLock mu(self, *Locks::jni_globals_lock_);
+  for (const std::unique_ptr<GlobalsShard>& shard : globals_) {
+    shard->table.VisitRoots(visitor, RootInfo(kRootJNIGlobal));
+  }
   // The weak_globals table is visited by the GC itself (because it mutates the table).
 }
 
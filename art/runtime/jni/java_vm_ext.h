@@ -44,6 +44,9 @@ using GetEnvHook = jint (*)(JavaVMExt* vm, /*out*/void** new_env, jint version);
 
 class JavaVMExt : public JavaVM {
  public:
+  // Number of independently locked shards of the global reference table.
+  static constexpr size_t kGlobalsShards = 8;
+
   // Creates a new JavaVMExt object.
   // Returns nullptr on error, in which case error_msg is set to a message
   // describing the error.
@@ -237,8 +240,24 @@ class JavaVMExt : public JavaVM {
   // Extra diagnostics.
   const std::string trace_;
 
+  // A shard of the global reference table. Shard `i` encodes its references with indices
+  // starting at `i * kGlobalsShardMax`, so the owning shard of a reference is known from the
+  // reference alone.
+  struct GlobalsShard {
+    GlobalsShard(size_t shard_index, std::string* error_msg);
+
+    // Serializes Add and Remove on this shard. Acquired with Locks::jni_globals_lock_ held
+    // shared; operations on all shards hold Locks::jni_globals_lock_ exclusively instead.
+    Mutex lock;
+    IndirectReferenceTable table;
+  };
+
+  GlobalsShard* GetGlobalsShard(IndirectRef ref) const;
+
   // Not guarded by globals_lock since we sometimes use SynchronizedGet in Thread::DecodeJObject.
-  IndirectReferenceTable globals_;
+  // Threads add to the shard selected by their tid, spreading the contention of concurrent
+  // AddGlobalRef and DeleteGlobalRef calls across shards.
+  std::unique_ptr<GlobalsShard> globals_[kGlobalsShards];
 
   // No lock annotation since UnloadNativeLibraries is called on libraries_ but locks the
   // jni_libraries_lock_ internally.
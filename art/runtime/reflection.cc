@@ -31,6 +31,7 @@
 #include "mirror/object_array-inl.h"
 #include "nativehelper/scoped_local_ref.h"
 #include "nth_caller_visitor.h"
+#include "reflective_invoke_cache.h"
 #include "scoped_thread_state_change-inl.h"
 #include "stack_reference.h"
 #include "thread-inl.h"
@@ -214,6 +215,14 @@ class ArgArray {
     }
   }
 
+  // Returns the box class (e.g. java.lang.Integer) declaring the given valueOf method. Box classes
+  // are always defined by the boot class loader, so comparing classes is the same as comparing
+  // descriptors.
+  static ObjPtr<mirror::Class> GetBoxClass(jmethodID value_of)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    return jni::DecodeArtMethod(value_of)->GetDeclaringClass();
+  }
+
   static void ThrowIllegalPrimitiveArgumentException(const char* expected,
                                                      const char* found_descriptor)
       REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -222,9 +231,12 @@ class ArgArray {
                      PrettyDescriptor(found_descriptor).c_str()).c_str());
   }
 
+  // `object_params` has bit i set if parameter i is declared as java.lang.Object
+  // (see ReflectiveInvokeCache::Shape).
   bool BuildArgArrayFromObjectArray(ObjPtr<mirror::Object> receiver,
                                     ObjPtr<mirror::ObjectArray<mirror::Object>> raw_args,
                                     ArtMethod* m,
+                                    uint32_t object_params,
                                     Thread* self)
       REQUIRES_SHARED(Locks::mutator_lock_) {
     const dex::TypeList* classes = m->GetParameterTypeList();
@@ -238,7 +250,10 @@ class ArgArray {
         hs.NewHandle<mirror::ObjectArray<mirror::Object>>(raw_args));
     for (size_t i = 1, args_offset = 0; i < shorty_len_; ++i, ++args_offset) {
       arg.Assign(args->Get(args_offset));
-      if (((shorty_[i] == 'L') && (arg != nullptr)) ||
+      // Any object can be passed to a java.lang.Object parameter.
+      const bool is_object_param =
+          args_offset < BitSizeOf<uint32_t>() && (object_params & (1u << args_offset)) != 0u;
+      if (((shorty_[i] == 'L') && (arg != nullptr) && !is_object_param) ||
           ((arg == nullptr && shorty_[i] != 'L'))) {
         // TODO: The method's parameter's type must have been previously resolved, yet
         // we've seen cases where it's not b/34440020.
@@ -259,15 +274,15 @@ class ArgArray {
         }
       }
 
-#define DO_FIRST_ARG(match_descriptor, get_fn, append) { \
+#define DO_FIRST_ARG(box, get_fn, append) { \
           if (LIKELY(arg != nullptr && \
-              arg->GetClass()->DescriptorEquals(match_descriptor))) { \
+              arg->GetClass() == GetBoxClass(WellKnownClasses::java_lang_ ## box ## _valueOf))) { \
             ArtField* primitive_field = arg->GetClass()->GetInstanceField(0); \
             append(primitive_field-> get_fn(arg.Get()));
 
-#define DO_ARG(match_descriptor, get_fn, append) \
+#define DO_ARG(box, get_fn, append) \
           } else if (LIKELY(arg != nullptr && \
-                            arg->GetClass<>()->DescriptorEquals(match_descriptor))) { \
+              arg->GetClass() == GetBoxClass(WellKnownClasses::java_lang_ ## box ## _valueOf))) { \
             ArtField* primitive_field = arg->GetClass()->GetInstanceField(0); \
             append(primitive_field-> get_fn(arg.Get()));
 
@@ -293,54 +308,54 @@ class ArgArray {
           Append(arg.Get());
           break;
         case 'Z':
-          DO_FIRST_ARG("Ljava/lang/Boolean;", GetBoolean, Append)
+          DO_FIRST_ARG(Boolean, GetBoolean, Append)
           DO_FAIL("boolean")
           break;
         case 'B':
-          DO_FIRST_ARG("Ljava/lang/Byte;", GetByte, Append)
+          DO_FIRST_ARG(Byte, GetByte, Append)
           DO_FAIL("byte")
           break;
         case 'C':
-          DO_FIRST_ARG("Ljava/lang/Character;", GetChar, Append)
+          DO_FIRST_ARG(Character, GetChar, Append)
           DO_FAIL("char")
           break;
         case 'S':
-          DO_FIRST_ARG("Ljava/lang/Short;", GetShort, Append)
-          DO_ARG("Ljava/lang/Byte;", GetByte, Append)
+          DO_FIRST_ARG(Short, GetShort, Append)
+          DO_ARG(Byte, GetByte, Append)
           DO_FAIL("short")
           break;
         case 'I':
-          DO_FIRST_ARG("Ljava/lang/Integer;", GetInt, Append)
-          DO_ARG("Ljava/lang/Character;", GetChar, Append)
-          DO_ARG("Ljava/lang/Short;", GetShort, Append)
-          DO_ARG("Ljava/lang/Byte;", GetByte, Append)
+          DO_FIRST_ARG(Integer, GetInt, Append)
+          DO_ARG(Character, GetChar, Append)
+          DO_ARG(Short, GetShort, Append)
+          DO_ARG(Byte, GetByte, Append)
           DO_FAIL("int")
           break;
         case 'J':
-          DO_FIRST_ARG("Ljava/lang/Long;", GetLong, AppendWide)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendWide)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendWide)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendWide)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendWide)
+          DO_FIRST_ARG(Long, GetLong, AppendWide)
+          DO_ARG(Integer, GetInt, AppendWide)
+          DO_ARG(Character, GetChar, AppendWide)
+          DO_ARG(Short, GetShort, AppendWide)
+          DO_ARG(Byte, GetByte, AppendWide)
           DO_FAIL("long")
           break;
         case 'F':
-          DO_FIRST_ARG("Ljava/lang/Float;", GetFloat, AppendFloat)
-          DO_ARG("Ljava/lang/Long;", GetLong, AppendFloat)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendFloat)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendFloat)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendFloat)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendFloat)
+          DO_FIRST_ARG(Float, GetFloat, AppendFloat)
+          DO_ARG(Long, GetLong, AppendFloat)
+          DO_ARG(Integer, GetInt, AppendFloat)
+          DO_ARG(Character, GetChar, AppendFloat)
+          DO_ARG(Short, GetShort, AppendFloat)
+          DO_ARG(Byte, GetByte, AppendFloat)
           DO_FAIL("float")
           break;
         case 'D':
-          DO_FIRST_ARG("Ljava/lang/Double;", GetDouble, AppendDouble)
-          DO_ARG("Ljava/lang/Float;", GetFloat, AppendDouble)
-          DO_ARG("Ljava/lang/Long;", GetLong, AppendDouble)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendDouble)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendDouble)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendDouble)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendDouble)
+          DO_FIRST_ARG(Double, GetDouble, AppendDouble)
+          DO_ARG(Float, GetFloat, AppendDouble)
+          DO_ARG(Long, GetLong, AppendDouble)
+          DO_ARG(Integer, GetInt, AppendDouble)
+          DO_ARG(Character, GetChar, AppendDouble)
+          DO_ARG(Short, GetShort, AppendDouble)
+          DO_ARG(Byte, GetByte, AppendDouble)
           DO_FAIL("double")
           break;
 #ifndef NDEBUG
@@ -459,11 +474,11 @@ void InvokeWithArgArray(const ScopedObjectAccessAlreadyRunnable& soa,
 }
 
 ALWAYS_INLINE
-bool CheckArgsForInvokeMethod(ArtMethod* np_method,
+bool CheckArgsForInvokeMethod(const ReflectiveInvokeCache::Shape& shape,
                               ObjPtr<mirror::ObjectArray<mirror::Object>> objects)
     REQUIRES_SHARED(Locks::mutator_lock_) {
-  const dex::TypeList* classes = np_method->GetParameterTypeList();
-  uint32_t classes_size = (classes == nullptr) ? 0 : classes->Size();
+  // The shorty starts with the return type.
+  uint32_t classes_size = shape.shorty_len - 1u;
   uint32_t arg_count = (objects == nullptr) ? 0 : objects->GetLength();
   if (UNLIKELY(arg_count != classes_size)) {
     ThrowIllegalArgumentException(StringPrintf("Wrong number of arguments; expected %d, got %d",
@@ -477,20 +492,19 @@ ALWAYS_INLINE
 bool InvokeMethodImpl(const ScopedObjectAccessAlreadyRunnable& soa,
                       ArtMethod* m,
                       ArtMethod* np_method,
+                      const ReflectiveInvokeCache::Shape& shape,
                       ObjPtr<mirror::Object> receiver,
                       ObjPtr<mirror::ObjectArray<mirror::Object>> objects,
-                      const char** shorty,
                       JValue* result) REQUIRES_SHARED(Locks::mutator_lock_) {
   // Invoke the method.
-  uint32_t shorty_len = 0;
-  *shorty = np_method->GetShorty(&shorty_len);
-  ArgArray arg_array(*shorty, shorty_len);
-  if (!arg_array.BuildArgArrayFromObjectArray(receiver, objects, np_method, soa.Self())) {
+  ArgArray arg_array(shape.shorty, shape.shorty_len);
+  if (!arg_array.BuildArgArrayFromObjectArray(
+          receiver, objects, np_method, shape.object_params, soa.Self())) {
     CHECK(soa.Self()->IsExceptionPending());
     return false;
   }
 
-  InvokeWithArgArray(soa, m, &arg_array, result, *shorty);
+  InvokeWithArgArray(soa, m, &arg_array, result, shape.shorty);
 
   // Wrap any exception with "Ljava/lang/reflect/InvocationTargetException;" and return early.
   if (soa.Self()->IsExceptionPending()) {
@@ -733,7 +747,9 @@ jobject InvokeMethod(const ScopedObjectAccessAlreadyRunnable& soa, jobject javaM
   ObjPtr<mirror::ObjectArray<mirror::Object>> objects =
       soa.Decode<mirror::ObjectArray<mirror::Object>>(javaArgs);
   auto* np_method = m->GetInterfaceMethodIfProxy(kRuntimePointerSize);
-  if (!CheckArgsForInvokeMethod(np_method, objects)) {
+  const ReflectiveInvokeCache::Shape shape =
+      soa.Self()->GetReflectiveInvokeCache()->GetShape(np_method);
+  if (!CheckArgsForInvokeMethod(shape, objects)) {
     return nullptr;
   }
 
@@ -757,11 +773,10 @@ jobject InvokeMethod(const ScopedObjectAccessAlreadyRunnable& soa, jobject javaM
 
   // Invoke the method.
   JValue result;
-  const char* shorty;
-  if (!InvokeMethodImpl(soa, m, np_method, receiver, objects, &shorty, &result)) {
+  if (!InvokeMethodImpl(soa, m, np_method, shape, receiver, objects, &result)) {
     return nullptr;
   }
-  return soa.AddLocalReference<jobject>(BoxPrimitive(Primitive::GetType(shorty[0]), result));
+  return soa.AddLocalReference<jobject>(BoxPrimitive(Primitive::GetType(shape.shorty[0]), result));
 }
 
 void InvokeConstructor(const ScopedObjectAccessAlreadyRunnable& soa,
@@ -797,14 +812,15 @@ void InvokeConstructor(const ScopedObjectAccessAlreadyRunnable& soa,
   ObjPtr<mirror::ObjectArray<mirror::Object>> objects =
       soa.Decode<mirror::ObjectArray<mirror::Object>>(javaArgs);
   ArtMethod* np_method = constructor->GetInterfaceMethodIfProxy(kRuntimePointerSize);
-  if (!CheckArgsForInvokeMethod(np_method, objects)) {
+  const ReflectiveInvokeCache::Shape shape =
+      soa.Self()->GetReflectiveInvokeCache()->GetShape(np_method);
+  if (!CheckArgsForInvokeMethod(shape, objects)) {
     return;
   }
 
   // Invoke the constructor.
   JValue result;
-  const char* shorty;
-  InvokeMethodImpl(soa, constructor, np_method, receiver, objects, &shorty, &result);
+  InvokeMethodImpl(soa, constructor, np_method, shape, receiver, objects, &result);
 }
 
 ObjPtr<mirror::Object> BoxPrimitive(Primitive::Type src_class, const JValue& value) {
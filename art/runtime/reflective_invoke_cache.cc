@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "reflective_invoke_cache.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "art_method-inl.h"
+#include "dex/dex_file-inl.h"
+
+namespace art {
+
+// Start at 1 so that default constructed entries never match.
+std::atomic<uint32_t> ReflectiveInvokeCache::global_epoch_(1u);
+
+void ReflectiveInvokeCache::ComputeShape(ArtMethod* method, /*out*/ Shape* shape) {
+  DCHECK(!method->IsProxyMethod());
+  shape->shorty = method->GetShorty(&shape->shorty_len);
+  shape->object_params = 0u;
+  const dex::TypeList* params = method->GetParameterTypeList();
+  if (params == nullptr) {
+    return;
+  }
+  size_t num_params = std::min<size_t>(params->Size(), BitSizeOf<uint32_t>());
+  for (size_t i = 0; i != num_params; ++i) {
+    const char* descriptor = method->GetTypeDescriptorFromTypeIdx(params->GetTypeItem(i).type_idx_);
+    if (strcmp(descriptor, "Ljava/lang/Object;") == 0) {
+      shape->object_params |= 1u << i;
+    }
+  }
+}
+
+}  // namespace art
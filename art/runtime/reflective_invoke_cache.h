@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_REFLECTIVE_INVOKE_CACHE_H_
+#define ART_RUNTIME_REFLECTIVE_INVOKE_CACHE_H_
+
+#include <array>
+#include <atomic>
+
+#include "base/bit_utils.h"
+#include "base/locks.h"
+#include "base/macros.h"
+
+namespace art {
+
+class ArtMethod;
+
+// Small thread-local cache of the argument shapes of methods called through reflection
+// (Method.invoke and Constructor.newInstance).
+//
+// Frameworks tend to call the same methods reflectively over and over. Every call needs the
+// method's shorty to marshal the boxed arguments, and the declared type of each reference
+// parameter to check the arguments against. We remember both per method so that repeated calls
+// skip decoding them from the dex file.
+//
+// All operations must be done from the owning thread.
+//
+// ArtMethods are freed when their class loader is unloaded. Like CodeInfoCache, we bump a
+// global epoch when that happens instead of clearing the caches of all threads.
+class ReflectiveInvokeCache {
+ public:
+  static constexpr size_t kSize = 32;
+
+  struct Shape {
+    const char* shorty = nullptr;
+    uint32_t shorty_len = 0u;
+    // Bit i is set if parameter i is declared as java.lang.Object, so that any non-null
+    // argument can be passed without resolving and checking the parameter type.
+    uint32_t object_params = 0u;
+  };
+
+  ReflectiveInvokeCache() {}
+
+  // Returns the shape of the given non-proxy method. The shape is returned by value as the
+  // entry may be replaced by a nested reflective call.
+  Shape GetShape(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_) {
+    uint32_t epoch = global_epoch_.load(std::memory_order_acquire);
+    Entry& entry = entries_[IndexOf(method)];
+    if (UNLIKELY(entry.method != method || entry.epoch != epoch)) {
+      entry.method = method;
+      entry.epoch = epoch;
+      ComputeShape(method, &entry.shape);
+    }
+    return entry.shape;
+  }
+
+  // Invalidate the caches of all threads. Must be called before the memory of any ArtMethod
+  // can be reused for a different method.
+  static void InvalidateAll() {
+    global_epoch_.fetch_add(1u, std::memory_order_release);
+  }
+
+ private:
+  struct Entry {
+    ArtMethod* method = nullptr;
+    uint32_t epoch = 0u;
+    Shape shape;
+  };
+
+  static ALWAYS_INLINE size_t IndexOf(ArtMethod* method) {
+    static_assert(IsPowerOfTwo(kSize), "Size must be power of two");
+    return (reinterpret_cast<uintptr_t>(method) >> 3) & (kSize - 1);
+  }
+
+  static void ComputeShape(ArtMethod* method, /*out*/ Shape* shape)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  std::array<Entry, kSize> entries_;
+
+  static std::atomic<uint32_t> global_epoch_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReflectiveInvokeCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_REFLECTIVE_INVOKE_CACHE_H_
@@ -69,6 +69,7 @@
 #include "base/utils.h"
 #include "class_linker-inl.h"
 #include "class_root.h"
+#include "code_info_cache.h"
 #include "compiler_callbacks.h"
 #include "debugger.h"
 #include "dex/art_dex_file_loader.h"
@@ -288,6 +289,7 @@ Runtime::Runtime()
       hidden_api_policy_(hiddenapi::EnforcementPolicy::kDisabled),
       core_platform_api_policy_(hiddenapi::EnforcementPolicy::kDisabled),
       test_api_policy_(hiddenapi::EnforcementPolicy::kDisabled),
+      hidden_api_access_decisions_epoch_(1u),
       dedupe_hidden_api_warnings_(true),
       hidden_api_access_event_log_rate_(0),
       dump_native_stack_on_sig_quit_(true),
@@ -2021,6 +2023,7 @@ void Runtime::DumpForSigQuit(std::ostream& os) {
   } else {
     os << "Running non JIT\n";
   }
+  CodeInfoCache::DumpStats(os);
   DumpDeoptimizations(os);
   TrackedAllocators::Dump(os);
   os << "\n";
@@ -20,6 +20,7 @@
 #include <jni.h>
 #include <stdio.h>
 
+#include <atomic>
 #include <iosfwd>
 #include <set>
 #include <string>
@@ -586,6 +587,7 @@ class Runtime {
 
   void SetHiddenApiEnforcementPolicy(hiddenapi::EnforcementPolicy policy) {
     hidden_api_policy_ = policy;
+    InvalidateHiddenApiAccessDecisions();
   }
 
   hiddenapi::EnforcementPolicy GetHiddenApiEnforcementPolicy() const {
@@ -602,6 +604,7 @@ class Runtime {
 
   void SetTestApiEnforcementPolicy(hiddenapi::EnforcementPolicy policy) {
     test_api_policy_ = policy;
+    InvalidateHiddenApiAccessDecisions();
   }
 
   hiddenapi::EnforcementPolicy GetTestApiEnforcementPolicy() const {
@@ -610,12 +613,24 @@ class Runtime {
 
   void SetHiddenApiExemptions(const std::vector<std::string>& exemptions) {
     hidden_api_exemptions_ = exemptions;
+    InvalidateHiddenApiAccessDecisions();
   }
 
   const std::vector<std::string>& GetHiddenApiExemptions() {
     return hidden_api_exemptions_;
   }
 
+  // Invalidate the hidden API access decisions cached by threads, see
+  // hiddenapi::AccessDecisionCache. Must be called whenever anything the decisions depend on
+  // changes, or class members may be freed.
+  void InvalidateHiddenApiAccessDecisions() {
+    hidden_api_access_decisions_epoch_.fetch_add(1u, std::memory_order_release);
+  }
+
+  uint32_t GetHiddenApiAccessDecisionsEpoch() const {
+    return hidden_api_access_decisions_epoch_.load(std::memory_order_acquire);
+  }
+
   void SetDedupeHiddenApiWarnings(bool value) {
     dedupe_hidden_api_warnings_ = value;
   }
@@ -670,6 +685,7 @@ class Runtime {
 
   void SetTargetSdkVersion(uint32_t version) {
     target_sdk_version_ = version;
+    InvalidateHiddenApiAccessDecisions();
   }
 
   uint32_t GetTargetSdkVersion() const {
@@ -678,6 +694,7 @@ class Runtime {
 
   void SetDisabledCompatChanges(const std::set<uint64_t>& disabled_changes) {
     disabled_compat_changes_ = disabled_changes;
+    InvalidateHiddenApiAccessDecisions();
   }
 
   std::set<uint64_t> GetDisabledCompatChanges() const {
@@ -1265,6 +1282,10 @@ class Runtime {
   // as if whitelisted.
   std::vector<std::string> hidden_api_exemptions_;
 
+  // Bumped to invalidate the hidden API access decisions cached by threads. Starts at 1 so that
+  // empty cache entries never match.
+  std::atomic<uint32_t> hidden_api_access_decisions_epoch_;
+
   // Do not warn about the same hidden API access violation twice.
   // This is only used for testing.
   bool dedupe_hidden_api_warnings_;
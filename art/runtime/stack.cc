@@ -24,6 +24,7 @@
 #include "base/callee_save_type.h"
 #include "base/enums.h"
 #include "base/hex_dump.h"
+#include "code_info_cache.h"
 #include "dex/dex_file_types.h"
 #include "entrypoints/entrypoint_utils-inl.h"
 #include "entrypoints/quick/callee_save_frame.h"
@@ -80,11 +81,20 @@ StackVisitor::StackVisitor(Thread* thread,
   }
 }
 
+CodeInfoCache* StackVisitor::GetCodeInfoCache() {
+  Thread* self = Thread::Current();
+  return (self != nullptr) ? self->GetCodeInfoCache() : nullptr;
+}
+
 CodeInfo* StackVisitor::GetCurrentInlineInfo() const {
   DCHECK(!(*cur_quick_frame_)->IsNative());
   const OatQuickMethodHeader* header = GetCurrentOatQuickMethodHeader();
   if (cur_inline_info_.first != header) {
-    cur_inline_info_ = std::make_pair(header, CodeInfo::DecodeInlineInfoOnly(header));
+    CodeInfoCache* cache = GetCodeInfoCache();
+    cur_inline_info_ = std::make_pair(header,
+                                      (cache != nullptr)
+                                          ? cache->GetCodeInfo(header)
+                                          : CodeInfo::DecodeInlineInfoOnly(header));
   }
   return &cur_inline_info_.second;
 }
@@ -94,8 +104,12 @@ StackMap* StackVisitor::GetCurrentStackMap() const {
   const OatQuickMethodHeader* header = GetCurrentOatQuickMethodHeader();
   if (cur_stack_map_.first != cur_quick_frame_pc_) {
     uint32_t pc = header->NativeQuickPcOffset(cur_quick_frame_pc_);
-    cur_stack_map_ = std::make_pair(cur_quick_frame_pc_,
-                                    GetCurrentInlineInfo()->GetStackMapForNativePcOffset(pc));
+    CodeInfoCache* cache = GetCodeInfoCache();
+    cur_stack_map_ = std::make_pair(
+        cur_quick_frame_pc_,
+        (cache != nullptr)
+            ? cache->GetStackMapForNativePcOffset(header, *GetCurrentInlineInfo(), pc)
+            : GetCurrentInlineInfo()->GetStackMapForNativePcOffset(pc));
   }
   return &cur_stack_map_.second;
 }
@@ -277,10 +291,14 @@ bool StackVisitor::GetVRegFromOptimizedCode(ArtMethod* m, uint16_t vreg, VRegKin
   uint16_t number_of_dex_registers = accessor.RegistersSize();
   DCHECK_LT(vreg, number_of_dex_registers);
   const OatQuickMethodHeader* method_header = GetCurrentOatQuickMethodHeader();
-  CodeInfo code_info(method_header);
+  CodeInfoCache* cache = GetCodeInfoCache();
+  CodeInfo code_info = (cache != nullptr) ? cache->GetCodeInfo(method_header)
+                                          : CodeInfo(method_header);
 
   uint32_t native_pc_offset = method_header->NativeQuickPcOffset(cur_quick_frame_pc_);
-  StackMap stack_map = code_info.GetStackMapForNativePcOffset(native_pc_offset);
+  StackMap stack_map = (cache != nullptr)
+      ? cache->GetStackMapForNativePcOffset(method_header, code_info, native_pc_offset)
+      : code_info.GetStackMapForNativePcOffset(native_pc_offset);
   DCHECK(stack_map.IsValid());
 
   DexRegisterMap dex_register_map = IsInInlinedFrame()
@@ -34,6 +34,7 @@ class Object;
 }  // namespace mirror
 
 class ArtMethod;
+class CodeInfoCache;
 class Context;
 class HandleScope;
 class OatQuickMethodHeader;
@@ -129,6 +130,10 @@ class StackVisitor {
   bool GetRegisterIfAccessible(uint32_t reg, VRegKind kind, uint32_t* val) const
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Returns the cache of decoded CodeInfo of the thread doing the walk (which is not necessarily
+  // the thread being walked), or null if the current thread is not attached.
+  static CodeInfoCache* GetCodeInfoCache();
+
  public:
   virtual ~StackVisitor() {}
   StackVisitor(const StackVisitor&) = default;
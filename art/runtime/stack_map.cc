@@ -110,12 +110,16 @@ size_t CodeInfo::Deduper::Dedupe(const uint8_t* code_info_data) {
     header[i] = code_info.*member_pointer;
   });
   writer_.WriteInterleavedVarints(header);
+  ++stats_.num_code_infos;
   ForEachBitTableField([this, &code_info, &it](size_t i, auto) {
     if (code_info.HasBitTable(i)) {
       uint32_t& bit_offset = it[i]->second;
+      ++stats_.num_bit_tables;
       if (code_info.IsBitTableDeduped(i)) {
         DCHECK_NE(bit_offset, 0u);
         writer_.WriteVarint(writer_.NumberOfWrittenBits() - bit_offset);
+        ++stats_.num_deduped_bit_tables;
+        stats_.deduped_bits += it[i]->first.size_in_bits();
       } else {
         bit_offset = writer_.NumberOfWrittenBits();  // Store offset in dedup map.
         writer_.WriteRegion(it[i]->first);
@@ -245,6 +249,23 @@ void CodeInfo::CollectSizeStats(const uint8_t* code_info_data, /*out*/ Stats* pa
   codeinfo_stats->AddBytes(BitsToBytesRoundUp(num_bits));
 }
 
+void CodeInfo::CollectDedupeStats(const uint8_t* code_info_data, /*inout*/ DedupeStats* stats) {
+  ++stats->num_code_infos;
+  CodeInfo code_info(code_info_data, nullptr, [&](size_t i, auto*, BitMemoryRegion region) {
+    ++stats->num_bit_tables;
+    if (code_info.IsBitTableDeduped(i)) {
+      ++stats->num_deduped_bit_tables;
+      stats->deduped_bits += region.size_in_bits();
+    }
+  });
+}
+
+void CodeInfo::DedupeStats::Dump(std::ostream& os) const {
+  os << num_code_infos << " CodeInfos, "
+     << num_deduped_bit_tables << " of " << num_bit_tables << " BitTables deduplicated, saving "
+     << BitsToBytesRoundUp(deduped_bits) << " bytes";
+}
+
 void DexRegisterMap::Dump(VariableIndentationOutputStream* vios) const {
   if (HasAnyLiveDexRegisters()) {
     ScopedIndentation indent1(vios);
@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_STACK_MAP_H_
 #define ART_RUNTIME_STACK_MAP_H_
 
+#include <iosfwd>
 #include <limits>
 
 #include "arch/instruction_set.h"
@@ -274,6 +275,16 @@ class MethodInfo : public BitTableAccessor<1> {
  */
 class CodeInfo {
  public:
+  // Statistics of the BitTable deduplication done by the Deduper.
+  struct DedupeStats {
+    size_t num_code_infos = 0;          // Number of distinct CodeInfos.
+    size_t num_bit_tables = 0;          // Number of BitTables present in them.
+    size_t num_deduped_bit_tables = 0;  // BitTables replaced by a reference to an identical one.
+    size_t deduped_bits = 0;            // Total size of the replaced BitTables.
+
+    void Dump(std::ostream& os) const;
+  };
+
   class Deduper {
    public:
     explicit Deduper(std::vector<uint8_t>* output) : writer_(output) {
@@ -284,8 +295,13 @@ class CodeInfo {
     // It returns the byte offset of the copied CodeInfo within the output.
     size_t Dedupe(const uint8_t* code_info);
 
+    const DedupeStats& GetStats() const {
+      return stats_;
+    }
+
    private:
     BitMemoryWriter<std::vector<uint8_t>> writer_;
+    DedupeStats stats_;
 
     // Deduplicate at BitTable level. The value is bit offset within the output.
     std::map<BitMemoryRegion, uint32_t, BitMemoryRegion::Less> dedupe_map_;
@@ -297,6 +313,9 @@ class CodeInfo {
 
   // The following methods decode only part of the data.
   static QuickMethodFrameInfo DecodeFrameInfo(const uint8_t* data);
+
+  // Accumulate the deduplication statistics of the encoded CodeInfo.
+  static void CollectDedupeStats(const uint8_t* code_info_data, /*inout*/ DedupeStats* stats);
   static CodeInfo DecodeGcMasksOnly(const OatQuickMethodHeader* header);
   static CodeInfo DecodeInlineInfoOnly(const OatQuickMethodHeader* header);
 
@@ -57,6 +57,7 @@
 #include "base/utils.h"
 #include "class_linker-inl.h"
 #include "class_root.h"
+#include "code_info_cache.h"
 #include "debugger.h"
 #include "dex/descriptors_names.h"
 #include "dex/dex_file-inl.h"
@@ -71,6 +72,7 @@
 #include "gc/space/space-inl.h"
 #include "gc_root.h"
 #include "handle_scope-inl.h"
+#include "hidden_api.h"
 #include "indirect_reference_table-inl.h"
 #include "instrumentation.h"
 #include "interpreter/interpreter.h"
@@ -100,6 +102,7 @@
 #include "read_barrier-inl.h"
 #include "reflection.h"
 #include "reflective_handle_scope-inl.h"
+#include "reflective_invoke_cache.h"
 #include "runtime-inl.h"
 #include "runtime.h"
 #include "runtime_callbacks.h"
@@ -3824,10 +3827,15 @@ class ReferenceMapVisitor : public StackVisitor {
       StackReference<mirror::Object>* vreg_base =
           reinterpret_cast<StackReference<mirror::Object>*>(cur_quick_frame);
       uintptr_t native_pc_offset = method_header->NativeQuickPcOffset(GetCurrentQuickFramePc());
-      CodeInfo code_info = kPrecise
-          ? CodeInfo(method_header)  // We will need dex register maps.
-          : CodeInfo::DecodeGcMasksOnly(method_header);
-      StackMap map = code_info.GetStackMapForNativePcOffset(native_pc_offset);
+      CodeInfoCache* cache = GetCodeInfoCache();
+      CodeInfo code_info = (cache != nullptr)
+          ? cache->GetCodeInfo(method_header)
+          : (kPrecise
+              ? CodeInfo(method_header)  // We will need dex register maps.
+              : CodeInfo::DecodeGcMasksOnly(method_header));
+      StackMap map = (cache != nullptr)
+          ? cache->GetStackMapForNativePcOffset(method_header, code_info, native_pc_offset)
+          : code_info.GetStackMapForNativePcOffset(native_pc_offset);
       DCHECK(map.IsValid());
 
       T vreg_info(m, code_info, map, visitor_);
@@ -4302,6 +4310,30 @@ void Thread::SetReadBarrierEntrypoints() {
   UpdateReadBarrierEntrypoints(&tlsPtr_.quick_entrypoints, /* is_active=*/ true);
 }
 
+CodeInfoCache* Thread::GetCodeInfoCache() {
+  DCHECK(this == Thread::Current());
+  if (UNLIKELY(code_info_cache_ == nullptr)) {
+    code_info_cache_.reset(new CodeInfoCache());
+  }
+  return code_info_cache_.get();
+}
+
+ReflectiveInvokeCache* Thread::GetReflectiveInvokeCache() {
+  DCHECK(this == Thread::Current());
+  if (UNLIKELY(reflective_invoke_cache_ == nullptr)) {
+    reflective_invoke_cache_.reset(new ReflectiveInvokeCache());
+  }
+  return reflective_invoke_cache_.get();
+}
+
+hiddenapi::AccessDecisionCache* Thread::GetHiddenApiAccessDecisionCache() {
+  DCHECK(this == Thread::Current());
+  if (UNLIKELY(hiddenapi_access_decision_cache_ == nullptr)) {
+    hiddenapi_access_decision_cache_.reset(new hiddenapi::AccessDecisionCache());
+  }
+  return hiddenapi_access_decision_cache_.get();
+}
+
 void Thread::ClearAllInterpreterCaches() {
   static struct ClearInterpreterCacheClosure : Closure {
     void Run(Thread* thread) override {
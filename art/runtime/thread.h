@@ -58,6 +58,10 @@ class SemiSpace;
 }  // namespace collector
 }  // namespace gc
 
+namespace hiddenapi {
+class AccessDecisionCache;
+}  // namespace hiddenapi
+
 namespace instrumentation {
 struct InstrumentationStackFrame;
 }  // namespace instrumentation
@@ -84,6 +88,7 @@ class ArtMethod;
 class BaseMutex;
 class ClassLinker;
 class Closure;
+class CodeInfoCache;
 class Context;
 class DeoptimizationContextRecord;
 class DexFile;
@@ -92,6 +97,7 @@ class IsMarkedVisitor;
 class JavaVMExt;
 class JNIEnvExt;
 class Monitor;
+class ReflectiveInvokeCache;
 class RootVisitor;
 class ScopedObjectAccessAlreadyRunnable;
 class ShadowFrame;
@@ -1342,6 +1348,35 @@ class Thread {
     return WhichPowerOf2(InterpreterCache::kSize);
   }
 
+  // Returns the cache of decoded CodeInfo used by stack walks, creating it on first use.
+  // Must only be called from the owning thread.
+  CodeInfoCache* GetCodeInfoCache();
+
+  const CodeInfoCache* GetCodeInfoCacheIfExists() const {
+    return code_info_cache_.get();
+  }
+
+  // Returns the cache of argument shapes used by reflective calls, creating it on first use.
+  // Must only be called from the owning thread.
+  ReflectiveInvokeCache* GetReflectiveInvokeCache();
+
+  // Returns the cache of hidden API access decisions, creating it on first use.
+  // Must only be called from the owning thread.
+  hiddenapi::AccessDecisionCache* GetHiddenApiAccessDecisionCache();
+
+  // Sampling state of the allocation tracker. Only accessed by the owning thread.
+  size_t GetAllocTrackerBytesUntilSample() const {
+    return alloc_tracker_bytes_until_sample_;
+  }
+
+  void SetAllocTrackerBytesUntilSample(size_t bytes) {
+    alloc_tracker_bytes_until_sample_ = bytes;
+  }
+
+  uint64_t* GetAllocTrackerSampleSeed() {
+    return &alloc_tracker_sample_seed_;
+  }
+
  private:
   explicit Thread(bool daemon);
   ~Thread() REQUIRES(!Locks::mutator_lock_, !Locks::thread_suspend_count_lock_);
@@ -1874,6 +1909,20 @@ class Thread {
   // compiled code or entrypoints.
   SafeMap<std::string, std::unique_ptr<TLSData>> custom_tls_ GUARDED_BY(Locks::custom_tls_lock_);
 
+  // Lazily allocated cache of decoded CodeInfo for stack walks done by this thread.
+  std::unique_ptr<CodeInfoCache> code_info_cache_;
+
+  // Lazily allocated cache of argument shapes for reflective calls done by this thread.
+  std::unique_ptr<ReflectiveInvokeCache> reflective_invoke_cache_;
+
+  // Lazily allocated cache of hidden API access decisions for accesses done by this thread.
+  std::unique_ptr<hiddenapi::AccessDecisionCache> hiddenapi_access_decision_cache_;
+
+  // Number of bytes this thread may still allocate before the allocation tracker takes a sample,
+  // and the state of the random generator choosing the distance between samples.
+  size_t alloc_tracker_bytes_until_sample_ = 0;
+  uint64_t alloc_tracker_sample_seed_ = 0;
+
 #ifndef __BIONIC__
   __attribute__((tls_model("initial-exec")))
   static thread_local Thread* self_tls_;
@@ -206,6 +206,13 @@ void ThreadPool::SetMaxActiveWorkers(size_t max_workers) {
   max_active_workers_ = max_workers;
 }
 
+void ThreadPool::SetThreadCount(size_t num_threads) {
+  MutexLock mu(Thread::Current(), task_queue_lock_);
+  CHECK(threads_.empty());
+  CHECK_GT(num_threads, 0u);
+  max_active_workers_ = num_threads;
+}
+
 ThreadPool::~ThreadPool() {
   DeleteThreads();
   RemoveAllTasks(Thread::Current());
@@ -160,6 +160,10 @@ class ThreadPool {
   // thread count of the thread pool.
   void SetMaxActiveWorkers(size_t threads) REQUIRES(!task_queue_lock_);
 
+  // Set the number of threads the next call to `CreateThreads` creates. The pool must not have
+  // any threads, e.g. between `DeleteThreads` and `CreateThreads` around a zygote fork.
+  void SetThreadCount(size_t num_threads) REQUIRES(!task_queue_lock_);
+
   // Set the "nice" priorty for threads in the pool.
   void SetPthreadPriority(int priority);
 
@@ -99,6 +99,26 @@ TEST_F(ThreadPoolTest, StopStart) {
   thread_pool.Wait(self, false, false);
 }
 
+// Check that the thread count can be changed while the pool has no threads.
+TEST_F(ThreadPoolTest, SetThreadCount) {
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Thread pool test thread pool", 1);
+  EXPECT_EQ(1u, thread_pool.GetThreadCount());
+  thread_pool.DeleteThreads();
+  EXPECT_EQ(0u, thread_pool.GetThreadCount());
+  thread_pool.SetThreadCount(num_threads);
+  thread_pool.CreateThreads();
+  EXPECT_EQ(static_cast<size_t>(num_threads), thread_pool.GetThreadCount());
+  AtomicInteger count(0);
+  static const int32_t num_tasks = num_threads * 4;
+  for (int32_t i = 0; i < num_tasks; ++i) {
+    thread_pool.AddTask(self, new CountTask(&count));
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, false, false);
+  EXPECT_EQ(num_tasks, count.load(std::memory_order_seq_cst));
+}
+
 TEST_F(ThreadPoolTest, StopWait) {
   Thread* self = Thread::Current();
   ThreadPool thread_pool("Thread pool test thread pool", num_threads);
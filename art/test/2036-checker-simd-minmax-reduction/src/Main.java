@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Tests for MIN/MAX vectorization of reductions.
+ */
+public class Main {
+
+  /// CHECK-START: int Main.reductionMinInt(int, int[]) loop_optimization (before)
+  /// CHECK-DAG: <<Init:i\d+>>   ParameterValue                loop:none
+  /// CHECK-DAG: <<Cons0:i\d+>>  IntConstant 0                 loop:none
+  /// CHECK-DAG: <<Cons1:i\d+>>  IntConstant 1                 loop:none
+  /// CHECK-DAG: <<Phi1:i\d+>>   Phi [<<Cons0>>,{{i\d+}}]      loop:<<Loop:B\d+>> outer_loop:none
+  /// CHECK-DAG: <<Phi2:i\d+>>   Phi [<<Init>>,{{i\d+}}]       loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: <<Get:i\d+>>    ArrayGet [{{l\d+}},<<Phi1>>]  loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:                 Min [<<Phi2>>,<<Get>>]        loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:                 Add [<<Phi1>>,<<Cons1>>]      loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:                 Return [<<Phi2>>]             loop:none
+  //
+  /// CHECK-START-ARM64: int Main.reductionMinInt(int, int[]) loop_optimization (after)
+  /// CHECK-DAG: <<Set:d\d+>>    VecReplicateScalar [{{i\d+}}] loop:none
+  /// CHECK-DAG: <<Phi:d\d+>>    Phi [<<Set>>,{{d\d+}}]        loop:<<Loop:B\d+>> outer_loop:none
+  /// CHECK-DAG: <<Load:d\d+>>   VecLoad [{{l\d+}},{{i\d+}}]   loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:                 VecMin [<<Phi>>,<<Load>>]     loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: <<Red:d\d+>>    VecReduce [<<Phi>>]           loop:none
+  /// CHECK-DAG:                 VecExtractScalar [<<Red>>]    loop:none
+  //
+  /// CHECK-START-{X86,X86_64}: int Main.reductionMinInt(int, int[]) loop_optimization (after)
+  /// CHECK-IF: hasIsaFeature("sse4.1")
+  //
+  ///   CHECK-DAG: <<Set:d\d+>>    VecReplicateScalar [{{i\d+}}] loop:none
+  ///   CHECK-DAG: <<Phi:d\d+>>    Phi [<<Set>>,{{d\d+}}]        loop:<<Loop:B\d+>> outer_loop:none
+  ///   CHECK-DAG: <<Load:d\d+>>   VecLoad [{{l\d+}},{{i\d+}}]   loop:<<Loop>>      outer_loop:none
+  ///   CHECK-DAG:                 VecMin [<<Phi>>,<<Load>>]     loop:<<Loop>>      outer_loop:none
+  ///   CHECK-DAG: <<Red:d\d+>>    VecReduce [<<Phi>>]           loop:none
+  ///   CHECK-DAG:                 VecExtractScalar [<<Red>>]    loop:none
+  //
+  /// CHECK-FI:
+  private static int reductionMinInt(int min, int[] x) {
+    for (int i = 0; i < x.length; i++) {
+      min = Math.min(min, x[i]);
+    }
+    return min;
+  }
+
+  /// CHECK-START: int Main.reductionMaxInt(int, int[]) loop_optimization (before)
+  /// CHECK-DAG: <<Init:i\d+>>   ParameterValue                loop:none
+  /// CHECK-DAG: <<Cons0:i\d+>>  IntConstant 0                 loop:none
+  /// CHECK-DAG: <<Cons1:i\d+>>  IntConstant 1                 loop:none
+  /// CHECK-DAG: <<Phi1:i\d+>>   Phi [<<Cons0>>,{{i\d+}}]      loop:<<Loop:B\d+>> outer_loop:none
+  /// CHECK-DAG: <<Phi2:i\d+>>   Phi [<<Init>>,{{i\d+}}]       loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: <<Get:i\d+>>    ArrayGet [{{l\d+}},<<Phi1>>]  loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:                 Max [<<Phi2>>,<<Get>>]        loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:                 Add [<<Phi1>>,<<Cons1>>]      loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:                 Return [<<Phi2>>]             loop:none
+  //
+  /// CHECK-START-ARM64: int Main.reductionMaxInt(int, int[]) loop_optimization (after)
+  /// CHECK-DAG: <<Set:d\d+>>    VecReplicateScalar [{{i\d+}}] loop:none
+  /// CHECK-DAG: <<Phi:d\d+>>    Phi [<<Set>>,{{d\d+}}]        loop:<<Loop:B\d+>> outer_loop:none
+  /// CHECK-DAG: <<Load:d\d+>>   VecLoad [{{l\d+}},{{i\d+}}]   loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:                 VecMax [<<Phi>>,<<Load>>]     loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: <<Red:d\d+>>    VecReduce [<<Phi>>]           loop:none
+  /// CHECK-DAG:                 VecExtractScalar [<<Red>>]    loop:none
+  //
+  /// CHECK-START-{X86,X86_64}: int Main.reductionMaxInt(int, int[]) loop_optimization (after)
+  /// CHECK-IF: hasIsaFeature("sse4.1")
+  //
+  ///   CHECK-DAG: <<Set:d\d+>>    VecReplicateScalar [{{i\d+}}] loop:none
+  ///   CHECK-DAG: <<Phi:d\d+>>    Phi [<<Set>>,{{d\d+}}]        loop:<<Loop:B\d+>> outer_loop:none
+  ///   CHECK-DAG: <<Load:d\d+>>   VecLoad [{{l\d+}},{{i\d+}}]   loop:<<Loop>>      outer_loop:none
+  ///   CHECK-DAG:                 VecMax [<<Phi>>,<<Load>>]     loop:<<Loop>>      outer_loop:none
+  ///   CHECK-DAG: <<Red:d\d+>>    VecReduce [<<Phi>>]           loop:none
+  ///   CHECK-DAG:                 VecExtractScalar [<<Red>>]    loop:none
+  //
+  /// CHECK-FI:
+  private static int reductionMaxInt(int max, int[] x) {
+    for (int i = 0; i < x.length; i++) {
+      max = Math.max(max, x[i]);
+    }
+    return max;
+  }
+
+  // Long MIN/MAX has no packed instruction on ARM64 or x86, so it stays scalar.
+  //
+  /// CHECK-START: long Main.reductionMinLong(long, long[]) loop_optimization (after)
+  /// CHECK-NOT: VecReduce
+  private static long reductionMinLong(long min, long[] x) {
+    for (int i = 0; i < x.length; i++) {
+      min = Math.min(min, x[i]);
+    }
+    return min;
+  }
+
+  public static void main(String[] args) {
+    // Every length up to a few vectors, so that the extreme values are found in each
+    // lane of the vector loop as well as in the peeling and cleanup loops.
+    for (int n = 0; n <= 37; n++) {
+      int[] x = new int[n];
+      long[] y = new long[n];
+      for (int i = 0; i < n; i++) {
+        x[i] = i - 10;
+        y[i] = i - 10;
+      }
+      expectEquals(n == 0 ? Integer.MAX_VALUE : -10, reductionMinInt(Integer.MAX_VALUE, x));
+      expectEquals(n == 0 ? Integer.MIN_VALUE : n - 11, reductionMaxInt(Integer.MIN_VALUE, x));
+      expectEquals(n == 0 ? Long.MAX_VALUE : -10L, reductionMinLong(Long.MAX_VALUE, y));
+      // The initial value is part of the reduction.
+      expectEquals(-100, reductionMinInt(-100, x));
+      expectEquals(100, reductionMaxInt(100, x));
+      for (int k = 0; k < n; k++) {
+        int saved = x[k];
+        x[k] = Integer.MIN_VALUE;
+        expectEquals(Integer.MIN_VALUE, reductionMinInt(Integer.MAX_VALUE, x));
+        x[k] = Integer.MAX_VALUE;
+        expectEquals(Integer.MAX_VALUE, reductionMaxInt(Integer.MIN_VALUE, x));
+        x[k] = saved;
+      }
+    }
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  private static void expectEquals(long expected, long result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
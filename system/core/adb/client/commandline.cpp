@@ -129,17 +129,17 @@ static void help() {
         " push [--sync] [-zZ] LOCAL... REMOTE\n"
         "     copy local files/directories to device\n"
         "     --sync: only push files that are newer on the host than the device\n"
-        "     -z: enable compression\n"
+        "     -z: enable compression with $ADB_COMPRESSION's algorithm (default any)\n"
         "     -Z: disable compression\n"
         " pull [-azZ] REMOTE... LOCAL\n"
         "     copy files/dirs from device\n"
         "     -a: preserve file timestamp and mode\n"
-        "     -z: enable compression\n"
+        "     -z: enable compression with $ADB_COMPRESSION's algorithm (default any)\n"
         "     -Z: disable compression\n"
         " sync [-lzZ] [all|data|odm|oem|product|system|system_ext|vendor]\n"
         "     sync a local build from $ANDROID_PRODUCT_OUT to the device (default all)\n"
         "     -l: list files that would be copied, but don't copy them\n"
-        "     -z: enable compression\n"
+        "     -z: enable compression with $ADB_COMPRESSION's algorithm (default any)\n"
         "     -Z: disable compression\n"
         "\n"
         "shell:\n"
@@ -230,6 +230,8 @@ static void help() {
         "     comma-separated list of debug info to log:\n"
         "     all,adb,sockets,packets,rwx,usb,sync,sysdeps,transport,jdwp\n"
         " $ADB_VENDOR_KEYS         colon-separated list of keys (files or directories)\n"
+        " $ADB_COMPRESSION         default push/pull/sync compression: any (default), none,\n"
+        "                          brotli, lz4 or zstd; any picks the fastest the device supports\n"
         " $ANDROID_SERIAL          serial number to connect to (see -s)\n"
         " $ANDROID_LOG_TAGS        tags to be used by logcat (see logcat --help)\n"
         " $ADB_LOCAL_TRANSPORT_MAX_PORT max emulator scan port (default 5585, 16 emus)\n"
@@ -1326,13 +1328,38 @@ static int restore(int argc, const char** argv) {
     return 0;
 }
 
+static CompressionType parse_compression_type(const std::string& str) {
+    if (str == "0" || str == "none") {
+        return CompressionType::None;
+    } else if (str == "1" || str == "any") {
+        return CompressionType::Any;
+    } else if (str == "brotli") {
+        return CompressionType::Brotli;
+    } else if (str == "lz4") {
+        return CompressionType::LZ4;
+    } else if (str == "zstd") {
+        return CompressionType::Zstd;
+    }
+    error_exit("unknown compression type '%s'", str.c_str());
+}
+
+// $ADB_COMPRESSION sets the default compression for push/pull/sync.
+static CompressionType default_compression() {
+    const char* adb_compression = getenv("ADB_COMPRESSION");
+    return adb_compression ? parse_compression_type(adb_compression) : CompressionType::Any;
+}
+
+// -z uses the algorithm named by $ADB_COMPRESSION, if any.
+static CompressionType enabled_compression() {
+    CompressionType compression = default_compression();
+    return compression == CompressionType::None ? CompressionType::Any : compression;
+}
+
 static void parse_push_pull_args(const char** arg, int narg, std::vector<const char*>* srcs,
-                                 const char** dst, bool* copy_attrs, bool* sync, bool* compressed) {
+                                 const char** dst, bool* copy_attrs, bool* sync,
+                                 CompressionType* compression) {
     *copy_attrs = false;
-    const char* adb_compression = getenv("ADB_COMPRESSION");
-    if (adb_compression && strcmp(adb_compression, "0") == 0) {
-        *compressed = false;
-    }
+    *compression = default_compression();
 
     srcs->clear();
     bool ignore_flags = false;
@@ -1345,13 +1372,9 @@ static void parse_push_pull_args(const char** arg, int narg, std::vector<const c
             } else if (!strcmp(*arg, "-a")) {
                 *copy_attrs = true;
             } else if (!strcmp(*arg, "-z")) {
-                if (compressed != nullptr) {
-                    *compressed = true;
-                }
+                *compression = enabled_compression();
             } else if (!strcmp(*arg, "-Z")) {
-                if (compressed != nullptr) {
-                    *compressed = false;
-                }
+                *compression = CompressionType::None;
             } else if (!strcmp(*arg, "--sync")) {
                 if (sync != nullptr) {
                     *sync = true;
@@ -1874,22 +1897,22 @@ int adb_commandline(int argc, const char** argv) {
     } else if (!strcmp(argv[0], "push")) {
         bool copy_attrs = false;
         bool sync = false;
-        bool compressed = true;
+        CompressionType compression;
         std::vector<const char*> srcs;
         const char* dst = nullptr;
 
-        parse_push_pull_args(&argv[1], argc - 1, &srcs, &dst, &copy_attrs, &sync, &compressed);
+        parse_push_pull_args(&argv[1], argc - 1, &srcs, &dst, &copy_attrs, &sync, &compression);
         if (srcs.empty() || !dst) error_exit("push requires an argument");
-        return do_sync_push(srcs, dst, sync, compressed) ? 0 : 1;
+        return do_sync_push(srcs, dst, sync, compression) ? 0 : 1;
     } else if (!strcmp(argv[0], "pull")) {
         bool copy_attrs = false;
-        bool compressed = true;
+        CompressionType compression;
         std::vector<const char*> srcs;
         const char* dst = ".";
 
-        parse_push_pull_args(&argv[1], argc - 1, &srcs, &dst, &copy_attrs, nullptr, &compressed);
+        parse_push_pull_args(&argv[1], argc - 1, &srcs, &dst, &copy_attrs, nullptr, &compression);
         if (srcs.empty()) error_exit("pull requires an argument");
-        return do_sync_pull(srcs, dst, copy_attrs, compressed) ? 0 : 1;
+        return do_sync_pull(srcs, dst, copy_attrs, compression) ? 0 : 1;
     } else if (!strcmp(argv[0], "install")) {
         if (argc < 2) error_exit("install requires an argument");
         return install_app(argc, argv);
@@ -1905,12 +1928,7 @@ int adb_commandline(int argc, const char** argv) {
     } else if (!strcmp(argv[0], "sync")) {
         std::string src;
         bool list_only = false;
-        bool compressed = true;
-
-        const char* adb_compression = getenv("ADB_COMPRESSION");
-        if (adb_compression && strcmp(adb_compression, "0") == 0) {
-            compressed = false;
-        }
+        CompressionType compression = default_compression();
 
         int opt;
         while ((opt = getopt(argc, const_cast<char**>(argv), "lzZ")) != -1) {
@@ -1919,10 +1937,10 @@ int adb_commandline(int argc, const char** argv) {
                     list_only = true;
                     break;
                 case 'z':
-                    compressed = true;
+                    compression = enabled_compression();
                     break;
                 case 'Z':
-                    compressed = false;
+                    compression = CompressionType::None;
                     break;
                 default:
                     error_exit("usage: adb sync [-lzZ] [PARTITION]");
@@ -1945,7 +1963,7 @@ int adb_commandline(int argc, const char** argv) {
                 std::string src_dir{product_file(partition)};
                 if (!directory_exists(src_dir)) continue;
                 found = true;
-                if (!do_sync_sync(src_dir, "/" + partition, list_only, compressed)) return 1;
+                if (!do_sync_sync(src_dir, "/" + partition, list_only, compression)) return 1;
             }
         }
         if (!found) error_exit("don't know how to sync %s partition", src.c_str());
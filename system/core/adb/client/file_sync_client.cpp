@@ -31,6 +31,7 @@
 #include <chrono>
 #include <deque>
 #include <functional>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -42,7 +43,7 @@
 #include "adb_client.h"
 #include "adb_io.h"
 #include "adb_utils.h"
-#include "brotli_utils.h"
+#include "compression_utils.h"
 #include "file_sync_protocol.h"
 #include "line_printer.h"
 #include "sysdeps/errno.h"
@@ -108,6 +109,23 @@ enum class TransferDirection {
     pull,
 };
 
+static uint32_t compression_flag(CompressionType compression) {
+    switch (compression) {
+        case CompressionType::None:
+            return kSyncFlagNone;
+        case CompressionType::Brotli:
+            return kSyncFlagBrotli;
+        case CompressionType::LZ4:
+            return kSyncFlagLZ4;
+        case CompressionType::Zstd:
+            return kSyncFlagZstd;
+        case CompressionType::Any:
+            break;
+    }
+    LOG(FATAL) << "unresolved CompressionType: " << static_cast<int>(compression);
+    __builtin_unreachable();
+}
+
 struct TransferLedger {
     std::chrono::steady_clock::time_point start_time;
     uint64_t files_transferred;
@@ -236,6 +254,8 @@ class SyncConnection {
             have_ls_v2_ = CanUseFeature(features_, kFeatureLs2);
             have_sendrecv_v2_ = CanUseFeature(features_, kFeatureSendRecv2);
             have_sendrecv_v2_brotli_ = CanUseFeature(features_, kFeatureSendRecv2Brotli);
+            have_sendrecv_v2_lz4_ = CanUseFeature(features_, kFeatureSendRecv2LZ4);
+            have_sendrecv_v2_zstd_ = CanUseFeature(features_, kFeatureSendRecv2Zstd);
             fd.reset(adb_connect("sync:", &error));
             if (fd < 0) {
                 Error("connect failed: %s", error.c_str());
@@ -260,7 +280,86 @@ class SyncConnection {
     }
 
     bool HaveSendRecv2() const { return have_sendrecv_v2_; }
-    bool HaveSendRecv2Brotli() const { return have_sendrecv_v2_brotli_; }
+
+    bool HaveCompression(CompressionType compression) const {
+        switch (compression) {
+            case CompressionType::Brotli:
+                return have_sendrecv_v2_brotli_;
+            case CompressionType::LZ4:
+                return have_sendrecv_v2_lz4_;
+            case CompressionType::Zstd:
+                return have_sendrecv_v2_zstd_;
+            case CompressionType::None:
+            case CompressionType::Any:
+                return false;
+        }
+    }
+
+    // Choose the compression to use for a file of the given size. An explicitly requested
+    // algorithm is used if the device supports it. Otherwise we pick between the fast codecs the
+    // device supports, trying each once on a large enough file and then using whichever has given
+    // the best end-to-end throughput on this connection so far. Every few large files the other
+    // one is tried again, since which is faster depends on the data. Brotli is only used if
+    // neither of them is available.
+    CompressionType ResolveCompression(CompressionType compression, uint64_t size) {
+        if (compression == CompressionType::None || !have_sendrecv_v2_) {
+            return CompressionType::None;
+        }
+        if (compression != CompressionType::Any && HaveCompression(compression)) {
+            return compression;
+        }
+
+        std::vector<CompressionType> candidates;
+        for (CompressionType candidate : {CompressionType::Zstd, CompressionType::LZ4}) {
+            if (HaveCompression(candidate)) {
+                candidates.push_back(candidate);
+            }
+        }
+        if (candidates.empty()) {
+            return have_sendrecv_v2_brotli_ ? CompressionType::Brotli : CompressionType::None;
+        }
+
+        CompressionType best = candidates.front();
+        for (CompressionType candidate : candidates) {
+            const CompressionStats& stats = compression_stats_[candidate];
+            if (stats.samples == 0) {
+                // Small files are dominated by per-file overhead, so don't waste them on probing.
+                if (size >= kCompressionSampleBytes) return candidate;
+                continue;
+            }
+            const CompressionStats& best_stats = compression_stats_[best];
+            if (best_stats.samples == 0 || stats.bytes_per_second > best_stats.bytes_per_second) {
+                best = candidate;
+            }
+        }
+        if (size < kCompressionSampleBytes) return best;
+        if (++large_files_since_probe_ < kCompressionProbeInterval) return best;
+        large_files_since_probe_ = 0;
+        for (CompressionType candidate : candidates) {
+            if (candidate != best) return candidate;
+        }
+        return best;
+    }
+
+    // Record how long it took to transfer |bytes| of uncompressed file data with |compression|.
+    void RecordCompressionThroughput(CompressionType compression, uint64_t bytes,
+                                     std::chrono::steady_clock::duration elapsed) {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        if (bytes < kCompressionSampleBytes || seconds <= 0) {
+            return;
+        }
+
+        // Exponentially weighted, so that a change in the data being transferred (text vs.
+        // already-compressed media, say) is picked up after a few files.
+        double bytes_per_second = bytes / seconds;
+        CompressionStats& stats = compression_stats_[compression];
+        if (stats.samples == 0) {
+            stats.bytes_per_second = bytes_per_second;
+        } else {
+            stats.bytes_per_second = 0.75 * stats.bytes_per_second + 0.25 * bytes_per_second;
+        }
+        stats.samples++;
+    }
 
     const FeatureSet& Features() const { return features_; }
 
@@ -323,7 +422,7 @@ class SyncConnection {
         return WriteFdExactly(fd, buf.data(), buf.size());
     }
 
-    bool SendSend2(std::string_view path, mode_t mode, bool compressed) {
+    bool SendSend2(std::string_view path, mode_t mode, CompressionType compression) {
         if (path.length() > 1024) {
             Error("SendRequest failed: path too long: %zu", path.length());
             errno = ENAMETOOLONG;
@@ -339,7 +438,7 @@ class SyncConnection {
         syncmsg msg;
         msg.send_v2_setup.id = ID_SEND_V2;
         msg.send_v2_setup.mode = mode;
-        msg.send_v2_setup.flags = compressed ? kSyncFlagBrotli : kSyncFlagNone;
+        msg.send_v2_setup.flags = compression_flag(compression);
 
         buf.resize(sizeof(SyncRequest) + path.length() + sizeof(msg.send_v2_setup));
 
@@ -352,7 +451,7 @@ class SyncConnection {
         return WriteFdExactly(fd, buf.data(), buf.size());
     }
 
-    bool SendRecv2(const std::string& path) {
+    bool SendRecv2(const std::string& path, CompressionType compression) {
         if (path.length() > 1024) {
             Error("SendRequest failed: path too long: %zu", path.length());
             errno = ENAMETOOLONG;
@@ -367,7 +466,7 @@ class SyncConnection {
 
         syncmsg msg;
         msg.recv_v2_setup.id = ID_RECV_V2;
-        msg.recv_v2_setup.flags = kSyncFlagBrotli;
+        msg.recv_v2_setup.flags = compression_flag(compression);
 
         buf.resize(sizeof(SyncRequest) + path.length() + sizeof(msg.recv_v2_setup));
 
@@ -534,8 +633,9 @@ class SyncConnection {
     }
 
     bool SendLargeFileCompressed(const std::string& path, mode_t mode, const std::string& lpath,
-                                 const std::string& rpath, unsigned mtime) {
-        if (!SendSend2(path, mode, true)) {
+                                 const std::string& rpath, unsigned mtime,
+                                 CompressionType compression) {
+        if (!SendSend2(path, mode, compression)) {
             Error("failed to send ID_SEND_V2 message '%s': %s", path.c_str(), strerror(errno));
             return false;
         }
@@ -558,7 +658,8 @@ class SyncConnection {
         syncsendbuf sbuf;
         sbuf.id = ID_DATA;
 
-        BrotliEncoder<SYNC_DATA_MAX> encoder;
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<Encoder> encoder = CreateEncoder(compression, SYNC_DATA_MAX);
         bool sending = true;
         while (sending) {
             Block input(SYNC_DATA_MAX);
@@ -569,10 +670,10 @@ class SyncConnection {
             }
 
             if (r == 0) {
-                encoder.Finish();
+                encoder->Finish();
             } else {
                 input.resize(r);
-                encoder.Append(std::move(input));
+                encoder->Append(std::move(input));
                 RecordBytesTransferred(r);
                 bytes_copied += r;
                 ReportProgress(rpath, bytes_copied, total_size);
@@ -580,8 +681,8 @@ class SyncConnection {
 
             while (true) {
                 Block output;
-                BrotliEncodeResult result = encoder.Encode(&output);
-                if (result == BrotliEncodeResult::Error) {
+                EncodeResult result = encoder->Encode(&output);
+                if (result == EncodeResult::Error) {
                     Error("compressing '%s' locally failed", lpath.c_str());
                     return false;
                 }
@@ -592,16 +693,18 @@ class SyncConnection {
                     WriteOrDie(lpath, rpath, &sbuf, sizeof(SyncRequest) + output.size());
                 }
 
-                if (result == BrotliEncodeResult::Done) {
+                if (result == EncodeResult::Done) {
                     sending = false;
                     break;
-                } else if (result == BrotliEncodeResult::NeedInput) {
+                } else if (result == EncodeResult::NeedInput) {
                     break;
-                } else if (result == BrotliEncodeResult::MoreOutput) {
+                } else if (result == EncodeResult::MoreOutput) {
                     continue;
                 }
             }
         }
+        RecordCompressionThroughput(compression, bytes_copied,
+                                    std::chrono::steady_clock::now() - start);
 
         syncmsg msg;
         msg.data.id = ID_DONE;
@@ -611,9 +714,9 @@ class SyncConnection {
     }
 
     bool SendLargeFile(const std::string& path, mode_t mode, const std::string& lpath,
-                       const std::string& rpath, unsigned mtime, bool compressed) {
-        if (compressed && HaveSendRecv2Brotli()) {
-            return SendLargeFileCompressed(path, mode, lpath, rpath, mtime);
+                       const std::string& rpath, unsigned mtime, CompressionType compression) {
+        if (compression != CompressionType::None) {
+            return SendLargeFileCompressed(path, mode, lpath, rpath, mtime, compression);
         }
 
         std::string path_and_mode = android::base::StringPrintf("%s,%d", path.c_str(), mode);
@@ -840,6 +943,20 @@ class SyncConnection {
     bool have_ls_v2_;
     bool have_sendrecv_v2_;
     bool have_sendrecv_v2_brotli_;
+    bool have_sendrecv_v2_lz4_;
+    bool have_sendrecv_v2_zstd_;
+
+    // Files smaller than this don't say much about a codec's throughput.
+    static constexpr uint64_t kCompressionSampleBytes = 1024 * 1024;
+    // How many large files go to the best codec before the other one is measured again.
+    static constexpr size_t kCompressionProbeInterval = 16;
+
+    struct CompressionStats {
+        size_t samples = 0;
+        double bytes_per_second = 0;
+    };
+    std::map<CompressionType, CompressionStats> compression_stats_;
+    size_t large_files_since_probe_ = 0;
 
     TransferLedger global_ledger_;
     TransferLedger current_ledger_;
@@ -921,7 +1038,7 @@ static bool sync_stat_fallback(SyncConnection& sc, const std::string& path, stru
 }
 
 static bool sync_send(SyncConnection& sc, const std::string& lpath, const std::string& rpath,
-                      unsigned mtime, mode_t mode, bool sync, bool compressed) {
+                      unsigned mtime, mode_t mode, bool sync, CompressionType compression) {
     if (sync) {
         struct stat st;
         if (sync_lstat(sc, rpath, &st)) {
@@ -964,17 +1081,16 @@ static bool sync_send(SyncConnection& sc, const std::string& lpath, const std::s
             return false;
         }
     } else {
-        if (!sc.SendLargeFile(rpath, mode, lpath, rpath, mtime, compressed)) {
+        if (!sc.SendLargeFile(rpath, mode, lpath, rpath, mtime,
+                              sc.ResolveCompression(compression, st.st_size))) {
             return false;
         }
     }
     return sc.ReadAcknowledgements();
 }
 
-static bool sync_recv_v1(SyncConnection& sc, const char* rpath, const char* lpath, const char* name,
-                         uint64_t expected_size) {
-    if (!sc.SendRequest(ID_RECV_V1, rpath)) return false;
-
+static bool sync_finish_recv_v1(SyncConnection& sc, const char* rpath, const char* lpath,
+                                const char* name, uint64_t expected_size) {
     adb_unlink(lpath);
     unique_fd lfd(adb_creat(lpath, 0644));
     if (lfd < 0) {
@@ -1026,10 +1142,9 @@ static bool sync_recv_v1(SyncConnection& sc, const char* rpath, const char* lpat
     return true;
 }
 
-static bool sync_recv_v2(SyncConnection& sc, const char* rpath, const char* lpath, const char* name,
-                         uint64_t expected_size) {
-    if (!sc.SendRecv2(rpath)) return false;
-
+static bool sync_finish_recv_v2(SyncConnection& sc, const char* rpath, const char* lpath,
+                                const char* name, uint64_t expected_size,
+                                CompressionType compression) {
     adb_unlink(lpath);
     unique_fd lfd(adb_creat(lpath, 0644));
     if (lfd < 0) {
@@ -1039,8 +1154,10 @@ static bool sync_recv_v2(SyncConnection& sc, const char* rpath, const char* lpat
 
     uint64_t bytes_copied = 0;
 
+    auto start = std::chrono::steady_clock::now();
     Block buffer(SYNC_DATA_MAX);
-    BrotliDecoder decoder(std::span(buffer.data(), buffer.size()));
+    std::unique_ptr<Decoder> decoder =
+            CreateDecoder(compression, std::span(buffer.data(), buffer.size()));
     bool reading = true;
     while (reading) {
         syncmsg msg;
@@ -1072,13 +1189,13 @@ static bool sync_recv_v2(SyncConnection& sc, const char* rpath, const char* lpat
             adb_unlink(lpath);
             return false;
         }
-        decoder.Append(std::move(block));
+        decoder->Append(std::move(block));
 
         while (true) {
             std::span<char> output;
-            BrotliDecodeResult result = decoder.Decode(&output);
+            DecodeResult result = decoder->Decode(&output);
 
-            if (result == BrotliDecodeResult::Error) {
+            if (result == DecodeResult::Error) {
                 sc.Error("decompress failed");
                 adb_unlink(lpath);
                 return false;
@@ -1097,15 +1214,15 @@ static bool sync_recv_v2(SyncConnection& sc, const char* rpath, const char* lpat
             sc.RecordBytesTransferred(msg.data.size);
             sc.ReportProgress(name != nullptr ? name : rpath, bytes_copied, expected_size);
 
-            if (result == BrotliDecodeResult::NeedInput) {
+            if (result == DecodeResult::NeedInput) {
                 break;
-            } else if (result == BrotliDecodeResult::MoreOutput) {
+            } else if (result == DecodeResult::MoreOutput) {
                 continue;
-            } else if (result == BrotliDecodeResult::Done) {
+            } else if (result == DecodeResult::Done) {
                 reading = false;
                 break;
             } else {
-                LOG(FATAL) << "invalid BrotliDecodeResult: " << static_cast<int>(result);
+                LOG(FATAL) << "invalid DecodeResult: " << static_cast<int>(result);
             }
         }
     }
@@ -1121,19 +1238,40 @@ static bool sync_recv_v2(SyncConnection& sc, const char* rpath, const char* lpat
         return false;
     }
 
+    sc.RecordCompressionThroughput(compression, bytes_copied,
+                                   std::chrono::steady_clock::now() - start);
     sc.RecordFilesTransferred(1);
     return true;
 }
 
-static bool sync_recv(SyncConnection& sc, const char* rpath, const char* lpath, const char* name,
-                      uint64_t expected_size, bool compressed) {
-    if (sc.HaveSendRecv2() && compressed) {
-        return sync_recv_v2(sc, rpath, lpath, name, expected_size);
+// Requesting a file and reading it back are separate steps so that callers can keep several
+// requests in flight. |compression| must already have been resolved by the SyncConnection.
+static bool sync_send_recv_request(SyncConnection& sc, const char* rpath,
+                                   CompressionType compression) {
+    if (compression == CompressionType::None) {
+        return sc.SendRequest(ID_RECV_V1, rpath);
     } else {
-        return sync_recv_v1(sc, rpath, lpath, name, expected_size);
+        return sc.SendRecv2(rpath, compression);
     }
 }
 
+static bool sync_finish_recv(SyncConnection& sc, const char* rpath, const char* lpath,
+                             const char* name, uint64_t expected_size,
+                             CompressionType compression) {
+    if (compression == CompressionType::None) {
+        return sync_finish_recv_v1(sc, rpath, lpath, name, expected_size);
+    } else {
+        return sync_finish_recv_v2(sc, rpath, lpath, name, expected_size, compression);
+    }
+}
+
+static bool sync_recv(SyncConnection& sc, const char* rpath, const char* lpath, const char* name,
+                      uint64_t expected_size, CompressionType compression) {
+    compression = sc.ResolveCompression(compression, expected_size);
+    return sync_send_recv_request(sc, rpath, compression) &&
+           sync_finish_recv(sc, rpath, lpath, name, expected_size, compression);
+}
+
 bool do_sync_ls(const char* path) {
     SyncConnection sc;
     if (!sc.IsValid()) return false;
@@ -1210,7 +1348,8 @@ static bool is_root_dir(std::string_view path) {
 }
 
 static bool copy_local_dir_remote(SyncConnection& sc, std::string lpath, std::string rpath,
-                                  bool check_timestamps, bool list_only, bool compressed) {
+                                  bool check_timestamps, bool list_only,
+                                  CompressionType compression) {
     sc.NewTransfer();
 
     // Make sure that both directory paths end in a slash.
@@ -1292,7 +1431,7 @@ static bool copy_local_dir_remote(SyncConnection& sc, std::string lpath, std::st
             if (list_only) {
                 sc.Println("would push: %s -> %s", ci.lpath.c_str(), ci.rpath.c_str());
             } else {
-                if (!sync_send(sc, ci.lpath, ci.rpath, ci.time, ci.mode, false, compressed)) {
+                if (!sync_send(sc, ci.lpath, ci.rpath, ci.time, ci.mode, false, compression)) {
                     return false;
                 }
             }
@@ -1308,7 +1447,7 @@ static bool copy_local_dir_remote(SyncConnection& sc, std::string lpath, std::st
 }
 
 bool do_sync_push(const std::vector<const char*>& srcs, const char* dst, bool sync,
-                  bool compressed) {
+                  CompressionType compression) {
     SyncConnection sc;
     if (!sc.IsValid()) return false;
 
@@ -1373,7 +1512,7 @@ bool do_sync_push(const std::vector<const char*>& srcs, const char* dst, bool sy
                 dst_dir.append(android::base::Basename(src_path));
             }
 
-            success &= copy_local_dir_remote(sc, src_path, dst_dir, sync, false, compressed);
+            success &= copy_local_dir_remote(sc, src_path, dst_dir, sync, false, compression);
             continue;
         } else if (!should_push_file(st.st_mode)) {
             sc.Warning("skipping special file '%s' (mode = 0o%o)", src_path, st.st_mode);
@@ -1394,7 +1533,7 @@ bool do_sync_push(const std::vector<const char*>& srcs, const char* dst, bool sy
 
         sc.NewTransfer();
         sc.SetExpectedTotalBytes(st.st_size);
-        success &= sync_send(sc, src_path, dst_path, st.st_mtime, st.st_mode, sync, compressed);
+        success &= sync_send(sc, src_path, dst_path, st.st_mtime, st.st_mode, sync, compression);
         sc.ReportTransferRate(src_path, TransferDirection::push);
     }
 
@@ -1480,7 +1619,7 @@ static int set_time_and_mode(const std::string& lpath, time_t time,
 }
 
 static bool copy_remote_dir_local(SyncConnection& sc, std::string rpath, std::string lpath,
-                                  bool copy_attrs, bool compressed) {
+                                  bool copy_attrs, CompressionType compression) {
     sc.NewTransfer();
 
     // Make sure that both directory paths end in a slash.
@@ -1496,6 +1635,28 @@ static bool copy_remote_dir_local(SyncConnection& sc, std::string rpath, std::st
 
     sc.ComputeExpectedTotalBytes(file_list);
 
+    // Keep several requests in flight, so that the device is already reading the next file
+    // while we're writing out the previous one. For directories full of small files that round
+    // trip is most of the cost. The responses come back in the order of the requests.
+    static constexpr size_t kMaxPendingRecvs = 32;
+    struct PendingRecv {
+        const copyinfo* ci;
+        CompressionType compression;
+    };
+    std::deque<PendingRecv> pending;
+
+    auto finish_recv = [&]() {
+        PendingRecv recv = pending.front();
+        pending.pop_front();
+
+        const copyinfo& ci = *recv.ci;
+        if (!sync_finish_recv(sc, ci.rpath.c_str(), ci.lpath.c_str(), nullptr, ci.size,
+                              recv.compression)) {
+            return false;
+        }
+        return !(copy_attrs && set_time_and_mode(ci.lpath, ci.time, ci.mode));
+    };
+
     int skipped = 0;
     for (const copyinfo &ci : file_list) {
         if (!ci.skip) {
@@ -1510,11 +1671,13 @@ static bool copy_remote_dir_local(SyncConnection& sc, std::string rpath, std::st
                 continue;
             }
 
-            if (!sync_recv(sc, ci.rpath.c_str(), ci.lpath.c_str(), nullptr, ci.size, compressed)) {
+            CompressionType file_compression = sc.ResolveCompression(compression, ci.size);
+            if (!sync_send_recv_request(sc, ci.rpath.c_str(), file_compression)) {
                 return false;
             }
+            pending.push_back({&ci, file_compression});
 
-            if (copy_attrs && set_time_and_mode(ci.lpath, ci.time, ci.mode)) {
+            if (pending.size() >= kMaxPendingRecvs && !finish_recv()) {
                 return false;
             }
         } else {
@@ -1522,13 +1685,19 @@ static bool copy_remote_dir_local(SyncConnection& sc, std::string rpath, std::st
         }
     }
 
+    while (!pending.empty()) {
+        if (!finish_recv()) {
+            return false;
+        }
+    }
+
     sc.RecordFilesSkipped(skipped);
     sc.ReportTransferRate(rpath, TransferDirection::pull);
     return true;
 }
 
 bool do_sync_pull(const std::vector<const char*>& srcs, const char* dst, bool copy_attrs,
-                  bool compressed, const char* name) {
+                  CompressionType compression, const char* name) {
     SyncConnection sc;
     if (!sc.IsValid()) return false;
 
@@ -1602,7 +1771,7 @@ bool do_sync_pull(const std::vector<const char*>& srcs, const char* dst, bool co
                 dst_dir.append(android::base::Basename(src_path));
             }
 
-            success &= copy_remote_dir_local(sc, src_path, dst_dir, copy_attrs, compressed);
+            success &= copy_remote_dir_local(sc, src_path, dst_dir, copy_attrs, compression);
             continue;
         } else if (!should_pull_file(src_st.st_mode)) {
             sc.Warning("skipping special file '%s' (mode = 0o%o)", src_path, src_st.st_mode);
@@ -1621,7 +1790,7 @@ bool do_sync_pull(const std::vector<const char*>& srcs, const char* dst, bool co
 
         sc.NewTransfer();
         sc.SetExpectedTotalBytes(src_st.st_size);
-        if (!sync_recv(sc, src_path, dst_path, name, src_st.st_size, compressed)) {
+        if (!sync_recv(sc, src_path, dst_path, name, src_st.st_size, compression)) {
             success = false;
             continue;
         }
@@ -1638,11 +1807,11 @@ bool do_sync_pull(const std::vector<const char*>& srcs, const char* dst, bool co
 }
 
 bool do_sync_sync(const std::string& lpath, const std::string& rpath, bool list_only,
-                  bool compressed) {
+                  CompressionType compression) {
     SyncConnection sc;
     if (!sc.IsValid()) return false;
 
-    bool success = copy_local_dir_remote(sc, lpath, rpath, true, list_only, compressed);
+    bool success = copy_local_dir_remote(sc, lpath, rpath, true, list_only, compression);
     if (!list_only) {
         sc.ReportOverallTransferRate(TransferDirection::push);
     }
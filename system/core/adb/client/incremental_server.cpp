@@ -156,10 +156,11 @@ class File {
         this->tree_fd_ = std::move(tree_fd);
         priority_blocks_ = PriorityBlocksForFile(filepath, fd_.get(), size);
     }
-    int64_t ReadDataBlock(BlockIdx block_idx, void* buf, bool* is_zip_compressed) const {
+    // Reads |count| consecutive data blocks with a single read.
+    int64_t ReadDataBlocks(BlockIdx block_idx, int count, void* buf) const {
         int64_t bytes_read = -1;
         const off64_t offsetStart = blockIndexToOffset(block_idx);
-        bytes_read = adb_pread(fd_, buf, kBlockSize, offsetStart);
+        bytes_read = adb_pread(fd_, buf, int64_t(count) * kBlockSize, offsetStart);
         return bytes_read;
     }
     int64_t ReadTreeBlock(BlockIdx block_idx, void* buf) const {
@@ -198,6 +199,7 @@ class IncrementalServer {
     IncrementalServer(unique_fd adb_fd, unique_fd output_fd, std::vector<File> files)
         : adb_fd_(std::move(adb_fd)), output_fd_(std::move(output_fd)), files_(std::move(files)) {
         buffer_.reserve(kReadBufferSize);
+        dataBlocksBuffer_.resize(kMaxBatchBlocks * kBlockSize);
         pendingBlocksBuffer_.resize(kChunkFlushSize + 2 * kBlockSize);
         pendingBlocks_ = pendingBlocksBuffer_.data() + sizeof(ChunkHeader);
     }
@@ -211,13 +213,16 @@ class IncrementalServer {
         BlockIdx overallEnd = 0;
         BlockIdx priorityIndex = 0;
 
-        explicit PrefetchState(const File& f, BlockIdx start, int count)
+        // Sends the file's priority blocks, then the whole file in order.
+        explicit PrefetchState(const File& f)
+            : file(&f), overallEnd((BlockIdx)f.sentBlocks.size()) {}
+
+        // Only reads ahead |count| blocks from |start|, skipping the priority blocks.
+        PrefetchState(const File& f, BlockIdx start, int count)
             : file(&f),
               overallIndex(start),
-              overallEnd(std::min<BlockIdx>(start + count, f.sentBlocks.size())) {}
-
-        explicit PrefetchState(const File& f)
-            : PrefetchState(f, 0, (BlockIdx)f.sentBlocks.size()) {}
+              overallEnd(std::min<BlockIdx>(start + count, f.sentBlocks.size())),
+              priorityIndex((BlockIdx)f.PriorityBlocks().size()) {}
 
         bool done() const {
             const bool overallSent = (overallIndex >= overallEnd);
@@ -235,12 +240,16 @@ class IncrementalServer {
 
     enum class SendResult { Sent, Skipped, Error };
     SendResult SendDataBlock(FileId fileId, BlockIdx blockIdx, bool flush = false);
+    int SendDataBlocks(FileId fileId, BlockIdx blockIdx, int count, bool flush = false);
+    void SendDataBlockBytes(File& file, BlockIdx blockIdx, const char* data, int16_t size,
+                            bool flush);
 
     bool SendTreeBlock(FileId fileId, int32_t fileBlockIdx, BlockIdx blockIdx);
     bool SendTreeBlocksForDataBlock(FileId fileId, BlockIdx blockIdx);
 
     bool SendDone();
     void RunPrefetching();
+    int RunPrefetchLane(std::deque<PrefetchState>* lane, int blocksToSend);
 
     void Send(const void* data, size_t size, bool flush);
     void Flush();
@@ -254,11 +263,20 @@ class IncrementalServer {
     // Incoming data buffer.
     std::vector<char> buffer_;
 
+    // Prefetch lanes, in priority order. Both only ever run after all the pending requests from
+    // the device are handled, so a page miss never waits for more than one prefetch slice.
+    // Blocks right after a reported miss: the reader is likely to carry on there.
+    std::deque<PrefetchState> readaheads_;
+    // Everything else: each file's priority blocks, then the whole file in order.
     std::deque<PrefetchState> prefetches_;
     int compressed_ = 0, uncompressed_ = 0;
     long long sentSize_ = 0;
 
     static constexpr auto kChunkFlushSize = 31 * kBlockSize;
+    // Adjacent blocks are read in runs of up to this many.
+    static constexpr int kMaxBatchBlocks = 16;
+
+    std::vector<char> dataBlocksBuffer_;
 
     std::vector<char> pendingBlocksBuffer_;
     char* pendingBlocks_ = nullptr;
@@ -409,28 +427,67 @@ auto IncrementalServer::SendDataBlock(FileId fileId, BlockIdx blockIdx, bool flu
         D("Skipped reading file %s at block %" PRId32 " (past end).", file.filepath, blockIdx);
         return SendResult::Skipped;
     }
-    if (file.sentBlocks[blockIdx]) {
-        return SendResult::Skipped;
-    }
 
-    if (!SendTreeBlocksForDataBlock(fileId, blockIdx)) {
-        return SendResult::Error;
+    switch (SendDataBlocks(fileId, blockIdx, 1, flush)) {
+        case 1:
+            return SendResult::Sent;
+        case 0:
+            return SendResult::Skipped;
+        default:
+            return SendResult::Error;
     }
+}
 
-    BlockBuffer raw;
-    bool isZipCompressed = false;
-    const int64_t bytesRead = file.ReadDataBlock(blockIdx, raw.data, &isZipCompressed);
-    if (bytesRead < 0) {
-        fprintf(stderr, "Failed to get data for %s at blockIdx=%d (%d).\n", file.filepath, blockIdx,
-                errno);
-        return SendResult::Error;
+// Sends the blocks in [blockIdx, blockIdx + count) that haven't been sent yet, reading each run
+// of adjacent ones at once. Returns the number of blocks sent, or -1 on error.
+int IncrementalServer::SendDataBlocks(FileId fileId, BlockIdx blockIdx, int count, bool flush) {
+    auto& file = files_[fileId];
+    const BlockIdx end = std::min<BlockIdx>(blockIdx + count, file.sentBlocks.size());
+
+    int sent = 0;
+    for (BlockIdx runStart = blockIdx; runStart < end;) {
+        if (file.sentBlocks[runStart]) {
+            ++runStart;
+            continue;
+        }
+        BlockIdx runEnd = runStart + 1;
+        while (runEnd < end && runEnd - runStart < kMaxBatchBlocks && !file.sentBlocks[runEnd]) {
+            ++runEnd;
+        }
+
+        const int64_t bytesRead =
+                file.ReadDataBlocks(runStart, runEnd - runStart, dataBlocksBuffer_.data());
+        if (bytesRead <= 0) {
+            fprintf(stderr, "Failed to get data for %s at blockIdx=%d (%d).\n", file.filepath,
+                    runStart, errno);
+            return -1;
+        }
+        // Only the last block of a file may be short.
+        runEnd = std::min<BlockIdx>(runEnd, runStart + numBytesToNumBlocks(bytesRead));
+
+        for (BlockIdx i = runStart; i < runEnd; ++i) {
+            if (!SendTreeBlocksForDataBlock(fileId, i)) {
+                return -1;
+            }
+            const int64_t offset = blockIndexToOffset(i - runStart);
+            SendDataBlockBytes(file, i, dataBlocksBuffer_.data() + offset,
+                               std::min<int64_t>(kBlockSize, bytesRead - offset),
+                               flush && i + 1 == end);
+            ++sent;
+        }
+        runStart = runEnd;
     }
+    return sent;
+}
 
+// Blocks are compressed one at a time, as the device hands each one to incfs separately.
+void IncrementalServer::SendDataBlockBytes(File& file, BlockIdx blockIdx, const char* data,
+                                           int16_t size, bool flush) {
     BlockBuffer<kCompressBound> compressed;
-    int16_t compressedSize = 0;
-    if (!isZipCompressed) {
-        compressedSize = LZ4_compress_default(raw.data, compressed.data, bytesRead, kCompressBound);
-    }
+    const int16_t compressedSize =
+            LZ4_compress_default(data, compressed.data, size, kCompressBound);
+
+    BlockBuffer raw;
     int16_t blockSize;
     ResponseHeader* header;
     if (compressedSize > 0 && compressedSize < kCompressedSizeMax) {
@@ -440,21 +497,20 @@ auto IncrementalServer::SendDataBlock(FileId fileId, BlockIdx blockIdx, bool flu
         header->compression_type = kCompressionLZ4;
     } else {
         ++uncompressed_;
-        blockSize = bytesRead;
+        blockSize = size;
+        memcpy(raw.data, data, size);
         header = &raw.header;
         header->compression_type = kCompressionNone;
     }
 
     header->block_type = kTypeData;
-    header->file_id = toBigEndian(fileId);
+    header->file_id = toBigEndian(file.id);
     header->block_size = toBigEndian(blockSize);
     header->block_idx = toBigEndian(blockIdx);
 
     file.sentBlocks[blockIdx] = true;
     file.sentBlocksCount += 1;
     Send(header, ResponseHeader::responseSizeFor(blockSize), flush);
-
-    return SendResult::Sent;
 }
 
 bool IncrementalServer::SendDone() {
@@ -469,35 +525,50 @@ bool IncrementalServer::SendDone() {
 }
 
 void IncrementalServer::RunPrefetching() {
-    constexpr auto kPrefetchBlocksPerIteration = 128;
+    // Small enough that a miss arriving meanwhile doesn't wait long for its turn.
+    constexpr auto kPrefetchBlocksPerIteration = 32;
 
     int blocksToSend = kPrefetchBlocksPerIteration;
-    while (!prefetches_.empty() && blocksToSend > 0) {
-        auto& prefetch = prefetches_.front();
+    blocksToSend -= RunPrefetchLane(&readaheads_, blocksToSend);
+    RunPrefetchLane(&prefetches_, blocksToSend);
+}
+
+// Returns the number of blocks sent.
+int IncrementalServer::RunPrefetchLane(std::deque<PrefetchState>* lane, int blocksToSend) {
+    const int budget = blocksToSend;
+    while (!lane->empty() && blocksToSend > 0) {
+        auto& prefetch = lane->front();
         const auto& file = *prefetch.file;
         const auto& priority_blocks = file.PriorityBlocks();
-        if (!priority_blocks.empty()) {
-            for (auto& i = prefetch.priorityIndex;
-                 blocksToSend > 0 && i < (BlockIdx)priority_blocks.size(); ++i) {
-                if (auto res = SendDataBlock(file.id, priority_blocks[i]);
-                    res == SendResult::Sent) {
-                    --blocksToSend;
-                } else if (res == SendResult::Error) {
-                    fprintf(stderr, "Failed to send priority block %" PRId32 "\n", i);
-                }
+        const BlockIdx priority_count = priority_blocks.size();
+        for (auto& i = prefetch.priorityIndex; blocksToSend > 0 && i < priority_count;) {
+            // Batch up the blocks that the list continues with adjacently.
+            int count = 1;
+            while (count < std::min(blocksToSend, kMaxBatchBlocks) && i + count < priority_count &&
+                   priority_blocks[i + count] == priority_blocks[i] + count) {
+                ++count;
+            }
+            if (auto sent = SendDataBlocks(file.id, priority_blocks[i], count); sent >= 0) {
+                blocksToSend -= sent;
+            } else {
+                fprintf(stderr, "Failed to send priority block %" PRId32 "\n", i);
             }
+            i += count;
         }
-        for (auto& i = prefetch.overallIndex; blocksToSend > 0 && i < prefetch.overallEnd; ++i) {
-            if (auto res = SendDataBlock(file.id, i); res == SendResult::Sent) {
-                --blocksToSend;
-            } else if (res == SendResult::Error) {
+        for (auto& i = prefetch.overallIndex; blocksToSend > 0 && i < prefetch.overallEnd;) {
+            const int count = std::min({blocksToSend, kMaxBatchBlocks, prefetch.overallEnd - i});
+            if (auto sent = SendDataBlocks(file.id, i, count); sent >= 0) {
+                blocksToSend -= sent;
+            } else {
                 fprintf(stderr, "Failed to send block %" PRId32 "\n", i);
             }
+            i += count;
         }
         if (prefetch.done()) {
-            prefetches_.pop_front();
+            lane->pop_front();
         }
     }
+    return budget - blocksToSend;
 }
 
 void IncrementalServer::Send(const void* data, size_t size, bool flush) {
@@ -552,7 +623,7 @@ bool IncrementalServer::Serve() {
     std::optional<TimePoint> startTime;
 
     while (true) {
-        if (!doneSent && prefetches_.empty() &&
+        if (!doneSent && readaheads_.empty() && prefetches_.empty() &&
             std::all_of(files_.begin(), files_.end(), [](const File& f) {
                 return f.sentBlocksCount == NumBlocks(f.sentBlocks.size());
             })) {
@@ -561,18 +632,20 @@ bool IncrementalServer::Serve() {
             doneSent = true;
         }
 
-        const bool blocking = prefetches_.empty();
+        bool blocking = readaheads_.empty() && prefetches_.empty();
         if (blocking) {
             // We've no idea how long the blocking call is, so let's flush whatever is still unsent.
             Flush();
         }
-        auto request = ReadRequest(blocking);
 
-        if (!startTime) {
-            startTime = high_resolution_clock::now();
-        }
+        // Handle every request that has arrived before going back to prefetching.
+        while (auto request = ReadRequest(blocking)) {
+            blocking = false;
+
+            if (!startTime) {
+                startTime = high_resolution_clock::now();
+            }
 
-        if (request) {
             FileId fileId = request->file_id;
             BlockIdx blockIdx = request->block_idx;
 
@@ -617,7 +690,7 @@ bool IncrementalServer::Serve() {
                         ++missesSent;
                         // Make sure we send more pages from this place onward, in case if the OS is
                         // reading a bigger block.
-                        prefetches_.emplace_front(files_[fileId], blockIdx + 1, 7);
+                        readaheads_.emplace_front(files_[fileId], blockIdx + 1, 7);
                     }
                     break;
                 }
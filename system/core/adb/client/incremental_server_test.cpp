@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "incremental_server.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <android-base/endian.h>
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+#include <gtest/gtest.h>
+
+#include "adb_io.h"
+#include "incremental_utils.h"
+
+using android::base::unique_fd;
+
+namespace incremental {
+
+static constexpr int kFileBlocks = 64;
+
+// The device side of the protocol: each request is "INCR" followed by the big endian type, file
+// id and block index.
+static std::string Request(int16_t type, int16_t file_id, int32_t block_idx) {
+    std::string request = "INCR";
+    int16_t be_type = htobe16(type);
+    int16_t be_file_id = htobe16(file_id);
+    int32_t be_block_idx = htobe32(block_idx);
+    request.append(reinterpret_cast<char*>(&be_type), sizeof(be_type));
+    request.append(reinterpret_cast<char*>(&be_file_id), sizeof(be_file_id));
+    request.append(reinterpret_cast<char*>(&be_block_idx), sizeof(be_block_idx));
+    return request;
+}
+
+// Reads the server's responses until it reports that everything was sent, and returns the
+// indices of the data blocks in the order they were sent.
+static bool ReadDataBlocks(int fd, std::vector<int32_t>* blocks) {
+    while (true) {
+        int32_t be_chunk_size;
+        if (!ReadFdExactly(fd, &be_chunk_size, sizeof(be_chunk_size))) return false;
+        std::vector<char> chunk(be32toh(be_chunk_size));
+        if (!ReadFdExactly(fd, chunk.data(), chunk.size())) return false;
+
+        // Each response: file id (2), block type (1), compression (1), block index (4), size (2).
+        for (size_t pos = 0; pos + 10 <= chunk.size();) {
+            int16_t file_id = be16toh(*reinterpret_cast<uint16_t*>(&chunk[pos]));
+            int8_t block_type = chunk[pos + 2];
+            int32_t block_idx = be32toh(*reinterpret_cast<uint32_t*>(&chunk[pos + 4]));
+            int16_t block_size = be16toh(*reinterpret_cast<uint16_t*>(&chunk[pos + 8]));
+            if (file_id == -1) return true;
+            if (block_type == 0) blocks->push_back(block_idx);
+            pos += 10 + block_size;
+        }
+    }
+}
+
+TEST(IncrementalServer, ReadaheadAfterMissGoesBeforePrefetch) {
+    TemporaryDir dir;
+    std::string path = std::string(dir.path) + "/file.bin";
+
+    std::string data(kFileBlocks * kBlockSize, '\0');
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i * 7 + i / kBlockSize);
+    ASSERT_TRUE(android::base::WriteStringToFile(data, path));
+
+    // An empty hashing and signing info, then the verity tree.
+    int32_t tree_size = verity_tree_size_for_file(data.size());
+    std::vector<int32_t> idsig_header = {0, 0, 0, htole32(tree_size)};
+    std::string idsig(reinterpret_cast<char*>(idsig_header.data()),
+                      idsig_header.size() * sizeof(int32_t));
+    idsig.append(tree_size, '\0');
+    ASSERT_TRUE(android::base::WriteStringToFile(idsig, path + std::string(IDSIG)));
+
+    // The startup trace makes blocks 40-47 the file's priority blocks.
+    ASSERT_TRUE(android::base::WriteStringToFile("40-47\n", path + std::string(READORDER)));
+
+    int sockets[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+    unique_fd device(sockets[0]);
+
+    // Queue the prefetch and a miss at block 10 before the server reads anything, so that both
+    // are handled before any prefetching.
+    std::string requests = Request(2 /* PREFETCH */, 0, 0) + Request(1 /* BLOCK_MISSING */, 0, 10);
+    ASSERT_TRUE(WriteFdExactly(device.get(), requests.data(), requests.size()));
+
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+        device.reset();
+        const char* argv[] = {path.c_str()};
+        _exit(serve(sockets[1], open("/dev/null", O_WRONLY), 1, argv) ? 0 : 1);
+    }
+    close(sockets[1]);
+
+    char okay[4];
+    ASSERT_TRUE(ReadFdExactly(device.get(), okay, sizeof(okay)));
+    ASSERT_EQ("OKAY", std::string(okay, sizeof(okay)));
+
+    std::vector<int32_t> blocks;
+    ASSERT_TRUE(ReadDataBlocks(device.get(), &blocks));
+    std::string destroy = Request(3 /* DESTROY */, 0, 0);
+    ASSERT_TRUE(WriteFdExactly(device.get(), destroy.data(), destroy.size()));
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+
+    // The miss, the 7 blocks after it, then the priority blocks, then the rest in order.
+    std::vector<int32_t> expected;
+    for (int32_t i = 10; i < 18; ++i) expected.push_back(i);
+    for (int32_t i = 40; i < 48; ++i) expected.push_back(i);
+    for (int32_t i = 0; i < kFileBlocks; ++i) {
+        if ((i < 10 || i >= 18) && (i < 40 || i >= 48)) expected.push_back(i);
+    }
+    EXPECT_EQ(expected, blocks);
+}
+
+}  // namespace incremental
@@ -19,7 +19,9 @@
 #include "incremental_utils.h"
 
 #include <android-base/endian.h>
+#include <android-base/file.h>
 #include <android-base/mapped_file.h>
+#include <android-base/parseint.h>
 #include <android-base/strings.h>
 #include <ziparchive/zip_archive.h>
 #include <ziparchive/zip_writer.h>
@@ -344,11 +346,7 @@ static std::vector<int32_t> InstallationPriorityBlocks(borrowed_fd fd, Size file
     return installationPriorityBlocks;
 }
 
-std::vector<int32_t> PriorityBlocksForFile(const std::string& filepath, borrowed_fd fd,
-                                           Size fileSize) {
-    if (!android::base::EndsWithIgnoreCase(filepath, ".apk")) {
-        return {};
-    }
+static std::vector<int32_t> ApkPriorityBlocks(borrowed_fd fd, Size fileSize) {
     off64_t signerOffset = SignerBlockOffset(fd, fileSize);
     if (signerOffset < 0) {
         // No signer block? not a valid APK
@@ -359,6 +357,52 @@ std::vector<int32_t> PriorityBlocksForFile(const std::string& filepath, borrowed
 
     priorityBlocks.insert(priorityBlocks.end(), installationPriorityBlocks.begin(),
                           installationPriorityBlocks.end());
+    return priorityBlocks;
+}
+
+// FILE.readorder lists the blocks of FILE in the order they were read during app startup, one
+// block index or inclusive "first-last" range per line. '#' starts a comment.
+static std::vector<int32_t> ReadOrderBlocks(const std::string& filepath, Size fileSize) {
+    std::string trace;
+    if (!android::base::ReadFileToString(filepath + std::string(READORDER), &trace)) {
+        return {};
+    }
+
+    const int32_t lastBlockIndex = offsetToBlockIndex(fileSize - 1);
+    std::vector<int32_t> readOrderBlocks;
+    for (const auto& rawLine : android::base::Split(trace, "\n")) {
+        std::string line = android::base::Trim(rawLine.substr(0, rawLine.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        auto range = android::base::Split(line, "-");
+        int32_t first, last;
+        if (range.size() > 2 ||
+            !android::base::ParseInt(android::base::Trim(range.front()), &first, 0,
+                                     lastBlockIndex) ||
+            !android::base::ParseInt(android::base::Trim(range.back()), &last, first,
+                                     lastBlockIndex)) {
+            D("\tignoring invalid read order entry '%s'", line.c_str());
+            continue;
+        }
+        appendBlocks(first, last - first + 1, &readOrderBlocks);
+    }
+    D("\tadding %d blocks from the read order trace", int(readOrderBlocks.size()));
+    return readOrderBlocks;
+}
+
+std::vector<int32_t> PriorityBlocksForFile(const std::string& filepath, borrowed_fd fd,
+                                           Size fileSize) {
+    std::vector<int32_t> priorityBlocks;
+    if (android::base::EndsWithIgnoreCase(filepath, ".apk")) {
+        priorityBlocks = ApkPriorityBlocks(fd, fileSize);
+    }
+
+    // The startup trace goes after the blocks needed to install the app, as those are read first
+    // anyway.
+    std::vector<int32_t> readOrderBlocks = ReadOrderBlocks(filepath, fileSize);
+    priorityBlocks.insert(priorityBlocks.end(), readOrderBlocks.begin(), readOrderBlocks.end());
     unduplicate(priorityBlocks);
     return priorityBlocks;
 }
@@ -35,7 +35,11 @@ constexpr int kSha256DigestSize = 32;
 constexpr int kDigestSize = kSha256DigestSize;
 
 constexpr std::string_view IDSIG = ".idsig";
+// Optional startup read-order trace for a file, see PriorityBlocksForFile().
+constexpr std::string_view READORDER = ".readorder";
 
+// Blocks to stream before the rest of the file: for APKs, those needed for installation; then
+// the blocks listed in FILE.readorder, in the order the app read them at startup.
 std::vector<int32_t> PriorityBlocksForFile(const std::string& filepath, borrowed_fd fd,
                                            Size fileSize);
 
@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <span>
+
+#include <android-base/logging.h>
+
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+#include <lz4frame.h>
+#include <zstd.h>
+
+#include "file_sync_protocol.h"
+#include "types.h"
+
+enum class DecodeResult {
+    Error,
+    Done,
+    NeedInput,
+    MoreOutput,
+};
+
+enum class EncodeResult {
+    Error,
+    Done,
+    NeedInput,
+    MoreOutput,
+};
+
+struct Decoder {
+    virtual ~Decoder() = default;
+
+    void Append(Block&& block) { input_buffer_.append(std::move(block)); }
+
+    // Decode as much of the appended input as fits into the output buffer. The returned span
+    // points into the output buffer and is only valid until the next call.
+    virtual DecodeResult Decode(std::span<char>* output) = 0;
+
+  protected:
+    explicit Decoder(std::span<char> output_buffer) : output_buffer_(output_buffer) {}
+
+    IOVector input_buffer_;
+    std::span<char> output_buffer_;
+};
+
+struct Encoder {
+    virtual ~Encoder() = default;
+
+    void Append(Block input) { input_buffer_.append(std::move(input)); }
+    void Finish() { finished_ = true; }
+
+    // Encode the appended input, returning at most one output block of at most
+    // output_block_size bytes per call.
+    virtual EncodeResult Encode(Block* output) = 0;
+
+  protected:
+    explicit Encoder(size_t output_block_size)
+        : output_block_size_(output_block_size),
+          output_block_(output_block_size),
+          output_bytes_left_(output_block_size) {}
+
+    char* output_position() {
+        return output_block_.data() + (output_block_size_ - output_bytes_left_);
+    }
+
+    // Hand out the current output block, and start a new one.
+    void TakeOutputBlock(Block* output) {
+        output_block_.resize(output_block_size_ - output_bytes_left_);
+        *output = std::move(output_block_);
+        output_block_ = Block(output_block_size_);
+        output_bytes_left_ = output_block_size_;
+    }
+
+    const size_t output_block_size_;
+    bool finished_ = false;
+    IOVector input_buffer_;
+    Block output_block_;
+    size_t output_bytes_left_;
+};
+
+struct BrotliDecoder final : public Decoder {
+    explicit BrotliDecoder(std::span<char> output_buffer)
+        : Decoder(output_buffer),
+          decoder_(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr),
+                   BrotliDecoderDestroyInstance) {}
+
+    DecodeResult Decode(std::span<char>* output) final {
+        size_t available_in = input_buffer_.front_size();
+        const uint8_t* next_in = reinterpret_cast<const uint8_t*>(input_buffer_.front_data());
+
+        size_t available_out = output_buffer_.size();
+        uint8_t* next_out = reinterpret_cast<uint8_t*>(output_buffer_.data());
+
+        BrotliDecoderResult r = BrotliDecoderDecompressStream(
+                decoder_.get(), &available_in, &next_in, &available_out, &next_out, nullptr);
+
+        size_t bytes_consumed = input_buffer_.front_size() - available_in;
+        input_buffer_.drop_front(bytes_consumed);
+
+        size_t bytes_emitted = output_buffer_.size() - available_out;
+        *output = std::span<char>(output_buffer_.data(), bytes_emitted);
+
+        switch (r) {
+            case BROTLI_DECODER_RESULT_SUCCESS:
+                return DecodeResult::Done;
+            case BROTLI_DECODER_RESULT_ERROR:
+                return DecodeResult::Error;
+            case BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT:
+                // Brotli guarantees as one of its invariants that if it returns NEEDS_MORE_INPUT,
+                // it will consume the entire input buffer passed in, so we don't have to worry
+                // about bytes left over in the front block with more input remaining.
+                return DecodeResult::NeedInput;
+            case BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT:
+                return DecodeResult::MoreOutput;
+        }
+    }
+
+  private:
+    std::unique_ptr<BrotliDecoderState, void (*)(BrotliDecoderState*)> decoder_;
+};
+
+struct BrotliEncoder final : public Encoder {
+    explicit BrotliEncoder(size_t output_block_size)
+        : Encoder(output_block_size),
+          encoder_(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr),
+                   BrotliEncoderDestroyInstance) {
+        BrotliEncoderSetParameter(encoder_.get(), BROTLI_PARAM_QUALITY, 1);
+    }
+
+    EncodeResult Encode(Block* output) final {
+        output->clear();
+        while (true) {
+            size_t available_in = input_buffer_.front_size();
+            const uint8_t* next_in = reinterpret_cast<const uint8_t*>(input_buffer_.front_data());
+
+            size_t available_out = output_bytes_left_;
+            uint8_t* next_out = reinterpret_cast<uint8_t*>(output_position());
+
+            BrotliEncoderOperation op = BROTLI_OPERATION_PROCESS;
+            if (finished_) {
+                op = BROTLI_OPERATION_FINISH;
+            }
+
+            if (!BrotliEncoderCompressStream(encoder_.get(), op, &available_in, &next_in,
+                                             &available_out, &next_out, nullptr)) {
+                return EncodeResult::Error;
+            }
+
+            size_t bytes_consumed = input_buffer_.front_size() - available_in;
+            input_buffer_.drop_front(bytes_consumed);
+
+            output_bytes_left_ = available_out;
+
+            if (BrotliEncoderIsFinished(encoder_.get())) {
+                TakeOutputBlock(output);
+                return EncodeResult::Done;
+            } else if (output_bytes_left_ == 0) {
+                TakeOutputBlock(output);
+                return EncodeResult::MoreOutput;
+            } else if (input_buffer_.empty()) {
+                return EncodeResult::NeedInput;
+            }
+        }
+    }
+
+  private:
+    std::unique_ptr<BrotliEncoderState, void (*)(BrotliEncoderState*)> encoder_;
+};
+
+struct LZ4Decoder final : public Decoder {
+    explicit LZ4Decoder(std::span<char> output_buffer)
+        : Decoder(output_buffer), decoder_(nullptr, nullptr) {
+        LZ4F_dctx* dctx;
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION))) {
+            LOG(FATAL) << "failed to create LZ4 decompression context";
+        }
+        decoder_ = std::unique_ptr<LZ4F_dctx, LZ4F_errorCode_t (*)(LZ4F_dctx*)>(
+                dctx, LZ4F_freeDecompressionContext);
+    }
+
+    DecodeResult Decode(std::span<char>* output) final {
+        size_t bytes_emitted = 0;
+        while (true) {
+            if (bytes_emitted == output_buffer_.size()) {
+                *output = std::span<char>(output_buffer_.data(), bytes_emitted);
+                return DecodeResult::MoreOutput;
+            }
+
+            // Keep calling in even with no input left: the decoder may still be holding output
+            // that didn't fit into the previous output buffer.
+            size_t available_in = input_buffer_.front_size();
+            size_t available_out = output_buffer_.size() - bytes_emitted;
+            size_t rc = LZ4F_decompress(decoder_.get(), output_buffer_.data() + bytes_emitted,
+                                        &available_out, input_buffer_.front_data(), &available_in,
+                                        nullptr);
+            if (LZ4F_isError(rc)) {
+                LOG(ERROR) << "LZ4F_decompress failed: " << LZ4F_getErrorName(rc);
+                return DecodeResult::Error;
+            }
+
+            input_buffer_.drop_front(available_in);
+            bytes_emitted += available_out;
+
+            if (rc == 0) {
+                *output = std::span<char>(output_buffer_.data(), bytes_emitted);
+                return DecodeResult::Done;
+            } else if (available_in == 0 && available_out == 0) {
+                *output = std::span<char>(output_buffer_.data(), bytes_emitted);
+                return DecodeResult::NeedInput;
+            }
+        }
+    }
+
+  private:
+    std::unique_ptr<LZ4F_dctx, LZ4F_errorCode_t (*)(LZ4F_dctx*)> decoder_;
+};
+
+struct LZ4Encoder final : public Encoder {
+    explicit LZ4Encoder(size_t output_block_size)
+        : Encoder(output_block_size), encoder_(nullptr, nullptr) {
+        LZ4F_cctx* cctx;
+        if (LZ4F_isError(LZ4F_createCompressionContext(&cctx, LZ4F_VERSION))) {
+            LOG(FATAL) << "failed to create LZ4 compression context";
+        }
+        encoder_ = std::unique_ptr<LZ4F_cctx, LZ4F_errorCode_t (*)(LZ4F_cctx*)>(
+                cctx, LZ4F_freeCompressionContext);
+
+        Block header(LZ4F_HEADER_SIZE_MAX);
+        size_t rc = LZ4F_compressBegin(encoder_.get(), header.data(), header.size(), nullptr);
+        if (LZ4F_isError(rc)) {
+            LOG(FATAL) << "LZ4F_compressBegin failed: " << LZ4F_getErrorName(rc);
+        }
+        header.resize(rc);
+        pending_.append(std::move(header));
+    }
+
+    EncodeResult Encode(Block* output) final {
+        output->clear();
+        while (true) {
+            // LZ4F wants room for a whole compressed chunk up front, so compress into pending_
+            // and cut that into output blocks.
+            if (pending_.size() >= output_block_size_) {
+                *output = pending_.take_front(output_block_size_).coalesce();
+                return EncodeResult::MoreOutput;
+            }
+
+            if (!input_buffer_.empty()) {
+                size_t available_in = input_buffer_.front_size();
+                Block chunk(LZ4F_compressBound(available_in, nullptr));
+                size_t rc = LZ4F_compressUpdate(encoder_.get(), chunk.data(), chunk.size(),
+                                                input_buffer_.front_data(), available_in, nullptr);
+                if (LZ4F_isError(rc)) {
+                    LOG(ERROR) << "LZ4F_compressUpdate failed: " << LZ4F_getErrorName(rc);
+                    return EncodeResult::Error;
+                }
+                input_buffer_.drop_front(available_in);
+                chunk.resize(rc);
+                pending_.append(std::move(chunk));
+                continue;
+            }
+
+            if (!finished_) {
+                return EncodeResult::NeedInput;
+            }
+
+            if (!ended_) {
+                Block trailer(LZ4F_compressBound(0, nullptr));
+                size_t rc = LZ4F_compressEnd(encoder_.get(), trailer.data(), trailer.size(),
+                                             nullptr);
+                if (LZ4F_isError(rc)) {
+                    LOG(ERROR) << "LZ4F_compressEnd failed: " << LZ4F_getErrorName(rc);
+                    return EncodeResult::Error;
+                }
+                trailer.resize(rc);
+                pending_.append(std::move(trailer));
+                ended_ = true;
+                continue;
+            }
+
+            *output = std::move(pending_).coalesce();
+            pending_ = IOVector();
+            return EncodeResult::Done;
+        }
+    }
+
+  private:
+    bool ended_ = false;
+    IOVector pending_;
+    std::unique_ptr<LZ4F_cctx, LZ4F_errorCode_t (*)(LZ4F_cctx*)> encoder_;
+};
+
+struct ZstdDecoder final : public Decoder {
+    explicit ZstdDecoder(std::span<char> output_buffer)
+        : Decoder(output_buffer), decoder_(ZSTD_createDStream(), ZSTD_freeDStream) {
+        if (!decoder_) {
+            LOG(FATAL) << "failed to create Zstd decompression context";
+        }
+    }
+
+    DecodeResult Decode(std::span<char>* output) final {
+        ZSTD_outBuffer out = {output_buffer_.data(), output_buffer_.size(), 0};
+        while (true) {
+            if (out.pos == out.size) {
+                *output = std::span<char>(output_buffer_.data(), out.pos);
+                return DecodeResult::MoreOutput;
+            }
+
+            // As with LZ4, call in even with no input left to flush buffered output.
+            ZSTD_inBuffer in = {input_buffer_.front_data(), input_buffer_.front_size(), 0};
+            size_t previous_out = out.pos;
+            size_t rc = ZSTD_decompressStream(decoder_.get(), &out, &in);
+            if (ZSTD_isError(rc)) {
+                LOG(ERROR) << "ZSTD_decompressStream failed: " << ZSTD_getErrorName(rc);
+                return DecodeResult::Error;
+            }
+
+            input_buffer_.drop_front(in.pos);
+
+            if (rc == 0) {
+                *output = std::span<char>(output_buffer_.data(), out.pos);
+                return DecodeResult::Done;
+            } else if (in.pos == 0 && out.pos == previous_out) {
+                *output = std::span<char>(output_buffer_.data(), out.pos);
+                return DecodeResult::NeedInput;
+            }
+        }
+    }
+
+  private:
+    std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream*)> decoder_;
+};
+
+struct ZstdEncoder final : public Encoder {
+    explicit ZstdEncoder(size_t output_block_size)
+        : Encoder(output_block_size), encoder_(ZSTD_createCStream(), ZSTD_freeCStream) {
+        if (!encoder_) {
+            LOG(FATAL) << "failed to create Zstd compression context";
+        }
+        ZSTD_CCtx_setParameter(encoder_.get(), ZSTD_c_compressionLevel, 1);
+    }
+
+    EncodeResult Encode(Block* output) final {
+        output->clear();
+        while (true) {
+            // ZSTD_e_end may only be used once the rest of the input is in this call.
+            ZSTD_EndDirective directive = ZSTD_e_continue;
+            if (finished_ && input_buffer_.size() == input_buffer_.front_size()) {
+                directive = ZSTD_e_end;
+            }
+
+            ZSTD_inBuffer in = {input_buffer_.front_data(), input_buffer_.front_size(), 0};
+            ZSTD_outBuffer out = {output_position(), output_bytes_left_, 0};
+            size_t rc = ZSTD_compressStream2(encoder_.get(), &out, &in, directive);
+            if (ZSTD_isError(rc)) {
+                LOG(ERROR) << "ZSTD_compressStream2 failed: " << ZSTD_getErrorName(rc);
+                return EncodeResult::Error;
+            }
+
+            input_buffer_.drop_front(in.pos);
+            output_bytes_left_ -= out.pos;
+
+            if (directive == ZSTD_e_end && rc == 0) {
+                TakeOutputBlock(output);
+                return EncodeResult::Done;
+            } else if (output_bytes_left_ == 0) {
+                TakeOutputBlock(output);
+                return EncodeResult::MoreOutput;
+            } else if (input_buffer_.empty() && !finished_) {
+                return EncodeResult::NeedInput;
+            }
+        }
+    }
+
+  private:
+    std::unique_ptr<ZSTD_CStream, size_t (*)(ZSTD_CStream*)> encoder_;
+};
+
+inline std::unique_ptr<Decoder> CreateDecoder(CompressionType compression,
+                                              std::span<char> output_buffer) {
+    switch (compression) {
+        case CompressionType::Brotli:
+            return std::make_unique<BrotliDecoder>(output_buffer);
+        case CompressionType::LZ4:
+            return std::make_unique<LZ4Decoder>(output_buffer);
+        case CompressionType::Zstd:
+            return std::make_unique<ZstdDecoder>(output_buffer);
+        case CompressionType::None:
+        case CompressionType::Any:
+            break;
+    }
+    LOG(FATAL) << "invalid CompressionType: " << static_cast<int>(compression);
+    __builtin_unreachable();
+}
+
+inline std::unique_ptr<Encoder> CreateEncoder(CompressionType compression,
+                                              size_t output_block_size) {
+    switch (compression) {
+        case CompressionType::Brotli:
+            return std::make_unique<BrotliEncoder>(output_block_size);
+        case CompressionType::LZ4:
+            return std::make_unique<LZ4Encoder>(output_block_size);
+        case CompressionType::Zstd:
+            return std::make_unique<ZstdEncoder>(output_block_size);
+        case CompressionType::None:
+        case CompressionType::Any:
+            break;
+    }
+    LOG(FATAL) << "invalid CompressionType: " << static_cast<int>(compression);
+    __builtin_unreachable();
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compression_utils.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+// Feeds |input| to the encoder |input_chunk| bytes at a time, like the sync client and service
+// do, and returns the concatenated output blocks.
+static bool Encode(CompressionType compression, const std::string& input, size_t input_chunk,
+                   size_t output_block_size, std::vector<std::string>* output) {
+    auto encoder = CreateEncoder(compression, output_block_size);
+    size_t pos = 0;
+    while (true) {
+        if (pos == input.size()) {
+            encoder->Finish();
+        } else {
+            size_t size = std::min(input_chunk, input.size() - pos);
+            encoder->Append(Block(input.begin() + pos, input.begin() + pos + size));
+            pos += size;
+        }
+
+        while (true) {
+            Block block;
+            EncodeResult result = encoder->Encode(&block);
+            if (result == EncodeResult::Error) {
+                ADD_FAILURE() << "encoding failed";
+                return false;
+            }
+            EXPECT_LE(block.size(), output_block_size);
+            if (!block.empty()) {
+                output->emplace_back(block.data(), block.size());
+            }
+
+            if (result == EncodeResult::Done) {
+                return true;
+            } else if (result == EncodeResult::NeedInput) {
+                break;
+            }
+        }
+    }
+}
+
+// Feeds the encoded blocks to the decoder |input_chunk| bytes at a time, decoding into an output
+// buffer of |output_buffer_size| bytes.
+static bool Decode(CompressionType compression, const std::vector<std::string>& blocks,
+                   size_t input_chunk, size_t output_buffer_size, std::string* output) {
+    std::string input;
+    for (const auto& block : blocks) input += block;
+
+    std::vector<char> buffer(output_buffer_size);
+    auto decoder = CreateDecoder(compression, std::span<char>(buffer.data(), buffer.size()));
+    size_t pos = 0;
+    while (true) {
+        if (pos == input.size()) {
+            ADD_FAILURE() << "decoder wants more input than was encoded";
+            return false;
+        }
+        size_t size = std::min(input_chunk, input.size() - pos);
+        decoder->Append(Block(input.begin() + pos, input.begin() + pos + size));
+        pos += size;
+
+        while (true) {
+            std::span<char> span;
+            DecodeResult result = decoder->Decode(&span);
+            if (result == DecodeResult::Error) {
+                ADD_FAILURE() << "decoding failed";
+                return false;
+            }
+            output->append(span.data(), span.size());
+
+            if (result == DecodeResult::Done) {
+                EXPECT_EQ(input.size(), pos) << "decoder finished before the end of its input";
+                return true;
+            } else if (result == DecodeResult::NeedInput) {
+                break;
+            }
+        }
+    }
+}
+
+// Text-like runs, which compress, interleaved with random bytes, which don't.
+static std::string TestData(size_t size) {
+    std::string data(size, '\0');
+    std::mt19937 rng(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = (i / 4096) % 2 ? static_cast<char>(rng()) : "adb sync\n"[rng() % 9];
+    }
+    return data;
+}
+
+class CompressionTest : public ::testing::TestWithParam<CompressionType> {
+  protected:
+    void RoundTrip(const std::string& data, size_t input_chunk, size_t output_block_size,
+                   size_t decoder_input_chunk, size_t decoder_buffer_size) {
+        std::vector<std::string> blocks;
+        ASSERT_TRUE(Encode(GetParam(), data, input_chunk, output_block_size, &blocks));
+        ASSERT_FALSE(blocks.empty()) << "even an empty stream has a header";
+
+        std::string decoded;
+        ASSERT_TRUE(Decode(GetParam(), blocks, decoder_input_chunk, decoder_buffer_size, &decoded));
+        ASSERT_EQ(data.size(), decoded.size());
+        EXPECT_TRUE(data == decoded);
+    }
+};
+
+TEST_P(CompressionTest, empty) {
+    RoundTrip("", 64 * 1024, 64 * 1024, 64 * 1024, 64 * 1024);
+}
+
+TEST_P(CompressionTest, empty_small_buffers) {
+    RoundTrip("", 1, 1, 1, 1);
+}
+
+TEST_P(CompressionTest, large_buffers) {
+    RoundTrip(TestData(1024 * 1024), 64 * 1024, 64 * 1024, 64 * 1024, 64 * 1024);
+}
+
+TEST_P(CompressionTest, split_input) {
+    // Input chunks that don't line up with anything in the codecs.
+    RoundTrip(TestData(256 * 1024 + 3), 1000, 64 * 1024, 777, 64 * 1024);
+}
+
+TEST_P(CompressionTest, small_output) {
+    // Output blocks and decoder buffers much smaller than what each call could produce, so that
+    // both sides have to hold on to output across calls.
+    RoundTrip(TestData(256 * 1024 + 3), 64 * 1024, 100, 64 * 1024, 10);
+}
+
+TEST_P(CompressionTest, byte_at_a_time) {
+    RoundTrip(TestData(16 * 1024 + 1), 1, 1, 1, 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(Codecs, CompressionTest,
+                         ::testing::Values(CompressionType::Brotli, CompressionType::LZ4,
+                                           CompressionType::Zstd),
+                         [](const ::testing::TestParamInfo<CompressionType>& info) {
+                             switch (info.param) {
+                                 case CompressionType::Brotli:
+                                     return "Brotli";
+                                 case CompressionType::LZ4:
+                                     return "LZ4";
+                                 case CompressionType::Zstd:
+                                     return "Zstd";
+                                 default:
+                                     return "Unknown";
+                             }
+                         });
@@ -32,9 +32,9 @@
 #include <utime.h>
 
 #include <memory>
-#include <optional>
 #include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <android-base/file.h>
@@ -57,7 +57,7 @@
 #include "adb_io.h"
 #include "adb_trace.h"
 #include "adb_utils.h"
-#include "brotli_utils.h"
+#include "compression_utils.h"
 #include "file_sync_protocol.h"
 #include "security_log_tags.h"
 #include "sysdeps/errno.h"
@@ -266,10 +266,34 @@ static bool SendSyncFailErrno(borrowed_fd fd, const std::string& reason) {
     return SendSyncFail(fd, StringPrintf("%s: %s", reason.c_str(), strerror(errno)));
 }
 
-static bool handle_send_file_compressed(borrowed_fd s, unique_fd fd, uint32_t* timestamp) {
+// Strip the compression flag from a send_v2/recv_v2 setup packet's flags.
+// Fails if more than one compression flag is set.
+static bool take_compression_flag(uint32_t* flags, CompressionType* compression) {
+    static constexpr std::pair<SyncFlag, CompressionType> kCompressionFlags[] = {
+            {kSyncFlagBrotli, CompressionType::Brotli},
+            {kSyncFlagLZ4, CompressionType::LZ4},
+            {kSyncFlagZstd, CompressionType::Zstd},
+    };
+
+    *compression = CompressionType::None;
+    for (const auto& [flag, type] : kCompressionFlags) {
+        if (*flags & flag) {
+            if (*compression != CompressionType::None) {
+                return false;
+            }
+            *flags &= ~flag;
+            *compression = type;
+        }
+    }
+    return true;
+}
+
+static bool handle_send_file_compressed(borrowed_fd s, unique_fd fd, uint32_t* timestamp,
+                                        CompressionType compression) {
     syncmsg msg;
     Block decode_buffer(SYNC_DATA_MAX);
-    BrotliDecoder decoder(std::span(decode_buffer.data(), decode_buffer.size()));
+    std::unique_ptr<Decoder> decoder =
+            CreateDecoder(compression, std::span(decode_buffer.data(), decode_buffer.size()));
     while (true) {
         if (!ReadFdExactly(s, &msg.data, sizeof(msg.data))) return false;
 
@@ -284,12 +308,12 @@ static bool handle_send_file_compressed(borrowed_fd s, unique_fd fd, uint32_t* t
 
         Block block(msg.data.size);
         if (!ReadFdExactly(s, block.data(), msg.data.size)) return false;
-        decoder.Append(std::move(block));
+        decoder->Append(std::move(block));
 
         while (true) {
             std::span<char> output;
-            BrotliDecodeResult result = decoder.Decode(&output);
-            if (result == BrotliDecodeResult::Error) {
+            DecodeResult result = decoder->Decode(&output);
+            if (result == DecodeResult::Error) {
                 SendSyncFailErrno(s, "decompress failed");
                 return false;
             }
@@ -299,14 +323,14 @@ static bool handle_send_file_compressed(borrowed_fd s, unique_fd fd, uint32_t* t
                 return false;
             }
 
-            if (result == BrotliDecodeResult::NeedInput) {
+            if (result == DecodeResult::NeedInput) {
                 break;
-            } else if (result == BrotliDecodeResult::MoreOutput) {
+            } else if (result == DecodeResult::MoreOutput) {
                 continue;
-            } else if (result == BrotliDecodeResult::Done) {
+            } else if (result == DecodeResult::Done) {
                 break;
             } else {
-                LOG(FATAL) << "invalid BrotliDecodeResult: " << static_cast<int>(result);
+                LOG(FATAL) << "invalid DecodeResult: " << static_cast<int>(result);
             }
         }
     }
@@ -343,8 +367,9 @@ static bool handle_send_file_uncompressed(borrowed_fd s, unique_fd fd, uint32_t*
 }
 
 static bool handle_send_file(borrowed_fd s, const char* path, uint32_t* timestamp, uid_t uid,
-                             gid_t gid, uint64_t capabilities, mode_t mode, bool compressed,
-                             std::vector<char>& buffer, bool do_unlink) {
+                             gid_t gid, uint64_t capabilities, mode_t mode,
+                             CompressionType compression, std::vector<char>& buffer,
+                             bool do_unlink) {
     int rc;
     syncmsg msg;
 
@@ -390,8 +415,8 @@ static bool handle_send_file(borrowed_fd s, const char* path, uint32_t* timestam
         }
 
         bool result;
-        if (compressed) {
-            result = handle_send_file_compressed(s, std::move(fd), timestamp);
+        if (compression != CompressionType::None) {
+            result = handle_send_file_compressed(s, std::move(fd), timestamp, compression);
         } else {
             result = handle_send_file_uncompressed(s, std::move(fd), timestamp, buffer);
         }
@@ -499,7 +524,7 @@ static bool handle_send_link(int s, const std::string& path, uint32_t* timestamp
 }
 #endif
 
-static bool send_impl(int s, const std::string& path, mode_t mode, bool compressed,
+static bool send_impl(int s, const std::string& path, mode_t mode, CompressionType compression,
                       std::vector<char>& buffer) {
     // Don't delete files before copying if they are not "regular" or symlinks.
     struct stat st;
@@ -527,7 +552,7 @@ static bool send_impl(int s, const std::string& path, mode_t mode, bool compress
         }
 
         result = handle_send_file(s, path.c_str(), &timestamp, uid, gid, capabilities, mode,
-                                  compressed, buffer, do_unlink);
+                                  compression, buffer, do_unlink);
     }
 
     if (!result) {
@@ -560,7 +585,7 @@ static bool do_send_v1(int s, const std::string& spec, std::vector<char>& buffer
         return false;
     }
 
-    return send_impl(s, path, mode, false, buffer);
+    return send_impl(s, path, mode, CompressionType::None, buffer);
 }
 
 static bool do_send_v2(int s, const std::string& path, std::vector<char>& buffer) {
@@ -574,10 +599,10 @@ static bool do_send_v2(int s, const std::string& path, std::vector<char>& buffer
         PLOG(ERROR) << "failed to read send_v2 setup packet";
     }
 
-    bool compressed = false;
-    if (msg.send_v2_setup.flags & kSyncFlagBrotli) {
-        msg.send_v2_setup.flags &= ~kSyncFlagBrotli;
-        compressed = true;
+    CompressionType compression;
+    if (!take_compression_flag(&msg.send_v2_setup.flags, &compression)) {
+        SendSyncFail(s, "multiple compression flags");
+        return false;
     }
     if (msg.send_v2_setup.flags) {
         SendSyncFail(s, android::base::StringPrintf("unknown flags: %d", msg.send_v2_setup.flags));
@@ -585,13 +610,12 @@ static bool do_send_v2(int s, const std::string& path, std::vector<char>& buffer
     }
 
     errno = 0;
-    return send_impl(s, path, msg.send_v2_setup.mode, compressed, buffer);
+    return send_impl(s, path, msg.send_v2_setup.mode, compression, buffer);
 }
 
 static bool recv_uncompressed(borrowed_fd s, unique_fd fd, std::vector<char>& buffer) {
     syncmsg msg;
     msg.data.id = ID_DATA;
-    std::optional<BrotliEncoder<SYNC_DATA_MAX>> encoder;
     while (true) {
         int r = adb_read(fd.get(), &buffer[0], buffer.size() - sizeof(msg.data));
         if (r <= 0) {
@@ -609,11 +633,11 @@ static bool recv_uncompressed(borrowed_fd s, unique_fd fd, std::vector<char>& bu
     return true;
 }
 
-static bool recv_compressed(borrowed_fd s, unique_fd fd) {
+static bool recv_compressed(borrowed_fd s, unique_fd fd, CompressionType compression) {
     syncmsg msg;
     msg.data.id = ID_DATA;
 
-    BrotliEncoder<SYNC_DATA_MAX> encoder;
+    std::unique_ptr<Encoder> encoder = CreateEncoder(compression, SYNC_DATA_MAX);
 
     bool sending = true;
     while (sending) {
@@ -625,16 +649,16 @@ static bool recv_compressed(borrowed_fd s, unique_fd fd) {
         }
 
         if (r == 0) {
-            encoder.Finish();
+            encoder->Finish();
         } else {
             input.resize(r);
-            encoder.Append(std::move(input));
+            encoder->Append(std::move(input));
         }
 
         while (true) {
             Block output;
-            BrotliEncodeResult result = encoder.Encode(&output);
-            if (result == BrotliEncodeResult::Error) {
+            EncodeResult result = encoder->Encode(&output);
+            if (result == EncodeResult::Error) {
                 SendSyncFailErrno(s, "compress failed");
                 return false;
             }
@@ -647,12 +671,12 @@ static bool recv_compressed(borrowed_fd s, unique_fd fd) {
                 }
             }
 
-            if (result == BrotliEncodeResult::Done) {
+            if (result == EncodeResult::Done) {
                 sending = false;
                 break;
-            } else if (result == BrotliEncodeResult::NeedInput) {
+            } else if (result == EncodeResult::NeedInput) {
                 break;
-            } else if (result == BrotliEncodeResult::MoreOutput) {
+            } else if (result == EncodeResult::MoreOutput) {
                 continue;
             }
         }
@@ -661,7 +685,8 @@ static bool recv_compressed(borrowed_fd s, unique_fd fd) {
     return true;
 }
 
-static bool recv_impl(borrowed_fd s, const char* path, bool compressed, std::vector<char>& buffer) {
+static bool recv_impl(borrowed_fd s, const char* path, CompressionType compression,
+                      std::vector<char>& buffer) {
     __android_log_security_bswrite(SEC_TAG_ADB_RECV_FILE, path);
 
     unique_fd fd(adb_open(path, O_RDONLY | O_CLOEXEC));
@@ -676,8 +701,8 @@ static bool recv_impl(borrowed_fd s, const char* path, bool compressed, std::vec
     }
 
     bool result;
-    if (compressed) {
-        result = recv_compressed(s, std::move(fd));
+    if (compression != CompressionType::None) {
+        result = recv_compressed(s, std::move(fd), compression);
     } else {
         result = recv_uncompressed(s, std::move(fd), buffer);
     }
@@ -693,7 +718,7 @@ static bool recv_impl(borrowed_fd s, const char* path, bool compressed, std::vec
 }
 
 static bool do_recv_v1(borrowed_fd s, const char* path, std::vector<char>& buffer) {
-    return recv_impl(s, path, false, buffer);
+    return recv_impl(s, path, CompressionType::None, buffer);
 }
 
 static bool do_recv_v2(borrowed_fd s, const char* path, std::vector<char>& buffer) {
@@ -707,17 +732,17 @@ static bool do_recv_v2(borrowed_fd s, const char* path, std::vector<char>& buffe
         PLOG(ERROR) << "failed to read recv_v2 setup packet";
     }
 
-    bool compressed = false;
-    if (msg.recv_v2_setup.flags & kSyncFlagBrotli) {
-        msg.recv_v2_setup.flags &= ~kSyncFlagBrotli;
-        compressed = true;
+    CompressionType compression;
+    if (!take_compression_flag(&msg.recv_v2_setup.flags, &compression)) {
+        SendSyncFail(s, "multiple compression flags");
+        return false;
     }
     if (msg.recv_v2_setup.flags) {
         SendSyncFail(s, android::base::StringPrintf("unknown flags: %d", msg.recv_v2_setup.flags));
         return false;
     }
 
-    return recv_impl(s, path, compressed, buffer);
+    return recv_impl(s, path, compression, buffer);
 }
 
 static const char* sync_id_to_name(uint32_t id) {
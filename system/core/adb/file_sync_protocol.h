@@ -92,6 +92,17 @@ struct __attribute__((packed)) sync_dent_v2 {
 enum SyncFlag : uint32_t {
     kSyncFlagNone = 0,
     kSyncFlagBrotli = 1,
+    kSyncFlagLZ4 = 2,
+    kSyncFlagZstd = 4,
+};
+
+// At most one compression flag may be set on a send_v2/recv_v2 request.
+enum class CompressionType {
+    None,
+    Any,
+    Brotli,
+    LZ4,
+    Zstd,
 };
 
 // send_v1 sent the path in a buffer, followed by a comma and the mode as a string.
@@ -587,7 +587,9 @@ int main(int argc, char** argv) {
   }
 
   // TODO: Use seccomp to lock ourselves down.
-  unwindstack::UnwinderFromPid unwinder(256, vm_pid);
+  // The threads are unwound concurrently, so the process memory cache has to be per thread.
+  unwindstack::UnwinderFromPid unwinder(
+      256, vm_pid, unwindstack::Memory::CreateProcessMemoryThreadCached(vm_pid));
   if (!unwinder.Init(unwindstack::Regs::CurrentArch())) {
     LOG(FATAL) << "Failed to init unwinder object.";
   }
@@ -22,7 +22,10 @@
 #include <unistd.h>
 
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 #include <debuggerd/client.h>
@@ -63,7 +66,8 @@ static std::chrono::duration<double> GetMaximumPause(std::atomic<ThreadState>& s
   return max_diff;
 }
 
-static void PerformDump() {
+static void PerformDump(DebuggerdDumpType dump_type = kDebuggerdNativeBacktrace,
+                        unsigned int timeout_ms = 1000) {
   pid_t target = getpid();
   pid_t forkpid = fork();
   if (forkpid == -1) {
@@ -84,7 +88,7 @@ static void PerformDump() {
       err(1, "failed to open /dev/null");
     }
 
-    if (!debuggerd_trigger_dump(target, kDebuggerdNativeBacktrace, 1000, std::move(output_fd))) {
+    if (!debuggerd_trigger_dump(target, dump_type, timeout_ms, std::move(output_fd))) {
       errx(1, "failed to trigger dump");
     }
 
@@ -125,4 +129,54 @@ static void BM_maximum_pause_debuggerd(benchmark::State& state) {
 BENCHMARK(BM_maximum_pause_noop)->Iterations(128)->UseManualTime();
 BENCHMARK(BM_maximum_pause_debuggerd)->Iterations(128)->UseManualTime();
 
+// Parks a thread a few frames deep, so each one has a stack worth unwinding.
+static void __attribute__((noinline)) ParkThread(std::mutex& mutex, std::condition_variable& cv,
+                                                 bool& done, int depth) {
+  if (depth > 0) {
+    ParkThread(mutex, cv, done, depth - 1);
+    // Keep the call from becoming a tail call.
+    benchmark::ClobberMemory();
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [&]() { return done; });
+}
+
+// Arg: extra threads in the dumped process, like a system_server sized process.
+template <DebuggerdDumpType dump_type>
+static void BM_dump_many_threads(benchmark::State& state) {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < state.range(0); i++) {
+    threads.emplace_back([&, i]() { ParkThread(mutex, cv, done, i % 16); });
+  }
+
+  for (auto _ : state) {
+    PerformDump(dump_type, 10000);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+  }
+  cv.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_dump_many_threads, kDebuggerdNativeBacktrace)
+    ->Arg(16)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_dump_many_threads, kDebuggerdTombstone)
+    ->Arg(16)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -77,6 +77,19 @@ void dump_backtrace_thread(int output_fd, unwindstack::Unwinder* unwinder,
   log_backtrace(&log, unwinder, "  ");
 }
 
+static void dump_backtrace_thread(log_t* log, unwindstack::Unwinder* unwinder,
+                                  const ThreadInfo& thread, const ThreadUnwind& unwind) {
+  _LOG(log, logtype::BACKTRACE, "\n\"%s\" sysTid=%d\n", thread.thread_name.c_str(), thread.tid);
+
+  if (unwind.frames.empty()) {
+    _LOG(log, logtype::THREAD, "Unwind failed: tid = %d", thread.tid);
+    return;
+  }
+
+  unwinder->SetRegs(thread.registers.get());
+  log_backtrace(log, unwinder, unwind, "  ");
+}
+
 void dump_backtrace(android::base::unique_fd output_fd, unwindstack::Unwinder* unwinder,
                     const std::map<pid_t, ThreadInfo>& thread_info, pid_t target_thread) {
   log_t log;
@@ -91,10 +104,11 @@ void dump_backtrace(android::base::unique_fd output_fd, unwindstack::Unwinder* u
 
   dump_process_header(&log, target->second.pid, target->second.process_name.c_str());
 
-  dump_backtrace_thread(output_fd.get(), unwinder, target->second);
+  std::map<pid_t, ThreadUnwind> unwinds = unwind_threads(unwinder, thread_info);
+  dump_backtrace_thread(&log, unwinder, target->second, unwinds[target_thread]);
   for (const auto& [tid, info] : thread_info) {
     if (tid != target_thread) {
-      dump_backtrace_thread(output_fd.get(), unwinder, info);
+      dump_backtrace_thread(&log, unwinder, info, unwinds[tid]);
     }
   }
 
@@ -18,8 +18,10 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <unwindstack/Regs.h>
+#include <unwindstack/Unwinder.h>
 
 struct ThreadInfo {
   std::unique_ptr<unwindstack::Regs> registers;
@@ -35,3 +37,9 @@ struct ThreadInfo {
   int signo = 0;
   siginfo_t* siginfo = nullptr;
 };
+
+// The frames of one thread, unwound ahead of logging them.
+struct ThreadUnwind {
+  std::vector<unwindstack::FrameData> frames;
+  bool elf_from_memory_not_file = false;
+};
@@ -24,10 +24,13 @@
 #include <stdbool.h>
 #include <sys/types.h>
 
+#include <map>
 #include <string>
 
 #include <android-base/macros.h>
 
+#include "types.h"
+
 struct log_t {
   // Tombstone file descriptor.
   int tfd;
@@ -80,6 +83,18 @@ class Memory;
 }
 
 void log_backtrace(log_t* log, unwindstack::Unwinder* unwinder, const char* prefix);
+void log_backtrace(log_t* log, unwindstack::Unwinder* unwinder, const ThreadUnwind& unwind,
+                   const char* prefix);
+
+// Unwinds all of the threads on a few worker threads, each with its own
+// Unwinder sharing the maps (and so the elf files) and process memory of
+// unwinder. The process memory must be safe to read from several threads at
+// once, see Memory::CreateProcessMemoryThreadCached. Must be called on the
+// thread that ptrace attached to the process: if process_vm_readv doesn't
+// work, it unwinds on the calling thread only, and unwinds that fail on
+// another thread are redone on the calling thread.
+std::map<pid_t, ThreadUnwind> unwind_threads(unwindstack::Unwinder* unwinder,
+                                             const std::map<pid_t, ThreadInfo>& thread_info);
 
 void dump_memory(log_t* log, unwindstack::Memory* backtrace, uint64_t addr, const std::string&);
 
@@ -376,8 +376,8 @@ void dump_memory_and_code(log_t* log, unwindstack::Maps* maps, unwindstack::Memo
 }
 
 static bool dump_thread(log_t* log, unwindstack::Unwinder* unwinder, const ThreadInfo& thread_info,
-                        uint64_t abort_msg_address, bool primary_thread,
-                        const GwpAsanCrashData& gwp_asan_crash_data) {
+                        const ThreadUnwind& unwind, uint64_t abort_msg_address,
+                        bool primary_thread, const GwpAsanCrashData& gwp_asan_crash_data) {
   log->current_tid = thread_info.tid;
   if (!primary_thread) {
     _LOG(log, logtype::THREAD, "--- --- --- --- --- --- --- --- --- --- --- --- --- --- --- ---\n");
@@ -401,15 +401,12 @@ static bool dump_thread(log_t* log, unwindstack::Unwinder* unwinder, const Threa
 
   dump_registers(log, thread_info.registers.get());
 
-  // Unwind will mutate the registers, so make a copy first.
-  std::unique_ptr<unwindstack::Regs> regs_copy(thread_info.registers->Clone());
-  unwinder->SetRegs(regs_copy.get());
-  unwinder->Unwind();
-  if (unwinder->NumFrames() == 0) {
+  unwinder->SetRegs(thread_info.registers.get());
+  if (unwind.frames.empty()) {
     _LOG(log, logtype::THREAD, "Failed to unwind");
   } else {
     _LOG(log, logtype::BACKTRACE, "\nbacktrace:\n");
-    log_backtrace(log, unwinder, "    ");
+    log_backtrace(log, unwinder, unwind, "    ");
   }
 
   if (primary_thread) {
@@ -632,7 +629,10 @@ void engrave_tombstone(unique_fd output_fd, unwindstack::Unwinder* unwinder,
                                        gwp_asan_state_ptr,
                                        gwp_asan_metadata_ptr, it->second);
 
-  dump_thread(&log, unwinder, it->second, abort_msg_address, true,
+  // Unwind every thread up front, concurrently, then log them in the usual order.
+  std::map<pid_t, ThreadUnwind> unwinds = unwind_threads(unwinder, threads);
+
+  dump_thread(&log, unwinder, it->second, unwinds[target_thread], abort_msg_address, true,
               gwp_asan_crash_data);
 
   if (want_logs) {
@@ -644,7 +644,7 @@ void engrave_tombstone(unique_fd output_fd, unwindstack::Unwinder* unwinder,
       continue;
     }
 
-    dump_thread(&log, unwinder, thread_info, 0, false, gwp_asan_crash_data);
+    dump_thread(&log, unwinder, thread_info, unwinds[tid], 0, false, gwp_asan_crash_data);
   }
 
   if (open_files) {
@@ -28,7 +28,12 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <android-base/logging.h>
 #include <android-base/properties.h>
@@ -431,8 +436,8 @@ const char* get_sigcode(const siginfo_t* si) {
   return "?";
 }
 
-void log_backtrace(log_t* log, unwindstack::Unwinder* unwinder, const char* prefix) {
-  if (unwinder->elf_from_memory_not_file()) {
+static void log_backtrace_notes(log_t* log, bool elf_from_memory_not_file, const char* prefix) {
+  if (elf_from_memory_not_file) {
     _LOG(log, logtype::BACKTRACE,
          "%sNOTE: Function names and BuildId information is missing for some frames due\n", prefix);
     _LOG(log, logtype::BACKTRACE,
@@ -443,9 +448,118 @@ void log_backtrace(log_t* log, unwindstack::Unwinder* unwinder, const char* pref
          "%sNOTE: On this device, run setenforce 0 to make the libraries readable.\n", prefix);
 #endif
   }
+}
+
+void log_backtrace(log_t* log, unwindstack::Unwinder* unwinder, const char* prefix) {
+  log_backtrace_notes(log, unwinder->elf_from_memory_not_file(), prefix);
 
   unwinder->SetDisplayBuildID(true);
   for (size_t i = 0; i < unwinder->NumFrames(); i++) {
     _LOG(log, logtype::BACKTRACE, "%s%s\n", prefix, unwinder->FormatFrame(i).c_str());
   }
 }
+
+void log_backtrace(log_t* log, unwindstack::Unwinder* unwinder, const ThreadUnwind& unwind,
+                   const char* prefix) {
+  log_backtrace_notes(log, unwind.elf_from_memory_not_file, prefix);
+
+  unwinder->SetDisplayBuildID(true);
+  for (const auto& frame : unwind.frames) {
+    _LOG(log, logtype::BACKTRACE, "%s%s\n", prefix, unwinder->FormatFrame(frame).c_str());
+  }
+}
+
+// Enough to keep a dump of a process with hundreds of threads short, without
+// taking over the device while the crashing process is still stopped.
+static constexpr size_t kMaxUnwindThreads = 4;
+
+// Reads that process_vm_readv can't do fall back to ptrace, which only works on
+// the thread that attached to the process, so only hand unwinds to other
+// threads if process_vm_readv works for the process.
+static bool can_read_without_ptrace(const ThreadInfo& thread) {
+  uint8_t byte;
+  struct iovec local = {&byte, sizeof(byte)};
+  struct iovec remote = {reinterpret_cast<void*>(thread.registers->sp()), sizeof(byte)};
+  return process_vm_readv(thread.pid, &local, 1, &remote, 1, 0) == sizeof(byte);
+}
+
+std::map<pid_t, ThreadUnwind> unwind_threads(unwindstack::Unwinder* unwinder,
+                                             const std::map<pid_t, ThreadInfo>& thread_info) {
+  std::vector<pid_t> tids;
+  std::vector<const ThreadInfo*> threads;
+  for (const auto& [tid, info] : thread_info) {
+    tids.push_back(tid);
+    threads.push_back(&info);
+  }
+  std::vector<ThreadUnwind> unwinds(threads.size());
+
+  size_t num_workers = std::min(
+      {threads.size(), kMaxUnwindThreads, std::max<size_t>(std::thread::hardware_concurrency(), 1)});
+  if (num_workers > 1 && !can_read_without_ptrace(*threads.front())) {
+    num_workers = 1;
+  }
+
+  // Set the workers up before starting any of them, since attaching the shared
+  // jit and dex debug info writes to it.
+  std::vector<std::unique_ptr<unwindstack::Unwinder>> workers;
+  for (size_t i = 0; i < num_workers; i++) {
+    auto worker = std::make_unique<unwindstack::Unwinder>(
+        unwinder->GetMaxFrames(), unwinder->GetMaps(), unwinder->GetProcessMemory());
+    unwindstack::ArchEnum arch = threads.front()->registers->Arch();
+    if (unwinder->GetJitDebug() != nullptr) {
+      worker->SetJitDebug(unwinder->GetJitDebug(), arch);
+    }
+    if (unwinder->GetDexFiles() != nullptr) {
+      worker->SetDexFiles(unwinder->GetDexFiles(), arch);
+    }
+    workers.push_back(std::move(worker));
+  }
+
+  // Whether a worker other than the calling thread failed to unwind a thread.
+  std::vector<uint8_t> retry(threads.size());
+  auto unwind_one = [&](unwindstack::Unwinder* worker, size_t i) {
+    // Unwind will mutate the registers, so make a copy first.
+    std::unique_ptr<unwindstack::Regs> regs(threads[i]->registers->Clone());
+    worker->SetRegs(regs.get());
+    worker->Unwind();
+    unwinds[i].frames = worker->ConsumeFrames();
+    unwinds[i].elf_from_memory_not_file = worker->elf_from_memory_not_file();
+    retry[i] = worker != workers[0].get() &&
+               (unwinds[i].frames.empty() ||
+                worker->LastErrorCode() == unwindstack::ERROR_MEMORY_INVALID);
+  };
+
+  std::atomic<size_t> next_thread = 0;
+  auto unwind = [&](unwindstack::Unwinder* worker) {
+    for (size_t i = next_thread++; i < threads.size(); i = next_thread++) {
+      unwind_one(worker, i);
+    }
+  };
+
+  // The calling thread takes a share of the work too.
+  std::vector<std::thread> worker_threads;
+  for (size_t i = 1; i < num_workers; i++) {
+    worker_threads.emplace_back(unwind, workers[i].get());
+  }
+  if (num_workers > 0) {
+    unwind(workers[0].get());
+  }
+  for (auto& thread : worker_threads) {
+    thread.join();
+  }
+
+  // Once a read that only ptrace could do has been made, the shared process
+  // memory keeps using ptrace, and the other workers' reads fail. Redo what
+  // they failed on here, where ptrace works.
+  for (size_t i = 0; i < threads.size(); i++) {
+    if (retry[i]) {
+      unwind_one(workers[0].get(), i);
+    }
+  }
+
+  std::map<pid_t, ThreadUnwind> result;
+  for (size_t i = 0; i < threads.size(); i++) {
+    result[tids[i]] = std::move(unwinds[i]);
+  }
+  return result;
+}
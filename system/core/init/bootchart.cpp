@@ -51,6 +51,9 @@ static std::mutex g_bootcharting_finished_mutex;
 static std::condition_variable g_bootcharting_finished_cv;
 static bool g_bootcharting_finished;
 
+// Only used from init's main thread, unlike the logs above.
+static FILE* g_services_log;
+
 static long long get_uptime_jiffies() {
     constexpr int64_t kNanosecondsPerJiffy = 10000000;
     boot_clock::time_point uptime = boot_clock::now();
@@ -174,6 +177,7 @@ static Result<void> do_bootchart_start() {
     }
 
     g_bootcharting_thread = new std::thread(bootchart_thread_main);
+    g_services_log = fopen_unique("/data/bootchart/services.log", "we").release();
     return {};
 }
 
@@ -190,9 +194,24 @@ static Result<void> do_bootchart_stop() {
     g_bootcharting_thread->join();
     delete g_bootcharting_thread;
     g_bootcharting_thread = nullptr;
+
+    if (g_services_log) {
+        fclose(g_services_log);
+        g_services_log = nullptr;
+    }
     return {};
 }
 
+void BootchartLogServiceStart(const std::string& name, pid_t pid,
+                              boot_clock::time_point time_started) {
+    if (!g_services_log) return;
+
+    auto uptime_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            time_started.time_since_epoch());
+    fprintf(g_services_log, "%lld %s %d\n", static_cast<long long>(uptime_ms.count()),
+            name.c_str(), pid);
+}
+
 Result<void> do_bootchart(const BuiltinArguments& args) {
     if (args[1] == "start") return do_bootchart_start();
     return do_bootchart_stop();
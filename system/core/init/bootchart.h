@@ -17,9 +17,13 @@
 #ifndef _BOOTCHART_H
 #define _BOOTCHART_H
 
+#include <sys/types.h>
+
 #include <string>
 #include <vector>
 
+#include <android-base/chrono_utils.h>
+
 #include "builtin_arguments.h"
 #include "result.h"
 
@@ -28,6 +32,10 @@ namespace init {
 
 Result<void> do_bootchart(const BuiltinArguments& args);
 
+// Records when a service's process was started, while bootcharting.
+void BootchartLogServiceStart(const std::string& name, pid_t pid,
+                              android::base::boot_clock::time_point time_started);
+
 }  // namespace init
 }  // namespace android
 
@@ -161,9 +161,16 @@ static Result<void> do_class_start(const BuiltinArguments& args) {
     // Do not start a class if it has a property persist.dont_start_class.CLASS set to 1.
     if (android::base::GetBoolProperty("persist.init.dont_start_class." + args[1], false))
         return {};
+    // Mark the whole class first, so that services ordered 'after' another one in the
+    // class wait for it regardless of the order they are started in below.
+    auto& service_list = ServiceList::GetInstance();
+    service_list.BeginClassStart();
+    for (const auto& service : service_list) {
+        if (service->classnames().count(args[1])) service->SetWaitingToStart();
+    }
     // Starting a class does not start services which are explicitly disabled.
     // They must  be started individually.
-    for (const auto& service : ServiceList::GetInstance()) {
+    for (const auto& service : service_list) {
         if (service->classnames().count(args[1])) {
             if (auto result = service->StartIfNotDisabled(); !result.ok()) {
                 LOG(ERROR) << "Could not start service '" << service->name()
@@ -171,6 +178,7 @@ static Result<void> do_class_start(const BuiltinArguments& args) {
             }
         }
     }
+    service_list.EndClassStart();
     return {};
 }
 
@@ -22,6 +22,7 @@
 
 #include <string>
 
+#include <android-base/chrono_utils.h>
 #include <android-base/properties.h>
 
 // android/api-level.h
@@ -35,6 +36,10 @@
 namespace android {
 namespace init {
 
+// bootchart.h
+inline void BootchartLogServiceStart(const std::string&, pid_t,
+                                     android::base::boot_clock::time_point) {}
+
 // property_service.h
 inline bool CanReadProperty(const std::string&, const std::string&) {
     return true;
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <functional>
 
 #include <android-base/file.h>
@@ -31,6 +32,7 @@
 #include "service.h"
 #include "service_list.h"
 #include "service_parser.h"
+#include "subcontext.h"
 #include "util.h"
 
 using android::base::GetIntProperty;
@@ -179,6 +181,206 @@ service A something
     EXPECT_TRUE(service->is_override());
 }
 
+TEST(init, ServiceAfterAndNeeds) {
+    std::string init_script = R"init(
+service A something
+    after B C
+    needs D
+
+service B something
+    after B
+)init";
+
+    ServiceList service_list;
+    Parser parser;
+    parser.AddSectionParser("service",
+                            std::make_unique<ServiceParser>(&service_list, nullptr, std::nullopt));
+
+    TemporaryFile tf;
+    ASSERT_TRUE(tf.fd != -1);
+    ASSERT_TRUE(android::base::WriteStringToFd(init_script, tf.fd));
+    ASSERT_TRUE(parser.ParseConfig(tf.path));
+
+    // A service cannot start after itself.
+    EXPECT_EQ(1u, parser.parse_error_count());
+
+    auto service = service_list.FindService("A");
+    ASSERT_NE(nullptr, service);
+    EXPECT_EQ(std::vector<std::string>({"B", "C"}), service->after());
+    EXPECT_EQ(std::vector<std::string>({"D"}), service->needs());
+}
+
+TEST(init, ServiceWaitsForStartingDependencies) {
+    std::string init_script = R"init(
+service A something
+    after B
+
+service B something
+    after C
+
+service C something
+
+service D something
+    after E
+)init";
+
+    ServiceList service_list;
+    TestInitText(init_script, BuiltinFunctionMap(), {}, &service_list);
+    auto a = service_list.FindService("A");
+    auto b = service_list.FindService("B");
+    auto c = service_list.FindService("C");
+    auto d = service_list.FindService("D");
+    ASSERT_NE(nullptr, a);
+    ASSERT_NE(nullptr, b);
+    ASSERT_NE(nullptr, c);
+    ASSERT_NE(nullptr, d);
+
+    // Neither stopped nor unknown services are waited for.
+    EXPECT_TRUE(*service_list.CheckDependencies(*a));
+    EXPECT_TRUE(*service_list.CheckDependencies(*d));
+
+    // A service that is itself waiting to start is waited for, regardless of why it waits.
+    b->SetWaitingToStart();
+    c->SetWaitingToStart();
+    EXPECT_FALSE(*service_list.CheckDependencies(*a));
+    EXPECT_FALSE(*service_list.CheckDependencies(*b));
+}
+
+TEST(init, ServiceDependencyCycleDoesNotWait) {
+    std::string init_script = R"init(
+service A something
+    after B
+
+service B something
+    after C
+
+service C something
+    after A
+)init";
+
+    ServiceList service_list;
+    TestInitText(init_script, BuiltinFunctionMap(), {}, &service_list);
+    auto a = service_list.FindService("A");
+    auto b = service_list.FindService("B");
+    auto c = service_list.FindService("C");
+    ASSERT_NE(nullptr, a);
+    ASSERT_NE(nullptr, b);
+    ASSERT_NE(nullptr, c);
+
+    // A waits for B, which waits for C, which would wait for A once A waits, so none of them
+    // waits at all.
+    a->SetWaitingToStart();
+    b->SetWaitingToStart();
+    c->SetWaitingToStart();
+    EXPECT_TRUE(*service_list.CheckDependencies(*a));
+    EXPECT_TRUE(*service_list.CheckDependencies(*b));
+    EXPECT_TRUE(*service_list.CheckDependencies(*c));
+}
+
+TEST(init, ServiceNeedsUnknownService) {
+    std::string init_script = R"init(
+service A something
+    needs B
+)init";
+
+    ServiceList service_list;
+    TestInitText(init_script, BuiltinFunctionMap(), {}, &service_list);
+    auto a = service_list.FindService("A");
+    ASSERT_NE(nullptr, a);
+
+    auto result = service_list.CheckDependencies(*a);
+    ASSERT_FALSE(result.ok());
+    EXPECT_EQ("needs unknown service 'B'", result.error().message());
+}
+
+TEST(init, ClassStartOrdersServicesInClass) {
+    // A comes first, but has to wait for B, which in turn waits for C. C is not in the class, and
+    // is left waiting to start, so that nothing is forked.
+    std::string init_script = R"init(
+service class_start_test_A something
+    class class_start_test
+    after class_start_test_B
+
+service class_start_test_B something
+    class class_start_test
+    after class_start_test_C
+
+service class_start_test_C something
+)init";
+
+    // Service::Start() and class_start operate on the global service list.
+    auto& service_list = ServiceList::GetInstance();
+    TestInitText(init_script, BuiltinFunctionMap(), {}, &service_list);
+    auto a = service_list.FindService("class_start_test_A");
+    auto b = service_list.FindService("class_start_test_B");
+    auto c = service_list.FindService("class_start_test_C");
+    ASSERT_NE(nullptr, a);
+    ASSERT_NE(nullptr, b);
+    ASSERT_NE(nullptr, c);
+    c->SetWaitingToStart();
+
+    auto class_start = GetBuiltinFunctionMap().Find({"class_start", "class_start_test"});
+    ASSERT_RESULT_OK(class_start);
+    std::string context = kInitContext;
+    BuiltinArguments args({"class_start", "class_start_test"}, context);
+    EXPECT_RESULT_OK(class_start->function(args));
+
+    // Without marking the whole class first, A would have been started before B was considered.
+    EXPECT_TRUE(a->flags() & SVC_WAITING);
+    EXPECT_TRUE(b->flags() & SVC_WAITING);
+    EXPECT_FALSE(a->IsRunning());
+    EXPECT_FALSE(b->IsRunning());
+
+    // Stopping a waiting service means it is no longer started once its dependencies are ready.
+    a->Stop();
+    EXPECT_FALSE(a->flags() & SVC_WAITING);
+
+    for (auto service : {a, b, c}) {
+        service_list.RemoveService(*service);
+    }
+}
+
+TEST(init, ClassStartStartsEachServiceOnce) {
+    // A has nothing to wait for, but fails to start, since updatable services are only started
+    // once the configs from the APEXes are loaded. Each attempt queues it once more.
+    std::string init_script = R"init(
+service class_start_once_test_A something
+    class class_start_once_test
+    updatable
+)init";
+
+    auto& service_list = ServiceList::GetInstance();
+    TestInitText(init_script, BuiltinFunctionMap(), {}, &service_list);
+    auto a = service_list.FindService("class_start_once_test_A");
+    ASSERT_NE(nullptr, a);
+    ASSERT_FALSE(service_list.IsServicesUpdated());
+    auto attempts = [&service_list, a] {
+        const auto& names = service_list.delayed_service_names();
+        return std::count(names.begin(), names.end(), a->name());
+    };
+
+    auto class_start = GetBuiltinFunctionMap().Find({"class_start", "class_start_once_test"});
+    ASSERT_RESULT_OK(class_start);
+    std::string context = kInitContext;
+    BuiltinArguments args({"class_start", "class_start_once_test"}, context);
+    EXPECT_RESULT_OK(class_start->function(args));
+    EXPECT_EQ(1, attempts());
+    EXPECT_FALSE(a->flags() & SVC_WAITING);
+
+    // Another service of the class starting first does not start A ahead of class_start, which
+    // would then try again.
+    a->SetWaitingToStart();
+    service_list.BeginClassStart();
+    service_list.StartWaitingServices();
+    EXPECT_EQ(1, attempts());
+    EXPECT_TRUE(a->flags() & SVC_WAITING);
+    EXPECT_FALSE(a->StartIfNotDisabled().ok());
+    service_list.EndClassStart();
+    EXPECT_EQ(2, attempts());
+
+    service_list.RemoveService(*a);
+}
+
 TEST(init, EventTriggerOrderMultipleFiles) {
     // 6 total files, which should have their triggers executed in the following order:
     // 1: start - original script parsed
@@ -18,6 +18,11 @@
 
 #include <dirent.h>
 
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <thread>
+
 #include <android-base/chrono_utils.h>
 #include <android-base/file.h>
 #include <android-base/logging.h>
@@ -30,6 +35,8 @@
 namespace android {
 namespace init {
 
+static constexpr size_t kMaxConfigReaderThreads = 4;
+
 Parser::Parser() {}
 
 void Parser::AddSectionParser(const std::string& name, std::unique_ptr<SectionParser> parser) {
@@ -40,7 +47,7 @@ void Parser::AddSingleLineParser(const std::string& prefix, LineCallback callbac
     line_callbacks_.emplace_back(prefix, std::move(callback));
 }
 
-void Parser::ParseData(const std::string& filename, std::string* data) {
+Parser::ConfigLines Parser::Tokenize(std::string* data) {
     data->push_back('\n');  // TODO: fix tokenizer
     data->push_back('\0');
 
@@ -49,9 +56,32 @@ void Parser::ParseData(const std::string& filename, std::string* data) {
     state.ptr = data->data();
     state.nexttoken = 0;
 
+    ConfigLines lines;
+    std::vector<std::string> args;
+    for (;;) {
+        switch (next_token(&state)) {
+            case T_EOF:
+                return lines;
+            case T_NEWLINE:
+                state.line++;
+                if (args.empty()) break;
+                lines.emplace_back(state.line, std::move(args));
+                args.clear();
+                break;
+            case T_TEXT:
+                args.emplace_back(state.text);
+                break;
+        }
+    }
+}
+
+void Parser::ParseData(const std::string& filename, std::string* data) {
+    ParseLines(filename, Tokenize(data));
+}
+
+void Parser::ParseLines(const std::string& filename, ConfigLines&& lines) {
     SectionParser* section_parser = nullptr;
     int section_start_line = -1;
-    std::vector<std::string> args;
 
     // If we encounter a bad section start, there is no valid parser object to parse the subsequent
     // sections, so we must suppress errors until the next valid section is found.
@@ -70,63 +100,48 @@ void Parser::ParseData(const std::string& filename, std::string* data) {
         section_start_line = -1;
     };
 
-    for (;;) {
-        switch (next_token(&state)) {
-            case T_EOF:
-                end_section();
-
-                for (const auto& [section_name, section_parser] : section_parsers_) {
-                    section_parser->EndFile();
-                }
-
-                return;
-            case T_NEWLINE: {
-                state.line++;
-                if (args.empty()) break;
-                // If we have a line matching a prefix we recognize, call its callback and unset any
-                // current section parsers.  This is meant for /sys/ and /dev/ line entries for
-                // uevent.
-                auto line_callback = std::find_if(
-                    line_callbacks_.begin(), line_callbacks_.end(),
-                    [&args](const auto& c) { return android::base::StartsWith(args[0], c.first); });
-                if (line_callback != line_callbacks_.end()) {
-                    end_section();
-
-                    if (auto result = line_callback->second(std::move(args)); !result.ok()) {
-                        parse_error_count_++;
-                        LOG(ERROR) << filename << ": " << state.line << ": " << result.error();
-                    }
-                } else if (section_parsers_.count(args[0])) {
-                    end_section();
-                    section_parser = section_parsers_[args[0]].get();
-                    section_start_line = state.line;
-                    if (auto result =
-                                section_parser->ParseSection(std::move(args), filename, state.line);
-                        !result.ok()) {
-                        parse_error_count_++;
-                        LOG(ERROR) << filename << ": " << state.line << ": " << result.error();
-                        section_parser = nullptr;
-                        bad_section_found = true;
-                    }
-                } else if (section_parser) {
-                    if (auto result = section_parser->ParseLineSection(std::move(args), state.line);
-                        !result.ok()) {
-                        parse_error_count_++;
-                        LOG(ERROR) << filename << ": " << state.line << ": " << result.error();
-                    }
-                } else if (!bad_section_found) {
-                    parse_error_count_++;
-                    LOG(ERROR) << filename << ": " << state.line
-                               << ": Invalid section keyword found";
-                }
-                args.clear();
-                break;
+    for (auto& [line, args] : lines) {
+        // If we have a line matching a prefix we recognize, call its callback and unset any
+        // current section parsers.  This is meant for /sys/ and /dev/ line entries for
+        // uevent.
+        auto line_callback = std::find_if(
+            line_callbacks_.begin(), line_callbacks_.end(),
+            [&args](const auto& c) { return android::base::StartsWith(args[0], c.first); });
+        if (line_callback != line_callbacks_.end()) {
+            end_section();
+
+            if (auto result = line_callback->second(std::move(args)); !result.ok()) {
+                parse_error_count_++;
+                LOG(ERROR) << filename << ": " << line << ": " << result.error();
             }
-            case T_TEXT:
-                args.emplace_back(state.text);
-                break;
+        } else if (section_parsers_.count(args[0])) {
+            end_section();
+            section_parser = section_parsers_[args[0]].get();
+            section_start_line = line;
+            if (auto result = section_parser->ParseSection(std::move(args), filename, line);
+                !result.ok()) {
+                parse_error_count_++;
+                LOG(ERROR) << filename << ": " << line << ": " << result.error();
+                section_parser = nullptr;
+                bad_section_found = true;
+            }
+        } else if (section_parser) {
+            if (auto result = section_parser->ParseLineSection(std::move(args), line);
+                !result.ok()) {
+                parse_error_count_++;
+                LOG(ERROR) << filename << ": " << line << ": " << result.error();
+            }
+        } else if (!bad_section_found) {
+            parse_error_count_++;
+            LOG(ERROR) << filename << ": " << line << ": Invalid section keyword found";
         }
     }
+
+    end_section();
+
+    for (const auto& [section_name, section_parser] : section_parsers_) {
+        section_parser->EndFile();
+    }
 }
 
 bool Parser::ParseConfigFileInsecure(const std::string& path) {
@@ -139,21 +154,32 @@ bool Parser::ParseConfigFileInsecure(const std::string& path) {
     return true;
 }
 
-bool Parser::ParseConfigFile(const std::string& path) {
-    LOG(INFO) << "Parsing file " << path << "...";
-    android::base::Timer t;
+Result<Parser::ConfigLines> Parser::ReadConfigFile(const std::string& path) {
     auto config_contents = ReadFile(path);
     if (!config_contents.ok()) {
-        LOG(INFO) << "Unable to read config file '" << path << "': " << config_contents.error();
+        return config_contents.error();
+    }
+    return Tokenize(&config_contents.value());
+}
+
+bool Parser::ParseConfigLines(const std::string& path, Result<ConfigLines>&& lines) {
+    LOG(INFO) << "Parsing file " << path << "...";
+    android::base::Timer t;
+    if (!lines.ok()) {
+        LOG(INFO) << "Unable to read config file '" << path << "': " << lines.error();
         return false;
     }
 
-    ParseData(path, &config_contents.value());
+    ParseLines(path, std::move(*lines));
 
     LOG(VERBOSE) << "(Parsing " << path << " took " << t << ".)";
     return true;
 }
 
+bool Parser::ParseConfigFile(const std::string& path) {
+    return ParseConfigLines(path, ReadConfigFile(path));
+}
+
 bool Parser::ParseConfigDir(const std::string& path) {
     LOG(INFO) << "Parsing directory " << path << "...";
     std::unique_ptr<DIR, decltype(&closedir)> config_dir(opendir(path.c_str()), closedir);
@@ -173,9 +199,32 @@ bool Parser::ParseConfigDir(const std::string& path) {
     }
     // Sort first so we load files in a consistent order (bug 31996208)
     std::sort(files.begin(), files.end());
-    for (const auto& file : files) {
-        if (!ParseConfigFile(file)) {
-            LOG(ERROR) << "could not import file '" << file << "'";
+
+    // Reading and tokenizing the files are independent of each other, so do them on a few
+    // threads. The section parsers are not thread safe and the order of their input matters
+    // (e.g. for 'override'), so the results are still parsed one file at a time, in order.
+    std::vector<std::optional<Result<ConfigLines>>> configs(files.size());
+    std::atomic<size_t> next_file = 0;
+    auto read_config_files = [&] {
+        for (size_t i = next_file++; i < files.size(); i = next_file++) {
+            configs[i] = ReadConfigFile(files[i]);
+        }
+    };
+
+    size_t num_threads = std::min({files.size(), kMaxConfigReaderThreads,
+                                   std::max<size_t>(std::thread::hardware_concurrency(), 1)});
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+        threads.emplace_back(read_config_files);
+    }
+    read_config_files();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!ParseConfigLines(files[i], std::move(*configs[i]))) {
+            LOG(ERROR) << "could not import file '" << files[i] << "'";
         }
     }
     return true;
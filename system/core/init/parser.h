@@ -82,7 +82,14 @@ class Parser {
     size_t parse_error_count() const { return parse_error_count_; }
 
   private:
+    // The tokens of each non-empty line of a config file, along with its line number.
+    using ConfigLines = std::vector<std::pair<int, std::vector<std::string>>>;
+
+    static ConfigLines Tokenize(std::string* data);
+    static Result<ConfigLines> ReadConfigFile(const std::string& path);
     void ParseData(const std::string& filename, std::string* data);
+    void ParseLines(const std::string& filename, ConfigLines&& lines);
+    bool ParseConfigLines(const std::string& path, Result<ConfigLines>&& lines);
     bool ParseConfigDir(const std::string& path);
 
     std::map<std::string, std::unique_ptr<SectionParser>> section_parsers_;
@@ -44,6 +44,7 @@
 #include <ApexProperties.sysprop.h>
 #include <android/api-level.h>
 
+#include "bootchart.h"
 #include "mount_namespace.h"
 #include "selinux.h"
 #else
@@ -291,6 +292,10 @@ void Service::Reap(const siginfo_t& siginfo) {
     flags_ &= (~SVC_RUNNING);
     start_order_ = 0;
 
+    // Services waiting for this one to exit or restart may start now.
+    auto start_waiting_services =
+            make_scope_guard([] { ServiceList::GetInstance().StartWaitingServices(); });
+
     // Oneshot processes go into the disabled state on exit,
     // except when manually restarted.
     if ((flags_ & SVC_ONESHOT) && !(flags_ & SVC_RESTART) && !(flags_ & SVC_RESET)) {
@@ -378,6 +383,13 @@ Result<void> Service::ExecStart() {
         return result;
     }
 
+    if (flags_ & SVC_WAITING) {
+        // Nothing is left to block on, so don't leave the service to start later either.
+        flags_ &= ~SVC_WAITING;
+        return Error() << "Cannot exec_start service '" << name_
+                       << "' before the services it starts after are ready";
+    }
+
     flags_ |= SVC_EXEC;
     is_exec_service_running_ = true;
 
@@ -397,6 +409,7 @@ Result<void> Service::Start() {
     });
 
     if (is_updatable() && !ServiceList::GetInstance().IsServicesUpdated()) {
+        flags_ &= ~SVC_WAITING;
         ServiceList::GetInstance().DelayService(*this);
         return Error() << "Cannot start an updatable service '" << name_
                        << "' before configs from APEXes are all loaded. "
@@ -406,7 +419,7 @@ Result<void> Service::Start() {
     bool disabled = (flags_ & (SVC_DISABLED | SVC_RESET));
     // Starting a service removes it from the disabled or reset state and
     // immediately takes it out of the restarting state if it was in there.
-    flags_ &= (~(SVC_DISABLED|SVC_RESTARTING|SVC_RESET|SVC_RESTART|SVC_DISABLED_START));
+    flags_ &= (~(SVC_DISABLED|SVC_RESTARTING|SVC_RESET|SVC_RESTART|SVC_DISABLED_START|SVC_WAITING));
 
     // Running processes require no additional work --- if they're in the
     // process of exiting, we've ensured that they will immediately restart
@@ -422,6 +435,21 @@ Result<void> Service::Start() {
         return {};
     }
 
+    if (!after_.empty() || !needs_.empty()) {
+        auto ready = ServiceList::GetInstance().CheckDependencies(*this);
+        if (!ready.ok()) {
+            return ready.error();
+        }
+        if (!*ready) {
+            // ServiceList::StartWaitingServices() tries again whenever another service starts
+            // or exits.
+            LOG(INFO) << "service '" << name_ << "' is waiting for the services it starts after";
+            flags_ |= SVC_WAITING;
+            reboot_on_failure.Disable();
+            return {};
+        }
+    }
+
     bool needs_console = (flags_ & SVC_CONSOLE);
     if (needs_console) {
         if (proc_attr_.console.empty()) {
@@ -546,6 +574,8 @@ Result<void> Service::Start() {
     start_order_ = next_start_order_++;
     process_cgroup_empty_ = false;
 
+    BootchartLogServiceStart(name_, pid_, time_started_);
+
     bool use_memcg = swappiness_ != -1 || soft_limit_in_bytes_ != -1 || limit_in_bytes_ != -1 ||
                       limit_percent_ != -1 || !limit_property_.empty();
     errno = -createProcessGroup(proc_attr_.uid, pid_, use_memcg);
@@ -599,6 +629,9 @@ Result<void> Service::Start() {
 
     NotifyStateChange("running");
     reboot_on_failure.Disable();
+
+    // Services waiting for this one to be running may start now.
+    ServiceList::GetInstance().StartWaitingServices();
     return {};
 }
 
@@ -647,7 +680,7 @@ void Service::Stop() {
 }
 
 void Service::Terminate() {
-    flags_ &= ~(SVC_RESTARTING | SVC_DISABLED_START);
+    flags_ &= ~(SVC_RESTARTING | SVC_DISABLED_START | SVC_WAITING);
     flags_ |= SVC_DISABLED;
     if (pid_) {
         KillProcessGroup(SIGTERM);
@@ -682,8 +715,9 @@ void Service::Restart() {
 // The how field should be either SVC_DISABLED, SVC_RESET, or SVC_RESTART.
 void Service::StopOrReset(int how) {
     // The service is still SVC_RUNNING until its process exits, but if it has
-    // already exited it shoudn't attempt a restart yet.
-    flags_ &= ~(SVC_RESTARTING | SVC_DISABLED_START);
+    // already exited it shoudn't attempt a restart yet. Nor should it start once
+    // what it was waiting for is ready.
+    flags_ &= ~(SVC_RESTARTING | SVC_DISABLED_START | SVC_WAITING);
 
     if ((how != SVC_DISABLED) && (how != SVC_RESET) && (how != SVC_RESTART)) {
         // An illegal flag: default to SVC_DISABLED.
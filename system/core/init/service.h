@@ -54,6 +54,8 @@
                                      // should not be killed during shutdown
 #define SVC_TEMPORARY 0x1000  // This service was started by 'exec' and should be removed from the
                               // service list once it is reaped.
+#define SVC_WAITING 0x2000  // A start was requested, but the services it starts 'after' or
+                            // 'needs' are not ready yet.
 
 #define NR_SVC_SUPP_GIDS 12    // twelve supplementary groups
 
@@ -92,6 +94,11 @@ class Service {
     void DumpState() const;
     void SetShutdownCritical() { flags_ |= SVC_SHUTDOWN_CRITICAL; }
     bool IsShutdownCritical() const { return (flags_ & SVC_SHUTDOWN_CRITICAL) != 0; }
+    // Marks a service about to be started with others, so that those ordered after it wait for
+    // it even when they are started first.
+    void SetWaitingToStart() {
+        if (!(flags_ & (SVC_DISABLED | SVC_RUNNING))) flags_ |= SVC_WAITING;
+    }
     void UnSetExec() {
         is_exec_service_running_ = false;
         flags_ &= ~SVC_EXEC;
@@ -118,6 +125,8 @@ class Service {
     IoSchedClass ioprio_class() const { return proc_attr_.ioprio_class; }
     int ioprio_pri() const { return proc_attr_.ioprio_pri; }
     const std::set<std::string>& interfaces() const { return interfaces_; }
+    const std::vector<std::string>& after() const { return after_; }
+    const std::vector<std::string>& needs() const { return needs_; }
     int priority() const { return proc_attr_.priority; }
     int oom_score_adjust() const { return oom_score_adjust_; }
     bool is_override() const { return override_; }
@@ -174,6 +183,9 @@ class Service {
 
     std::set<std::string> interfaces_;  // e.g. some.package.foo@1.0::IBaz/instance-name
 
+    std::vector<std::string> after_;  // services to wait for, if they are being started
+    std::vector<std::string> needs_;  // services to start and wait for
+
     // keycodes for triggering this service via /dev/input/input*
     std::vector<int> keycodes_;
 
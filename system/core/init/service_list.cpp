@@ -102,5 +102,102 @@ void ServiceList::DelayService(const Service& service) {
     delayed_service_names_.emplace_back(service.name());
 }
 
+// Whether a service ordered after |dependency| has to wait for it.
+static bool IsStarting(const Service& dependency) {
+    if (dependency.flags() & (SVC_WAITING | SVC_RESTARTING)) return true;
+    return (dependency.flags() & SVC_ONESHOT) && (dependency.flags() & SVC_RUNNING);
+}
+
+Result<bool> ServiceList::CheckDependencies(const Service& service) {
+    for (const auto& name : service.needs()) {
+        Service* needed = FindService(name);
+        if (needed == nullptr) {
+            return Error() << "needs unknown service '" << name << "'";
+        }
+        // Don't rerun a oneshot service that has already run.
+        bool has_run = (needed->flags() & SVC_ONESHOT) &&
+                       needed->time_started() != android::base::boot_clock::time_point();
+        if (needed->IsRunning() || IsStarting(*needed) || has_run) continue;
+
+        if (auto result = needed->Start(); !result.ok()) {
+            return Error() << "needed service '" << name << "' failed to start: " << result.error();
+        }
+    }
+
+    bool ready = true;
+    for (const auto* names : {&service.after(), &service.needs()}) {
+        for (const auto& name : *names) {
+            Service* dependency = FindService(name);
+            if (dependency == nullptr || !IsStarting(*dependency)) continue;
+
+            std::set<const Service*> visited;
+            if (WaitsFor(*dependency, service, &visited)) {
+                LOG(WARNING) << "Service '" << service.name() << "' and '" << name
+                             << "' wait for each other, not waiting for '" << name << "'";
+                continue;
+            }
+            ready = false;
+        }
+    }
+    return ready;
+}
+
+bool ServiceList::WaitsFor(const Service& service, const Service& target,
+                           std::set<const Service*>* visited) const {
+    // Only a service that is itself waiting is held up by its dependencies.
+    if (!(service.flags() & SVC_WAITING)) return false;
+    if (!visited->emplace(&service).second) return false;
+
+    for (const auto* names : {&service.after(), &service.needs()}) {
+        for (const auto& name : *names) {
+            Service* dependency = FindService(name);
+            if (dependency == &target) return true;
+            if (dependency != nullptr && IsStarting(*dependency) &&
+                WaitsFor(*dependency, target, visited)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ServiceList::StartWaitingServices() {
+    if (starting_class_) {
+        start_waiting_services_after_class_ = true;
+        return;
+    }
+
+    // Every service that starts calls back in here; rather than recursing, have the outermost call
+    // go over the list again.
+    if (starting_waiting_services_) {
+        start_waiting_services_again_ = true;
+        return;
+    }
+
+    starting_waiting_services_ = true;
+    do {
+        start_waiting_services_again_ = false;
+        for (size_t i = 0; i < services_.size(); ++i) {
+            Service* service = services_[i].get();
+            if (!(service->flags() & SVC_WAITING)) continue;
+
+            if (auto result = service->Start(); !result.ok()) {
+                LOG(ERROR) << "Could not start service '" << service->name()
+                           << "' after waiting for its dependencies: " << result.error();
+            }
+        }
+    } while (start_waiting_services_again_);
+    starting_waiting_services_ = false;
+}
+
+void ServiceList::EndClassStart() {
+    starting_class_ = false;
+    // Some of the services of the class started, so the ones waiting for them may start now.
+    if (start_waiting_services_after_class_) {
+        start_waiting_services_after_class_ = false;
+        StartWaitingServices();
+    }
+}
+
 }  // namespace init
 }  // namespace android
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <memory>
+#include <set>
 #include <vector>
 
 #include "service.h"
@@ -74,6 +75,19 @@ class ServiceList {
     void MarkServicesUpdate();
     bool IsServicesUpdated() const { return services_update_finished_; }
     void DelayService(const Service& service);
+    const std::vector<std::string>& delayed_service_names() const { return delayed_service_names_; }
+
+    // Starts the services |service| needs that are not started yet, and returns whether all of
+    // the services it starts after are ready, i.e. neither waiting to start, restarting nor, for
+    // oneshot services, still running.
+    Result<bool> CheckDependencies(const Service& service);
+    // Starts the services that were waiting for others and no longer have to. While a class is
+    // being started, this is left until the whole class has been.
+    void StartWaitingServices();
+    // class_start marks every service of the class as waiting, but starts each of them itself,
+    // so none of them is started, or fails to start, twice.
+    void BeginClassStart() { starting_class_ = true; }
+    void EndClassStart();
 
     void ResetState() {
         post_data_ = false;
@@ -81,11 +95,18 @@ class ServiceList {
     }
 
   private:
+    bool WaitsFor(const Service& service, const Service& target,
+                  std::set<const Service*>* visited) const;
+
     std::vector<std::unique_ptr<Service>> services_;
 
     bool post_data_ = false;
     bool services_update_finished_ = false;
     std::vector<std::string> delayed_service_names_;
+    bool starting_waiting_services_ = false;
+    bool start_waiting_services_again_ = false;
+    bool starting_class_ = false;
+    bool start_waiting_services_after_class_ = false;
 };
 
 }  // namespace init
@@ -50,6 +50,16 @@ using android::base::StartsWith;
 namespace android {
 namespace init {
 
+Result<void> ServiceParser::ParseAfter(std::vector<std::string>&& args) {
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == service_->name_) {
+            return Error() << "service cannot start after itself";
+        }
+        service_->after_.emplace_back(args[i]);
+    }
+    return {};
+}
+
 Result<void> ServiceParser::ParseCapabilities(std::vector<std::string>&& args) {
     service_->capabilities_ = 0;
 
@@ -232,6 +242,16 @@ Result<void> ServiceParser::ParseKeycodes(std::vector<std::string>&& args) {
     return {};
 }
 
+Result<void> ServiceParser::ParseNeeds(std::vector<std::string>&& args) {
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == service_->name_) {
+            return Error() << "service cannot need itself";
+        }
+        service_->needs_.emplace_back(args[i]);
+    }
+    return {};
+}
+
 Result<void> ServiceParser::ParseOneshot(std::vector<std::string>&& args) {
     service_->flags_ |= SVC_ONESHOT;
     return {};
@@ -503,6 +523,7 @@ const KeywordMap<ServiceParser::OptionParser>& ServiceParser::GetParserMap() con
     constexpr std::size_t kMax = std::numeric_limits<std::size_t>::max();
     // clang-format off
     static const KeywordMap<ServiceParser::OptionParser> parser_map = {
+        {"after",                   {1,     kMax, &ServiceParser::ParseAfter}},
         {"capabilities",            {0,     kMax, &ServiceParser::ParseCapabilities}},
         {"class",                   {1,     kMax, &ServiceParser::ParseClass}},
         {"console",                 {0,     1,    &ServiceParser::ParseConsole}},
@@ -521,6 +542,7 @@ const KeywordMap<ServiceParser::OptionParser>& ServiceParser::GetParserMap() con
                                     {1,     1,    &ServiceParser::ParseMemcgSoftLimitInBytes}},
         {"memcg.swappiness",        {1,     1,    &ServiceParser::ParseMemcgSwappiness}},
         {"namespace",               {1,     2,    &ServiceParser::ParseNamespace}},
+        {"needs",                   {1,     kMax, &ServiceParser::ParseNeeds}},
         {"oneshot",                 {0,     0,    &ServiceParser::ParseOneshot}},
         {"onrestart",               {1,     kMax, &ServiceParser::ParseOnrestart}},
         {"oom_score_adjust",        {1,     1,    &ServiceParser::ParseOomScoreAdjust}},
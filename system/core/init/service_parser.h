@@ -48,6 +48,7 @@ class ServiceParser : public SectionParser {
     using OptionParser = Result<void> (ServiceParser::*)(std::vector<std::string>&& args);
     const KeywordMap<ServiceParser::OptionParser>& GetParserMap() const;
 
+    Result<void> ParseAfter(std::vector<std::string>&& args);
     Result<void> ParseCapabilities(std::vector<std::string>&& args);
     Result<void> ParseClass(std::vector<std::string>&& args);
     Result<void> ParseConsole(std::vector<std::string>&& args);
@@ -59,6 +60,7 @@ class ServiceParser : public SectionParser {
     Result<void> ParseInterface(std::vector<std::string>&& args);
     Result<void> ParseIoprio(std::vector<std::string>&& args);
     Result<void> ParseKeycodes(std::vector<std::string>&& args);
+    Result<void> ParseNeeds(std::vector<std::string>&& args);
     Result<void> ParseOneshot(std::vector<std::string>&& args);
     Result<void> ParseOnrestart(std::vector<std::string>&& args);
     Result<void> ParseOomScoreAdjust(std::vector<std::string>&& args);
@@ -52,6 +52,19 @@ typedef struct __attribute__((__packed__)) {
   log_time realtime;
 } android_log_header_t;
 
+/*
+ * A batch of log entries to logd is a single datagram that starts with an
+ * android_log_header_t whose id is LOG_ID_BATCH, followed by entries that each
+ * consist of an android_log_batch_entry_t and len bytes of payload.
+ */
+#define LOG_ID_BATCH 0xff
+
+/* Entry Header Structure within a batch to logd */
+typedef struct __attribute__((__packed__)) {
+  uint16_t len;
+  android_log_header_t header;
+} android_log_batch_entry_t;
+
 /* Event Header Structure to logd */
 typedef struct __attribute__((__packed__)) {
   int32_t tag;  // Little Endian Order
@@ -144,6 +157,19 @@ int __android_log_security_bwrite(int32_t tag, const void* payload, size_t len);
 int __android_log_security_bswrite(int32_t tag, const char* payload);
 int __android_log_security(); /* Device Owner is present */
 
+/*
+ * Buffer log messages in the process and send them to logd in batches, once
+ * max_bytes are pending or the oldest pending message is max_delay_ms old.
+ * Security and crash messages are never delayed. Pending messages are also
+ * sent on a FATAL message, at exit, and on fatal signals, before the signal
+ * handlers that were in place when batching was first turned on. A max_bytes
+ * of 0 sends any pending messages and turns batching off again. The child of a
+ * fork() does not batch until this is called again.
+ */
+int __android_log_set_batching(size_t max_bytes, uint32_t max_delay_ms);
+/* Send any log messages that batching is holding back. */
+void __android_log_flush();
+
 #define BOOL_DEFAULT_FLAG_TRUE_FALSE 0x1
 #define BOOL_DEFAULT_FALSE 0x0        /* false if property not present   */
 #define BOOL_DEFAULT_TRUE 0x1         /* true if property not present    */
@@ -159,6 +185,18 @@ bool __android_logger_property_get_bool(const char* key, int flag);
 unsigned long __android_logger_get_buffer_size(log_id_t logId);
 bool __android_logger_valid_buffer_size(unsigned long value);
 
+/*
+ * Filters that logd applies before it sends entries to a reader, in addition
+ * to the pid the list was allocated with. filterspec uses the syntax of the
+ * logcat filterspecs, and text only matches the message of text entries.
+ * These must be set before the first read from the list.
+ */
+int android_logger_list_set_filter(struct logger_list* logger_list,
+                                   const char* filterspec);
+int android_logger_list_set_uid(struct logger_list* logger_list, uid_t uid);
+int android_logger_list_set_grep(struct logger_list* logger_list,
+                                 const char* text);
+
 /* Retrieve the composed event buffer */
 int android_log_write_list_buffer(android_log_context ctx, const char** msg);
 
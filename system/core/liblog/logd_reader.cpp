@@ -260,7 +260,7 @@ int android_logger_set_prune_list(struct logger_list* logger_list, const char* b
 }
 
 static int logdOpen(struct logger_list* logger_list) {
-  char buffer[256], *cp, c;
+  char buffer[1024], *cp, c;
   int ret, remaining, sock;
 
   sock = atomic_load(&logger_list->fd);
@@ -319,6 +319,28 @@ static int logdOpen(struct logger_list* logger_list) {
   if (logger_list->pid) {
     ret = snprintf(cp, remaining, " pid=%u", logger_list->pid);
     ret = MIN(ret, remaining);
+    remaining -= ret;
+    cp += ret;
+  }
+
+  if (logger_list->filter_uid) {
+    ret = snprintf(cp, remaining, " uids=%u", logger_list->uid);
+    ret = MIN(ret, remaining);
+    remaining -= ret;
+    cp += ret;
+  }
+
+  if (logger_list->filter) {
+    ret = snprintf(cp, remaining, " filter=%s", logger_list->filter);
+    ret = MIN(ret, remaining);
+    remaining -= ret;
+    cp += ret;
+  }
+
+  // logd takes everything after grep= as the text, so it must come last.
+  if (logger_list->grep) {
+    ret = snprintf(cp, remaining, " grep=%s", logger_list->grep);
+    ret = MIN(ret, remaining);
     cp += ret;
   }
 
@@ -20,6 +20,8 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <poll.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdatomic.h>
 #include <stdio.h>
@@ -27,11 +29,16 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/un.h>
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+
+#include <android-base/errno_restorer.h>
+#include <android-base/macros.h>
 #include <private/android_filesystem_config.h>
 #include <private/android_logger.h>
 
@@ -39,6 +46,34 @@
 #include "uio.h"
 
 static atomic_int logd_socket;
+static atomic_int dropped;
+static atomic_int droppedSecurity;
+
+// Log entries held back once batching is turned on with LogdSetBatching().  batch_buffer starts
+// with the android_log_header_t of the batch and is sized so that logd receives it in one read.
+static pthread_mutex_t batch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t batch_cond;
+static char batch_buffer[sizeof(android_log_header_t) + LOGGER_ENTRY_MAX_PAYLOAD];
+static size_t batch_size = sizeof(android_log_header_t);
+static size_t batch_count;
+static struct timespec batch_deadline;
+static size_t batch_max_bytes;
+static uint32_t batch_max_delay_ms;
+static bool batch_flusher_started;
+static atomic_bool batch_enabled;
+// The thread holding batch_lock.  A signal handler that logs on that thread writes directly
+// instead of deadlocking.  This cannot be thread_local since the linker links liblog statically.
+static atomic_int batch_lock_owner;
+// The fatal signals on which the pending entries are sent before the process dies, and the
+// actions that were in place before batching was first turned on.
+static const int kBatchFlushSignals[] = {
+    SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV,
+#if defined(SIGSTKFLT)
+    SIGSTKFLT,
+#endif
+    SIGSYS,  SIGTRAP,
+};
+static struct sigaction batch_previous_actions[arraysize(kBatchFlushSignals)];
 
 // Note that it is safe to call connect() multiple times on DGRAM Unix domain sockets, so this
 // function is used to reconnect to logd without requiring a new socket.
@@ -85,14 +120,275 @@ void LogdClose() {
   logd_socket = 0;
 }
 
+// The write below could be lost, but will never block.
+// EAGAIN occurs if logd is overloaded, other errors indicate that something went wrong with
+// the connection, so we reset it and try again.
+static ssize_t LogdSend(struct iovec* vec, size_t nr) {
+  ssize_t ret = TEMP_FAILURE_RETRY(writev(logd_socket, vec, nr));
+  if (ret < 0 && errno != EAGAIN) {
+    LogdConnect();
+
+    ret = TEMP_FAILURE_RETRY(writev(logd_socket, vec, nr));
+  }
+
+  if (ret < 0) {
+    ret = -errno;
+  }
+  return ret;
+}
+
+// Returns false without locking if the calling thread already holds batch_lock.
+static bool BatchLock() {
+  pid_t tid = gettid();
+  if (batch_lock_owner == tid) {
+    return false;
+  }
+  pthread_mutex_lock(&batch_lock);
+  batch_lock_owner = tid;
+  return true;
+}
+
+static void BatchUnlock() {
+  batch_lock_owner = 0;
+  pthread_mutex_unlock(&batch_lock);
+}
+
+// Sends the entries pending in batch_buffer as one datagram, and leaves them there.  Only uses
+// async-signal-safe calls.  Must be called with batch_lock held.
+static void SendBatchLocked() {
+  android_log_header_t* header = reinterpret_cast<android_log_header_t*>(batch_buffer);
+  header->id = LOG_ID_BATCH;
+  header->tid = gettid();
+  header->realtime.tv_sec = 0;
+  header->realtime.tv_nsec = 0;
+
+  ssize_t ret = -EBADF;
+  if (logd_socket > 0) {
+    struct iovec vec = {batch_buffer, batch_size};
+    ret = LogdSend(&vec, 1);
+  }
+  if (ret < 0) {
+    atomic_fetch_add_explicit(&dropped, batch_count, memory_order_relaxed);
+  }
+}
+
+// Sends all pending entries as one datagram.  Must be called with batch_lock held.
+static void FlushBatchLocked() {
+  if (batch_count == 0) {
+    return;
+  }
+
+  SendBatchLocked();
+  batch_size = sizeof(android_log_header_t);
+  batch_count = 0;
+}
+
+// Sends the pending entries from a signal handler without blocking.  If the interrupted code on
+// this thread holds batch_lock, the batch is sent but left as it is: an entry is only added to
+// batch_size once it is fully copied, so the entries up to there are complete.  If another thread
+// holds batch_lock for more than a few milliseconds, the entries are lost.
+static void FlushBatchFromSignal() {
+  if (!batch_enabled) {
+    return;
+  }
+
+  pid_t tid = gettid();
+  if (batch_lock_owner == tid) {
+    if (batch_size > sizeof(android_log_header_t)) {
+      SendBatchLocked();
+    }
+    return;
+  }
+  for (int tries = 0; pthread_mutex_trylock(&batch_lock) != 0; ++tries) {
+    if (tries == 10) {
+      return;
+    }
+    struct timespec delay = {0, 1000000};
+    nanosleep(&delay, nullptr);
+  }
+  batch_lock_owner = tid;
+  FlushBatchLocked();
+  BatchUnlock();
+}
+
+static void BatchFlushSignalHandler(int signal, siginfo_t* info, void* context) {
+  {
+    android::base::ErrnoRestorer errno_restorer;
+    FlushBatchFromSignal();
+  }
+
+  const struct sigaction* previous = nullptr;
+  for (size_t i = 0; i < arraysize(kBatchFlushSignals); ++i) {
+    if (kBatchFlushSignals[i] == signal) {
+      previous = &batch_previous_actions[i];
+    }
+  }
+  if (previous->sa_flags & SA_SIGINFO) {
+    previous->sa_sigaction(signal, info, context);
+    return;
+  }
+  // Ignored signals that another process sent stay ignored, but faults are fatal regardless.
+  if (previous->sa_handler == SIG_IGN && info->si_code <= 0) {
+    return;
+  }
+  if (previous->sa_handler != SIG_DFL && previous->sa_handler != SIG_IGN) {
+    previous->sa_handler(signal);
+    return;
+  }
+  // Take the default action by sending the signal again, which is delivered once this returns.
+  struct sigaction default_action = {};
+  default_action.sa_handler = SIG_DFL;
+  sigaction(signal, &default_action, nullptr);
+  syscall(__NR_rt_tgsigqueueinfo, getpid(), gettid(), signal, info);
+}
+
+// Runs the handlers that were in place before, after sending the pending entries.
+static void InstallBatchSignalHandlers() {
+  struct sigaction action = {};
+  action.sa_sigaction = BatchFlushSignalHandler;
+  action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  for (size_t i = 0; i < arraysize(kBatchFlushSignals); ++i) {
+    sigaction(kBatchFlushSignals[i], &action, &batch_previous_actions[i]);
+  }
+}
+
+// Sends the pending entries once the oldest of them has waited for batch_max_delay_ms.
+static void* BatchFlushThread(void*) {
+  pthread_setname_np(pthread_self(), "liblog.batch");
+
+  pthread_mutex_lock(&batch_lock);
+  while (true) {
+    int ret = batch_count == 0
+                  ? pthread_cond_wait(&batch_cond, &batch_lock)
+                  : pthread_cond_timedwait(&batch_cond, &batch_lock, &batch_deadline);
+    if (ret == ETIMEDOUT) {
+      batch_lock_owner = gettid();
+      FlushBatchLocked();
+      batch_lock_owner = 0;
+    }
+  }
+  return nullptr;
+}
+
+// The child of a fork has no flusher thread, and its parent still sends the pending entries.
+static void BatchAtForkPrepare() {
+  pthread_mutex_lock(&batch_lock);
+}
+
+static void BatchAtForkParent() {
+  pthread_mutex_unlock(&batch_lock);
+}
+
+static void BatchAtForkChild() {
+  batch_size = sizeof(android_log_header_t);
+  batch_count = 0;
+  batch_flusher_started = false;
+  batch_enabled = false;
+  batch_lock_owner = 0;
+  pthread_mutex_unlock(&batch_lock);
+}
+
+// Must be called with batch_lock held.
+static void StartBatchFlusherLocked() {
+  static bool initialized;
+  if (!initialized) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&batch_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_atfork(BatchAtForkPrepare, BatchAtForkParent, BatchAtForkChild);
+    atexit(LogdFlush);
+    InstallBatchSignalHandlers();
+    initialized = true;
+  }
+  if (batch_flusher_started) {
+    return;
+  }
+
+  pthread_t thread;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  batch_flusher_started = pthread_create(&thread, &attr, BatchFlushThread, nullptr) == 0;
+  pthread_attr_destroy(&attr);
+}
+
+int LogdSetBatching(size_t max_bytes, uint32_t max_delay_ms) {
+  if (!BatchLock()) {
+    return -EDEADLK;
+  }
+  FlushBatchLocked();
+  batch_max_bytes = std::min(max_bytes, sizeof(batch_buffer) - sizeof(android_log_header_t));
+  batch_max_delay_ms = max_delay_ms;
+  if (batch_max_bytes != 0) {
+    StartBatchFlusherLocked();
+  }
+  batch_enabled = batch_max_bytes != 0 && batch_flusher_started;
+  int ret = (batch_enabled || max_bytes == 0) ? 0 : -EAGAIN;
+  BatchUnlock();
+  return ret;
+}
+
+void LogdFlush() {
+  if (!batch_enabled || !BatchLock()) {
+    return;
+  }
+  FlushBatchLocked();
+  BatchUnlock();
+}
+
+// Adds an entry to the pending batch, sending the batch first if the entry does not fit.  Returns
+// false if the entry has to be sent on its own.
+static bool BatchAppend(const android_log_header_t& header, struct iovec* vec, size_t nr,
+                        size_t payloadSize) {
+  if (!BatchLock()) {
+    return false;
+  }
+
+  size_t entrySize = sizeof(android_log_batch_entry_t) + payloadSize;
+  if (batch_max_bytes == 0 || entrySize > batch_max_bytes) {
+    FlushBatchLocked();
+    BatchUnlock();
+    return false;
+  }
+  if (batch_size + entrySize > sizeof(android_log_header_t) + batch_max_bytes) {
+    FlushBatchLocked();
+  }
+
+  android_log_batch_entry_t entry;
+  entry.len = payloadSize;
+  entry.header = header;
+  char* dest = batch_buffer + batch_size;
+  memcpy(dest, &entry, sizeof(entry));
+  dest += sizeof(entry);
+  for (size_t i = 0; i < nr; ++i) {
+    memcpy(dest, vec[i].iov_base, vec[i].iov_len);
+    dest += vec[i].iov_len;
+  }
+  batch_size += entrySize;
+
+  if (batch_count++ == 0) {
+    clock_gettime(CLOCK_MONOTONIC, &batch_deadline);
+    batch_deadline.tv_sec += batch_max_delay_ms / 1000;
+    batch_deadline.tv_nsec += (batch_max_delay_ms % 1000) * 1000000;
+    if (batch_deadline.tv_nsec >= 1000000000) {
+      batch_deadline.tv_sec++;
+      batch_deadline.tv_nsec -= 1000000000;
+    }
+    pthread_cond_signal(&batch_cond);
+  }
+  BatchUnlock();
+  return true;
+}
+
 int LogdWrite(log_id_t logId, struct timespec* ts, struct iovec* vec, size_t nr) {
   ssize_t ret;
   static const unsigned headerLength = 1;
   struct iovec newVec[nr + headerLength];
   android_log_header_t header;
   size_t i, payloadSize;
-  static atomic_int dropped;
-  static atomic_int droppedSecurity;
 
   GetSocket();
 
@@ -167,20 +463,19 @@ int LogdWrite(log_id_t logId, struct timespec* ts, struct iovec* vec, size_t nr)
       break;
     }
   }
-
-  // The write below could be lost, but will never block.
-  // EAGAIN occurs if logd is overloaded, other errors indicate that something went wrong with
-  // the connection, so we reset it and try again.
-  ret = TEMP_FAILURE_RETRY(writev(logd_socket, newVec, i));
-  if (ret < 0 && errno != EAGAIN) {
-    LogdConnect();
-
-    ret = TEMP_FAILURE_RETRY(writev(logd_socket, newVec, i));
+  payloadSize = std::min(payloadSize, static_cast<size_t>(LOGGER_ENTRY_MAX_PAYLOAD));
+
+  // Security and crash messages are never held back.  Anything pending is sent first so the
+  // messages of each thread stay in order.
+  if (batch_enabled) {
+    if (logId != LOG_ID_SECURITY && logId != LOG_ID_CRASH &&
+        BatchAppend(header, &newVec[headerLength], i - headerLength, payloadSize)) {
+      return payloadSize;
+    }
+    LogdFlush();
   }
 
-  if (ret < 0) {
-    ret = -errno;
-  }
+  ret = LogdSend(newVec, i);
 
   if (ret > (ssize_t)sizeof(header)) {
     ret -= sizeof(header);
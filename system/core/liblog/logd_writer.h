@@ -17,8 +17,11 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <android/log.h>
 
 int LogdWrite(log_id_t logId, struct timespec* ts, struct iovec* vec, size_t nr);
 void LogdClose();
+int LogdSetBatching(size_t max_bytes, uint32_t max_delay_ms);
+void LogdFlush();
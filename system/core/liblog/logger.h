@@ -32,6 +32,11 @@ struct logger_list {
   log_time start;
   pid_t pid;
   uint32_t log_mask;
+  // Filters evaluated by logd, see android_logger_list_set_filter().
+  char* filter;
+  char* grep;
+  bool filter_uid;
+  uid_t uid;
 };
 
 // Format for a 'logger' entry: uintptr_t where only the bottom 32 bits are used.
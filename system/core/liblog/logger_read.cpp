@@ -16,6 +16,7 @@
 
 #include "log/log_read.h"
 
+#include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <pthread.h>
@@ -60,6 +61,60 @@ struct logger_list* android_logger_list_alloc_time(int mode, log_time start, pid
   return android_logger_list_alloc_internal(mode, 0, start, pid);
 }
 
+// The filters are sent to logd along with the rest of the reader command, which logd reads into a
+// fixed size buffer.
+static constexpr size_t kMaxFilterLength = 512;
+static constexpr size_t kMaxGrepLength = 256;
+
+int android_logger_list_set_filter(struct logger_list* logger_list, const char* filterspec) {
+  if (!logger_list || !filterspec || atomic_load(&logger_list->fd) != 0) {
+    return -EINVAL;
+  }
+  if (strlen(filterspec) > kMaxFilterLength) {
+    return -E2BIG;
+  }
+
+  // logd expects the rules separated by commas rather than whitespace.
+  char* filter = strdup(filterspec);
+  if (!filter) {
+    return -ENOMEM;
+  }
+  for (char* cp = filter; *cp; ++cp) {
+    if (isspace(*cp)) {
+      *cp = ',';
+    }
+  }
+  free(logger_list->filter);
+  logger_list->filter = filter;
+  return 0;
+}
+
+int android_logger_list_set_uid(struct logger_list* logger_list, uid_t uid) {
+  if (!logger_list || atomic_load(&logger_list->fd) != 0) {
+    return -EINVAL;
+  }
+  logger_list->filter_uid = true;
+  logger_list->uid = uid;
+  return 0;
+}
+
+int android_logger_list_set_grep(struct logger_list* logger_list, const char* text) {
+  if (!logger_list || !text || !*text || atomic_load(&logger_list->fd) != 0) {
+    return -EINVAL;
+  }
+  if (strlen(text) > kMaxGrepLength) {
+    return -E2BIG;
+  }
+
+  char* grep = strdup(text);
+  if (!grep) {
+    return -ENOMEM;
+  }
+  free(logger_list->grep);
+  logger_list->grep = grep;
+  return 0;
+}
+
 /* Open the named log and add it to the logger list */
 struct logger* android_logger_open(struct logger_list* logger_list, log_id_t logId) {
   if (!logger_list || (logId >= LOG_ID_MAX)) {
@@ -145,5 +200,7 @@ void android_logger_list_free(struct logger_list* logger_list) {
   }
 #endif
 
+  free(logger_list->filter);
+  free(logger_list->grep);
   free(logger_list);
 }
@@ -108,6 +108,21 @@ void __android_log_close() {
 #endif
 }
 
+int __android_log_set_batching(size_t max_bytes, uint32_t max_delay_ms) {
+#ifdef __ANDROID__
+  return LogdSetBatching(max_bytes, max_delay_ms);
+#else
+  UNUSED(max_bytes, max_delay_ms);
+  return -ENOTSUP;
+#endif
+}
+
+void __android_log_flush() {
+#ifdef __ANDROID__
+  LogdFlush();
+#endif
+}
+
 #if defined(__GLIBC__) || defined(_WIN32)
 static const char* getprogname() {
 #if defined(__GLIBC__)
@@ -167,6 +182,7 @@ void __android_log_set_logger(__android_logger_function logger) {
 void __android_log_default_aborter(const char* abort_message) {
 #ifdef __ANDROID__
   android_set_abort_message(abort_message);
+  LogdFlush();
 #else
   UNUSED(abort_message);
 #endif
@@ -312,6 +328,13 @@ void __android_log_write_log_message(__android_log_message* log_message) {
 #endif
 
   logger_function(log_message);
+
+#ifdef __ANDROID__
+  // Do not hold back the messages that led up to an abort.
+  if (log_message->priority == ANDROID_LOG_FATAL) {
+    LogdFlush();
+  }
+#endif
 }
 
 int __android_log_buf_write(int bufID, int prio, const char* tag, const char* msg) {
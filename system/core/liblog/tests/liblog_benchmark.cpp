@@ -73,6 +73,22 @@ static void BM_log_maximum(benchmark::State& state) {
 }
 BENCHMARK(BM_log_maximum);
 
+/*
+ *	Measure the fastest rate we can stuff print messages into the log
+ * at high pressure, with the messages sent to logd in batches of up to
+ * the given number of bytes. 0 is the same as BM_log_maximum.
+ */
+static void BM_log_maximum_batched(benchmark::State& state) {
+  __android_log_set_batching(state.range(0), 100);
+  while (state.KeepRunning()) {
+    __android_log_print(ANDROID_LOG_INFO, "BM_log_maximum_batched", "%" PRIu64,
+                        state.iterations());
+  }
+  __android_log_set_batching(0, 0);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_log_maximum_batched)->Arg(0)->Arg(1024)->Arg(LOGGER_ENTRY_MAX_PAYLOAD);
+
 /*
  *	Measure the time it takes to collect the time using
  * discrete acquisition (state.PauseTiming() to state.ResumeTiming())
@@ -23,8 +23,10 @@
 #include <semaphore.h>
 #include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include <memory>
@@ -330,6 +332,96 @@ TEST(liblog, __android_log_write__android_logger_list_read) {
 #endif
 }
 
+TEST(liblog, __android_log_set_batching) {
+#ifdef __ANDROID__
+  pid_t pid = getpid();
+  static const char tag[] = "liblog.__android_log_set_batching";
+  static const size_t kMessages = 100;
+
+  auto logger_list = std::unique_ptr<struct logger_list, ListCloser>{
+      android_logger_list_open(LOG_ID_MAIN, ANDROID_LOG_RDONLY, 1000, pid)};
+  ASSERT_TRUE(logger_list);
+
+  // Hold messages back for longer than the test takes, so only a full batch or a flush sends
+  // them to logd.
+  ASSERT_EQ(0, __android_log_set_batching(LOGGER_ENTRY_MAX_PAYLOAD, 60 * 1000));
+  auto batching_guard = make_scope_guard([] { __android_log_set_batching(0, 0); });
+  for (size_t i = 0; i < kMessages; ++i) {
+    ASSERT_LT(0, __android_log_print(ANDROID_LOG_INFO, tag, "%zu", i));
+  }
+  __android_log_flush();
+
+  // The messages arrive in the order they were logged, with their own timestamps.
+  alarm(2);
+  auto alarm_guard = make_scope_guard([] { alarm(0); });
+  size_t next = 0;
+  log_time last_time;
+  while (next < kMessages) {
+    log_msg log_msg;
+    ASSERT_GT(android_logger_list_read(logger_list.get(), &log_msg), 0);
+    ASSERT_EQ(LOG_ID_MAIN, log_msg.id());
+    ASSERT_EQ(pid, log_msg.entry.pid);
+
+    std::string expected_message = std::string(1, ANDROID_LOG_INFO) + tag + std::string("", 1) +
+                                   std::to_string(next) + std::string("", 1);
+    if (expected_message != std::string(log_msg.msg(), log_msg.entry.len)) {
+      continue;
+    }
+
+    log_time time(log_msg.entry.sec, log_msg.entry.nsec);
+    if (next > 0) {
+      EXPECT_LE(last_time, time);
+    }
+    last_time = time;
+    ++next;
+  }
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(liblog, __android_log_set_batching_fatal_signal) {
+#ifdef __ANDROID__
+  static const char tag[] = "liblog.__android_log_set_batching_fatal_signal";
+
+  // The child holds its message back for longer than the test takes, and then crashes.
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    if (__android_log_set_batching(LOGGER_ENTRY_MAX_PAYLOAD, 60 * 1000) != 0 ||
+        __android_log_write(ANDROID_LOG_INFO, tag, "before the crash") <= 0) {
+      _exit(EXIT_FAILURE);
+    }
+    raise(SIGSEGV);
+    _exit(EXIT_SUCCESS);
+  }
+  int status;
+  ASSERT_EQ(pid, TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)));
+  ASSERT_TRUE(WIFSIGNALED(status)) << status;
+  EXPECT_EQ(SIGSEGV, WTERMSIG(status));
+
+  // The handler of the signal sent the message before the process died.
+  auto logger_list = std::unique_ptr<struct logger_list, ListCloser>{
+      android_logger_list_open(LOG_ID_MAIN, ANDROID_LOG_RDONLY | ANDROID_LOG_NONBLOCK, 1000, pid)};
+  ASSERT_TRUE(logger_list);
+  std::string expected_message = std::string(1, ANDROID_LOG_INFO) + tag + std::string("", 1) +
+                                 "before the crash" + std::string("", 1);
+  bool found = false;
+  while (!found) {
+    log_msg log_msg;
+    int ret = android_logger_list_read(logger_list.get(), &log_msg);
+    if (ret == -EAGAIN) {
+      break;
+    }
+    ASSERT_GT(ret, 0);
+    found = expected_message == std::string(log_msg.msg(), log_msg.entry.len);
+  }
+  EXPECT_TRUE(found);
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 static void bswrite_test(const char* message) {
 #ifdef __ANDROID__
   pid_t pid = getpid();
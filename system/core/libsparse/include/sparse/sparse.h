@@ -167,6 +167,22 @@ int sparse_file_add_fd(struct sparse_file *s,
 int sparse_file_write(struct sparse_file *s, int fd, bool gz, bool sparse,
 		bool crc);
 
+/**
+ * sparse_file_write_parallel - expand a sparse file into a file using threads
+ *
+ * @s - sparse file cookie
+ * @fd - file descriptor to write to, must support pwrite
+ * @threads - number of worker threads, or 0 to use one per CPU
+ *
+ * Writes the same output as sparse_file_write() with gz, sparse and crc all
+ * false, but since every chunk of an expanded file has a fixed offset, the
+ * chunks are read and written concurrently.  Chunks are written at their
+ * offset from the start of the file, not from the current file position.
+ *
+ * Returns 0 on success, negative errno on error.
+ */
+int sparse_file_write_parallel(struct sparse_file *s, int fd, unsigned int threads);
+
 /**
  * sparse_file_len - return the length of a sparse file if written to disk
  *
@@ -245,6 +261,24 @@ int sparse_file_foreach_chunk(struct sparse_file *s, bool sparse, bool crc,
  */
 int sparse_file_read(struct sparse_file *s, int fd, bool sparse, bool crc);
 
+/**
+ * sparse_file_read_parallel - read a raw file into a sparse file cookie using threads
+ *
+ * @s - sparse file cookie
+ * @fd - file descriptor to read from
+ * @threads - number of worker threads, or 0 to use one per CPU
+ *
+ * Behaves like sparse_file_read() with sparse and crc false: blocks that
+ * repeat a single 32-bit value become fill chunks, the rest reference @fd.
+ * Blocks are classified concurrently and then added to the cookie in order,
+ * so the result is identical to the serial reader.  Blocks the filesystem
+ * reports as holes are added as zero fills without being read.  Falls back to
+ * the serial reader if @fd is not seekable.
+ *
+ * Returns 0 on success, negative errno on error.
+ */
+int sparse_file_read_parallel(struct sparse_file *s, int fd, unsigned int threads);
+
 /**
  * sparse_file_read_buf - read a buffer into a sparse file cookie
  *
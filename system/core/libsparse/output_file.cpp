@@ -334,6 +334,11 @@ static int write_sparse_skip_chunk(struct output_file* out, int64_t skip_len) {
   ret = out->ops->write(out, &chunk_header, sizeof(chunk_header));
   if (ret < 0) return -1;
 
+  /* The reader counts don't care blocks as zeros in the image crc. */
+  if (out->use_crc) {
+    out->crc32 = sparse_crc32_fill(out->crc32, 0, skip_len);
+  }
+
   out->cur_out_ptr += skip_len;
   out->chunk_cnt++;
 
@@ -342,7 +347,7 @@ static int write_sparse_skip_chunk(struct output_file* out, int64_t skip_len) {
 
 static int write_sparse_fill_chunk(struct output_file* out, unsigned int len, uint32_t fill_val) {
   chunk_header_t chunk_header;
-  int rnd_up_len, count;
+  int rnd_up_len;
   int ret;
 
   /* Round up the fill length to a multiple of the block size */
@@ -360,8 +365,7 @@ static int write_sparse_fill_chunk(struct output_file* out, unsigned int len, ui
   if (ret < 0) return -1;
 
   if (out->use_crc) {
-    count = out->block_size / sizeof(uint32_t);
-    while (count--) out->crc32 = sparse_crc32(out->crc32, &fill_val, sizeof(uint32_t));
+    out->crc32 = sparse_crc32_fill(out->crc32, fill_val, rnd_up_len);
   }
 
   out->cur_out_ptr += rnd_up_len;
@@ -14,9 +14,21 @@
  * limitations under the License.
  */
 
+#define _FILE_OFFSET_BITS 64
+#define _LARGEFILE64_SOURCE 1
+
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
+#include <android-base/macros.h>
 #include <sparse/sparse.h>
 
 #include "defs.h"
@@ -165,6 +177,142 @@ int sparse_file_write(struct sparse_file* s, int fd, bool gz, bool sparse, bool
   return ret;
 }
 
+#ifndef _WIN32
+/* Largest piece of a chunk a worker reads or writes at a time. */
+static constexpr unsigned int PARALLEL_WRITE_BUF_SIZE = 1024 * 1024;
+
+static int pwrite_all(int fd, const void* buf, size_t len, int64_t offset) {
+  const char* ptr = reinterpret_cast<const char*>(buf);
+
+  while (len > 0) {
+    ssize_t ret = TEMP_FAILURE_RETRY(pwrite(fd, ptr, len, offset));
+    if (ret < 0) return -errno;
+    ptr += ret;
+    len -= ret;
+    offset += ret;
+  }
+
+  return 0;
+}
+
+static int copy_range(int in_fd, int64_t in_offset, int out_fd, int64_t out_offset,
+                      unsigned int len, char* buf) {
+  while (len > 0) {
+    unsigned int chunk = std::min(len, PARALLEL_WRITE_BUF_SIZE);
+    ssize_t n = TEMP_FAILURE_RETRY(pread(in_fd, buf, chunk, in_offset));
+    if (n < 0) return -errno;
+    if (n == 0) return -EINVAL;
+    int ret = pwrite_all(out_fd, buf, n, out_offset);
+    if (ret < 0) return ret;
+    in_offset += n;
+    out_offset += n;
+    len -= n;
+  }
+
+  return 0;
+}
+
+/* Writes the expanded contents of bb at its own offset in fd, as write_normal_*_chunk would. */
+static int write_block_at(struct sparse_file* s, struct backed_block* bb, int fd, char* buf) {
+  int64_t offset = (int64_t)backed_block_block(bb) * s->block_size;
+  unsigned int len = backed_block_len(bb);
+  int in_fd;
+  int ret = -EINVAL;
+
+  switch (backed_block_type(bb)) {
+    case BACKED_BLOCK_DATA:
+      ret = pwrite_all(fd, backed_block_data(bb), len, offset);
+      break;
+    case BACKED_BLOCK_FILE:
+      in_fd = open(backed_block_filename(bb), O_RDONLY | O_CLOEXEC);
+      if (in_fd < 0) return -errno;
+      ret = copy_range(in_fd, backed_block_file_offset(bb), fd, offset, len, buf);
+      close(in_fd);
+      break;
+    case BACKED_BLOCK_FD:
+      ret = copy_range(backed_block_fd(bb), backed_block_file_offset(bb), fd, offset, len, buf);
+      break;
+    case BACKED_BLOCK_FILL:
+      std::fill_n(reinterpret_cast<uint32_t*>(buf), PARALLEL_WRITE_BUF_SIZE / sizeof(uint32_t),
+                  backed_block_fill_val(bb));
+      ret = 0;
+      while (len > 0 && ret == 0) {
+        unsigned int chunk = std::min(len, PARALLEL_WRITE_BUF_SIZE);
+        ret = pwrite_all(fd, buf, chunk, offset);
+        offset += chunk;
+        len -= chunk;
+      }
+      break;
+  }
+
+  return ret;
+}
+#endif
+
+int sparse_file_write_parallel(struct sparse_file* s, int fd, unsigned int threads) {
+#ifdef _WIN32
+  (void)threads;
+  return sparse_file_write(s, fd, false, false, false);
+#else
+  std::vector<struct backed_block*> blocks;
+  std::vector<std::thread> workers;
+  std::atomic<size_t> next(0);
+  std::atomic<int> result(0);
+  struct backed_block* bb;
+  int ret;
+
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+
+  for (bb = backed_block_iter_new(s->backed_block_list); bb; bb = backed_block_iter_next(bb)) {
+    ret = backed_block_split(s->backed_block_list, bb, MAX_BACKED_BLOCK_SIZE);
+    if (ret) return ret;
+    blocks.push_back(bb);
+  }
+
+  /*
+   * Every chunk of an expanded image has a fixed offset, so chunks can be
+   * written in any order; workers take the next unwritten one until done.
+   */
+  auto write_blocks = [&]() {
+    char* buf = reinterpret_cast<char*>(malloc(PARALLEL_WRITE_BUF_SIZE));
+    if (!buf) {
+      result = -ENOMEM;
+      return;
+    }
+
+    for (size_t i = next++; i < blocks.size() && result == 0; i = next++) {
+      int err = write_block_at(s, blocks[i], fd, buf);
+      if (err < 0) {
+        result = err;
+      }
+    }
+
+    free(buf);
+  };
+
+  threads = std::max<size_t>(1, std::min<size_t>(threads, blocks.size()));
+  for (unsigned int i = 0; i < threads; i++) {
+    workers.emplace_back(write_blocks);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  if (result < 0) {
+    return result;
+  }
+
+  /* Skipped ranges are left as holes, as with sparse_file_write(). */
+  if (ftruncate(fd, s->len) < 0) {
+    return -errno;
+  }
+
+  return 0;
+#endif
+}
+
 int sparse_file_callback(struct sparse_file* s, bool sparse, bool crc,
                          int (*write)(void* priv, const void* data, size_t len), void* priv) {
   int ret;
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+#include <sparse/sparse.h>
+
+#include "sparse_crc32.h"
+
+static constexpr unsigned int kBlockSize = 4096;
+static constexpr unsigned int kImageBlocks = 64 * 1024;  // 256MiB
+
+// Creates a raw image of mixed content: runs of random data blocks, fill
+// blocks, zero blocks and unallocated holes, roughly like a partly used
+// filesystem image.
+static std::unique_ptr<TemporaryFile> CreateImage() {
+  auto image = std::make_unique<TemporaryFile>();
+  std::vector<uint32_t> block(kBlockSize / sizeof(uint32_t));
+  unsigned int seed = 42;
+
+  for (unsigned int i = 0; i < kImageBlocks; i++) {
+    switch ((i / 64) % 4) {
+      case 0:
+        for (auto& word : block) word = rand_r(&seed);
+        break;
+      case 1:
+        std::fill(block.begin(), block.end(), 0xdeadbeef);
+        break;
+      case 2:
+        std::fill(block.begin(), block.end(), 0);
+        break;
+      case 3:
+        // Leave a hole.
+        continue;
+    }
+    pwrite(image->fd, block.data(), kBlockSize, static_cast<off_t>(i) * kBlockSize);
+  }
+  ftruncate(image->fd, static_cast<off_t>(kImageBlocks) * kBlockSize);
+
+  return image;
+}
+
+static void BM_sparse_crc32(benchmark::State& state) {
+  std::vector<char> buf(state.range(0), 'x');
+  uint32_t crc = 0;
+
+  for (auto _ : state) {
+    crc = sparse_crc32(crc, buf.data(), buf.size());
+  }
+  benchmark::DoNotOptimize(crc);
+  state.SetBytesProcessed(state.iterations() * buf.size());
+}
+BENCHMARK(BM_sparse_crc32)->Arg(kBlockSize)->Arg(1024 * 1024);
+
+static void BM_sparse_crc32_fill(benchmark::State& state) {
+  uint32_t crc = 0;
+
+  for (auto _ : state) {
+    crc = sparse_crc32_fill(crc, 0xdeadbeef, state.range(0));
+  }
+  benchmark::DoNotOptimize(crc);
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_sparse_crc32_fill)->Arg(kBlockSize)->Arg(64 * 1024 * 1024);
+
+// Arg: reader threads, 1 being the serial reader.
+static void BM_sparse_file_read(benchmark::State& state) {
+  auto image = CreateImage();
+
+  for (auto _ : state) {
+    struct sparse_file* s =
+        sparse_file_new(kBlockSize, static_cast<int64_t>(kImageBlocks) * kBlockSize);
+    // The serial reader starts at the current offset.
+    lseek(image->fd, 0, SEEK_SET);
+    sparse_file_read_parallel(s, image->fd, state.range(0));
+    sparse_file_destroy(s);
+  }
+  state.SetBytesProcessed(state.iterations() * kImageBlocks * kBlockSize);
+}
+BENCHMARK(BM_sparse_file_read)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// Arg: writer threads.
+static void BM_sparse_file_write_parallel(benchmark::State& state) {
+  auto image = CreateImage();
+  TemporaryFile out;
+  struct sparse_file* s =
+      sparse_file_new(kBlockSize, static_cast<int64_t>(kImageBlocks) * kBlockSize);
+  sparse_file_read_parallel(s, image->fd, 0);
+
+  for (auto _ : state) {
+    sparse_file_write_parallel(s, out.fd, state.range(0));
+  }
+  sparse_file_destroy(s);
+  state.SetBytesProcessed(state.iterations() * kImageBlocks * kBlockSize);
+}
+BENCHMARK(BM_sparse_file_write_parallel)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+static void BM_sparse_file_write_sparse_crc(benchmark::State& state) {
+  auto image = CreateImage();
+  TemporaryFile out;
+  struct sparse_file* s =
+      sparse_file_new(kBlockSize, static_cast<int64_t>(kImageBlocks) * kBlockSize);
+  sparse_file_read_parallel(s, image->fd, 0);
+
+  for (auto _ : state) {
+    lseek(out.fd, 0, SEEK_SET);
+    sparse_file_write(s, out.fd, false, true, true);
+  }
+  sparse_file_destroy(s);
+  state.SetBytesProcessed(state.iterations() * kImageBlocks * kBlockSize);
+}
+BENCHMARK(BM_sparse_file_write_sparse_crc);
+
+BENCHMARK_MAIN();
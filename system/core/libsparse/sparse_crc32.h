@@ -17,8 +17,15 @@
 #ifndef _LIBSPARSE_SPARSE_CRC32_H_
 #define _LIBSPARSE_SPARSE_CRC32_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 uint32_t sparse_crc32(uint32_t crc, const void* buf, size_t size);
 
+/* Returns the crc of the concatenation of two buffers, len2 being the length of the second. */
+uint32_t sparse_crc32_combine(uint32_t crc1, uint32_t crc2, int64_t len2);
+
+/* Updates crc with len bytes of the repeated 32-bit pattern fill_val. */
+uint32_t sparse_crc32_fill(uint32_t crc, uint32_t fill_val, int64_t len);
+
 #endif
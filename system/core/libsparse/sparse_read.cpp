@@ -26,10 +26,14 @@
 #include <string.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <sparse/sparse.h>
 
+#include "android-base/file.h"
 #include "android-base/stringprintf.h"
 #include "defs.h"
 #include "output_file.h"
@@ -206,11 +210,8 @@ static int process_fill_chunk(struct sparse_file* s, unsigned int chunk_size,
                               SparseFileSource* source, unsigned int blocks, unsigned int block,
                               uint32_t* crc32) {
   int ret;
-  int chunk;
   int64_t len = (int64_t)blocks * s->block_size;
   uint32_t fill_val;
-  uint32_t* fillbuf;
-  unsigned int i;
 
   if (chunk_size != sizeof(fill_val)) {
     return -EINVAL;
@@ -227,17 +228,7 @@ static int process_fill_chunk(struct sparse_file* s, unsigned int chunk_size,
   }
 
   if (crc32) {
-    /* Fill copy_buf with the fill value */
-    fillbuf = (uint32_t*)copybuf;
-    for (i = 0; i < (COPY_BUF_SIZE / sizeof(fill_val)); i++) {
-      fillbuf[i] = fill_val;
-    }
-
-    while (len) {
-      chunk = std::min(len, COPY_BUF_SIZE);
-      *crc32 = sparse_crc32(*crc32, copybuf, chunk);
-      len -= chunk;
-    }
+    *crc32 = sparse_crc32_fill(*crc32, fill_val, len);
   }
 
   return 0;
@@ -252,13 +243,7 @@ static int process_skip_chunk(struct sparse_file* s, unsigned int chunk_size,
 
   if (crc32) {
     int64_t len = (int64_t)blocks * s->block_size;
-    memset(copybuf, 0, COPY_BUF_SIZE);
-
-    while (len) {
-      int chunk = std::min(len, COPY_BUF_SIZE);
-      *crc32 = sparse_crc32(*crc32, copybuf, chunk);
-      len -= chunk;
-    }
+    *crc32 = sparse_crc32_fill(*crc32, 0, len);
   }
 
   return 0;
@@ -410,6 +395,22 @@ static int sparse_file_read_sparse(struct sparse_file* s, SparseFileSource* sour
   return 0;
 }
 
+static bool sparse_block_is_fill(const uint32_t* buf, unsigned int len, unsigned int block_size) {
+  unsigned int i;
+
+  if (len != block_size) {
+    return false;
+  }
+
+  for (i = 1; i < block_size / sizeof(uint32_t); i++) {
+    if (buf[0] != buf[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 static int sparse_file_read_normal(struct sparse_file* s, int fd) {
   int ret;
   uint32_t* buf = (uint32_t*)malloc(s->block_size);
@@ -417,8 +418,6 @@ static int sparse_file_read_normal(struct sparse_file* s, int fd) {
   int64_t remain = s->len;
   int64_t offset = 0;
   unsigned int to_read;
-  unsigned int i;
-  bool sparse_block;
 
   if (!buf) {
     return -ENOMEM;
@@ -433,19 +432,7 @@ static int sparse_file_read_normal(struct sparse_file* s, int fd) {
       return ret;
     }
 
-    if (to_read == s->block_size) {
-      sparse_block = true;
-      for (i = 1; i < s->block_size / sizeof(uint32_t); i++) {
-        if (buf[0] != buf[i]) {
-          sparse_block = false;
-          break;
-        }
-      }
-    } else {
-      sparse_block = false;
-    }
-
-    if (sparse_block) {
+    if (sparse_block_is_fill(buf, to_read, s->block_size)) {
       /* TODO: add flag to use skip instead of fill for buf[0] == 0 */
       sparse_file_add_fill(s, buf[0], to_read, block);
     } else {
@@ -461,6 +448,151 @@ static int sparse_file_read_normal(struct sparse_file* s, int fd) {
   return 0;
 }
 
+/* Number of blocks a worker reads and classifies at a time. */
+static constexpr unsigned int PARALLEL_READ_BLOCKS = 256;
+
+enum block_class : uint8_t {
+  BLOCK_DATA,
+  BLOCK_FILL,
+  BLOCK_HOLE,
+};
+
+struct block_info {
+  uint32_t fill_val;
+  block_class type;
+};
+
+/*
+ * Marks the blocks that lie entirely within a hole of fd, so they can be added
+ * as zero fills without being read.  Filesystems without SEEK_DATA support
+ * report the whole file as data, which leaves every block to be classified.
+ */
+static void mark_hole_blocks(struct sparse_file* s, int fd, std::vector<block_info>* info) {
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+  int64_t hole = 0;
+  int64_t data;
+  int64_t block;
+
+  while (hole < s->len) {
+    data = lseek64(fd, hole, SEEK_DATA);
+    if (data < 0) {
+      if (errno != ENXIO) {
+        return;
+      }
+      /* No data after hole; anything past the end of the file is left to fail the read. */
+      data = lseek64(fd, 0, SEEK_END);
+      if (data < 0) {
+        return;
+      }
+    }
+    data = std::min(data, s->len);
+
+    for (block = DIV_ROUND_UP(hole, s->block_size); block < data / s->block_size; block++) {
+      (*info)[block].type = BLOCK_HOLE;
+      (*info)[block].fill_val = 0;
+    }
+
+    if (data >= s->len) {
+      return;
+    }
+    hole = lseek64(fd, data, SEEK_HOLE);
+    if (hole < 0) {
+      return;
+    }
+  }
+#else
+  (void)s;
+  (void)fd;
+  (void)info;
+#endif
+}
+
+static int sparse_file_read_normal_parallel(struct sparse_file* s, int fd, unsigned int threads) {
+  unsigned int blocks = DIV_ROUND_UP(s->len, s->block_size);
+  unsigned int units = DIV_ROUND_UP(blocks, PARALLEL_READ_BLOCKS);
+  std::vector<block_info> info(blocks, block_info{0, BLOCK_DATA});
+  std::vector<std::thread> workers;
+  std::atomic<unsigned int> next_unit(0);
+  std::atomic<int> result(0);
+  unsigned int block;
+
+  mark_hole_blocks(s, fd, &info);
+
+  auto classify = [&]() {
+    uint32_t* buf = (uint32_t*)malloc((size_t)PARALLEL_READ_BLOCKS * s->block_size);
+    if (!buf) {
+      result = -ENOMEM;
+      return;
+    }
+
+    for (unsigned int unit = next_unit++; unit < units && result == 0; unit = next_unit++) {
+      unsigned int first = unit * PARALLEL_READ_BLOCKS;
+      unsigned int end = std::min(first + PARALLEL_READ_BLOCKS, blocks);
+
+      while (first < end) {
+        /* Read the next run of blocks that were not already known to be holes. */
+        if (info[first].type == BLOCK_HOLE) {
+          first++;
+          continue;
+        }
+        unsigned int last = first;
+        while (last < end && info[last].type != BLOCK_HOLE) {
+          last++;
+        }
+
+        int64_t offset = (int64_t)first * s->block_size;
+        int64_t len = std::min((int64_t)last * s->block_size, s->len) - offset;
+        errno = 0;
+        if (!android::base::ReadFullyAtOffset(fd, buf, len, offset)) {
+          result = errno ? -errno : -EINVAL;
+          break;
+        }
+
+        const uint32_t* block_buf = buf;
+        for (unsigned int b = first; b < last; b++) {
+          unsigned int block_len = std::min(len, (int64_t)s->block_size);
+          if (sparse_block_is_fill(block_buf, block_len, s->block_size)) {
+            info[b].type = BLOCK_FILL;
+            info[b].fill_val = block_buf[0];
+          }
+          block_buf += s->block_size / sizeof(uint32_t);
+          len -= block_len;
+        }
+        first = last;
+      }
+    }
+
+    free(buf);
+  };
+
+  threads = std::max(1U, std::min(threads, units));
+  for (unsigned int i = 0; i < threads; i++) {
+    workers.emplace_back(classify);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  if (result < 0) {
+    error("failed to read sparse file");
+    return result;
+  }
+
+  /* Add the classified blocks in order so the result matches sparse_file_read_normal. */
+  for (block = 0; block < blocks; block++) {
+    int64_t offset = (int64_t)block * s->block_size;
+    unsigned int len = std::min(s->len - offset, (int64_t)s->block_size);
+
+    if (info[block].type == BLOCK_DATA) {
+      sparse_file_add_fd(s, fd, offset, len, block);
+    } else {
+      sparse_file_add_fill(s, info[block].fill_val, len, block);
+    }
+  }
+
+  return 0;
+}
+
 int sparse_file_read(struct sparse_file* s, int fd, bool sparse, bool crc) {
   if (crc && !sparse) {
     return -EINVAL;
@@ -474,6 +606,19 @@ int sparse_file_read(struct sparse_file* s, int fd, bool sparse, bool crc) {
   }
 }
 
+int sparse_file_read_parallel(struct sparse_file* s, int fd, unsigned int threads) {
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+
+  /* Workers use positional reads, so fall back to reading a pipe sequentially. */
+  if (threads <= 1 || lseek64(fd, 0, SEEK_CUR) < 0) {
+    return sparse_file_read_normal(s, fd);
+  }
+
+  return sparse_file_read_normal_parallel(s, fd, threads);
+}
+
 int sparse_file_read_buf(struct sparse_file* s, char* buf, bool crc) {
   SparseFileBufSource source(buf);
   return sparse_file_read_sparse(s, &source, crc);
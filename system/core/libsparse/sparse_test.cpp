@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+#include <sparse/sparse.h>
+
+#include "sparse_crc32.h"
+
+static constexpr unsigned int kBlockSize = 4096;
+static constexpr unsigned int kImageBlocks = 1024;
+
+struct SparseFileDeleter {
+  void operator()(struct sparse_file* s) { sparse_file_destroy(s); }
+};
+using SparseFilePtr = std::unique_ptr<struct sparse_file, SparseFileDeleter>;
+
+// Writes a raw image of runs of random data, fill, zero and hole blocks, with
+// run lengths that don't line up with the workers' batches, and returns its
+// expanded contents.
+static std::string CreateImage(int fd) {
+  std::string contents(kImageBlocks * kBlockSize, '\0');
+  std::vector<uint32_t> block(kBlockSize / sizeof(uint32_t));
+  unsigned int seed = 42;
+  int64_t offset = 0;
+
+  for (unsigned int i = 0; i < kImageBlocks; i++, offset += kBlockSize) {
+    switch ((i / 37) % 4) {
+      case 0:
+        for (auto& word : block) word = rand_r(&seed);
+        break;
+      case 1:
+        std::fill(block.begin(), block.end(), 0xdeadbeef);
+        break;
+      case 2:
+        std::fill(block.begin(), block.end(), 0);
+        break;
+      case 3:
+        // Leave a hole, unless it is the last block, which sets the file size.
+        if (i != kImageBlocks - 1) continue;
+        std::fill(block.begin(), block.end(), 0);
+        break;
+    }
+    EXPECT_EQ(static_cast<ssize_t>(kBlockSize), pwrite(fd, block.data(), kBlockSize, offset));
+    memcpy(&contents[offset], block.data(), kBlockSize);
+  }
+
+  return contents;
+}
+
+static std::string ReadFile(int fd) {
+  std::string contents;
+  EXPECT_EQ(0, lseek(fd, 0, SEEK_SET));
+  EXPECT_TRUE(android::base::ReadFdToString(fd, &contents));
+  return contents;
+}
+
+static std::string Write(struct sparse_file* s, bool sparse, bool crc) {
+  TemporaryFile out;
+  EXPECT_EQ(0, sparse_file_write(s, out.fd, false, sparse, crc));
+  return ReadFile(out.fd);
+}
+
+static std::string WriteParallel(struct sparse_file* s, unsigned int threads) {
+  TemporaryFile out;
+  EXPECT_EQ(0, sparse_file_write_parallel(s, out.fd, threads));
+  return ReadFile(out.fd);
+}
+
+static uint32_t ZlibCrc32(const std::string& data) {
+  return crc32(0, reinterpret_cast<const Bytef*>(data.data()), data.size());
+}
+
+// Returns the value of the CRC32 chunk that ends an image written with crc.
+static uint32_t ImageCrc32(const std::string& image) {
+  uint32_t crc = 0;
+  EXPECT_GE(image.size(), sizeof(crc));
+  memcpy(&crc, image.data() + image.size() - sizeof(crc), sizeof(crc));
+  return crc;
+}
+
+// Imports a sparse image, which checks its CRC32 chunk, and returns it expanded.
+static std::string Import(const std::string& image) {
+  TemporaryFile sparse_image;
+  EXPECT_TRUE(android::base::WriteStringToFd(image, sparse_image.fd));
+  EXPECT_EQ(0, lseek(sparse_image.fd, 0, SEEK_SET));
+  SparseFilePtr s(sparse_file_import(sparse_image.fd, false, true));
+  if (!s) {
+    ADD_FAILURE() << "sparse_file_import failed";
+    return "";
+  }
+  return Write(s.get(), false, false);
+}
+
+class SparseTest : public ::testing::Test {
+ protected:
+  void SetUp() override { contents_ = CreateImage(image_.fd); }
+
+  // The serial reader reads from the current file position.
+  SparseFilePtr Read() {
+    SparseFilePtr s(sparse_file_new(kBlockSize, contents_.size()));
+    EXPECT_EQ(0, lseek(image_.fd, 0, SEEK_SET));
+    EXPECT_EQ(0, sparse_file_read(s.get(), image_.fd, false, false));
+    return s;
+  }
+
+  SparseFilePtr ReadParallel(unsigned int threads) {
+    SparseFilePtr s(sparse_file_new(kBlockSize, contents_.size()));
+    EXPECT_EQ(0, lseek(image_.fd, 0, SEEK_SET));
+    EXPECT_EQ(0, sparse_file_read_parallel(s.get(), image_.fd, threads));
+    return s;
+  }
+
+  TemporaryFile image_;
+  std::string contents_;
+};
+
+TEST_F(SparseTest, ReadParallelMatchesRead) {
+  std::string serial = Write(Read().get(), true, true);
+
+  for (unsigned int threads : {0, 1, 3, 8}) {
+    SCOPED_TRACE(threads);
+    EXPECT_TRUE(serial == Write(ReadParallel(threads).get(), true, true));
+  }
+}
+
+TEST_F(SparseTest, WriteParallelMatchesWrite) {
+  SparseFilePtr s = Read();
+  std::string serial = Write(s.get(), false, false);
+  ASSERT_TRUE(contents_ == serial);
+
+  for (unsigned int threads : {0, 1, 3, 8}) {
+    SCOPED_TRACE(threads);
+    EXPECT_TRUE(serial == WriteParallel(s.get(), threads));
+  }
+}
+
+TEST_F(SparseTest, WriteParallelLeavesGapsAsZeros) {
+  // A file built from pieces, with gaps that are skip chunks when written
+  // sparse, and a gap at the end.
+  std::vector<char> data(3 * kBlockSize);
+  for (size_t i = 0; i < data.size(); i++) data[i] = i * 7;
+  SparseFilePtr s(sparse_file_new(kBlockSize, 40 * kBlockSize));
+  ASSERT_EQ(0, sparse_file_add_data(s.get(), data.data(), data.size(), 2));
+  ASSERT_EQ(0, sparse_file_add_fill(s.get(), 0x12345678, 10 * kBlockSize, 9));
+  ASSERT_EQ(0, sparse_file_add_fd(s.get(), image_.fd, 0, 5 * kBlockSize, 30));
+
+  std::string serial = Write(s.get(), false, false);
+  ASSERT_EQ(40 * kBlockSize, serial.size());
+  EXPECT_TRUE(serial == WriteParallel(s.get(), 4));
+}
+
+TEST_F(SparseTest, ImageCrc32MatchesZlib) {
+  SparseFilePtr s = Read();
+  std::string image = Write(s.get(), true, true);
+  EXPECT_EQ(ZlibCrc32(contents_), ImageCrc32(image));
+
+  EXPECT_TRUE(contents_ == Import(image));
+}
+
+TEST_F(SparseTest, ImageCrc32MatchesZlibWithSkips) {
+  // Multi-block fills and skip chunks are checksummed without being expanded.
+  SparseFilePtr s(sparse_file_new(kBlockSize, 100 * kBlockSize));
+  ASSERT_EQ(0, sparse_file_add_fill(s.get(), 0xdeadbeef, 17 * kBlockSize, 3));
+  ASSERT_EQ(0, sparse_file_add_fd(s.get(), image_.fd, 0, 5 * kBlockSize, 50));
+  ASSERT_EQ(0, sparse_file_add_fill(s.get(), 0, 20 * kBlockSize, 70));
+
+  std::string expanded = Write(s.get(), false, false);
+  std::string image = Write(s.get(), true, true);
+  EXPECT_EQ(ZlibCrc32(expanded), ImageCrc32(image));
+  EXPECT_TRUE(expanded == Import(image));
+}
+
+TEST(SparseCrc32, MatchesZlib) {
+  std::string data(100000, '\0');
+  for (size_t i = 0; i < data.size(); i++) data[i] = i * 31 + i / 256;
+
+  EXPECT_EQ(ZlibCrc32(data), sparse_crc32(0, data.data(), data.size()));
+  EXPECT_EQ(ZlibCrc32(""), sparse_crc32(0, data.data(), 0));
+}
+
+TEST(SparseCrc32, Combine) {
+  std::string data(10000, '\0');
+  for (size_t i = 0; i < data.size(); i++) data[i] = i * 13;
+
+  for (size_t split : {0, 1, 4095, 4096, 9999, 10000}) {
+    SCOPED_TRACE(split);
+    uint32_t crc1 = sparse_crc32(0, data.data(), split);
+    uint32_t crc2 = sparse_crc32(0, data.data() + split, data.size() - split);
+    EXPECT_EQ(ZlibCrc32(data), sparse_crc32_combine(crc1, crc2, data.size() - split));
+  }
+}
+
+TEST(SparseCrc32, Fill) {
+  const uint32_t fill_val = 0xcafef00d;
+  const std::string prefix = "prefix";
+  uint32_t prefix_crc = ZlibCrc32(prefix);
+
+  for (int64_t len : {0, 4, 8, 252, 256, 260, 508, 512, 516, 4096, 4100, 65536, 1000000}) {
+    SCOPED_TRACE(len);
+    std::string expanded = prefix;
+    for (int64_t i = 0; i < len; i += sizeof(fill_val)) {
+      expanded.append(reinterpret_cast<const char*>(&fill_val), sizeof(fill_val));
+    }
+    EXPECT_EQ(ZlibCrc32(expanded), sparse_crc32_fill(prefix_crc, fill_val, len));
+  }
+}
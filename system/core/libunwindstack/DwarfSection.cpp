@@ -16,6 +16,8 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+
 #include <unwindstack/DwarfError.h>
 #include <unwindstack/DwarfLocation.h>
 #include <unwindstack/DwarfMemory.h>
@@ -319,33 +321,42 @@ bool DwarfSectionImpl<AddressType>::FillInFdeHeader(DwarfFde* fde) {
 }
 
 template <typename AddressType>
-bool DwarfSectionImpl<AddressType>::FillInFde(DwarfFde* fde) {
-  uint64_t cur_offset = memory_.cur_offset();
-
-  const DwarfCie* cie = GetCieFromOffset(fde->cie_offset);
-  if (cie == nullptr) {
-    return false;
-  }
-  fde->cie = cie;
-
+bool DwarfSectionImpl<AddressType>::ReadFdePcRange(const DwarfCie* cie, uint64_t* pc_start,
+                                                   uint64_t* pc_end) {
   if (cie->segment_size != 0) {
     // Skip over the segment selector for now.
-    cur_offset += cie->segment_size;
+    memory_.set_cur_offset(memory_.cur_offset() + cie->segment_size);
   }
-  memory_.set_cur_offset(cur_offset);
 
   // The load bias only applies to the start.
   memory_.set_pc_offset(section_bias_);
-  bool valid = memory_.ReadEncodedValue<AddressType>(cie->fde_address_encoding, &fde->pc_start);
-  fde->pc_start = AdjustPcFromFde(fde->pc_start);
+  bool valid = memory_.ReadEncodedValue<AddressType>(cie->fde_address_encoding, pc_start);
+  *pc_start = AdjustPcFromFde(*pc_start);
 
   memory_.set_pc_offset(0);
-  if (!valid || !memory_.ReadEncodedValue<AddressType>(cie->fde_address_encoding, &fde->pc_end)) {
+  if (!valid || !memory_.ReadEncodedValue<AddressType>(cie->fde_address_encoding, pc_end)) {
     last_error_.code = DWARF_ERROR_MEMORY_INVALID;
     last_error_.address = memory_.cur_offset();
     return false;
   }
-  fde->pc_end += fde->pc_start;
+  *pc_end += *pc_start;
+  return true;
+}
+
+template <typename AddressType>
+bool DwarfSectionImpl<AddressType>::FillInFde(DwarfFde* fde) {
+  uint64_t cur_offset = memory_.cur_offset();
+
+  const DwarfCie* cie = GetCieFromOffset(fde->cie_offset);
+  if (cie == nullptr) {
+    return false;
+  }
+  fde->cie = cie;
+
+  memory_.set_cur_offset(cur_offset);
+  if (!ReadFdePcRange(cie, &fde->pc_start, &fde->pc_end)) {
+    return false;
+  }
 
   if (cie->augmentation_string.size() > 0 && cie->augmentation_string[0] == 'z') {
     // Augmentation Size
@@ -607,29 +618,152 @@ bool DwarfSectionImpl<AddressType>::Init(uint64_t offset, uint64_t size, int64_t
   return true;
 }
 
-// Create a cached version of the fde information such that it is a std::map
-// that is indexed by end pc and contains a pair that represents the start pc
-// followed by the fde object. The fde pointers are owned by fde_entries_
-// and not by the map object.
-// It is possible for an fde to be represented by multiple entries in
-// the map. This can happen if the the start pc and end pc overlap already
-// existing entries. For example, if there is already an entry of 0x400, 0x200,
-// and an fde has a start pc of 0x100 and end pc of 0x500, two new entries
-// will be added: 0x200, 0x100 and 0x500, 0x400.
+// Create an index of the pc ranges of all of the fdes in the section. Only
+// the header and the pc range of each fde are read, the rest of an fde is
+// read when a pc in its range is looked up.
+template <typename AddressType>
+void DwarfSectionImpl<AddressType>::BuildFdeIndex() {
+  fde_index_built_ = true;
+  DwarfErrorData last_error = last_error_;
+
+  uint64_t last_cie_offset = 0;
+  const DwarfCie* last_cie = nullptr;
+  uint64_t entry_offset = entries_offset_;
+  while (entry_offset < entries_end_) {
+    memory_.set_data_offset(entries_offset_);
+    memory_.set_cur_offset(entry_offset);
+    uint32_t value32;
+    if (!memory_.ReadBytes(&value32, sizeof(value32))) {
+      last_error_.code = DWARF_ERROR_MEMORY_INVALID;
+      last_error_.address = memory_.cur_offset();
+      break;
+    }
+
+    uint64_t next_entry_offset;
+    uint64_t cie_offset = 0;
+    bool entry_is_cie = false;
+    if (value32 == static_cast<uint32_t>(-1)) {
+      // 64 bit entry.
+      uint64_t value64;
+      if (!memory_.ReadBytes(&value64, sizeof(value64))) {
+        last_error_.code = DWARF_ERROR_MEMORY_INVALID;
+        last_error_.address = memory_.cur_offset();
+        break;
+      }
+      next_entry_offset = memory_.cur_offset() + value64;
+      // Read the Cie Id of a Cie or the pointer of the Fde.
+      if (!memory_.ReadBytes(&value64, sizeof(value64))) {
+        last_error_.code = DWARF_ERROR_MEMORY_INVALID;
+        last_error_.address = memory_.cur_offset();
+        break;
+      }
+      if (value64 == cie64_value_) {
+        entry_is_cie = true;
+      } else {
+        cie_offset = GetCieOffsetFromFde64(value64);
+      }
+    } else {
+      next_entry_offset = memory_.cur_offset() + value32;
+      // Read the Cie Id of a Cie or the pointer of the Fde.
+      if (!memory_.ReadBytes(&value32, sizeof(value32))) {
+        last_error_.code = DWARF_ERROR_MEMORY_INVALID;
+        last_error_.address = memory_.cur_offset();
+        break;
+      }
+      if (value32 == cie32_value_) {
+        entry_is_cie = true;
+      } else {
+        cie_offset = GetCieOffsetFromFde32(value32);
+      }
+    }
+
+    if (!entry_is_cie) {
+      // Most fdes share a handful of cies, avoid looking the cie up every time.
+      if (last_cie == nullptr || cie_offset != last_cie_offset) {
+        uint64_t cur_offset = memory_.cur_offset();
+        last_cie = GetCieFromOffset(cie_offset);
+        if (last_cie == nullptr) {
+          break;
+        }
+        last_cie_offset = cie_offset;
+        memory_.set_cur_offset(cur_offset);
+      }
+      uint64_t start;
+      uint64_t end;
+      if (!ReadFdePcRange(last_cie, &start, &end)) {
+        break;
+      }
+      if (start < end) {
+        fde_index_.push_back(FdeRange{start, end, entry_offset});
+      }
+    }
+
+    if (next_entry_offset < memory_.cur_offset()) {
+      // Simply consider the processing done in this case.
+      entry_offset = entries_end_;
+      break;
+    }
+    entry_offset = next_entry_offset;
+  }
+  if (entry_offset < entries_end_) {
+    // Remember the error, so that lookups of pcs that are not in the part
+    // of the section that could be indexed report it.
+    fde_index_error_ = last_error_;
+    last_error_ = last_error;
+  }
+
+  // The ranges are in section order, which is also the order of the fde offsets.
+  std::sort(fde_index_.begin(), fde_index_.end(), [](const FdeRange& a, const FdeRange& b) {
+    return a.pc_start < b.pc_start;
+  });
+  bool overlap = false;
+  for (size_t i = 1; i < fde_index_.size(); i++) {
+    if (fde_index_[i].pc_start < fde_index_[i - 1].pc_end) {
+      overlap = true;
+      break;
+    }
+  }
+  if (overlap) {
+    ResolveOverlappingFdes();
+  }
+  fde_index_.shrink_to_fit();
+}
+
+// The pc ranges of the fdes overlap, in which case the fde that comes first
+// in the section wins. To resolve the overlaps, the ranges are inserted in
+// section order into a std::map that is indexed by end pc and contains a pair
+// that represents the start pc followed by the fde offset.
+// It is possible for an fde to be represented by multiple entries in the map.
+// This can happen if the the start pc and end pc overlap already existing
+// entries. For example, if there is already an entry of 0x400, 0x200, and an
+// fde has a start pc of 0x100 and end pc of 0x500, two new entries will be
+// added: 0x200, 0x100 and 0x500, 0x400.
 template <typename AddressType>
-void DwarfSectionImpl<AddressType>::InsertFde(const DwarfFde* fde) {
-  uint64_t start = fde->pc_start;
-  uint64_t end = fde->pc_end;
-  auto it = fdes_.upper_bound(start);
-  while (it != fdes_.end() && start < end && it->second.first < end) {
-    if (start < it->second.first) {
-      fdes_[it->second.first] = std::make_pair(start, fde);
+void DwarfSectionImpl<AddressType>::ResolveOverlappingFdes() {
+  std::sort(fde_index_.begin(), fde_index_.end(), [](const FdeRange& a, const FdeRange& b) {
+    return a.fde_offset < b.fde_offset;
+  });
+
+  std::map<uint64_t, std::pair<uint64_t, uint64_t>> ranges;
+  for (const FdeRange& fde_range : fde_index_) {
+    uint64_t start = fde_range.pc_start;
+    uint64_t end = fde_range.pc_end;
+    auto it = ranges.upper_bound(start);
+    while (it != ranges.end() && start < end && it->second.first < end) {
+      if (start < it->second.first) {
+        ranges[it->second.first] = std::make_pair(start, fde_range.fde_offset);
+      }
+      start = it->first;
+      ++it;
+    }
+    if (start < end) {
+      ranges[end] = std::make_pair(start, fde_range.fde_offset);
     }
-    start = it->first;
-    ++it;
   }
-  if (start < end) {
-    fdes_[end] = std::make_pair(start, fde);
+
+  fde_index_.clear();
+  for (const auto& range : ranges) {
+    fde_index_.push_back(FdeRange{range.second.first, range.first, range.second.second});
   }
 }
 
@@ -748,7 +882,6 @@ void DwarfSectionImpl<AddressType>::GetFdes(std::vector<const DwarfFde*>* fdes)
       break;
     }
     if (fde != nullptr) {
-      InsertFde(fde);
       fdes->push_back(fde);
     }
 
@@ -761,35 +894,22 @@ void DwarfSectionImpl<AddressType>::GetFdes(std::vector<const DwarfFde*>* fdes)
 
 template <typename AddressType>
 const DwarfFde* DwarfSectionImpl<AddressType>::GetFdeFromPc(uint64_t pc) {
-  // Search in the list of fdes we already have.
-  auto it = fdes_.upper_bound(pc);
-  if (it != fdes_.end()) {
-    if (pc >= it->second.first) {
-      return it->second.second;
-    }
+  // The section might have overlapping pcs in fdes and is not sorted, so
+  // index all of the fdes the first time a pc is looked up.
+  if (!fde_index_built_) {
+    BuildFdeIndex();
   }
 
-  // The section might have overlapping pcs in fdes, so it is necessary
-  // to do a linear search of the fdes by pc. As fdes are read, a cached
-  // search map is created.
-  while (next_entries_offset_ < entries_end_) {
-    const DwarfFde* fde;
-    if (!GetNextCieOrFde(&fde)) {
-      return nullptr;
-    }
-    if (fde != nullptr) {
-      InsertFde(fde);
-      if (pc >= fde->pc_start && pc < fde->pc_end) {
-        return fde;
-      }
-    }
-
-    if (next_entries_offset_ < memory_.cur_offset()) {
-      // Simply consider the processing done in this case.
-      break;
+  auto it = std::upper_bound(
+      fde_index_.begin(), fde_index_.end(), pc,
+      [](uint64_t value, const FdeRange& range) { return value < range.pc_end; });
+  if (it == fde_index_.end() || pc < it->pc_start) {
+    if (fde_index_error_.code != DWARF_ERROR_NONE) {
+      last_error_ = fde_index_error_;
     }
+    return nullptr;
   }
-  return nullptr;
+  return GetFdeFromOffset(it->fde_offset);
 }
 
 // Explicitly instantiate DwarfSectionImpl
@@ -148,13 +148,17 @@ std::string Elf::GetBuildID() {
   return interface_->GetBuildID();
 }
 
+// The last error is written by Step, so read it under the same lock in case
+// another thread is stepping through this object.
 void Elf::GetLastError(ErrorData* data) {
+  std::lock_guard<std::mutex> guard(lock_);
   if (valid_) {
     *data = interface_->last_error();
   }
 }
 
 ErrorCode Elf::GetLastErrorCode() {
+  std::lock_guard<std::mutex> guard(lock_);
   if (valid_) {
     return interface_->LastErrorCode();
   }
@@ -162,6 +166,7 @@ ErrorCode Elf::GetLastErrorCode() {
 }
 
 uint64_t Elf::GetLastErrorAddress() {
+  std::lock_guard<std::mutex> guard(lock_);
   if (valid_) {
     return interface_->LastErrorAddress();
   }
@@ -200,6 +200,13 @@ std::shared_ptr<Memory> Memory::CreateProcessMemoryCached(pid_t pid) {
   return std::shared_ptr<Memory>(new MemoryCache(new MemoryRemote(pid)));
 }
 
+std::shared_ptr<Memory> Memory::CreateProcessMemoryThreadCached(pid_t pid) {
+  if (pid == getpid()) {
+    return std::shared_ptr<Memory>(new MemoryThreadCache(new MemoryLocal()));
+  }
+  return std::shared_ptr<Memory>(new MemoryThreadCache(new MemoryRemote(pid)));
+}
+
 std::shared_ptr<Memory> Memory::CreateOfflineMemory(const uint8_t* data, uint64_t start,
                                                     uint64_t end) {
   return std::shared_ptr<Memory>(new MemoryOfflineBuffer(data, start, end));
@@ -429,22 +436,22 @@ size_t MemoryOfflineParts::Read(uint64_t addr, void* dst, size_t size) {
   return 0;
 }
 
-size_t MemoryCache::Read(uint64_t addr, void* dst, size_t size) {
+size_t MemoryCacheBase::CachedRead(uint64_t addr, void* dst, size_t size, CacheDataType* cache) {
   // Only bother caching and looking at the cache if this is a small read for now.
   if (size > 64) {
     return impl_->Read(addr, dst, size);
   }
 
   uint64_t addr_page = addr >> kCacheBits;
-  auto entry = cache_.find(addr_page);
+  auto entry = cache->find(addr_page);
   uint8_t* cache_dst;
-  if (entry != cache_.end()) {
+  if (entry != cache->end()) {
     cache_dst = entry->second;
   } else {
-    cache_dst = cache_[addr_page];
+    cache_dst = (*cache)[addr_page];
     if (!impl_->ReadFully(addr_page << kCacheBits, cache_dst, kCacheSize)) {
       // Erase the entry.
-      cache_.erase(addr_page);
+      cache->erase(addr_page);
       return impl_->Read(addr, dst, size);
     }
   }
@@ -460,14 +467,14 @@ size_t MemoryCache::Read(uint64_t addr, void* dst, size_t size) {
   dst = &reinterpret_cast<uint8_t*>(dst)[max_read];
   addr_page++;
 
-  entry = cache_.find(addr_page);
-  if (entry != cache_.end()) {
+  entry = cache->find(addr_page);
+  if (entry != cache->end()) {
     cache_dst = entry->second;
   } else {
-    cache_dst = cache_[addr_page];
+    cache_dst = (*cache)[addr_page];
     if (!impl_->ReadFully(addr_page << kCacheBits, cache_dst, kCacheSize)) {
       // Erase the entry.
-      cache_.erase(addr_page);
+      cache->erase(addr_page);
       return impl_->Read(addr_page << kCacheBits, dst, size - max_read) + max_read;
     }
   }
@@ -475,4 +482,41 @@ size_t MemoryCache::Read(uint64_t addr, void* dst, size_t size) {
   return size;
 }
 
+MemoryThreadCache::MemoryThreadCache(Memory* memory) : MemoryCacheBase(memory) {
+  auto free_cache = [](void* cache) { delete reinterpret_cast<CacheDataType*>(cache); };
+  thread_cache_valid_ = pthread_key_create(&thread_cache_, free_cache) == 0;
+}
+
+MemoryThreadCache::~MemoryThreadCache() {
+  if (thread_cache_valid_) {
+    // Other threads free their caches on exit, but the key's destructor never
+    // runs for the thread deleting this object.
+    delete reinterpret_cast<CacheDataType*>(pthread_getspecific(thread_cache_));
+    pthread_key_delete(thread_cache_);
+  }
+}
+
+size_t MemoryThreadCache::Read(uint64_t addr, void* dst, size_t size) {
+  if (!thread_cache_valid_) {
+    return impl_->Read(addr, dst, size);
+  }
+
+  CacheDataType* cache = reinterpret_cast<CacheDataType*>(pthread_getspecific(thread_cache_));
+  if (cache == nullptr) {
+    cache = new CacheDataType;
+    pthread_setspecific(thread_cache_, cache);
+  }
+  return CachedRead(addr, dst, size, cache);
+}
+
+void MemoryThreadCache::Clear() {
+  if (!thread_cache_valid_) {
+    return;
+  }
+  CacheDataType* cache = reinterpret_cast<CacheDataType*>(pthread_getspecific(thread_cache_));
+  if (cache != nullptr) {
+    cache->clear();
+  }
+}
+
 }  // namespace unwindstack
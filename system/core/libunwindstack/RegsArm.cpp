@@ -92,6 +92,14 @@ bool RegsArm::SetPcFromReturnAddress(Memory*) {
   return true;
 }
 
+bool RegsArm::ReadFrameRecord(Memory*, uint64_t, FrameRecord*) {
+  // Arm and thumb code use different frame pointer registers and record
+  // layouts, so the chain cannot be followed reliably.
+  return false;
+}
+
+void RegsArm::SetFromFrameRecord(const FrameRecord&) {}
+
 void RegsArm::IterateRegisters(std::function<void(const char*, uint64_t)> fn) {
   fn("r0", regs_[ARM_REG_R0]);
   fn("r1", regs_[ARM_REG_R1]);
@@ -69,6 +69,31 @@ bool RegsArm64::SetPcFromReturnAddress(Memory*) {
   return true;
 }
 
+bool RegsArm64::ReadFrameRecord(Memory* process_memory, uint64_t stack_end,
+                                FrameRecord* record) {
+  // x29 points at {caller x29, lr}. The record is at the bottom of the frame
+  // for most code, so the sp of the caller is not known exactly. Use the
+  // lowest address it can have.
+  uint64_t fp = regs_[ARM64_REG_R29];
+  uint64_t data[2];
+  if ((fp & 0x7) != 0 || fp < regs_[ARM64_REG_SP] || fp >= stack_end ||
+      stack_end - fp < sizeof(data) || !process_memory->ReadFully(fp, data, sizeof(data))) {
+    return false;
+  }
+  record->address = fp;
+  record->fp = data[0];
+  record->pc = data[1];
+  record->sp = fp + sizeof(data);
+  return true;
+}
+
+void RegsArm64::SetFromFrameRecord(const FrameRecord& record) {
+  regs_[ARM64_REG_R29] = record.fp;
+  regs_[ARM64_REG_LR] = record.pc;
+  regs_[ARM64_REG_PC] = record.pc;
+  regs_[ARM64_REG_SP] = record.sp;
+}
+
 void RegsArm64::IterateRegisters(std::function<void(const char*, uint64_t)> fn) {
   fn("x0", regs_[ARM64_REG_R0]);
   fn("x1", regs_[ARM64_REG_R1]);
@@ -70,6 +70,13 @@ bool RegsMips::SetPcFromReturnAddress(Memory*) {
   return true;
 }
 
+bool RegsMips::ReadFrameRecord(Memory*, uint64_t, FrameRecord*) {
+  // There is no standard frame record layout.
+  return false;
+}
+
+void RegsMips::SetFromFrameRecord(const FrameRecord&) {}
+
 void RegsMips::IterateRegisters(std::function<void(const char*, uint64_t)> fn) {
   fn("r0", regs_[MIPS_REG_R0]);
   fn("r1", regs_[MIPS_REG_R1]);
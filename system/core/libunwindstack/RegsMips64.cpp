@@ -70,6 +70,13 @@ bool RegsMips64::SetPcFromReturnAddress(Memory*) {
   return true;
 }
 
+bool RegsMips64::ReadFrameRecord(Memory*, uint64_t, FrameRecord*) {
+  // There is no standard frame record layout.
+  return false;
+}
+
+void RegsMips64::SetFromFrameRecord(const FrameRecord&) {}
+
 void RegsMips64::IterateRegisters(std::function<void(const char*, uint64_t)> fn) {
   fn("r0", regs_[MIPS64_REG_R0]);
   fn("r1", regs_[MIPS64_REG_R1]);
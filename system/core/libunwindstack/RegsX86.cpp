@@ -69,6 +69,28 @@ bool RegsX86::SetPcFromReturnAddress(Memory* process_memory) {
   return true;
 }
 
+bool RegsX86::ReadFrameRecord(Memory* process_memory, uint64_t stack_end,
+                              FrameRecord* record) {
+  // ebp points at the saved ebp of the caller, followed by the return address.
+  uint32_t fp = regs_[X86_REG_EBP];
+  uint32_t data[2];
+  if ((fp & 0x3) != 0 || fp < regs_[X86_REG_SP] || fp >= stack_end ||
+      stack_end - fp < sizeof(data) || !process_memory->ReadFully(fp, data, sizeof(data))) {
+    return false;
+  }
+  record->address = fp;
+  record->fp = data[0];
+  record->pc = data[1];
+  record->sp = fp + sizeof(data);
+  return true;
+}
+
+void RegsX86::SetFromFrameRecord(const FrameRecord& record) {
+  regs_[X86_REG_EBP] = record.fp;
+  regs_[X86_REG_PC] = record.pc;
+  regs_[X86_REG_SP] = record.sp;
+}
+
 void RegsX86::IterateRegisters(std::function<void(const char*, uint64_t)> fn) {
   fn("eax", regs_[X86_REG_EAX]);
   fn("ebx", regs_[X86_REG_EBX]);
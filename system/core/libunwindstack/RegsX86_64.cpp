@@ -70,6 +70,28 @@ bool RegsX86_64::SetPcFromReturnAddress(Memory* process_memory) {
   return true;
 }
 
+bool RegsX86_64::ReadFrameRecord(Memory* process_memory, uint64_t stack_end,
+                                 FrameRecord* record) {
+  // rbp points at the saved rbp of the caller, followed by the return address.
+  uint64_t fp = regs_[X86_64_REG_RBP];
+  uint64_t data[2];
+  if ((fp & 0x7) != 0 || fp < regs_[X86_64_REG_SP] || fp >= stack_end ||
+      stack_end - fp < sizeof(data) || !process_memory->ReadFully(fp, data, sizeof(data))) {
+    return false;
+  }
+  record->address = fp;
+  record->fp = data[0];
+  record->pc = data[1];
+  record->sp = fp + sizeof(data);
+  return true;
+}
+
+void RegsX86_64::SetFromFrameRecord(const FrameRecord& record) {
+  regs_[X86_64_REG_RBP] = record.fp;
+  regs_[X86_64_REG_PC] = record.pc;
+  regs_[X86_64_REG_SP] = record.sp;
+}
+
 void RegsX86_64::IterateRegisters(std::function<void(const char*, uint64_t)> fn) {
   fn("rax", regs_[X86_64_REG_RAX]);
   fn("rbx", regs_[X86_64_REG_RBX]);
@@ -19,6 +19,7 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -125,6 +126,29 @@ FrameData* Unwinder::FillInFrame(MapInfo* map_info, Elf* elf, uint64_t rel_pc,
   return frame;
 }
 
+bool Unwinder::StepFromFrameRecord(MapInfo* stack_info) {
+  // The record must be on the same stack as the current frame, which is
+  // stack_info, and the chain must move towards the base of the stack. A zero
+  // frame pointer marks the end of the chain.
+  if (stack_info == nullptr) {
+    return false;
+  }
+  Regs::FrameRecord record;
+  if (!regs_->ReadFrameRecord(process_memory_.get(), stack_info->end, &record) ||
+      (record.fp != 0 && record.fp <= record.address)) {
+    return false;
+  }
+
+  // The return address must be in executable code.
+  MapInfo* pc_info = maps_->Find(record.pc);
+  if (pc_info == nullptr || !(pc_info->flags & PROT_EXEC)) {
+    return false;
+  }
+
+  regs_->SetFromFrameRecord(record);
+  return true;
+}
+
 static bool ShouldStop(const std::vector<std::string>* map_suffixes_to_ignore,
                        std::string& map_name) {
   if (map_suffixes_to_ignore == nullptr) {
@@ -150,6 +174,7 @@ void Unwinder::Unwind(const std::vector<std::string>* initial_map_names_to_skip,
 
   bool return_address_attempt = false;
   bool adjust_pc = false;
+  FrameUnwindMethod unwind_method = FRAME_UNWIND_INITIAL_REGS;
   for (; frames_.size() < max_frames_;) {
     uint64_t cur_pc = regs_->pc();
     uint64_t cur_sp = regs_->sp();
@@ -218,6 +243,7 @@ void Unwinder::Unwind(const std::vector<std::string>* initial_map_names_to_skip,
       }
 
       frame = FillInFrame(map_info, elf, rel_pc, pc_adjustment);
+      frames_.back().unwind_method = unwind_method;
 
       // Once a frame is added, stop skipping frames.
       initial_map_names_to_skip = nullptr;
@@ -226,6 +252,7 @@ void Unwinder::Unwind(const std::vector<std::string>* initial_map_names_to_skip,
 
     bool stepped = false;
     bool in_device_map = false;
+    FrameUnwindMethod next_unwind_method = FRAME_UNWIND_RETURN_ADDRESS;
     bool finished = false;
     if (map_info != nullptr) {
       if (map_info->flags & MAPS_FLAGS_DEVICE_MAP) {
@@ -243,6 +270,7 @@ void Unwinder::Unwind(const std::vector<std::string>* initial_map_names_to_skip,
         } else {
           if (elf->StepIfSignalHandler(rel_pc, regs_, process_memory_.get())) {
             stepped = true;
+            next_unwind_method = FRAME_UNWIND_SIGNAL_HANDLER;
             if (frame != nullptr) {
               // Need to adjust the relative pc because the signal handler
               // pc should not be adjusted.
@@ -250,10 +278,27 @@ void Unwinder::Unwind(const std::vector<std::string>* initial_map_names_to_skip,
               frame->pc += pc_adjustment;
               step_pc = rel_pc;
             }
+          } else if (use_frame_pointers_ &&
+                     (unwind_method == FRAME_UNWIND_DWARF ||
+                      unwind_method == FRAME_UNWIND_FRAME_POINTER) &&
+                     StepFromFrameRecord(sp_info)) {
+            // Only use the record at a call site. The registers of the initial
+            // frame, or of the frame interrupted by a signal, may be anywhere
+            // in a function, before the frame pointer is set up. This needs
+            // no unwind information, so it also steps through code without
+            // any.
+            stepped = true;
+            next_unwind_method = FRAME_UNWIND_FRAME_POINTER;
           } else if (elf->Step(step_pc, regs_, process_memory_.get(), &finished)) {
             stepped = true;
+            next_unwind_method = FRAME_UNWIND_DWARF;
+          }
+          if (next_unwind_method == FRAME_UNWIND_FRAME_POINTER) {
+            last_error_.code = ERROR_NONE;
+            last_error_.address = 0;
+          } else {
+            elf->GetLastError(&last_error_);
           }
-          elf->GetLastError(&last_error_);
         }
       }
     }
@@ -298,6 +343,7 @@ void Unwinder::Unwind(const std::vector<std::string>* initial_map_names_to_skip,
         last_error_.code = ERROR_MAX_FRAMES_EXCEEDED;
       }
     }
+    unwind_method = next_unwind_method;
 
     // If the pc and sp didn't change, then consider everything stopped.
     if (cur_pc == regs_->pc() && cur_sp == regs_->sp()) {
@@ -381,7 +427,9 @@ bool UnwinderFromPid::Init(ArchEnum arch) {
   }
   maps_ = maps_ptr_.get();
 
-  process_memory_ = Memory::CreateProcessMemoryCached(pid_);
+  if (process_memory_ == nullptr) {
+    process_memory_ = Memory::CreateProcessMemoryCached(pid_);
+  }
 
   jit_debug_ptr_.reset(new JitDebug(process_memory_));
   jit_debug_ = jit_debug_ptr_.get();
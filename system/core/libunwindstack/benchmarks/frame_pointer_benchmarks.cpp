@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <unwindstack/MapInfo.h>
+#include <unwindstack/Maps.h>
+#include <unwindstack/Memory.h>
+#include <unwindstack/Regs.h>
+#include <unwindstack/RegsGetLocal.h>
+#include <unwindstack/Unwinder.h>
+
+// Compares unwinding the same stacks using only the unwind information, and
+// using the frame pointer chain wherever the frame records are valid. This is
+// built optimized with frame pointers, like code that would use the frame
+// pointer unwinds.
+
+constexpr size_t kMaxFrames = 128;
+
+// The registers and a copy of the stack taken at the bottom of a chain of
+// calls, so that every iteration unwinds the same frames after the calls
+// have returned.
+struct StackSnapshot {
+  std::unique_ptr<unwindstack::Regs> regs;
+  uint64_t stack_start = 0;
+  std::vector<uint8_t> stack;
+};
+
+// Reads the stack from the snapshot, and everything else from the process.
+class SnapshotMemory : public unwindstack::Memory {
+ public:
+  SnapshotMemory(const StackSnapshot* snapshot, std::shared_ptr<unwindstack::Memory> process_memory)
+      : snapshot_(snapshot), process_memory_(process_memory) {}
+  virtual ~SnapshotMemory() = default;
+
+  size_t Read(uint64_t addr, void* dst, size_t size) override {
+    uint64_t offset = addr - snapshot_->stack_start;
+    if (addr < snapshot_->stack_start || offset >= snapshot_->stack.size()) {
+      return process_memory_->Read(addr, dst, size);
+    }
+    size_t bytes = std::min(size, static_cast<size_t>(snapshot_->stack.size() - offset));
+    memcpy(dst, &snapshot_->stack[offset], bytes);
+    return bytes;
+  }
+
+ private:
+  const StackSnapshot* snapshot_;
+  std::shared_ptr<unwindstack::Memory> process_memory_;
+};
+
+static __attribute__((noinline)) bool TakeSnapshot(unwindstack::Maps* maps,
+                                                   StackSnapshot* snapshot) {
+  snapshot->regs.reset(unwindstack::Regs::CreateFromLocal());
+  unwindstack::RegsGetLocal(snapshot->regs.get());
+  uint64_t sp = snapshot->regs->sp();
+  unwindstack::MapInfo* map_info = maps->Find(sp);
+  if (map_info == nullptr) {
+    return false;
+  }
+  snapshot->stack_start = sp;
+  snapshot->stack.resize(map_info->end - sp);
+  memcpy(snapshot->stack.data(), reinterpret_cast<void*>(sp), snapshot->stack.size());
+  return true;
+}
+
+static __attribute__((noinline)) bool CallChain(size_t depth, unwindstack::Maps* maps,
+                                                StackSnapshot* snapshot) {
+  bool taken = depth == 0 ? TakeSnapshot(maps, snapshot) : CallChain(depth - 1, maps, snapshot);
+  // Keep the calls from becoming tail calls, which would not leave a frame.
+  benchmark::ClobberMemory();
+  return taken;
+}
+
+static void Unwind(const StackSnapshot& snapshot, unwindstack::Maps* maps,
+                   std::shared_ptr<unwindstack::Memory>& memory, bool use_frame_pointers,
+                   std::vector<unwindstack::FrameData>* frames) {
+  std::unique_ptr<unwindstack::Regs> regs(snapshot.regs->Clone());
+  unwindstack::Unwinder unwinder(kMaxFrames, maps, regs.get(), memory);
+  // Only time the steps between the frames.
+  unwinder.SetResolveNames(false);
+  unwinder.SetUseFramePointers(use_frame_pointers);
+  unwinder.Unwind();
+  if (frames != nullptr) {
+    *frames = unwinder.frames();
+  }
+}
+
+static void BM_unwind_snapshot(benchmark::State& state, bool use_frame_pointers) {
+  unwindstack::LocalMaps maps;
+  if (!maps.Parse()) {
+    state.SkipWithError("Failed to parse local maps.");
+    return;
+  }
+
+  StackSnapshot snapshot;
+  if (!CallChain(state.range(0), &maps, &snapshot)) {
+    state.SkipWithError("Failed to find the stack map.");
+    return;
+  }
+  std::shared_ptr<unwindstack::Memory> memory(new SnapshotMemory(
+      &snapshot, unwindstack::Memory::CreateProcessMemoryCached(getpid())));
+
+  // Both kinds of unwind have to find the same frames for the times to be
+  // comparable. The sp of a frame reached through a record is only exact on
+  // x86 and x86_64, so only the pcs are compared. This also loads all of the
+  // elf files before timing.
+  std::vector<unwindstack::FrameData> cfi_frames;
+  std::vector<unwindstack::FrameData> frames;
+  Unwind(snapshot, &maps, memory, false, &cfi_frames);
+  Unwind(snapshot, &maps, memory, use_frame_pointers, &frames);
+  if (frames.size() != cfi_frames.size() ||
+      !std::equal(frames.begin(), frames.end(), cfi_frames.begin(),
+                  [](const unwindstack::FrameData& a, const unwindstack::FrameData& b) {
+                    return a.pc == b.pc;
+                  })) {
+    state.SkipWithError("The unwinds found different frames.");
+    return;
+  }
+  state.counters["frames"] = frames.size();
+  state.counters["fp_frames"] =
+      std::count_if(frames.begin(), frames.end(), [](const unwindstack::FrameData& frame) {
+        return frame.unwind_method == unwindstack::FRAME_UNWIND_FRAME_POINTER;
+      });
+
+  for (auto _ : state) {
+    Unwind(snapshot, &maps, memory, use_frame_pointers, nullptr);
+  }
+}
+BENCHMARK_CAPTURE(BM_unwind_snapshot, cfi, false)->Arg(8)->Arg(32);
+BENCHMARK_CAPTURE(BM_unwind_snapshot, frame_pointers, true)->Arg(8)->Arg(32);
+
+BENCHMARK_MAIN();
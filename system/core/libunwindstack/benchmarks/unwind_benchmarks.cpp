@@ -15,8 +15,12 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 
+#include <algorithm>
 #include <memory>
+#include <random>
+#include <vector>
 
 #include <benchmark/benchmark.h>
 
@@ -29,6 +33,9 @@
 #include <unwindstack/RegsGetLocal.h>
 #include <unwindstack/Unwinder.h>
 
+#include "DwarfDebugFrame.h"
+#include "MemoryBuffer.h"
+
 size_t Call6(std::shared_ptr<unwindstack::Memory>& process_memory, unwindstack::Maps* maps) {
   std::unique_ptr<unwindstack::Regs> regs(unwindstack::Regs::CreateFromLocal());
   unwindstack::RegsGetLocal(regs.get());
@@ -142,4 +149,81 @@ static void BM_get_build_id_from_file(benchmark::State& state) {
 }
 BENCHMARK(BM_get_build_id_from_file);
 
+// Number of fdes in the generated .debug_frame sections. This is in the
+// range of what large shared libraries have.
+constexpr size_t kNumDebugFrameFdes = 20000;
+constexpr uint32_t kDebugFrameFdePcSize = 0x40;
+
+// Creates a .debug_frame section with a single cie and kNumDebugFrameFdes
+// fdes in random order, as .debug_frame is not sorted by pc. The fde i
+// covers the pcs [i * kDebugFrameFdePcSize, (i + 1) * kDebugFrameFdePcSize).
+static void CreateDebugFrame(unwindstack::MemoryBuffer* memory) {
+  std::vector<uint8_t> data;
+  auto append32 = [&data](uint32_t value) {
+    uint8_t bytes[sizeof(value)];
+    memcpy(bytes, &value, sizeof(value));
+    data.insert(data.end(), bytes, bytes + sizeof(value));
+  };
+
+  // Cie: version 1, no augmentation, code alignment 1, data alignment -4,
+  // return address register 1, padded with DW_CFA_nop.
+  append32(12);
+  append32(0xffffffff);
+  data.insert(data.end(), {1, '\0', 1, 0x7c, 1, 0, 0, 0});
+
+  std::vector<uint32_t> order(kNumDebugFrameFdes);
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(0));
+  for (uint32_t index : order) {
+    append32(12);
+    // Offset of the cie.
+    append32(0);
+    append32(index * kDebugFrameFdePcSize);
+    append32(kDebugFrameFdePcSize);
+  }
+
+  memory->Resize(data.size());
+  memcpy(memory->GetPtr(0), data.data(), data.size());
+}
+
+// Measures the first lookup in a .debug_frame section, which includes
+// reading the section far enough to find the fde.
+static void BM_debug_frame_first_lookup(benchmark::State& state) {
+  unwindstack::MemoryBuffer memory;
+  CreateDebugFrame(&memory);
+
+  uint64_t pc = 0;
+  for (auto _ : state) {
+    unwindstack::DwarfDebugFrame<uint64_t> debug_frame(&memory);
+    if (!debug_frame.Init(0, memory.Size(), 0)) {
+      state.SkipWithError("Failed to init the debug frame.");
+      break;
+    }
+    benchmark::DoNotOptimize(debug_frame.GetFdeFromPc(pc));
+    pc = (pc + 997 * kDebugFrameFdePcSize) % (kNumDebugFrameFdes * kDebugFrameFdePcSize);
+  }
+}
+BENCHMARK(BM_debug_frame_first_lookup);
+
+// Measures lookups in a .debug_frame section that has already been used,
+// like an elf in the elf cache.
+static void BM_debug_frame_lookup(benchmark::State& state) {
+  unwindstack::MemoryBuffer memory;
+  CreateDebugFrame(&memory);
+  unwindstack::DwarfDebugFrame<uint64_t> debug_frame(&memory);
+  if (!debug_frame.Init(0, memory.Size(), 0)) {
+    state.SkipWithError("Failed to init the debug frame.");
+    return;
+  }
+
+  std::mt19937 random(0);
+  std::uniform_int_distribution<uint64_t> pcs(0, kNumDebugFrameFdes * kDebugFrameFdePcSize - 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(debug_frame.GetFdeFromPc(pcs(random)));
+  }
+}
+BENCHMARK(BM_debug_frame_lookup);
+
 BENCHMARK_MAIN();
@@ -22,6 +22,7 @@
 #include <iterator>
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 #include <unwindstack/DwarfError.h>
 #include <unwindstack/DwarfLocation.h>
@@ -158,7 +159,11 @@ class DwarfSectionImpl : public DwarfSection {
   bool EvalExpression(const DwarfLocation& loc, Memory* regular_memory, AddressType* value,
                       RegsInfo<AddressType>* regs_info, bool* is_dex_pc);
 
-  void InsertFde(const DwarfFde* fde);
+  bool ReadFdePcRange(const DwarfCie* cie, uint64_t* pc_start, uint64_t* pc_end);
+
+  void BuildFdeIndex();
+
+  void ResolveOverlappingFdes();
 
   int64_t section_bias_ = 0;
   uint64_t entries_offset_ = 0;
@@ -166,7 +171,22 @@ class DwarfSectionImpl : public DwarfSection {
   uint64_t next_entries_offset_ = 0;
   uint64_t pc_offset_ = 0;
 
-  std::map<uint64_t, std::pair<uint64_t, const DwarfFde*>> fdes_;
+  // A pc range covered by a single fde, the fde is identified by its offset
+  // and only fully read when it is needed.
+  struct FdeRange {
+    uint64_t pc_start;
+    uint64_t pc_end;
+    uint64_t fde_offset;
+  };
+
+  // Non overlapping pc ranges of all of the fdes in the section sorted by pc.
+  // Built on the first pc lookup. Sections are usually only used through
+  // Elf objects, so the index is shared by everything sharing the Elf, for
+  // example through the Elf cache.
+  std::vector<FdeRange> fde_index_;
+  bool fde_index_built_ = false;
+  // Set if the section could not be fully indexed because of an error.
+  DwarfErrorData fde_index_error_{DWARF_ERROR_NONE, 0};
 };
 
 }  // namespace unwindstack
@@ -33,6 +33,12 @@ class Memory {
 
   static std::shared_ptr<Memory> CreateProcessMemory(pid_t pid);
   static std::shared_ptr<Memory> CreateProcessMemoryCached(pid_t pid);
+  // Like CreateProcessMemoryCached, but safe to share between threads. Reads
+  // that process_vm_readv can't do fall back to ptrace, which only works on
+  // the thread attached to pid, and once one succeeds every later read uses
+  // ptrace, so other threads should only read while process_vm_readv works
+  // and must tolerate failed reads.
+  static std::shared_ptr<Memory> CreateProcessMemoryThreadCached(pid_t pid);
   static std::shared_ptr<Memory> CreateOfflineMemory(const uint8_t* data, uint64_t start,
                                                      uint64_t end);
   static std::unique_ptr<Memory> CreateFileMemory(const std::string& path, uint64_t offset);
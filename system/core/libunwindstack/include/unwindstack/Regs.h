@@ -46,6 +46,19 @@ class Regs {
     int16_t value;
   };
 
+  // A frame record as laid out by code built with frame pointers. The frame
+  // pointer of a function points at the record, which holds the frame pointer
+  // and the return address of its caller.
+  struct FrameRecord {
+    // The address of the record, i.e. the current frame pointer.
+    uint64_t address;
+    uint64_t fp;
+    uint64_t pc;
+    // The address just above the record. This is the sp of the caller on
+    // x86 and x86_64, and the lowest it can be on arm64.
+    uint64_t sp;
+  };
+
   Regs(uint16_t total_regs, const Location& return_loc)
       : total_regs_(total_regs), return_loc_(return_loc) {}
   virtual ~Regs() = default;
@@ -70,6 +83,18 @@ class Regs {
 
   virtual bool SetPcFromReturnAddress(Memory* process_memory) = 0;
 
+  // Reads the frame record that the frame pointer points to. Returns false if
+  // the architecture has no frame pointer chain, or the record does not lie
+  // between the sp and stack_end, or it cannot be read. The record is only
+  // meaningful if the current pc is at a call site of a function that keeps
+  // a frame pointer.
+  virtual bool ReadFrameRecord(Memory* process_memory, uint64_t stack_end,
+                               FrameRecord* record) = 0;
+
+  // Steps to the caller described by a record from ReadFrameRecord. Only the
+  // pc, sp and frame pointer are changed.
+  virtual void SetFromFrameRecord(const FrameRecord& record) = 0;
+
   virtual void IterateRegisters(std::function<void(const char*, uint64_t)>) = 0;
 
   uint16_t total_regs() { return total_regs_; }
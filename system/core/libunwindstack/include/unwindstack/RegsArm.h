@@ -40,6 +40,10 @@ class RegsArm : public RegsImpl<uint32_t> {
 
   bool SetPcFromReturnAddress(Memory* process_memory) override;
 
+  bool ReadFrameRecord(Memory* process_memory, uint64_t stack_end, FrameRecord* record) override;
+
+  void SetFromFrameRecord(const FrameRecord& record) override;
+
   bool StepIfSignalHandler(uint64_t elf_offset, Elf* elf, Memory* process_memory) override;
 
   void IterateRegisters(std::function<void(const char*, uint64_t)>) override final;
@@ -41,6 +41,10 @@ class RegsX86 : public RegsImpl<uint32_t> {
 
   bool SetPcFromReturnAddress(Memory* process_memory) override;
 
+  bool ReadFrameRecord(Memory* process_memory, uint64_t stack_end, FrameRecord* record) override;
+
+  void SetFromFrameRecord(const FrameRecord& record) override;
+
   bool StepIfSignalHandler(uint64_t elf_offset, Elf* elf, Memory* process_memory) override;
 
   void SetFromUcontext(x86_ucontext_t* ucontext);
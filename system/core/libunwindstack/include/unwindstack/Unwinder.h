@@ -37,6 +37,15 @@ namespace unwindstack {
 class Elf;
 enum ArchEnum : uint8_t;
 
+// How the registers of a frame were recovered from the frame before it.
+enum FrameUnwindMethod : uint8_t {
+  FRAME_UNWIND_INITIAL_REGS = 0,  // The registers the unwind started with.
+  FRAME_UNWIND_DWARF,             // The unwind information of the elf.
+  FRAME_UNWIND_FRAME_POINTER,     // The frame record of the frame pointer chain.
+  FRAME_UNWIND_SIGNAL_HANDLER,    // The context saved by the signal handler.
+  FRAME_UNWIND_RETURN_ADDRESS,    // A guess using the return address.
+};
+
 struct FrameData {
   size_t num;
 
@@ -59,6 +68,8 @@ struct FrameData {
   uint64_t map_end = 0;
   uint64_t map_load_bias = 0;
   int map_flags = 0;
+
+  FrameUnwindMethod unwind_method = FRAME_UNWIND_INITIAL_REGS;
 };
 
 class Unwinder {
@@ -78,6 +89,7 @@ class Unwinder {
               const std::vector<std::string>* map_suffixes_to_ignore = nullptr);
 
   size_t NumFrames() const { return frames_.size(); }
+  size_t GetMaxFrames() const { return max_frames_; }
 
   const std::vector<FrameData>& frames() { return frames_; }
 
@@ -95,6 +107,8 @@ class Unwinder {
   void SetRegs(Regs* regs) { regs_ = regs; }
   Maps* GetMaps() { return maps_; }
   std::shared_ptr<Memory>& GetProcessMemory() { return process_memory_; }
+  JitDebug* GetJitDebug() { return jit_debug_; }
+  DexFiles* GetDexFiles() { return dex_files_; }
 
   // Disabling the resolving of names results in the function name being
   // set to an empty string and the function offset being set to zero.
@@ -107,6 +121,20 @@ class Unwinder {
 
   void SetDisplayBuildID(bool display_build_id) { display_build_id_ = display_build_id; }
 
+  // Follow the frame pointer chain instead of evaluating the unwind
+  // information when stepping from a function called by another. A frame
+  // record is used if it lies on the current stack, is aligned, moves towards
+  // the base of the stack and returns into executable code. Otherwise the
+  // frame is stepped with the unwind information, and the chain is picked up
+  // again in its caller. The unwind information is not looked at for frames
+  // that have a valid record, so code without any can be unwound, but the
+  // callers of functions that do not keep a frame pointer are skipped.
+  // Only the pc, sp and frame pointer are recovered through a record, and on
+  // arm64 the sp is the address just above it rather than the real sp of the
+  // caller.
+  // This is disabled by default.
+  void SetUseFramePointers(bool use_frame_pointers) { use_frame_pointers_ = use_frame_pointers; }
+
   void SetDexFiles(DexFiles* dex_files, ArchEnum arch);
 
   bool elf_from_memory_not_file() { return elf_from_memory_not_file_; }
@@ -119,6 +147,7 @@ class Unwinder {
 
   void FillInDexFrame();
   FrameData* FillInFrame(MapInfo* map_info, Elf* elf, uint64_t rel_pc, uint64_t pc_adjustment);
+  bool StepFromFrameRecord(MapInfo* stack_info);
 
   size_t max_frames_;
   Maps* maps_;
@@ -130,6 +159,7 @@ class Unwinder {
   bool resolve_names_ = true;
   bool embedded_soname_ = true;
   bool display_build_id_ = false;
+  bool use_frame_pointers_ = false;
   // True if at least one elf file is coming from memory and not the related
   // file. This is only true if there is an actual file backing up the elf.
   bool elf_from_memory_not_file_ = false;
@@ -139,6 +169,11 @@ class Unwinder {
 class UnwinderFromPid : public Unwinder {
  public:
   UnwinderFromPid(size_t max_frames, pid_t pid) : Unwinder(max_frames), pid_(pid) {}
+  // Unwinds through the given process memory rather than creating a cached one.
+  UnwinderFromPid(size_t max_frames, pid_t pid, std::shared_ptr<Memory> process_memory)
+      : Unwinder(max_frames), pid_(pid) {
+    process_memory_ = process_memory;
+  }
   virtual ~UnwinderFromPid() = default;
 
   bool Init(ArchEnum arch);
@@ -870,6 +870,34 @@ TYPED_TEST_P(DwarfDebugFrameTest, GetFdeFromPc_overlap) {
   ASSERT_TRUE(fde == nullptr);
 }
 
+TYPED_TEST_P(DwarfDebugFrameTest, GetFdeFromPc_bad_cie) {
+  SetCie32(&this->memory_, 0x5000, 0xfc, std::vector<uint8_t>{1, '\0', 0, 0, 1});
+
+  // FDE 0 (0x100 - 0x200)
+  SetFde32(&this->memory_, 0x5100, 0xfc, 0, 0x100, 0x100);
+  // FDE 1 (0x300 - 0x400) with an unsupported cie.
+  SetFde32(&this->memory_, 0x5200, 0xfc, 0x300, 0x300, 0x100);
+  SetCie32(&this->memory_, 0x5300, 0xfc, std::vector<uint8_t>{20, '\0', 0, 0, 1});
+  // FDE 2 (0x500 - 0x600)
+  SetFde32(&this->memory_, 0x5400, 0xfc, 0, 0x500, 0x100);
+
+  this->debug_frame_->Init(0x5000, 0x500, 0);
+
+  // The fdes before the bad one can still be found.
+  const DwarfFde* fde = this->debug_frame_->GetFdeFromPc(0x150);
+  ASSERT_TRUE(fde != nullptr);
+  EXPECT_EQ(0x100U, fde->pc_start);
+  EXPECT_EQ(0x200U, fde->pc_end);
+  EXPECT_EQ(DWARF_ERROR_NONE, this->debug_frame_->LastErrorCode());
+
+  // Any other pc reports the error every time it is looked up.
+  for (size_t i = 0; i < 2; i++) {
+    fde = this->debug_frame_->GetFdeFromPc(0x550);
+    ASSERT_TRUE(fde == nullptr);
+    EXPECT_EQ(DWARF_ERROR_UNSUPPORTED_VERSION, this->debug_frame_->LastErrorCode());
+  }
+}
+
 REGISTER_TYPED_TEST_SUITE_P(
     DwarfDebugFrameTest, GetFdes32, GetFdes32_after_GetFdeFromPc, GetFdes32_not_in_section,
     GetFdeFromPc32, GetFdeFromPc32_reverse, GetFdeFromPc32_not_in_section, GetFdes64,
@@ -880,7 +908,8 @@ REGISTER_TYPED_TEST_SUITE_P(
     GetCieFromOffset64_version4, GetCieFromOffset32_version5, GetCieFromOffset64_version5,
     GetCieFromOffset_version_invalid, GetCieFromOffset32_augment, GetCieFromOffset64_augment,
     GetFdeFromOffset32_augment, GetFdeFromOffset64_augment, GetFdeFromOffset32_lsda_address,
-    GetFdeFromOffset64_lsda_address, GetFdeFromPc_interleaved, GetFdeFromPc_overlap);
+    GetFdeFromOffset64_lsda_address, GetFdeFromPc_interleaved, GetFdeFromPc_overlap,
+    GetFdeFromPc_bad_cie);
 
 typedef ::testing::Types<uint32_t, uint64_t> DwarfDebugFrameTestTypes;
 INSTANTIATE_TYPED_TEST_SUITE_P(Libunwindstack, DwarfDebugFrameTest, DwarfDebugFrameTestTypes);
@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 
+#include <thread>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -139,4 +140,48 @@ TEST_F(MemoryCacheTest, read_for_cache_fail_cross) {
   ASSERT_EQ(expect, buffer);
 }
 
+TEST(MemoryThreadCacheTest, cached_read_per_thread) {
+  MemoryFake* memory = new MemoryFake;
+  MemoryThreadCache memory_cache(memory);
+  memory->SetMemoryBlock(0x8000, 4096, 0xab);
+
+  std::vector<uint8_t> buffer(16);
+  ASSERT_TRUE(memory_cache.ReadFully(0x8010, buffer.data(), buffer.size()));
+  ASSERT_EQ(std::vector<uint8_t>(16, 0xab), buffer);
+
+  // This thread keeps using its cached data, while a new thread fills its own cache.
+  memory->SetMemoryBlock(0x8000, 4096, 0xff);
+  ASSERT_TRUE(memory_cache.ReadFully(0x8010, buffer.data(), buffer.size()));
+  ASSERT_EQ(std::vector<uint8_t>(16, 0xab), buffer);
+
+  std::vector<uint8_t> thread_buffer(16);
+  bool thread_read = false;
+  std::thread thread([&]() {
+    thread_read = memory_cache.ReadFully(0x8010, thread_buffer.data(), thread_buffer.size());
+  });
+  thread.join();
+  ASSERT_TRUE(thread_read);
+  ASSERT_EQ(std::vector<uint8_t>(16, 0xff), thread_buffer);
+}
+
+TEST(MemoryThreadCacheTest, clear_only_current_thread) {
+  MemoryFake* memory = new MemoryFake;
+  MemoryThreadCache memory_cache(memory);
+  memory->SetMemoryBlock(0x8000, 4096, 0xab);
+
+  std::vector<uint8_t> buffer(16);
+  ASSERT_TRUE(memory_cache.ReadFully(0x8010, buffer.data(), buffer.size()));
+  memory->SetMemoryBlock(0x8000, 4096, 0xff);
+
+  // Clearing from another thread leaves this thread's cache alone.
+  std::thread thread([&]() { memory_cache.Clear(); });
+  thread.join();
+  ASSERT_TRUE(memory_cache.ReadFully(0x8010, buffer.data(), buffer.size()));
+  ASSERT_EQ(std::vector<uint8_t>(16, 0xab), buffer);
+
+  memory_cache.Clear();
+  ASSERT_TRUE(memory_cache.ReadFully(0x8010, buffer.data(), buffer.size()));
+  ASSERT_EQ(std::vector<uint8_t>(16, 0xff), buffer);
+}
+
 }  // namespace unwindstack
@@ -19,6 +19,8 @@
 
 #include <stdint.h>
 
+#include <deque>
+
 #include <unwindstack/Elf.h>
 #include <unwindstack/Memory.h>
 #include <unwindstack/Regs.h>
@@ -47,6 +49,20 @@ class RegsFake : public Regs {
     return true;
   }
 
+  bool ReadFrameRecord(Memory*, uint64_t, FrameRecord* record) override {
+    if (fake_frame_records_.empty()) {
+      return false;
+    }
+    *record = fake_frame_records_.front();
+    return true;
+  }
+
+  void SetFromFrameRecord(const FrameRecord& record) override {
+    fake_pc_ = record.pc;
+    fake_sp_ = record.sp;
+    fake_frame_records_.pop_front();
+  }
+
   void IterateRegisters(std::function<void(const char*, uint64_t)>) override {}
 
   bool Is32Bit() {
@@ -62,6 +78,10 @@ class RegsFake : public Regs {
   void FakeSetDexPc(uint64_t dex_pc) { dex_pc_ = dex_pc; }
   void FakeSetReturnAddress(uint64_t return_address) { fake_return_address_ = return_address; }
   void FakeSetReturnAddressValid(bool valid) { fake_return_address_valid_ = valid; }
+  void FakePushFrameRecord(uint64_t address, uint64_t fp, uint64_t pc, uint64_t sp) {
+    fake_frame_records_.push_back(FrameRecord{address, fp, pc, sp});
+  }
+  void FakeClearFrameRecords() { fake_frame_records_.clear(); }
 
   Regs* Clone() override { return nullptr; }
 
@@ -71,6 +91,7 @@ class RegsFake : public Regs {
   uint64_t fake_sp_ = 0;
   bool fake_return_address_valid_ = false;
   uint64_t fake_return_address_ = 0;
+  std::deque<FrameRecord> fake_frame_records_;
 };
 
 template <typename TypeParam>
@@ -88,6 +109,8 @@ class RegsImplFake : public RegsImpl<TypeParam> {
 
   uint64_t GetPcAdjustment(uint64_t, Elf*) override { return 0; }
   bool SetPcFromReturnAddress(Memory*) override { return false; }
+  bool ReadFrameRecord(Memory*, uint64_t, Regs::FrameRecord*) override { return false; }
+  void SetFromFrameRecord(const Regs::FrameRecord&) override {}
   bool StepIfSignalHandler(uint64_t, Elf*, Memory*) override { return false; }
 
   Regs* Clone() override { return nullptr; }
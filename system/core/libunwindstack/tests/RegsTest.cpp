@@ -20,6 +20,9 @@
 
 #include <unwindstack/Elf.h>
 #include <unwindstack/ElfInterface.h>
+#include <unwindstack/MachineArm64.h>
+#include <unwindstack/MachineX86.h>
+#include <unwindstack/MachineX86_64.h>
 #include <unwindstack/MapInfo.h>
 #include <unwindstack/RegsArm.h>
 #include <unwindstack/RegsArm64.h>
@@ -266,6 +269,116 @@ TEST_F(RegsTest, mips64_verify_sp_pc) {
   EXPECT_EQ(0xc200000000U, mips64.pc());
 }
 
+TEST_F(RegsTest, arm64_frame_record) {
+  RegsArm64 arm64;
+  arm64[ARM64_REG_R29] = 0x1000;
+  arm64[ARM64_REG_SP] = 0xf00;
+  arm64[ARM64_REG_PC] = 0x2000;
+  memory_->SetData64(0x1000, 0x1100);
+  memory_->SetData64(0x1008, 0x3004);
+
+  Regs::FrameRecord record;
+  ASSERT_TRUE(arm64.ReadFrameRecord(memory_, 0x2000, &record));
+  EXPECT_EQ(0x1000U, record.address);
+  EXPECT_EQ(0x1100U, record.fp);
+  EXPECT_EQ(0x3004U, record.pc);
+  EXPECT_EQ(0x1010U, record.sp);
+
+  arm64.SetFromFrameRecord(record);
+  EXPECT_EQ(0x1100U, arm64[ARM64_REG_R29]);
+  EXPECT_EQ(0x3004U, arm64.pc());
+  EXPECT_EQ(0x1010U, arm64.sp());
+
+  // The record cannot be read.
+  EXPECT_FALSE(arm64.ReadFrameRecord(memory_, 0x2000, &record));
+
+  // Misaligned frame pointer.
+  arm64[ARM64_REG_R29] = 0x1004;
+  EXPECT_FALSE(arm64.ReadFrameRecord(memory_, 0x2000, &record));
+
+  // The record is not below the end of the stack.
+  arm64[ARM64_REG_R29] = 0x1000;
+  arm64[ARM64_REG_SP] = 0xf00;
+  EXPECT_TRUE(arm64.ReadFrameRecord(memory_, 0x1010, &record));
+  EXPECT_FALSE(arm64.ReadFrameRecord(memory_, 0x1008, &record));
+
+  // The record is below the sp.
+  arm64[ARM64_REG_SP] = 0x1008;
+  EXPECT_FALSE(arm64.ReadFrameRecord(memory_, 0x2000, &record));
+}
+
+TEST_F(RegsTest, x86_frame_record) {
+  RegsX86 x86;
+  x86[X86_REG_EBP] = 0x1000;
+  x86[X86_REG_SP] = 0xf00;
+  x86[X86_REG_PC] = 0x2000;
+  memory_->SetData32(0x1000, 0x1100);
+  memory_->SetData32(0x1004, 0x3004);
+
+  Regs::FrameRecord record;
+  ASSERT_TRUE(x86.ReadFrameRecord(memory_, 0x2000, &record));
+  EXPECT_EQ(0x1000U, record.address);
+  EXPECT_EQ(0x1100U, record.fp);
+  EXPECT_EQ(0x3004U, record.pc);
+  EXPECT_EQ(0x1008U, record.sp);
+
+  x86.SetFromFrameRecord(record);
+  EXPECT_EQ(0x1100U, x86[X86_REG_EBP]);
+  EXPECT_EQ(0x3004U, x86.pc());
+  EXPECT_EQ(0x1008U, x86.sp());
+
+  EXPECT_FALSE(x86.ReadFrameRecord(memory_, 0x2000, &record));
+}
+
+TEST_F(RegsTest, x86_64_frame_record) {
+  RegsX86_64 x86_64;
+  x86_64[X86_64_REG_RBP] = 0x1000;
+  x86_64[X86_64_REG_SP] = 0xf00;
+  x86_64[X86_64_REG_PC] = 0x2000;
+  memory_->SetData64(0x1000, 0x1100);
+  memory_->SetData64(0x1008, 0x3004);
+
+  Regs::FrameRecord record;
+  ASSERT_TRUE(x86_64.ReadFrameRecord(memory_, 0x2000, &record));
+  EXPECT_EQ(0x1000U, record.address);
+  EXPECT_EQ(0x1100U, record.fp);
+  EXPECT_EQ(0x3004U, record.pc);
+  EXPECT_EQ(0x1010U, record.sp);
+
+  x86_64.SetFromFrameRecord(record);
+  EXPECT_EQ(0x1100U, x86_64[X86_64_REG_RBP]);
+  EXPECT_EQ(0x3004U, x86_64.pc());
+  EXPECT_EQ(0x1010U, x86_64.sp());
+
+  // The record cannot be read.
+  EXPECT_FALSE(x86_64.ReadFrameRecord(memory_, 0x2000, &record));
+
+  // Misaligned frame pointer.
+  x86_64[X86_64_REG_RBP] = 0x1004;
+  x86_64[X86_64_REG_SP] = 0xf00;
+  EXPECT_FALSE(x86_64.ReadFrameRecord(memory_, 0x2000, &record));
+
+  // The record is below the sp.
+  x86_64[X86_64_REG_RBP] = 0x1000;
+  EXPECT_TRUE(x86_64.ReadFrameRecord(memory_, 0x2000, &record));
+  x86_64[X86_64_REG_SP] = 0x1008;
+  EXPECT_FALSE(x86_64.ReadFrameRecord(memory_, 0x2000, &record));
+}
+
+TEST_F(RegsTest, frame_record_unsupported) {
+  memory_->SetMemoryBlock(0, 0x100, 0);
+  Regs::FrameRecord record;
+
+  RegsArm arm;
+  EXPECT_FALSE(arm.ReadFrameRecord(memory_, 0x2000, &record));
+
+  RegsMips mips;
+  EXPECT_FALSE(mips.ReadFrameRecord(memory_, 0x2000, &record));
+
+  RegsMips64 mips64;
+  EXPECT_FALSE(mips64.ReadFrameRecord(memory_, 0x2000, &record));
+}
+
 TEST_F(RegsTest, machine_type) {
   RegsArm arm_regs;
   EXPECT_EQ(ARCH_ARM, arm_regs.Arch());
@@ -143,6 +143,7 @@ class UnwinderTest : public ::testing::Test {
     ElfInterfaceFake::FakeClear();
     regs_.FakeSetArch(ARCH_ARM);
     regs_.FakeSetReturnAddressValid(false);
+    regs_.FakeClearFrameRecords();
   }
 
   static std::unique_ptr<Maps> maps_;
@@ -662,6 +663,170 @@ TEST_F(UnwinderTest, pc_without_map) {
   EXPECT_EQ(0, frame->map_flags);
 }
 
+// Verify that the frame pointer chain is used once a frame is at a call site.
+TEST_F(UnwinderTest, frame_pointer_unwind) {
+  regs_.set_pc(0xc1100);
+  regs_.set_sp(0x10000);
+
+  // The initial frame always uses the unwind information.
+  ElfInterfaceFake::FakePushStepData(StepData(0xc1202, 0x10010, false));
+  // The next two frames have valid records.
+  regs_.FakePushFrameRecord(0x10020, 0x10100, 0xc2302, 0x10030);
+  regs_.FakePushFrameRecord(0x10100, 0, 0xc1402, 0x10110);
+  // The last frame does not, and falls back to the unwind information.
+  ElfInterfaceFake::FakePushStepData(StepData(0, 0, true));
+
+  Unwinder unwinder(64, maps_.get(), &regs_, process_memory_);
+  unwinder.SetUseFramePointers(true);
+  unwinder.SetResolveNames(false);
+  unwinder.Unwind();
+  EXPECT_EQ(ERROR_NONE, unwinder.LastErrorCode());
+
+  ASSERT_EQ(4U, unwinder.NumFrames());
+
+  auto* frame = &unwinder.frames()[0];
+  EXPECT_EQ(0xc1100U, frame->pc);
+  EXPECT_EQ(0x10000U, frame->sp);
+  EXPECT_EQ(FRAME_UNWIND_INITIAL_REGS, frame->unwind_method);
+
+  frame = &unwinder.frames()[1];
+  EXPECT_EQ(0xc1200U, frame->pc);
+  EXPECT_EQ(0x10010U, frame->sp);
+  EXPECT_EQ(FRAME_UNWIND_DWARF, frame->unwind_method);
+
+  frame = &unwinder.frames()[2];
+  EXPECT_EQ(0xc2300U, frame->pc);
+  EXPECT_EQ(0x10030U, frame->sp);
+  EXPECT_EQ(FRAME_UNWIND_FRAME_POINTER, frame->unwind_method);
+
+  frame = &unwinder.frames()[3];
+  EXPECT_EQ(0xc1400U, frame->pc);
+  EXPECT_EQ(0x10110U, frame->sp);
+  EXPECT_EQ(FRAME_UNWIND_FRAME_POINTER, frame->unwind_method);
+}
+
+// Verify that frame records that do not look valid are not followed.
+TEST_F(UnwinderTest, frame_pointer_unwind_invalid_record) {
+  regs_.set_pc(0xc1100);
+  regs_.set_sp(0x10000);
+
+  ElfInterfaceFake::FakePushStepData(StepData(0xc1202, 0x10010, false));
+  // The chain does not move up the stack.
+  regs_.FakePushFrameRecord(0x10020, 0x10020, 0xc2302, 0x10030);
+  ElfInterfaceFake::FakePushStepData(StepData(0xc2402, 0x10040, false));
+  ElfInterfaceFake::FakePushStepData(StepData(0, 0, true));
+
+  Unwinder unwinder(64, maps_.get(), &regs_, process_memory_);
+  unwinder.SetUseFramePointers(true);
+  unwinder.SetResolveNames(false);
+  unwinder.Unwind();
+  EXPECT_EQ(ERROR_NONE, unwinder.LastErrorCode());
+
+  ASSERT_EQ(3U, unwinder.NumFrames());
+  EXPECT_EQ(FRAME_UNWIND_INITIAL_REGS, unwinder.frames()[0].unwind_method);
+  EXPECT_EQ(FRAME_UNWIND_DWARF, unwinder.frames()[1].unwind_method);
+  EXPECT_EQ(0xc2400U, unwinder.frames()[2].pc);
+  EXPECT_EQ(0x10040U, unwinder.frames()[2].sp);
+  EXPECT_EQ(FRAME_UNWIND_DWARF, unwinder.frames()[2].unwind_method);
+
+  // The return address is not in executable code.
+  regs_.FakeClearFrameRecords();
+  regs_.set_pc(0xc1100);
+  regs_.set_sp(0x10000);
+  ElfInterfaceFake::FakePushStepData(StepData(0xc1202, 0x10010, false));
+  regs_.FakePushFrameRecord(0x10020, 0x10100, 0x1302, 0x10030);
+  ElfInterfaceFake::FakePushStepData(StepData(0xc2402, 0x10040, false));
+  ElfInterfaceFake::FakePushStepData(StepData(0, 0, true));
+  unwinder.Unwind();
+  EXPECT_EQ(ERROR_NONE, unwinder.LastErrorCode());
+
+  ASSERT_EQ(3U, unwinder.NumFrames());
+  EXPECT_EQ(0xc2400U, unwinder.frames()[2].pc);
+  EXPECT_EQ(FRAME_UNWIND_DWARF, unwinder.frames()[2].unwind_method);
+}
+
+// Verify that the frame pointer chain steps through code without unwind
+// information.
+TEST_F(UnwinderTest, frame_pointer_unwind_no_unwind_info) {
+  regs_.set_pc(0xc1100);
+  regs_.set_sp(0x10000);
+
+  // The caller is in a map without a valid elf.
+  ElfInterfaceFake::FakePushStepData(StepData(0xa3102, 0x10010, false));
+  regs_.FakePushFrameRecord(0x10020, 0, 0xc1402, 0x10030);
+  ElfInterfaceFake::FakePushStepData(StepData(0, 0, true));
+
+  Unwinder unwinder(64, maps_.get(), &regs_, process_memory_);
+  unwinder.SetUseFramePointers(true);
+  unwinder.SetResolveNames(false);
+  unwinder.Unwind();
+  EXPECT_EQ(ERROR_NONE, unwinder.LastErrorCode());
+
+  ASSERT_EQ(3U, unwinder.NumFrames());
+  EXPECT_EQ(FRAME_UNWIND_INITIAL_REGS, unwinder.frames()[0].unwind_method);
+
+  auto* frame = &unwinder.frames()[1];
+  EXPECT_EQ(0xa3100U, frame->pc);
+  EXPECT_EQ(0x10010U, frame->sp);
+  EXPECT_EQ(FRAME_UNWIND_DWARF, frame->unwind_method);
+
+  frame = &unwinder.frames()[2];
+  EXPECT_EQ(0xc1400U, frame->pc);
+  EXPECT_EQ(0x10030U, frame->sp);
+  EXPECT_EQ(FRAME_UNWIND_FRAME_POINTER, frame->unwind_method);
+}
+
+// Verify that a frame record is not used if the sp is not in a map, and that
+// the chain is picked up again once it is.
+TEST_F(UnwinderTest, frame_pointer_unwind_sp_not_in_map) {
+  regs_.set_pc(0xc1100);
+  regs_.set_sp(0x10000);
+
+  ElfInterfaceFake::FakePushStepData(StepData(0xc1202, 0x9000, false));
+  ElfInterfaceFake::FakePushStepData(StepData(0xc2402, 0x10040, false));
+  regs_.FakePushFrameRecord(0x10050, 0, 0xc1402, 0x10060);
+  ElfInterfaceFake::FakePushStepData(StepData(0, 0, true));
+
+  Unwinder unwinder(64, maps_.get(), &regs_, process_memory_);
+  unwinder.SetUseFramePointers(true);
+  unwinder.SetResolveNames(false);
+  unwinder.Unwind();
+  EXPECT_EQ(ERROR_NONE, unwinder.LastErrorCode());
+
+  ASSERT_EQ(4U, unwinder.NumFrames());
+  EXPECT_EQ(0x9000U, unwinder.frames()[1].sp);
+
+  auto* frame = &unwinder.frames()[2];
+  EXPECT_EQ(0xc2400U, frame->pc);
+  EXPECT_EQ(0x10040U, frame->sp);
+  EXPECT_EQ(FRAME_UNWIND_DWARF, frame->unwind_method);
+
+  frame = &unwinder.frames()[3];
+  EXPECT_EQ(0xc1400U, frame->pc);
+  EXPECT_EQ(0x10060U, frame->sp);
+  EXPECT_EQ(FRAME_UNWIND_FRAME_POINTER, frame->unwind_method);
+}
+
+// Verify that the frame pointer chain is not used unless enabled.
+TEST_F(UnwinderTest, frame_pointer_unwind_disabled) {
+  regs_.set_pc(0xc1100);
+  regs_.set_sp(0x10000);
+
+  ElfInterfaceFake::FakePushStepData(StepData(0xc1202, 0x10010, false));
+  regs_.FakePushFrameRecord(0x10020, 0x10100, 0xc2302, 0x10030);
+  ElfInterfaceFake::FakePushStepData(StepData(0xc2402, 0x10040, false));
+  ElfInterfaceFake::FakePushStepData(StepData(0, 0, true));
+
+  Unwinder unwinder(64, maps_.get(), &regs_, process_memory_);
+  unwinder.SetResolveNames(false);
+  unwinder.Unwind();
+  EXPECT_EQ(ERROR_NONE, unwinder.LastErrorCode());
+
+  ASSERT_EQ(3U, unwinder.NumFrames());
+  EXPECT_EQ(0xc2400U, unwinder.frames()[2].pc);
+  EXPECT_EQ(FRAME_UNWIND_DWARF, unwinder.frames()[2].unwind_method);
+}
+
 // Verify that a speculative frame is added.
 TEST_F(UnwinderTest, speculative_frame) {
   ElfInterfaceFake::FakePushFunctionData(FunctionData("Frame0", 0));
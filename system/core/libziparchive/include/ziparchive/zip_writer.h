@@ -97,6 +97,20 @@ class ZipWriter {
   // Move assignment.
   ZipWriter& operator=(ZipWriter&& zipWriter) noexcept;
 
+  ~ZipWriter();
+
+  /**
+   * Compresses entries started with ZipWriter::kCompress on `threads` worker threads.
+   * Entries are split into independently deflated blocks that are joined with sync flushes,
+   * so large entries compress in parallel, and entries are queued so that several small
+   * entries compress at the same time. Entries are still written in the order they were
+   * started. Since FinishEntry() no longer waits for the entry to be written, a compression
+   * or IO error may be reported by a later call. Passing 0 or 1 compresses on the calling
+   * thread. Can only be called between entries.
+   * Returns 0 on success, and an error value < 0 on failure.
+   */
+  int32_t SetCompressionThreads(size_t threads);
+
   /**
    * Starts a new zip entry with the given path and flags.
    * Flags can be a bitwise OR of ZipWriter::kCompress and ZipWriter::kAlign.
@@ -161,11 +175,18 @@ class ZipWriter {
  private:
   DISALLOW_COPY_AND_ASSIGN(ZipWriter);
 
+  struct ParallelDeflate;
+
   int32_t HandleError(int32_t error_code);
+  int32_t WriteLocalFileHeader(FileEntry* file_entry, uint32_t alignment);
+  int32_t WriteEntryTrailer(const FileEntry& file_entry);
   int32_t PrepareDeflate();
   int32_t StoreBytes(FileEntry* file, const void* data, uint32_t len);
   int32_t CompressBytes(FileEntry* file, const void* data, uint32_t len);
   int32_t FlushCompressedBytes(FileEntry* file);
+  int32_t QueueCompressedBytes(const void* data, uint32_t len);
+  void QueueBlock(bool last);
+  int32_t WritePendingEntries(size_t max_in_flight);
   bool ShouldUseDataDescriptor() const;
 
   enum class State {
@@ -185,5 +206,8 @@ class ZipWriter {
   std::unique_ptr<z_stream, void (*)(z_stream*)> z_stream_;
   std::vector<uint8_t> buffer_;
 
+  // Worker threads and the entries waiting to be written, see SetCompressionThreads().
+  std::unique_ptr<ParallelDeflate> parallel_;
+
   FRIEND_TEST(zipwriter, WriteToUnseekableFile);
 };
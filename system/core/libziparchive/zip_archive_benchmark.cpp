@@ -132,4 +132,57 @@ static void ExtractEntry(benchmark::State& state) {
 
 BENCHMARK(ExtractEntry)->Arg(2)->Arg(16)->Arg(1024);
 
+// Compressible, but not trivially so.
+static std::vector<uint8_t> MakeCompressibleData(size_t size) {
+  std::vector<uint8_t> data;
+  data.reserve(size);
+  for (size_t i = 0; data.size() < size; i++) {
+    std::string word = std::to_string(i * i % 7919) + " ";
+    data.insert(data.end(), word.begin(), word.end());
+  }
+  data.resize(size);
+  return data;
+}
+
+// Arg: compression threads, 0 compressing on the calling thread.
+static void Compress_large_entry(benchmark::State& state) {
+  std::vector<uint8_t> data = MakeCompressibleData(8 * 1024 * 1024);
+
+  for (auto _ : state) {
+    TemporaryFile file;
+    FILE* fp = fdopen(file.fd, "w");
+    ZipWriter writer(fp);
+    writer.SetCompressionThreads(state.range(0));
+    writer.StartEntry("large", ZipWriter::kCompress);
+    writer.WriteBytes(data.data(), data.size());
+    writer.FinishEntry();
+    writer.Finish();
+    fclose(fp);
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(Compress_large_entry)->Arg(0)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// Arg: compression threads, 0 compressing on the calling thread.
+static void Compress_small_entries(benchmark::State& state) {
+  std::vector<uint8_t> data = MakeCompressibleData(16 * 1024);
+  constexpr size_t kEntries = 512;
+
+  for (auto _ : state) {
+    TemporaryFile file;
+    FILE* fp = fdopen(file.fd, "w");
+    ZipWriter writer(fp);
+    writer.SetCompressionThreads(state.range(0));
+    for (size_t i = 0; i < kEntries; i++) {
+      writer.StartEntry("small" + std::to_string(i), ZipWriter::kCompress);
+      writer.WriteBytes(data.data(), data.size());
+      writer.FinishEntry();
+    }
+    writer.Finish();
+    fclose(fp);
+  }
+  state.SetBytesProcessed(state.iterations() * kEntries * data.size());
+}
+BENCHMARK(Compress_small_entries)->Arg(0)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -22,7 +22,14 @@
 #include <cstdio>
 #define DEF_MEM_LEVEL 8  // normally in zutil.h?
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "android-base/logging.h"
@@ -47,6 +54,15 @@ enum {
 // Size of the output buffer used for compression.
 static const size_t kBufSize = 32768u;
 
+// Size of the input blocks that are deflated independently when compressing on worker threads.
+static const size_t kParallelBlockSize = 128 * 1024u;
+
+// Number of blocks per worker thread that may be waiting to be compressed or written.
+static const size_t kBlocksInFlightPerThread = 4;
+
+// The deflate window; at most this much of the previous block is used as a dictionary.
+static const size_t kDeflateWindowSize = 32768u;
+
 // No error, operation completed successfully.
 static const int32_t kNoError = 0;
 
@@ -84,6 +100,147 @@ static void DeleteZStream(z_stream* stream) {
   delete stream;
 }
 
+namespace {
+
+struct CompressedBlock {
+  bool ok;
+  std::vector<uint8_t> data;
+};
+
+}  // namespace
+
+// Deflates one block of an entry. Every block but the last ends with a sync flush, which ends
+// on a byte boundary without marking the final deflate block, so the blocks of an entry can be
+// concatenated into a single valid deflate stream. The tail of the previous block is used as
+// the dictionary so that matches across block boundaries are not lost.
+static CompressedBlock DeflateBlock(const std::vector<uint8_t>& input,
+                                    const std::vector<uint8_t>* dictionary, bool last) {
+  CompressedBlock result = {};
+  z_stream stream = {};
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+  int zerr = deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL,
+                          Z_DEFAULT_STRATEGY);
+#pragma GCC diagnostic pop
+  if (zerr != Z_OK) {
+    LOG(ERROR) << "deflateInit2 failed (zerr=" << zerr << ")";
+    return result;
+  }
+
+  if (dictionary != nullptr && !dictionary->empty()) {
+    size_t dictionary_size = std::min(dictionary->size(), kDeflateWindowSize);
+    deflateSetDictionary(&stream, dictionary->data() + dictionary->size() - dictionary_size,
+                         static_cast<uInt>(dictionary_size));
+  }
+
+  // deflateBound() doesn't account for the sync flush marker.
+  result.data.resize(deflateBound(&stream, input.size()) + 16);
+  stream.next_in = input.data();
+  stream.avail_in = static_cast<uInt>(input.size());
+  stream.next_out = result.data.data();
+  stream.avail_out = static_cast<uInt>(result.data.size());
+
+  int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+  while (true) {
+    zerr = deflate(&stream, flush);
+    if (last ? zerr == Z_STREAM_END : (zerr == Z_OK && stream.avail_out != 0)) {
+      break;
+    }
+    if (zerr != Z_OK && zerr != Z_BUF_ERROR) {
+      LOG(ERROR) << "deflate failed (zerr=" << zerr << ")";
+      deflateEnd(&stream);
+      return result;
+    }
+    size_t used = result.data.size() - stream.avail_out;
+    result.data.resize(result.data.size() * 2);
+    stream.next_out = result.data.data() + used;
+    stream.avail_out = static_cast<uInt>(result.data.size() - used);
+  }
+
+  result.data.resize(result.data.size() - stream.avail_out);
+  deflateEnd(&stream);
+  result.ok = true;
+  return result;
+}
+
+struct ZipWriter::ParallelDeflate {
+  // An entry whose compressed blocks are still being produced or waiting to be written.
+  struct PendingEntry {
+    FileEntry entry;
+    uint32_t alignment;
+    bool header_written = false;
+    bool finished = false;
+    size_t next_block = 0;
+    std::vector<std::future<CompressedBlock>> blocks;
+  };
+
+  explicit ParallelDeflate(size_t thread_count)
+      : max_in_flight(thread_count * kBlocksInFlightPerThread) {
+    for (size_t i = 0; i < thread_count; i++) {
+      threads.emplace_back([this]() { Run(); });
+    }
+  }
+
+  ~ParallelDeflate() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stopping = true;
+      tasks.clear();
+    }
+    cv.notify_all();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  std::future<CompressedBlock> Submit(std::shared_ptr<const std::vector<uint8_t>> input,
+                                      std::shared_ptr<const std::vector<uint8_t>> dictionary,
+                                      bool last) {
+    std::packaged_task<CompressedBlock()> task([input, dictionary, last]() {
+      return DeflateBlock(*input, dictionary.get(), last);
+    });
+    std::future<CompressedBlock> result = task.get_future();
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      tasks.push_back(std::move(task));
+    }
+    cv.notify_one();
+    return result;
+  }
+
+  void Run() {
+    while (true) {
+      std::packaged_task<CompressedBlock()> task;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        cv.wait(guard, [this]() { return stopping || !tasks.empty(); });
+        if (stopping) {
+          return;
+        }
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  // Entries in the order they were started; only the last one can be unfinished.
+  std::deque<PendingEntry> pending;
+  // The block of the current entry that WriteBytes() is filling, and the one before it.
+  std::shared_ptr<std::vector<uint8_t>> input;
+  std::shared_ptr<const std::vector<uint8_t>> previous;
+  // Blocks queued or compressed but not yet written, and the limit before waiting on them.
+  size_t in_flight = 0;
+  const size_t max_in_flight;
+
+  std::vector<std::thread> threads;
+  std::mutex lock;
+  std::condition_variable cv;
+  std::deque<std::packaged_task<CompressedBlock()>> tasks;
+  bool stopping = false;
+};
+
 ZipWriter::ZipWriter(FILE* f)
     : file_(f),
       seekable_(false),
@@ -106,7 +263,8 @@ ZipWriter::ZipWriter(ZipWriter&& writer) noexcept
       state_(writer.state_),
       files_(std::move(writer.files_)),
       z_stream_(std::move(writer.z_stream_)),
-      buffer_(std::move(writer.buffer_)) {
+      buffer_(std::move(writer.buffer_)),
+      parallel_(std::move(writer.parallel_)) {
   writer.file_ = nullptr;
   writer.state_ = State::kError;
 }
@@ -119,17 +277,38 @@ ZipWriter& ZipWriter::operator=(ZipWriter&& writer) noexcept {
   files_ = std::move(writer.files_);
   z_stream_ = std::move(writer.z_stream_);
   buffer_ = std::move(writer.buffer_);
+  parallel_ = std::move(writer.parallel_);
   writer.file_ = nullptr;
   writer.state_ = State::kError;
   return *this;
 }
 
+ZipWriter::~ZipWriter() = default;
+
 int32_t ZipWriter::HandleError(int32_t error_code) {
   state_ = State::kError;
   z_stream_.reset();
+  if (parallel_) {
+    parallel_->pending.clear();
+    parallel_->in_flight = 0;
+  }
   return error_code;
 }
 
+int32_t ZipWriter::SetCompressionThreads(size_t threads) {
+  if (state_ != State::kWritingZip) {
+    return kInvalidState;
+  }
+
+  int32_t result = WritePendingEntries(0);
+  if (result != kNoError) {
+    return result;
+  }
+
+  parallel_.reset(threads > 1 ? new ParallelDeflate(threads) : nullptr);
+  return kNoError;
+}
+
 int32_t ZipWriter::StartEntry(std::string_view path, size_t flags) {
   uint32_t alignment = 0;
   if (flags & kAlign32) {
@@ -205,7 +384,8 @@ int32_t ZipWriter::StartAlignedEntryWithTime(std::string_view path, size_t flags
   }
 
   // Can only have 16535 entries because of zip records.
-  if (files_.size() == std::numeric_limits<uint16_t>::max()) {
+  size_t entry_count = files_.size() + (parallel_ ? parallel_->pending.size() : 0);
+  if (entry_count == std::numeric_limits<uint16_t>::max()) {
     return HandleError(kIoError);
   }
 
@@ -221,12 +401,7 @@ int32_t ZipWriter::StartAlignedEntryWithTime(std::string_view path, size_t flags
   }
 
   FileEntry file_entry = {};
-  file_entry.local_file_header_offset = current_offset_;
   file_entry.path = path;
-  // No support for larger than 4GB files.
-  if (file_entry.local_file_header_offset > std::numeric_limits<uint32_t>::max()) {
-    return HandleError(kIoError);
-  }
 
   if (!IsValidEntryName(reinterpret_cast<const uint8_t*>(file_entry.path.data()),
                         file_entry.path.size())) {
@@ -235,18 +410,55 @@ int32_t ZipWriter::StartAlignedEntryWithTime(std::string_view path, size_t flags
 
   if (flags & ZipWriter::kCompress) {
     file_entry.compression_method = kCompressDeflated;
+  } else {
+    file_entry.compression_method = kCompressStored;
+  }
+
+  ExtractTimeAndDate(time, &file_entry.last_mod_time, &file_entry.last_mod_date);
 
-    int32_t result = PrepareDeflate();
+  if (parallel_ && file_entry.compression_method == kCompressDeflated) {
+    // The local file header is written once the entries before it have been, when its offset
+    // and so its padding are known.
+    current_file_entry_ = file_entry;
+    parallel_->pending.push_back({std::move(file_entry), alignment});
+    parallel_->input = std::make_shared<std::vector<uint8_t>>();
+    parallel_->input->reserve(kParallelBlockSize);
+    parallel_->previous.reset();
+    state_ = State::kWritingEntry;
+    return kNoError;
+  }
+
+  // Anything else is written directly, after the entries still being compressed.
+  int32_t result = WritePendingEntries(0);
+  if (result != kNoError) {
+    return result;
+  }
+
+  if (file_entry.compression_method == kCompressDeflated) {
+    result = PrepareDeflate();
     if (result != kNoError) {
       return result;
     }
-  } else {
-    file_entry.compression_method = kCompressStored;
   }
 
-  ExtractTimeAndDate(time, &file_entry.last_mod_time, &file_entry.last_mod_date);
+  result = WriteLocalFileHeader(&file_entry, alignment);
+  if (result != kNoError) {
+    return result;
+  }
 
-  off_t offset = current_offset_ + sizeof(LocalFileHeader) + file_entry.path.size();
+  current_file_entry_ = std::move(file_entry);
+  state_ = State::kWritingEntry;
+  return kNoError;
+}
+
+int32_t ZipWriter::WriteLocalFileHeader(FileEntry* file_entry, uint32_t alignment) {
+  file_entry->local_file_header_offset = current_offset_;
+  // No support for larger than 4GB files.
+  if (file_entry->local_file_header_offset > std::numeric_limits<uint32_t>::max()) {
+    return HandleError(kIoError);
+  }
+
+  off_t offset = current_offset_ + sizeof(LocalFileHeader) + file_entry->path.size();
   // prepare a pre-zeroed memory page in case when we need to pad some aligned data.
   static constexpr auto kPageSize = 4096;
   static constexpr char kSmallZeroPadding[kPageSize] = {};
@@ -257,7 +469,7 @@ int32_t ZipWriter::StartAlignedEntryWithTime(std::string_view path, size_t flags
   if (alignment != 0 && (offset & (alignment - 1))) {
     // Pad the extra field so the data will be aligned.
     uint16_t padding = static_cast<uint16_t>(alignment - (offset % alignment));
-    file_entry.padding_length = padding;
+    file_entry->padding_length = padding;
     offset += padding;
     if (padding <= std::size(kSmallZeroPadding)) {
         zero_padding = kSmallZeroPadding;
@@ -270,29 +482,37 @@ int32_t ZipWriter::StartAlignedEntryWithTime(std::string_view path, size_t flags
   LocalFileHeader header = {};
   // Always start expecting a data descriptor. When the data has finished being written,
   // if it is possible to seek back, the GPB flag will reset and the sizes written.
-  CopyFromFileEntry(file_entry, true /*use_data_descriptor*/, &header);
+  CopyFromFileEntry(*file_entry, true /*use_data_descriptor*/, &header);
 
   if (fwrite(&header, sizeof(header), 1, file_) != 1) {
     return HandleError(kIoError);
   }
 
-  if (fwrite(path.data(), 1, path.size(), file_) != path.size()) {
+  if (fwrite(file_entry->path.data(), 1, file_entry->path.size(), file_) !=
+      file_entry->path.size()) {
     return HandleError(kIoError);
   }
 
-  if (file_entry.padding_length != 0 && fwrite(zero_padding, 1, file_entry.padding_length,
-                                               file_) != file_entry.padding_length) {
+  if (file_entry->padding_length != 0 &&
+      fwrite(zero_padding, 1, file_entry->padding_length, file_) != file_entry->padding_length) {
     return HandleError(kIoError);
   }
 
-  current_file_entry_ = std::move(file_entry);
   current_offset_ = offset;
-  state_ = State::kWritingEntry;
   return kNoError;
 }
 
 int32_t ZipWriter::DiscardLastEntry() {
-  if (state_ != State::kWritingZip || files_.empty()) {
+  if (state_ != State::kWritingZip) {
+    return kInvalidState;
+  }
+
+  int32_t result = WritePendingEntries(0);
+  if (result != kNoError) {
+    return result;
+  }
+
+  if (files_.empty()) {
     return kInvalidState;
   }
 
@@ -308,6 +528,13 @@ int32_t ZipWriter::DiscardLastEntry() {
 int32_t ZipWriter::GetLastEntry(FileEntry* out_entry) {
   CHECK(out_entry != nullptr);
 
+  if (state_ == State::kWritingZip) {
+    int32_t result = WritePendingEntries(0);
+    if (result != kNoError) {
+      return result;
+    }
+  }
+
   if (files_.empty()) {
     return kInvalidState;
   }
@@ -356,7 +583,11 @@ int32_t ZipWriter::WriteBytes(const void* data, size_t len) {
 
   int32_t result = kNoError;
   if (current_file_entry_.compression_method & kCompressDeflated) {
-    result = CompressBytes(&current_file_entry_, data, len32);
+    if (parallel_) {
+      result = QueueCompressedBytes(data, len32);
+    } else {
+      result = CompressBytes(&current_file_entry_, data, len32);
+    }
   } else {
     result = StoreBytes(&current_file_entry_, data, len32);
   }
@@ -455,6 +686,94 @@ int32_t ZipWriter::FlushCompressedBytes(FileEntry* file) {
   return kNoError;
 }
 
+int32_t ZipWriter::QueueCompressedBytes(const void* data, uint32_t len) {
+  CHECK(state_ == State::kWritingEntry);
+  CHECK(parallel_);
+
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  while (len > 0) {
+    std::vector<uint8_t>& input = *parallel_->input;
+    size_t space = kParallelBlockSize - input.size();
+    uint32_t chunk = static_cast<uint32_t>(std::min<size_t>(len, space));
+    input.insert(input.end(), bytes, bytes + chunk);
+    bytes += chunk;
+    len -= chunk;
+
+    if (input.size() == kParallelBlockSize) {
+      QueueBlock(false);
+      int32_t result = WritePendingEntries(parallel_->max_in_flight);
+      if (result != kNoError) {
+        return result;
+      }
+    }
+  }
+  return kNoError;
+}
+
+void ZipWriter::QueueBlock(bool last) {
+  ParallelDeflate& parallel = *parallel_;
+  std::shared_ptr<const std::vector<uint8_t>> input = std::move(parallel.input);
+
+  parallel.pending.back().blocks.push_back(parallel.Submit(input, parallel.previous, last));
+  parallel.in_flight++;
+
+  parallel.previous = std::move(input);
+  parallel.input = std::make_shared<std::vector<uint8_t>>();
+  parallel.input->reserve(kParallelBlockSize);
+}
+
+// Writes the queued entries in order, as far as their blocks have been compressed. While more
+// than `max_in_flight` blocks are outstanding it waits for them, so 0 writes every finished entry.
+int32_t ZipWriter::WritePendingEntries(size_t max_in_flight) {
+  if (!parallel_) {
+    return kNoError;
+  }
+
+  std::deque<ParallelDeflate::PendingEntry>& pending = parallel_->pending;
+  while (!pending.empty()) {
+    ParallelDeflate::PendingEntry& head = pending.front();
+    if (!head.header_written) {
+      int32_t result = WriteLocalFileHeader(&head.entry, head.alignment);
+      if (result != kNoError) {
+        return result;
+      }
+      head.header_written = true;
+    }
+
+    for (; head.next_block < head.blocks.size(); head.next_block++) {
+      std::future<CompressedBlock>& block = head.blocks[head.next_block];
+      if (parallel_->in_flight <= max_in_flight &&
+          block.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return kNoError;
+      }
+
+      CompressedBlock compressed = block.get();
+      parallel_->in_flight--;
+      if (!compressed.ok) {
+        return HandleError(kZlibError);
+      }
+      size_t write_bytes = compressed.data.size();
+      if (fwrite(compressed.data.data(), 1, write_bytes, file_) != write_bytes) {
+        return HandleError(kIoError);
+      }
+      head.entry.compressed_size += write_bytes;
+      current_offset_ += write_bytes;
+    }
+
+    if (!head.finished) {
+      return kNoError;
+    }
+
+    int32_t result = WriteEntryTrailer(head.entry);
+    if (result != kNoError) {
+      return result;
+    }
+    files_.emplace_back(std::move(head.entry));
+    pending.pop_front();
+  }
+  return kNoError;
+}
+
 bool ZipWriter::ShouldUseDataDescriptor() const {
   // Only use a trailing "data descriptor" if the output isn't seekable.
   return !seekable_;
@@ -465,6 +784,18 @@ int32_t ZipWriter::FinishEntry() {
     return kInvalidState;
   }
 
+  if (parallel_ && (current_file_entry_.compression_method & kCompressDeflated)) {
+    QueueBlock(true);
+    ParallelDeflate::PendingEntry& pending = parallel_->pending.back();
+    pending.entry.crc32 = current_file_entry_.crc32;
+    pending.entry.uncompressed_size = current_file_entry_.uncompressed_size;
+    pending.finished = true;
+    parallel_->input.reset();
+    parallel_->previous.reset();
+    state_ = State::kWritingZip;
+    return WritePendingEntries(parallel_->max_in_flight);
+  }
+
   if (current_file_entry_.compression_method & kCompressDeflated) {
     int32_t result = FlushCompressedBytes(&current_file_entry_);
     if (result != kNoError) {
@@ -472,6 +803,17 @@ int32_t ZipWriter::FinishEntry() {
     }
   }
 
+  int32_t result = WriteEntryTrailer(current_file_entry_);
+  if (result != kNoError) {
+    return result;
+  }
+
+  files_.emplace_back(std::move(current_file_entry_));
+  state_ = State::kWritingZip;
+  return kNoError;
+}
+
+int32_t ZipWriter::WriteEntryTrailer(const FileEntry& file_entry) {
   if (ShouldUseDataDescriptor()) {
     // Some versions of ZIP don't allow STORED data to have a trailing DataDescriptor.
     // If this file is not seekable, or if the data is compressed, write a DataDescriptor.
@@ -481,21 +823,21 @@ int32_t ZipWriter::FinishEntry() {
     }
 
     DataDescriptor dd = {};
-    dd.crc32 = current_file_entry_.crc32;
-    dd.compressed_size = current_file_entry_.compressed_size;
-    dd.uncompressed_size = current_file_entry_.uncompressed_size;
+    dd.crc32 = file_entry.crc32;
+    dd.compressed_size = file_entry.compressed_size;
+    dd.uncompressed_size = file_entry.uncompressed_size;
     if (fwrite(&dd, sizeof(dd), 1, file_) != 1) {
       return HandleError(kIoError);
     }
     current_offset_ += sizeof(DataDescriptor::kOptSignature) + sizeof(dd);
   } else {
     // Seek back to the header and rewrite to include the size.
-    if (fseeko(file_, current_file_entry_.local_file_header_offset, SEEK_SET) != 0) {
+    if (fseeko(file_, file_entry.local_file_header_offset, SEEK_SET) != 0) {
       return HandleError(kIoError);
     }
 
     LocalFileHeader header = {};
-    CopyFromFileEntry(current_file_entry_, false /*use_data_descriptor*/, &header);
+    CopyFromFileEntry(file_entry, false /*use_data_descriptor*/, &header);
 
     if (fwrite(&header, sizeof(header), 1, file_) != 1) {
       return HandleError(kIoError);
@@ -505,9 +847,6 @@ int32_t ZipWriter::FinishEntry() {
       return HandleError(kIoError);
     }
   }
-
-  files_.emplace_back(std::move(current_file_entry_));
-  state_ = State::kWritingZip;
   return kNoError;
 }
 
@@ -516,6 +855,11 @@ int32_t ZipWriter::Finish() {
     return kInvalidState;
   }
 
+  int32_t result = WritePendingEntries(0);
+  if (result != kNoError) {
+    return result;
+  }
+
   off_t startOfCdr = current_offset_;
   for (FileEntry& file : files_) {
     CentralDirectoryRecord cdr = {};
@@ -288,6 +288,67 @@ TEST_F(zipwriter, WriteCompressedZipFlushFull) {
   CloseArchive(handle);
 }
 
+TEST_F(zipwriter, WriteCompressedZipInParallel) {
+  // Large enough to be split into several blocks, and written in uneven pieces.
+  std::string large;
+  for (size_t i = 0; large.size() < 1024 * 1024; i++) {
+    large += std::to_string(i * i) + " ";
+  }
+
+  ZipWriter writer(file_);
+  ASSERT_EQ(0, writer.SetCompressionThreads(4));
+
+  ASSERT_EQ(0, writer.StartEntry("large.txt", ZipWriter::kCompress));
+  for (size_t offset = 0; offset < large.size(); offset += 100003) {
+    ASSERT_EQ(0, writer.WriteBytes(large.data() + offset,
+                                   std::min<size_t>(100003, large.size() - offset)));
+  }
+  ASSERT_EQ(0, writer.FinishEntry());
+
+  ASSERT_EQ(0, writer.StartEntry("small.txt", ZipWriter::kCompress | ZipWriter::kAlign32));
+  ASSERT_EQ(0, writer.WriteBytes("helo", 4));
+  ASSERT_EQ(0, writer.FinishEntry());
+
+  ASSERT_EQ(0, writer.StartEntry("empty.txt", ZipWriter::kCompress));
+  ASSERT_EQ(0, writer.FinishEntry());
+
+  // Stored entries wait for the compressed entries before them to be written.
+  ASSERT_EQ(0, writer.StartEntry("stored.txt", ZipWriter::kAlign32));
+  ASSERT_EQ(0, writer.WriteBytes("stored", 6));
+  ASSERT_EQ(0, writer.FinishEntry());
+
+  ZipWriter::FileEntry last;
+  ASSERT_EQ(0, writer.GetLastEntry(&last));
+  EXPECT_EQ("stored.txt", last.path);
+  ASSERT_EQ(0, writer.Finish());
+
+  ASSERT_GE(0, lseek(fd_, 0, SEEK_SET));
+
+  ZipArchiveHandle handle;
+  ASSERT_EQ(0, OpenArchiveFd(fd_, "temp", &handle, false));
+
+  ZipEntry data;
+  ASSERT_EQ(0, FindEntry(handle, "large.txt", &data));
+  EXPECT_EQ(kCompressDeflated, data.method);
+  EXPECT_LT(data.compressed_length, data.uncompressed_length);
+  ASSERT_TRUE(AssertFileEntryContentsEq(large, handle, &data));
+
+  ASSERT_EQ(0, FindEntry(handle, "small.txt", &data));
+  EXPECT_EQ(kCompressDeflated, data.method);
+  EXPECT_EQ(0, data.offset & 0x03);
+  ASSERT_TRUE(AssertFileEntryContentsEq("helo", handle, &data));
+
+  ASSERT_EQ(0, FindEntry(handle, "empty.txt", &data));
+  ASSERT_TRUE(AssertFileEntryContentsEq("", handle, &data));
+
+  ASSERT_EQ(0, FindEntry(handle, "stored.txt", &data));
+  EXPECT_EQ(kCompressStored, data.method);
+  EXPECT_EQ(0, data.offset & 0x03);
+  ASSERT_TRUE(AssertFileEntryContentsEq("stored", handle, &data));
+
+  CloseArchive(handle);
+}
+
 TEST_F(zipwriter, CheckStartEntryErrors) {
   ZipWriter writer(file_);
 
@@ -529,6 +529,8 @@ int Logcat::Run(int argc, char** argv) {
     const char* setId = nullptr;
     int mode = ANDROID_LOG_RDONLY;
     std::string forceFilters;
+    // The filterspecs given to logformat_, so logd can apply them as well.
+    std::string logdFilters;
     size_t tail_lines = 0;
     log_time tail_time(log_time::EPOCH);
     size_t pid = 0;
@@ -636,6 +638,7 @@ int Logcat::Run(int argc, char** argv) {
             case 's':
                 // default to all silent
                 android_log_addFilterRule(logformat_.get(), "*:s");
+                logdFilters += " *:s";
                 break;
 
             case 'c':
@@ -942,6 +945,7 @@ int Logcat::Run(int argc, char** argv) {
         if (err < 0) {
             error(EXIT_FAILURE, 0, "Invalid filter expression in logcat args.");
         }
+        logdFilters += " " + forceFilters;
     } else if (argc == optind) {
         // Add from environment variable
         const char* env_tags_orig = getenv("ANDROID_LOG_TAGS");
@@ -952,6 +956,7 @@ int Logcat::Run(int argc, char** argv) {
             if (err < 0) {
                 error(EXIT_FAILURE, 0, "Invalid filter expression in ANDROID_LOG_TAGS.");
             }
+            logdFilters += " " + std::string(env_tags_orig);
         }
     } else {
         // Add from commandline
@@ -960,6 +965,7 @@ int Logcat::Run(int argc, char** argv) {
             if (err < 0) {
                 error(EXIT_FAILURE, 0, "Invalid filter expression '%s'.", argv[i]);
             }
+            logdFilters += " " + std::string(argv[i]);
         }
     }
 
@@ -1015,6 +1021,12 @@ int Logcat::Run(int argc, char** argv) {
     } else {
         logger_list.reset(android_logger_list_alloc(mode, tail_lines, pid));
     }
+    // Have logd drop the entries that would not be printed, rather than send them. They are still
+    // filtered here, so this is only an optimization and failures are ignored. Binary output is
+    // not filtered at all.
+    if (!logdFilters.empty() && !print_binary_) {
+        android_logger_list_set_filter(logger_list.get(), logdFilters.c_str());
+    }
     // We have three orthogonal actions below to clear, set log size and
     // get log size. All sharing the same iteration loop.
     std::vector<std::string> open_device_failures;
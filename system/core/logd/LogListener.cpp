@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <errno.h>
 #include <limits.h>
 #include <sys/cdefs.h>
 #include <sys/prctl.h>
@@ -87,31 +88,68 @@ bool LogListener::onDataAvailable(SocketClient* cli) {
 
     android_log_header_t* header =
         reinterpret_cast<android_log_header_t*>(buffer);
+    char* msg = ((char*)buffer) + sizeof(android_log_header_t);
+    n -= sizeof(android_log_header_t);
+
+    if (header->id != LOG_ID_BATCH) {
+        // NB: hdr.msg_flags & MSG_TRUNC is not tested, silently passing a
+        // truncated message to the logs.
+        int res = logEntry(cred, header, msg, n);
+        if (res == -EINVAL || res == -EPERM) {
+            return false;
+        }
+        if (res > 0) {
+            reader->notifyNewLog(static_cast<log_mask_t>(1 << header->id));
+        }
+        return true;
+    }
+
+    // A batch holds the entries of any of the sender's threads in the order
+    // they were logged, each with its own header and tid; the tid in the batch
+    // header is just that of the thread that flushed it. A truncated last
+    // entry is dropped.
+    log_mask_t mask = 0;
+    while ((size_t)n >= sizeof(android_log_batch_entry_t)) {
+        android_log_batch_entry_t* entry =
+            reinterpret_cast<android_log_batch_entry_t*>(msg);
+        msg += sizeof(android_log_batch_entry_t);
+        n -= sizeof(android_log_batch_entry_t);
+        if (entry->len > n) {
+            break;
+        }
+
+        int res = logEntry(cred, &entry->header, msg, entry->len);
+        if (res > 0) {
+            mask |= static_cast<log_mask_t>(1 << entry->header.id);
+        }
+        msg += entry->len;
+        n -= entry->len;
+    }
+    if (mask) {
+        reader->notifyNewLog(mask);
+    }
+
+    return true;
+}
+
+int LogListener::logEntry(const struct ucred* cred,
+                          const android_log_header_t* header, char* msg,
+                          size_t len) {
     log_id_t logId = static_cast<log_id_t>(header->id);
     if (/* logId < LOG_ID_MIN || */ logId >= LOG_ID_MAX ||
         logId == LOG_ID_KERNEL) {
-        return false;
+        return -EINVAL;
     }
 
     if ((logId == LOG_ID_SECURITY) &&
         (!__android_log_security() ||
          !clientHasLogCredentials(cred->uid, cred->gid, cred->pid))) {
-        return false;
+        return -EPERM;
     }
 
-    char* msg = ((char*)buffer) + sizeof(android_log_header_t);
-    n -= sizeof(android_log_header_t);
-
-    // NB: hdr.msg_flags & MSG_TRUNC is not tested, silently passing a
-    // truncated message to the logs.
-
-    int res = logbuf->log(logId, header->realtime, cred->uid, cred->pid, header->tid, msg,
-                          ((size_t)n <= UINT16_MAX) ? (uint16_t)n : UINT16_MAX);
-    if (res > 0) {
-        reader->notifyNewLog(static_cast<log_mask_t>(1 << logId));
-    }
-
-    return true;
+    return logbuf->log(logId, header->realtime, cred->uid, cred->pid,
+                       header->tid, msg,
+                       (len <= UINT16_MAX) ? (uint16_t)len : UINT16_MAX);
 }
 
 int LogListener::getLogSocket() {
@@ -17,6 +17,9 @@
 #ifndef _LOGD_LOG_LISTENER_H__
 #define _LOGD_LOG_LISTENER_H__
 
+#include <sys/socket.h>
+
+#include <private/android_logger.h>
 #include <sysutils/SocketListener.h>
 #include "LogReader.h"
 
@@ -31,6 +34,8 @@ class LogListener : public SocketListener {
     virtual bool onDataAvailable(SocketClient* cli);
 
    private:
+    int logEntry(const struct ucred* cred, const android_log_header_t* header,
+                 char* msg, size_t len);
     static int getLogSocket();
 };
 
@@ -28,6 +28,7 @@
 #include "LogBuffer.h"
 #include "LogBufferElement.h"
 #include "LogReader.h"
+#include "LogReaderFilter.h"
 #include "LogUtils.h"
 
 LogReader::LogReader(LogBuffer* logbuf)
@@ -49,7 +50,7 @@ bool LogReader::onDataAvailable(SocketClient* cli) {
         name_set = true;
     }
 
-    char buffer[255];
+    char buffer[1024];
 
     int len = read(cli->getSocket(), buffer, sizeof(buffer) - 1);
     if (len <= 0) {
@@ -70,6 +71,14 @@ bool LogReader::onDataAvailable(SocketClient* cli) {
     }
     LogTimeEntry::unlock();
 
+    // Parsed first, as the text of grep= may contain any of the other
+    // arguments.
+    LogReaderFilter filter;
+    if (!filter.init(buffer)) {
+        doSocketDelete(cli);
+        return false;
+    }
+
     unsigned long tail = 0;
     static const char _tail[] = " tail=";
     char* cp = strstr(buffer, _tail);
@@ -208,9 +217,10 @@ bool LogReader::onDataAvailable(SocketClient* cli) {
 
     android::prdebug(
         "logdr: UID=%d GID=%d PID=%d %c tail=%lu logMask=%x pid=%d "
-        "start=%" PRIu64 "ns timeout=%" PRIu64 "ns\n",
+        "start=%" PRIu64 "ns timeout=%" PRIu64 "ns%s\n",
         cli->getUid(), cli->getGid(), cli->getPid(), nonBlock ? 'n' : 'b', tail,
-        logMask, (int)pid, sequence.nsec(), timeout);
+        logMask, (int)pid, sequence.nsec(), timeout,
+        filter.empty() ? "" : " filtered");
 
     if (sequence == log_time::EPOCH) {
         timeout = 0;
@@ -218,7 +228,8 @@ bool LogReader::onDataAvailable(SocketClient* cli) {
 
     LogTimeEntry::wrlock();
     auto entry = std::make_unique<LogTimeEntry>(
-        *this, cli, nonBlock, tail, logMask, pid, sequence, timeout);
+        *this, cli, nonBlock, tail, logMask, pid, std::move(filter), sequence,
+        timeout);
     if (!entry->startReader_Locked()) {
         LogTimeEntry::unlock();
         return false;
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <log/log.h>
+
+#include "LogBuffer.h"
+#include "LogBufferElement.h"
+#include "LogReaderFilter.h"
+
+// Matches filterCharToPri() in liblog/logprint.cpp
+static int priorityFromChar(char c) {
+    c = tolower(c);
+    if (c >= '0' && c <= '9') {
+        if (c >= ('0' + ANDROID_LOG_SILENT)) {
+            return ANDROID_LOG_VERBOSE;
+        }
+        return c - '0';
+    }
+    switch (c) {
+        case 'v': return ANDROID_LOG_VERBOSE;
+        case 'd': return ANDROID_LOG_DEBUG;
+        case 'i': return ANDROID_LOG_INFO;
+        case 'w': return ANDROID_LOG_WARN;
+        case 'e': return ANDROID_LOG_ERROR;
+        case 'f': return ANDROID_LOG_FATAL;
+        case 's': return ANDROID_LOG_SILENT;
+        case '*': return ANDROID_LOG_DEFAULT;
+    }
+    return ANDROID_LOG_UNKNOWN;
+}
+
+LogReaderFilter::LogReaderFilter()
+    : mDefaultPriority(ANDROID_LOG_VERBOSE), mEmpty(true) {
+}
+
+bool LogReaderFilter::init(char* command) {
+    static const char _grep[] = " grep=";
+    char* cp = strstr(command, _grep);
+    if (cp) {
+        mGrep = cp + sizeof(_grep) - 1;
+        *cp = '\0';
+        if (mGrep.empty()) {
+            return false;
+        }
+        mEmpty = false;
+    }
+
+    static const char _uids[] = " uids=";
+    cp = strstr(command, _uids);
+    if (cp) {
+        cp += sizeof(_uids) - 1;
+        while (true) {
+            char* end;
+            unsigned long uid = strtoul(cp, &end, 10);
+            if (end == cp) {
+                return false;
+            }
+            mUids.insert(uid);
+            cp = end;
+            if (*cp != ',') {
+                break;
+            }
+            ++cp;
+        }
+        mEmpty = false;
+    }
+
+    // Same rules as android_log_addFilterRule().
+    static const char _filter[] = " filter=";
+    cp = strstr(command, _filter);
+    if (cp) {
+        cp += sizeof(_filter) - 1;
+        while (*cp && !isspace(*cp)) {
+            if (*cp == ',') {
+                ++cp;
+                continue;
+            }
+            const char* tag = cp;
+            while (*cp && (*cp != ':') && (*cp != ',') && !isspace(*cp)) {
+                ++cp;
+            }
+            size_t tagLen = cp - tag;
+            if (!tagLen) {
+                return false;
+            }
+            int priority = ANDROID_LOG_DEFAULT;
+            if (*cp == ':') {
+                priority = priorityFromChar(*++cp);
+                if (priority == ANDROID_LOG_UNKNOWN) {
+                    return false;
+                }
+                ++cp;
+            }
+            if ((tagLen == 1) && (*tag == '*')) {
+                mDefaultPriority = (priority == ANDROID_LOG_DEFAULT)
+                                       ? ANDROID_LOG_DEBUG
+                                       : priority;
+            } else {
+                mTagPriorities[std::string(tag, tagLen)] =
+                    (priority == ANDROID_LOG_DEFAULT) ? ANDROID_LOG_VERBOSE
+                                                      : priority;
+            }
+            if (*cp == ',') {
+                ++cp;
+            }
+        }
+        mEmpty = false;
+    }
+
+    return true;
+}
+
+int LogReaderFilter::priorityForTag(const char* tag, size_t len) const {
+    if (!mTagPriorities.empty()) {
+        auto it = mTagPriorities.find(std::string(tag, len));
+        if (it != mTagPriorities.end()) {
+            return it->second;
+        }
+    }
+    return mDefaultPriority;
+}
+
+bool LogReaderFilter::matches(const LogBufferElement* element,
+                              LogBuffer& logbuf) const {
+    if (mEmpty) {
+        return true;
+    }
+
+    if (!mUids.empty() && !mUids.count(element->getUid())) {
+        return false;
+    }
+
+    // The chatty entries for dropped messages are formatted as they are sent,
+    // leave them to the client.
+    const char* msg = element->getMsg();
+    if (!msg) {
+        return true;
+    }
+    size_t len = element->getMsgLen();
+
+    log_id_t logId = element->getLogId();
+    if (element->isBinary() || (logId == LOG_ID_STATS)) {
+        if (!mGrep.empty()) {
+            return false;
+        }
+        if (mTagPriorities.empty() && (mDefaultPriority <= ANDROID_LOG_INFO)) {
+            return true;
+        }
+        // Binary entries are printed by logcat at ANDROID_LOG_INFO.
+        const char* tag = logbuf.tagToName(element->getTag());
+        if (!tag) {
+            return true;
+        }
+        return ANDROID_LOG_INFO >= priorityForTag(tag, strlen(tag));
+    }
+
+    if (len < 2) {
+        return true;
+    }
+    int priority = msg[0];
+    const char* tag = msg + 1;
+    size_t tagLen = strnlen(tag, len - 1);
+    if (priority < priorityForTag(tag, tagLen)) {
+        return false;
+    }
+
+    if (!mGrep.empty()) {
+        size_t offset = 1 + tagLen + 1;
+        if ((offset >= len) ||
+            !memmem(msg + offset, len - offset, mGrep.data(), mGrep.size())) {
+            return false;
+        }
+    }
+
+    return true;
+}
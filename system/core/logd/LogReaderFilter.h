@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOGD_LOG_READER_FILTER_H__
+#define _LOGD_LOG_READER_FILTER_H__
+
+#include <sys/types.h>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+class LogBuffer;
+class LogBufferElement;
+
+// Filters that a reader asks logd to apply before an entry is sent to it.
+//
+// filter=<tag>:<priority>,...  The filterspec of logcat, comma separated.
+//                              A tag of * sets the priority of all other
+//                              tags, later rules replace earlier ones.
+// uids=<uid>,...               Only entries logged by these uids.
+// grep=<text>                  Only text entries whose message contains text.
+//                              Must be the last argument, as text runs to
+//                              the end of the command.
+//
+// Each of these only ever removes entries that logcat would not print with
+// the same filterspec, so a client may keep filtering on its side.
+class LogReaderFilter {
+    std::unordered_map<std::string, int> mTagPriorities;
+    int mDefaultPriority;
+    std::unordered_set<uid_t> mUids;
+    std::string mGrep;
+    bool mEmpty;
+
+    int priorityForTag(const char* tag, size_t len) const;
+
+   public:
+    LogReaderFilter();
+
+    // Parses and removes the filter arguments from a reader command.
+    // Returns false if they are malformed.
+    bool init(char* command);
+
+    bool empty() const {
+        return mEmpty;
+    }
+
+    bool matches(const LogBufferElement* element, LogBuffer& logbuf) const;
+};
+
+#endif  // _LOGD_LOG_READER_FILTER_H__
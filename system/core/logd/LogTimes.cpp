@@ -29,11 +29,13 @@ pthread_mutex_t LogTimeEntry::timesLock = PTHREAD_MUTEX_INITIALIZER;
 
 LogTimeEntry::LogTimeEntry(LogReader& reader, SocketClient* client,
                            bool nonBlock, unsigned long tail, log_mask_t logMask,
-                           pid_t pid, log_time start, uint64_t timeout)
+                           pid_t pid, LogReaderFilter filter,
+                           log_time start, uint64_t timeout)
     : leadingDropped(false),
       mReader(reader),
       mLogMask(logMask),
       mPid(pid),
+      mFilter(std::move(filter)),
       mCount(0),
       mTail(tail),
       mIndex(0),
@@ -162,7 +164,7 @@ int LogTimeEntry::FilterFirstPass(const LogBufferElement* element, void* obj) {
     }
 
     if ((!me->mPid || (me->mPid == element->getPid())) &&
-        (me->isWatching(element->getLogId()))) {
+        (me->isWatching(element->getLogId())) && me->isSelected(element)) {
         ++me->mCount;
     }
 
@@ -204,6 +206,10 @@ int LogTimeEntry::FilterSecondPass(const LogBufferElement* element, void* obj) {
         goto skip;
     }
 
+    if (!me->isSelected(element)) {
+        goto skip;
+    }
+
     if (me->mRelease) {
         goto stop;
     }
@@ -238,6 +244,12 @@ stop:
     return -1;
 }
 
+// Evaluates the filters of the reader, so entries it would discard are never
+// formatted and written to its socket.
+bool LogTimeEntry::isSelected(const LogBufferElement* element) const {
+    return mFilter.matches(element, mReader.logbuf());
+}
+
 void LogTimeEntry::cleanSkip_Locked(void) {
     memset(skipAhead, 0, sizeof(skipAhead));
 }
@@ -28,6 +28,8 @@
 #include <log/log.h>
 #include <sysutils/SocketClient.h>
 
+#include "LogReaderFilter.h"
+
 typedef unsigned int log_mask_t;
 
 class LogReader;
@@ -43,6 +45,7 @@ class LogTimeEntry {
     static void* threadStart(void* me);
     const log_mask_t mLogMask;
     const pid_t mPid;
+    const LogReaderFilter mFilter;
     unsigned int skipAhead[LOG_ID_MAX];
     pid_t mLastTid[LOG_ID_MAX];
     unsigned long mCount;
@@ -52,7 +55,7 @@ class LogTimeEntry {
    public:
     LogTimeEntry(LogReader& reader, SocketClient* client, bool nonBlock,
                  unsigned long tail, log_mask_t logMask, pid_t pid,
-                 log_time start, uint64_t timeout);
+                 LogReaderFilter filter, log_time start, uint64_t timeout);
 
     SocketClient* mClient;
     log_time mStart;
@@ -95,6 +98,7 @@ class LogTimeEntry {
     bool isWatchingMultiple(log_mask_t logMask) const {
         return mLogMask & logMask;
     }
+    bool isSelected(const LogBufferElement* element) const;
     // flushTo filter callbacks
     static int FilterFirstPass(const LogBufferElement* element, void* me);
     static int FilterSecondPass(const LogBufferElement* element, void* me);
@@ -832,6 +832,52 @@ TEST(logd, getEventTag_newentry) {
 #endif
 }
 
+TEST(logd, reader_filter) {
+#ifdef __ANDROID__
+    static const char tag[] = "logd.reader_filter";
+    static const char other_tag[] = "logd.reader_filter.other";
+    log_time now(CLOCK_MONOTONIC);
+    std::string match =
+        android::base::StringPrintf("match %" PRIu64, now.nsec());
+
+    ASSERT_LT(0, __android_log_buf_write(LOG_ID_MAIN, ANDROID_LOG_INFO, tag,
+                                         match.c_str()));
+    ASSERT_LT(0, __android_log_buf_write(LOG_ID_MAIN, ANDROID_LOG_DEBUG, tag,
+                                         match.c_str()));
+    ASSERT_LT(0, __android_log_buf_write(LOG_ID_MAIN, ANDROID_LOG_INFO, tag,
+                                         "other message"));
+    ASSERT_LT(0, __android_log_buf_write(LOG_ID_MAIN, ANDROID_LOG_ERROR,
+                                         other_tag, match.c_str()));
+
+    struct logger_list* logger_list =
+        android_logger_list_alloc(ANDROID_LOG_NONBLOCK, 0, getpid());
+    ASSERT_TRUE(logger_list != nullptr);
+    ASSERT_TRUE(android_logger_open(logger_list, LOG_ID_MAIN) != nullptr);
+    std::string filterspec = android::base::StringPrintf("*:S %s:I", tag);
+    ASSERT_EQ(0, android_logger_list_set_filter(logger_list,
+                                                filterspec.c_str()));
+    ASSERT_EQ(0, android_logger_list_set_uid(logger_list, getuid()));
+    ASSERT_EQ(0, android_logger_list_set_grep(logger_list, match.c_str()));
+
+    // Only the first entry passes the filters.
+    size_t count = 0;
+    log_msg msg;
+    while (android_logger_list_read(logger_list, &msg) > 0) {
+        ASSERT_EQ(LOG_ID_MAIN, msg.id());
+        const char* payload = msg.msg();
+        ASSERT_EQ(ANDROID_LOG_INFO, payload[0]);
+        EXPECT_STREQ(tag, payload + 1);
+        EXPECT_EQ(match, payload + 1 + sizeof(tag));
+        ++count;
+    }
+    android_logger_list_free(logger_list);
+
+    EXPECT_EQ(1U, count);
+#else
+    GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 #ifdef __ANDROID__
 static inline uint32_t get4LE(const uint8_t* src) {
   return src[0] | (src[1] << 8) | (src[2] << 16) | (src[3] << 24);